@@ -1,800 +1,1215 @@
-//===========================================================================
-/*
- This file is part of the CHAI 3D visualization and haptics libraries.
- Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
- 
- This library is free software; you can redistribute it and/or modify
- it under the terms of the GNU General Public License("GPL") version 2
- as published by the Free Software Foundation.
- 
- For using the CHAI 3D libraries with software that can not be combined
- with the GNU GPL, and for taking advantage of the additional benefits
- of our support services, please contact CHAI 3D about acquiring a
- Professional Edition License.
- 
- \author    <http://www.chai3d.org>
- \author    Francois Conti
- \version   2.0.0 $Rev: 269 $
- */
-//===========================================================================
-
-//---------------------------------------------------------------------------
-#include <assert.h>
-#include <math.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-//---------------------------------------------------------------------------
-#include "chai3d.h"
-//---------------------------------------------------------------------------
-
-//---------------------------------------------------------------------------
-// DECLARED CONSTANTS
-//---------------------------------------------------------------------------
-
-// initial size (width/height) in pixels of the display window
-const int WINDOW_SIZE_W = 600;
-const int WINDOW_SIZE_H = 600;
-
-// mouse menu options (right button)
-const int OPTION_FULLSCREEN = 1;
-const int OPTION_WINDOWDISPLAY = 2;
-
-//---------------------------------------------------------------------------
-// DECLARED VARIABLES
-//---------------------------------------------------------------------------
-
-// a world that contains all objects of the virtual environment
-cWorld* world;
-
-// a camera that renders the world in a window display
-cCamera* camera;
-
-// a light source to illuminate the objects in the virtual scene
-cLight *light;
-
-// a little "chai3d" bitmap logo at the bottom of the screen
-cBitmap* logo;
-
-// width and height of the current window display
-int displayW = 0;
-int displayH = 0;
-
-// a haptic device handler
-cHapticDeviceHandler* handler;
-
-// a virtual tool representing the haptic device in the scene
-cGeneric3dofPointer* tool;
-
-// radius of the tool proxy
-double proxyRadius;
-
-//collision plane with sphere
-cMesh* plane;
-
-// 3 spheres and
-cShapeSphere * s[3];
-
-cVector3d s_pos[3];
-cVector3d v[3];
-cVector3d g(0,0,-9.8);
-
-//3 springs
-cShapeLine *l[3];
-
-//default parameters
-double para[4];
-double m = 10;
-double restLength = 0.5;
-double SPRING_C = 100;
-double DAMPING_C_z = 0.9;
-double DAMPING_G = 0.6;
-int i;
-
-// status of the main simulation haptics loop
-bool simulationRunning = false;
-
-// simulation clock
-cPrecisionClock simClock;
-
-// root resource path
-string resourceRoot;
-
-// has exited haptics simulation thread
-bool simulationFinished = false;
-
-// set a random Inital Position
-bool randomInitPos = false;
-
-//---------------------------------------------------------------------------
-// DECLARED MACROS
-//---------------------------------------------------------------------------
-// convert to resource path
-#define RESOURCE_PATH(p)    (char*)((resourceRoot+string(p)).c_str())
-
-
-//---------------------------------------------------------------------------
-// DECLARED FUNCTIONS
-//---------------------------------------------------------------------------
-
-// callback when the window display is resized
-void resizeWindow(int w, int h);
-
-// callback when a keyboard key is pressed
-void keySelect(unsigned char key, int x, int y);
-
-// callback when the right mouse button is pressed to select a menu item
-void menuSelect(int value);
-
-// function called before exiting the application
-void close(void);
-
-// main graphics callback
-void updateGraphics(void);
-
-// main haptics loop
-void updateHaptics(void);
-
-//detect collision and update velocity
-void updateVafterCollision(int);
-
-//constrains of parameters
-void pararestrict(void);
-//===========================================================================
-/*
- DEMO:    polygons.cpp
- 
- This example illustrates how to build an object composed of triangle
- with individual colors. A finger-proxy algorithm is used to compute
- the interaction force between the tool and the object.
- */
-//===========================================================================
-
-int main(int argc, char* argv[])
-{
-    //-----------------------------------------------------------------------
-    // INITIALIZATION
-    //-----------------------------------------------------------------------
-    
-    printf("\n");
-    printf("-----------------------------------\n");
-    printf("CHAI 3D\n");
-    printf("Demo: 12-polygons\n");
-    printf("Copyright 2003-2009\n");
-    printf("-----------------------------------\n");
-    printf("\n\n");
-    printf("Keyboard Options:\n\n");
-    printf("[1] - restart\n");
-    printf("[2] - select start mode\n");
-    printf("[9] - increase parameters\n");
-    printf("[0] - decrease parameters\n");
-    printf("[x] - Exit application\n");
-    printf("\n\n");
-    
-    // parse first arg to try and locate resources
-    resourceRoot = string(argv[0]).substr(0, string(argv[0]).find_last_of("/\\") + 1);
-    
-    
-    //-----------------------------------------------------------------------
-    // 3D - SCENEGRAPH
-    //-----------------------------------------------------------------------
-    
-    // create a new world.
-    world = new cWorld();
-    
-    // set the background color of the environment
-    // the color is defined by its (R,G,B) components.
-    world->setBackgroundColor(0.15, 0.15, 0.15);
-    
-    // create a camera and insert it into the virtual world
-    camera = new cCamera(world);
-    world->addChild(camera);
-    
-    // position and oriente the camera
-    camera->set(cVector3d(3.0, 0.0, 0.0),    // camera position (eye)
-                cVector3d(0.0, 0.0, 0.0),    // lookat position (target)
-                cVector3d(0.0, 0.0, 1.0));   // direction of the "up" vector
-    
-    // set the near and far clipping planes of the camera
-    // anything in front/behind these clipping planes will not be rendered
-    camera->setClippingPlanes(0.01, 10.0);
-    
-    // create a light source and attach it to the camera
-    light = new cLight(world);
-    camera->addChild(light);                   // attach light to camera
-    light->setEnabled(true);                   // enable light source
-    light->setPos(cVector3d(2.0, 0.5, 1.0));  // position the light source
-    light->setDir(cVector3d(-2.0, 0.5, 1.0));  // define the direction of the light beam
-    
-    
-    //-----------------------------------------------------------------------
-    // 2D - WIDGETS
-    //-----------------------------------------------------------------------
-    
-    // create a 2D bitmap logo
-    logo = new cBitmap();
-    
-    // add logo to the front plane
-    camera->m_front_2Dscene.addChild(logo);
-    
-    // load a "chai3d" bitmap image file
-    bool fileload;
-    fileload = logo->m_image.loadFromFile(RESOURCE_PATH("resources/images/chai3d.bmp"));
-    if (!fileload)
-    {
-#if defined(_MSVC)
-        fileload = logo->m_image.loadFromFile("../../../bin/resources/images/chai3d.bmp");
-#endif
-    }
-    
-    // position the logo at the bottom left of the screen (pixel coordinates)
-    logo->setPos(10, 10, 0);
-    
-    // scale the logo along its horizontal and vertical axis
-    logo->setZoomHV(0.4, 0.4);
-    
-    // here we replace all wite pixels (1,1,1) of the logo bitmap
-    // with transparent black pixels (1, 1, 1, 0). This allows us to make
-    // the background of the logo look transparent.
-    logo->m_image.replace(
-                          cColorb(0x00, 0x00, 0x00),      // original RGB color
-                          cColorb(0x00, 0x00, 0x00, 0x00) // new RGBA color
-                          );
-    
-    // enable transparency
-    logo->enableTransparency(true);
-    
-    
-    //-----------------------------------------------------------------------
-    // HAPTIC DEVICES / TOOLS
-    //-----------------------------------------------------------------------
-    
-    // create a haptic device handler
-    handler = new cHapticDeviceHandler();
-    
-    // get access to the first available haptic device
-    cGenericHapticDevice* hapticDevice;
-    handler->getDevice(hapticDevice, 0);
-    
-    // retrieve information about the current haptic device
-    cHapticDeviceInfo info;
-    if (hapticDevice)
-    {
-        info = hapticDevice->getSpecifications();
-    }
-    
-    // create a 3D tool and add it to the world
-    tool = new cGeneric3dofPointer(world);
-    world->addChild(tool);
-    
-    // connect the haptic device to the tool
-    tool->setHapticDevice(hapticDevice);
-    
-    // initialize tool by connecting to haptic device
-    tool->start();
-    
-    // map the physical workspace of the haptic device to a larger virtual workspace.
-    tool->setWorkspaceRadius(1.2);
-    
-    // define a radius for the tool (graphical display)
-    tool->setRadius(0.05);
-    
-    // hide the device sphere. only show proxy.
-    tool->m_deviceSphere->setShowEnabled(false);
-    
-    // set the physical readius of the proxy.
-    proxyRadius = 0.1;
-    tool->m_proxyPointForceModel->setProxyRadius(proxyRadius);
-    
-    // enable if objects in the scene are going to rotate of translate
-    // or possibly collide against the tool. If the environment
-    // is entirely static, you can set this parameter to "false"
-    tool->m_proxyPointForceModel->m_useDynamicProxy = true;
-    
-    // read the scale factor between the physical workspace of the haptic
-    // device and the virtual workspace defined for the tool
-    double workspaceScaleFactor = tool->getWorkspaceScaleFactor();
-    
-    // define a maximum stiffness that can be handled by the current
-    // haptic device. The value is scaled to take into account the
-    // workspace scale factor
-    double stiffnessMax = info.m_maxForceStiffness / workspaceScaleFactor;
-    
-    
-    //-----------------------------------------------------------------------
-    // COMPOSE THE VIRTUAL SCENE
-    //-----------------------------------------------------------------------
-    
-    // create a plane as mesh
-    plane = new cMesh(world);
-    world->addChild(plane);
-    
-    // create two Triangles in plane
-    plane->newTriangle(cVector3d(1,-1,-0.5), cVector3d(1, 1, -0.5), cVector3d(-1, -1, -0.5));
-    plane->newTriangle(cVector3d(1, 1, -0.5), cVector3d(-1, 1, -0.5), cVector3d(-1, -1, -0.5));
-    
-    // setup collision detector
-    plane->createAABBCollisionDetector(0.05, true, false);
-    
-    s[0] = new cShapeSphere(0.05);
-    world->addChild(s[0]);
-    s[1] = new cShapeSphere(0.05);
-    world->addChild(s[1]);
-    s[2] = new cShapeSphere(0.05);
-    world->addChild(s[2]);
-    
-    if (randomInitPos) {
-        for (int i = 0;i < 3;i++) {
-            s[i]->setPos((140.0 * rand() / RAND_MAX) / 100.0 - 0.7,
-                         (140.0 * rand() / RAND_MAX) / 100.0 - 0.7, 0.5);
-            s_pos[i] = s[i]->getPos();
-        }
-    }
-    else {
-        s[0]->setPos(-0.5, 0, 0.5);
-        s[1]->setPos(0, 0.4, 0.5);
-        s[2]->setPos(0, -0.3, 0.5);
-        
-        s_pos[0] = s[0]->getPos();
-        s_pos[1] = s[1]->getPos();
-        s_pos[2] = s[2]->getPos();
-    }
-    
-    l[0] = new cShapeLine(s_pos[0], s_pos[1]);
-    world->addChild(l[0]);
-    l[1] = new cShapeLine(s_pos[0], s_pos[2]);
-    world->addChild(l[1]);
-    l[2] = new cShapeLine(s_pos[1], s_pos[2]);
-    world->addChild(l[2]);
-    
-    std::cout << "s_pos[0]: " << s_pos[0] << std::endl;
-    std::cout << "s_pos[1]: " << s_pos[1] << std::endl;
-    std::cout << "s_pos[2]: " << s_pos[2] << std::endl;
-    
-    para[0] = m;
-    para[1] = restLength;
-    para[2] = SPRING_C;
-    para[3] = DAMPING_C_z;
-    para[4] = DAMPING_G;
-    
-    //-----------------------------------------------------------------------
-    // OPEN GL - WINDOW DISPLAY
-    //-----------------------------------------------------------------------
-    
-    // initialize GLUT
-    glutInit(&argc, argv);
-    
-    // retrieve the resolution of the computer display and estimate the position
-    // of the GLUT window so that it is located at the center of the screen
-    int screenW = glutGet(GLUT_SCREEN_WIDTH);
-    int screenH = glutGet(GLUT_SCREEN_HEIGHT);
-    int windowPosX = (screenW - WINDOW_SIZE_W) / 2;
-    int windowPosY = (screenH - WINDOW_SIZE_H) / 2;
-    
-    // initialize the OpenGL GLUT window
-    glutInitWindowPosition(windowPosX, windowPosY);
-    glutInitWindowSize(WINDOW_SIZE_W, WINDOW_SIZE_H);
-    glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH | GLUT_DOUBLE);
-    glutCreateWindow(argv[0]);
-    glutDisplayFunc(updateGraphics);
-    glutKeyboardFunc(keySelect);
-    glutReshapeFunc(resizeWindow);
-    glutSetWindowTitle("CHAI 3D");
-    
-    // create a mouse menu (right button)
-    glutCreateMenu(menuSelect);
-    glutAddMenuEntry("full screen", OPTION_FULLSCREEN);
-    glutAddMenuEntry("window display", OPTION_WINDOWDISPLAY);
-    glutAttachMenu(GLUT_RIGHT_BUTTON);
-    
-    
-    //-----------------------------------------------------------------------
-    // START SIMULATION
-    //-----------------------------------------------------------------------
-    
-    // simulation in now running
-    simulationRunning = true;
-    
-    // create a thread which starts the main haptics rendering loop
-    cThread* hapticsThread = new cThread();
-    hapticsThread->set(updateHaptics, CHAI_THREAD_PRIORITY_HAPTICS);
-    
-    // start the main graphics rendering loop
-    glutMainLoop();
-    
-    // close everything
-    close();
-    
-    // exit
-    return (0);
-}
-
-//---------------------------------------------------------------------------
-
-void resizeWindow(int w, int h)
-{
-    // update the size of the viewport
-    displayW = w;
-    displayH = h;
-    glViewport(0, 0, displayW, displayH);
-}
-
-//---------------------------------------------------------------------------
-
-void keySelect(unsigned char key, int x, int y)
-{
-    // escape key
-    if ((key == 27) || (key == 'x'))
-    {
-        // close everything
-        close();
-        
-        // exit application
-        exit(0);
-    }
-    
-    if (key == '2')
-    {
-        randomInitPos = !randomInitPos;
-        if(randomInitPos){
-            std::cout << "random start mode on " << std::endl;
-        }
-        else {
-            std::cout << "random start mode off " << std::endl;
-        }
-        
-    }
-    
-    if (key == '1')
-    {
-        close();
-        for (int i = 0;i < 3;i++){
-            v[i].zero();
-            s_pos[i].zero();
-        }
-        
-        if (randomInitPos) {
-            for (int i = 0;i < 3;i++) {
-                s[i]->setPos((140.0 * rand() / RAND_MAX) / 100.0 - 0.7,
-                             (140.0 * rand() / RAND_MAX) / 100.0 - 0.7, 0.5);
-                s_pos[i] = s[i]->getPos();
-            }
-        }
-        else {
-            s[0]->setPos(-0.5, 0, 0.5);
-            s[1]->setPos(0, 0.4, 0.5);
-            s[2]->setPos(0, -0.3, 0.5);
-            
-            s_pos[0] = s[0]->getPos();
-            s_pos[1] = s[1]->getPos();
-            s_pos[2] = s[2]->getPos();
-        }
-        std::cout << "pos[0]: " << s_pos[0] << std::endl;
-        std::cout << "pos[1]: " << s_pos[1] << std::endl;
-        std::cout << "pos[2]: " << s_pos[2] << std::endl;
-        
-        simulationRunning = true;
-        
-        // create a thread which starts the main haptics rendering loop
-        cThread* hapticsThread = new cThread();
-        hapticsThread->set(updateHaptics, CHAI_THREAD_PRIORITY_HAPTICS);
-        
-        // start the main graphics rendering loop
-        glutMainLoop();
-        
-        // close everything
-        close();
-        
-    }
-    if (key == '9')
-    {
-        switch (i + 1)
-        {
-            case 1:
-                std::cout << "m: " << m << std::endl;
-                para[i] = para[i] + 20;
-                m = para[i];
-                break;
-            case 2:
-                std::cout << "restLength: " << restLength << std::endl;
-                para[i] = para[i] + 0.1;
-                restLength = para[i];
-                break;
-            case 3:
-                std::cout << "SPRING_C: " << SPRING_C << std::endl;
-                para[i] = para[i] + 50;
-                SPRING_C = para[i];
-                break;
-            case 4:
-                std::cout << "DAMPING_C_z: " << DAMPING_C_z << std::endl;
-                para[i] = para[i] + 0.05;
-                DAMPING_C_z = para[i];
-                break;
-            case 5:
-                std::cout << "DAMPING_C: " << DAMPING_G << std::endl;
-                para[i] = para[i] + 0.05;
-                DAMPING_G = para[i];
-                break;
-                
-                
-        }
-        
-        
-    }
-    if (key == '0')
-    {
-        switch(i+1)
-        {
-            case 1:
-                std::cout << "m: " << m << std::endl;
-                para[i] = para[i] -20;
-                m = para[i];
-                break;
-            case 2:
-                std::cout << "restLength: " << restLength << std::endl;
-                para[i] = para[i] - 0.1;
-                restLength = para[i];
-                break;
-            case 3:
-                std::cout << "SPRING_C: " << SPRING_C << std::endl;
-                para[i] = para[i] - 50;
-                SPRING_C = para[i];
-                break;
-            case 4:
-                std::cout << "DAMPING_C_z: " << DAMPING_C_z << std::endl;
-                para[i] = para[i] - 0.05;
-                DAMPING_C_z = para[i];
-                break;
-            case 5:
-                std::cout << "DAMPING_C: " << DAMPING_G << std::endl;
-                para[i] = para[i] - 0.05;
-                DAMPING_G = para[i];
-                break;
-                
-                
-        }
-        
-        
-    }
-    
-    if (key == ' ')
-    {
-        i = (++i ) % 5;
-        std::cout << "i: " << i << std::endl;
-        switch (i+1)
-        {
-                
-            case 1:
-                std::cout << "m: " << m << std::endl;
-                break;
-            case 2:
-                std::cout << "restLength: " << restLength << std::endl;
-                break;
-            case 3:
-                std::cout << "SPRING_C: " << SPRING_C << std::endl;
-                break;
-            case 4:
-                std::cout << "DAMPING_C_z: " << DAMPING_C_z << std::endl;
-                break;
-            case 5:
-                std::cout << "DAMPING_C: " << DAMPING_G << std::endl;
-                break;
-        }
-        
-    }
-}
-
-//---------------------------------------------------------------------------
-
-void menuSelect(int value)
-{
-    switch (value)
-    {
-            // enable full screen display
-        case OPTION_FULLSCREEN:
-            glutFullScreen();
-            break;
-            
-            // reshape window to original size
-        case OPTION_WINDOWDISPLAY:
-            glutReshapeWindow(WINDOW_SIZE_W, WINDOW_SIZE_H);
-            break;
-    }
-}
-
-//---------------------------------------------------------------------------
-
-void close(void)
-{
-    // stop the simulation
-    simulationRunning = false;
-    
-    // wait for graphics and haptics loops to terminate
-    while (!simulationFinished) { cSleepMs(100); }
-    
-    // close haptic device
-    tool->stop();
-}
-
-//---------------------------------------------------------------------------
-
-void updateGraphics(void)
-{
-    // render world
-    camera->renderView(displayW, displayH);
-    
-    // Swap buffers
-    glutSwapBuffers();
-    
-    // check for any OpenGL errors
-    GLenum err;
-    err = glGetError();
-    if (err != GL_NO_ERROR) printf("Error:  %s\n", gluErrorString(err));
-    
-    // inform the GLUT window to call updateGraphics again (next frame)
-    if (simulationRunning)
-    {
-        glutPostRedisplay();
-    }
-}
-
-//---------------------------------------------------------------------------
-
-void updateHaptics(void)
-{
-    //pararestrict();
-    // reset clock
-    simClock.reset();
-    
-    // main haptic simulation loop
-    while (simulationRunning)
-    {
-        // stop the simulation clock
-        simClock.stop();
-        
-        // read the time increment in seconds
-        double timeInterval = simClock.getCurrentTimeSeconds();
-        
-        // restart the simulation clock
-        simClock.reset();
-        simClock.start();
-        
-        //calculate distance between 3 balls
-        cVector3d dis0 = s_pos[1] - s_pos[0];
-        cVector3d dis1 = s_pos[2] - s_pos[0];
-        cVector3d dis2 = s_pos[2] - s_pos[1];
-        
-        //compare the distance with restlength
-        double sub0 = dis0.length() - restLength;
-        double sub1 = dis1.length() - restLength;
-        double sub2 = dis2.length() - restLength;
-        
-        //normalize the distance vecter to get the direction
-        dis0.normalize();
-        dis1.normalize();
-        dis2.normalize();
-        
-        //update velocity of s0-------------------------------------------------------
-        
-        v[0].add(timeInterval*(g + dis0*SPRING_C*sub0 + dis1*SPRING_C*sub1)/m);
-        s_pos[0].z = s_pos[0].z + v[0].z*timeInterval;
-        s_pos[0].y = s_pos[0].y + v[0].y*timeInterval;
-        s_pos[0].x = s_pos[0].x + v[0].x*timeInterval;
-        
-        s[0]->setPos(s_pos[0]);
-        
-        updateVafterCollision(0);
-        
-        // update velocity of s1--------------------------------------------------------
-        
-        
-        v[1].add(timeInterval*(g - dis0*SPRING_C*sub0 + dis2*SPRING_C*sub2)/m);
-        s_pos[1].z = s_pos[1].z + v[1].z*timeInterval;
-        s_pos[1].y = s_pos[1].y + v[1].y*timeInterval;
-        s_pos[1].x = s_pos[1].x + v[1].x*timeInterval;
-        
-        s[1]->setPos(s_pos[1]);
-        
-        updateVafterCollision(1);
-        
-        //update velocity of s2----------------------------------------------------
-        
-        
-        v[2].add(timeInterval*(g - dis1*SPRING_C*sub1 - dis2*SPRING_C*sub2)/m);
-        s_pos[2].z = s_pos[2].z + v[2].z*timeInterval;
-        s_pos[2].y = s_pos[2].y + v[2].y*timeInterval;
-        s_pos[2].x = s_pos[2].x + v[2].x*timeInterval;
-        
-        s[2]->setPos(s_pos[2]);
-        
-        updateVafterCollision(2);
-        
-        //update spring position
-        l[0]->m_pointA = s_pos[0];
-        l[0]->m_pointB = s_pos[1];
-        l[1]->m_pointA = s_pos[0];
-        l[1]->m_pointB = s_pos[2];
-        l[2]->m_pointA = s_pos[1];
-        l[2]->m_pointB = s_pos[2];
-        
-        //apply damping
-        v[0].mul(1.0 - DAMPING_G * timeInterval);
-        v[1].mul(1.0 - DAMPING_G * timeInterval);
-        v[2].mul(1.0 - DAMPING_G * timeInterval);
-        
-        
-    }
-    
-    // exit haptics thread
-    simulationFinished = true;
-}
-
-//---------------------------------------------------------------------------
-
-void updateVafterCollision(int i)
-{
-    if(s[i]->getPos().z > -0.475)
-    {
-        cCollisionRecorder *recorder = new cCollisionRecorder();
-        cCollisionSettings *setting = new cCollisionSettings();
-        bool collision = plane->getCollisionDetector()->
-        computeCollision(cVector3d(0, 0, 0), cVector3d(s[i]->getPos().x,
-                                                       s[i]->getPos().y, s[i]->getPos().z - 0.05), *recorder, *setting);
-        if (collision)
-        {
-            // change the z axis velocity to positive 
-            double v_z = v[i].z * (-DAMPING_C_z);
-            v[i] = cVector3d(v[i].x, v[i].y, v_z);
-        }
-    }
-    else {
-        s[i]->setPos(s[i]->getPos().x,
-                     s[i]->getPos().y, -0.475);
-        
-    }
-    
-    
-}
-
-//---------------------------------------------------------------------------
-
-/*
- void pararestrict(void) 
- {
-	//for m
-	if (para[0] < 0) 
-	{
- para[0] = 0;
-	};
-	//for restLength
-	if (para[1] < 0.1)
-	{
- para[1] = 0.1;
-	};
-	//for SPRING_C
-	if (para[2] < 0)
-	{
- para[2] = 0;
-	};
-	// for DAMPING_C_z
-	if (para[3] < 0)
-	{
- para[3] = 0;
-	};
-	// for DAMPING_C_z
-	if (para[3] > 1)
-	{
- para[3] = 1;
-	};
-	// for DAMPING_C
-	if (para[4] < 0)
-	{
- para[4] = 0;
-	};
-	// for DAMPING_C
-	if (para[4] > 1)
-	{
- para[4] = 1;
-	};
-	
+//===========================================================================
+/*
+ This file is part of the CHAI 3D visualization and haptics libraries.
+ Copyright (C) 2003-2009 by CHAI 3D. All rights reserved.
+ 
+ This library is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License("GPL") version 2
+ as published by the Free Software Foundation.
+ 
+ For using the CHAI 3D libraries with software that can not be combined
+ with the GNU GPL, and for taking advantage of the additional benefits
+ of our support services, please contact CHAI 3D about acquiring a
+ Professional Edition License.
+ 
+ \author    <http://www.chai3d.org>
+ \author    Francois Conti
+ \version   2.0.0 $Rev: 269 $
+ */
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include <assert.h>
+#include <atomic>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+//---------------------------------------------------------------------------
+#include "ParticleSystem/CParticleSimulation.h"
+#include "ParticleSystem/CMultiRateScheduler.h"
+#include "ParticleSystem/CAdaptiveTimestep.h"
+#include "ParticleSystem/CParticleRenderNode.h"
+#include "ParticleSystem/CTriangleScene.h"
+#include "ParticleSystem/CLoopProfiler.h"
+#include "ParticleSystem/CTrajectoryRecorder.h"
+#include "ParticleSystem/CTrajectoryPlayer.h"
+#include "ParticleSystem/CParticleCheckpoint.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// DECLARED CONSTANTS
+//---------------------------------------------------------------------------
+
+// initial size (width/height) in pixels of the display window
+const int WINDOW_SIZE_W = 600;
+const int WINDOW_SIZE_H = 600;
+
+// mouse menu options (right button)
+const int OPTION_FULLSCREEN = 1;
+const int OPTION_WINDOWDISPLAY = 2;
+
+// number of particles in the scene
+const int NUM_PARTICLES = C_TRIANGLE_SCENE_PARTICLES;
+
+// rates [Hz] selectable for the fixed timestep mode; below SERVO_RATE
+// the physics states are interpolated, above it they are substeps
+const double STEP_RATES[] = { 250.0, 500.0, 1000.0, 4000.0, 10000.0 };
+const int NUM_STEP_RATES = 5;
+const int DEFAULT_STEP_RATE = 2;
+
+// rates [Hz] of the device servo loop and of the display
+const double SERVO_RATE = 1000.0;
+const double RENDER_RATE = 60.0;
+
+// maximum number of physics steps taken in one pass of the haptics loop
+const unsigned int MAX_SUBSTEPS = 10;
+
+// threads running the particle step (0: one per core)
+const unsigned int NUM_SIM_THREADS = 0;
+
+// number of adjustable parameters (see para[])
+const int NUM_PARAMETERS = 5;
+
+// smallest mass the keyboard can set; particles pinned by a zero mass stay put
+const double MIN_MASS = 1.0;
+
+// change of each parameter per press of '9' or '0'
+const double PARAMETER_STEPS[NUM_PARAMETERS] = { 20.0, 0.1, 50.0, 0.05, 0.05 };
+
+// trajectory file, keeping the last RECORD_CAPACITY steps (60 s at 1 kHz)
+const char RECORD_FILENAME[] = "particles.ptrj";
+const unsigned long long RECORD_CAPACITY = 60000;
+
+// a checkpoint enters the rewind history every CHECKPOINT_INTERVAL steps,
+// which keeps the last CHECKPOINT_HISTORY of them (60 s at 1 kHz)
+const unsigned int CHECKPOINT_INTERVAL = 100;
+const unsigned int CHECKPOINT_HISTORY = 600;
+
+//---------------------------------------------------------------------------
+// DECLARED VARIABLES
+//---------------------------------------------------------------------------
+
+// a world that contains all objects of the virtual environment
+cWorld* world;
+
+// a camera that renders the world in a window display
+cCamera* camera;
+
+// a light source to illuminate the objects in the virtual scene
+cLight *light;
+
+// a little "chai3d" bitmap logo at the bottom of the screen
+cBitmap* logo;
+
+// width and height of the current window display
+int displayW = 0;
+int displayH = 0;
+
+// a haptic device handler
+cHapticDeviceHandler* handler;
+
+// a virtual tool representing the haptic device in the scene
+cGeneric3dofPointer* tool;
+
+// radius of the tool proxy
+double proxyRadius;
+
+//collision plane with sphere
+cMesh* plane;
+
+// mass-spring system: particles, springs and integrator
+cParticleSimulation sim;
+
+// worker threads shared by the force, integration and collision loops
+cTaskPool* taskPool;
+
+// positions, velocities, forces and masses of all particles
+cParticleArrays& particles = sim.m_particles;
+
+// springs connecting the particles
+cSpringTable& springs = sim.m_springs;
+
+// draws every particle and spring from the published snapshots
+cParticleRenderNode* particleNode;
+
+//default parameters (springs take restLength and SPRING_C when created
+//or when the parameters are changed from the keyboard)
+double para[NUM_PARAMETERS];
+double m = 10;
+double restLength = 0.5;
+double SPRING_C = 100;
+double DAMPING_C_z = 0.9;
+double DAMPING_G = 0.6;
+int i;
+
+// status of the main simulation haptics loop
+bool simulationRunning = false;
+
+// simulation clock
+cPrecisionClock simClock;
+
+// paces the servo loop, the physics and the display, with statistics for each
+cMultiRateScheduler scheduler(SERVO_RATE, STEP_RATES[DEFAULT_STEP_RATE], RENDER_RATE);
+
+// records every step to RECORD_FILENAME; opened and closed by the haptics thread
+cTrajectoryRecorder recorder;
+
+// recording requested from the keyboard
+bool recordTrajectory = false;
+
+// plays RECORD_FILENAME back; opened and closed by the haptics thread
+cTrajectoryPlayer player;
+
+// replay requested from the keyboard, paused, and pending seeks
+bool replayTrajectory = false;
+bool replayPaused = false;
+std::atomic<double> replaySeek(0.0);
+std::atomic<int> replayStepFrames(0);
+
+// replay position: simulated time and frame on screen
+double replayTime = 0.0;
+unsigned long long replayFrame = 0;
+
+// state saved from the keyboard, and the rewind history; haptics thread only
+cParticleCheckpoint savedCheckpoint;
+cParticleCheckpoint historyCheckpoint;
+cCheckpointHistory checkpointHistory(CHECKPOINT_HISTORY);
+
+// restart, save, restore and rewind [s] requested from the keyboard
+std::atomic<bool> restartRequested(false);
+std::atomic<bool> saveRequested(false);
+std::atomic<bool> restoreRequested(false);
+std::atomic<double> rewindRequested(0.0);
+
+// integrate with a fixed timestep instead of the measured clock interval
+bool useFixedTimestep = true;
+
+// let resting particles fall asleep; parameter changes wake them up
+bool sleepEnabled = true;
+
+// parameter changes requested from the keyboard, taken by the haptics thread
+std::atomic<double> parameterRequested[NUM_PARAMETERS];
+
+// switch to the next integrator, requested from the keyboard
+std::atomic<bool> integratorRequested(false);
+
+// selected entry of STEP_RATES; applied by the haptics thread
+int stepRateIndex = DEFAULT_STEP_RATE;
+
+// positions before the last physics step, for interpolation
+cParticleSnapshot previousFrame;
+
+// size the steps by error control instead; overrides the fixed timestep
+bool useAdaptiveTimestep = false;
+cAdaptiveTimestep adaptiveStep;
+
+// root resource path
+string resourceRoot;
+
+// has exited haptics simulation thread
+bool simulationFinished = false;
+
+// set a random Inital Position
+bool randomInitPos = false;
+
+//---------------------------------------------------------------------------
+// DECLARED MACROS
+//---------------------------------------------------------------------------
+// convert to resource path
+#define RESOURCE_PATH(p)    (char*)((resourceRoot+string(p)).c_str())
+
+
+//---------------------------------------------------------------------------
+// DECLARED FUNCTIONS
+//---------------------------------------------------------------------------
+
+// callback when the window display is resized
+void resizeWindow(int w, int h);
+
+// callback when a keyboard key is pressed
+void keySelect(unsigned char key, int x, int y);
+
+// callback when the right mouse button is pressed to select a menu item
+void menuSelect(int value);
+
+// function called before exiting the application
+void close(void);
+
+// main graphics callback
+void updateGraphics(void);
+
+// main haptics loop
+void updateHaptics(void);
+
+//constrains of parameters
+void pararestrict(void);
+
+//place the particles at their initial positions
+void resetParticles(void);
+
+//advance the particle system by one step of dt seconds
+void stepParticles(double dt);
+
+//advance the particle system by one step sized by adaptiveStep
+void stepParticlesAdaptive(void);
+
+//record the step just taken and keep it for rewinding
+void storeStep(void);
+
+//advance the replay by dt seconds and publish the frame due
+void replayParticles(double dt);
+
+//serve the restart and checkpoint requests made from the keyboard
+void serveCheckpoints(void);
+
+//apply the parameter and integrator changes requested from the keyboard
+void serveParameters(void);
+
+//add a_value to a request that the haptics thread takes with exchange()
+void addRequest(std::atomic<double>& a_request, double a_value);
+//===========================================================================
+/*
+ DEMO:    polygons.cpp
+ 
+ This example illustrates how to build an object composed of triangle
+ with individual colors. A finger-proxy algorithm is used to compute
+ the interaction force between the tool and the object.
+ */
+//===========================================================================
+
+int main(int argc, char* argv[])
+{
+    //-----------------------------------------------------------------------
+    // INITIALIZATION
+    //-----------------------------------------------------------------------
+    
+    printf("\n");
+    printf("-----------------------------------\n");
+    printf("CHAI 3D\n");
+    printf("Demo: 12-polygons\n");
+    printf("Copyright 2003-2009\n");
+    printf("-----------------------------------\n");
+    printf("\n\n");
+    printf("Keyboard Options:\n\n");
+    printf("[1] - restart\n");
+    printf("[2] - select start mode\n");
+    printf("[3] - toggle fixed timestep\n");
+    printf("[4] - select fixed step rate\n");
+    printf("[5] - select integrator\n");
+    printf("[6] - toggle sleeping of resting particles\n");
+    printf("[7] - toggle adaptive timestep\n");
+    printf("[p] - print haptics loop latency\n");
+    printf("[r] - start/stop recording trajectories\n");
+    printf("[l] - start/stop replaying the recording\n");
+    printf("[k] - pause/resume the replay\n");
+    printf("[[] - replay: back 1 s      []] - replay: forward 1 s\n");
+    printf("[,] - replay: previous step [.] - replay: next step\n");
+    printf("[c] - save checkpoint       [v] - restore checkpoint\n");
+    printf("[b] - rewind 1 s\n");
+    printf("[9] - increase parameters\n");
+    printf("[0] - decrease parameters\n");
+    printf("[x] - Exit application\n");
+    printf("\n\n");
+    
+    // parse first arg to try and locate resources
+    resourceRoot = string(argv[0]).substr(0, string(argv[0]).find_last_of("/\\") + 1);
+    
+    
+    //-----------------------------------------------------------------------
+    // 3D - SCENEGRAPH
+    //-----------------------------------------------------------------------
+    
+    // create a new world.
+    world = new cWorld();
+    
+    // set the background color of the environment
+    // the color is defined by its (R,G,B) components.
+    world->setBackgroundColor(0.15, 0.15, 0.15);
+    
+    // create a camera and insert it into the virtual world
+    camera = new cCamera(world);
+    world->addChild(camera);
+    
+    // position and oriente the camera
+    camera->set(cVector3d(3.0, 0.0, 0.0),    // camera position (eye)
+                cVector3d(0.0, 0.0, 0.0),    // lookat position (target)
+                cVector3d(0.0, 0.0, 1.0));   // direction of the "up" vector
+    
+    // set the near and far clipping planes of the camera
+    // anything in front/behind these clipping planes will not be rendered
+    camera->setClippingPlanes(0.01, 10.0);
+    
+    // create a light source and attach it to the camera
+    light = new cLight(world);
+    camera->addChild(light);                   // attach light to camera
+    light->setEnabled(true);                   // enable light source
+    light->setPos(cVector3d(2.0, 0.5, 1.0));  // position the light source
+    light->setDir(cVector3d(-2.0, 0.5, 1.0));  // define the direction of the light beam
+    
+    
+    //-----------------------------------------------------------------------
+    // 2D - WIDGETS
+    //-----------------------------------------------------------------------
+    
+    // create a 2D bitmap logo
+    logo = new cBitmap();
+    
+    // add logo to the front plane
+    camera->m_front_2Dscene.addChild(logo);
+    
+    // load a "chai3d" bitmap image file
+    bool fileload;
+    fileload = logo->m_image.loadFromFile(RESOURCE_PATH("resources/images/chai3d.bmp"));
+    if (!fileload)
+    {
+#if defined(_MSVC)
+        fileload = logo->m_image.loadFromFile("../../../bin/resources/images/chai3d.bmp");
+#endif
+    }
+    
+    // position the logo at the bottom left of the screen (pixel coordinates)
+    logo->setPos(10, 10, 0);
+    
+    // scale the logo along its horizontal and vertical axis
+    logo->setZoomHV(0.4, 0.4);
+    
+    // here we replace all wite pixels (1,1,1) of the logo bitmap
+    // with transparent black pixels (1, 1, 1, 0). This allows us to make
+    // the background of the logo look transparent.
+    logo->m_image.replace(
+                          cColorb(0x00, 0x00, 0x00),      // original RGB color
+                          cColorb(0x00, 0x00, 0x00, 0x00) // new RGBA color
+                          );
+    
+    // enable transparency
+    logo->enableTransparency(true);
+    
+    
+    //-----------------------------------------------------------------------
+    // HAPTIC DEVICES / TOOLS
+    //-----------------------------------------------------------------------
+    
+    // create a haptic device handler
+    handler = new cHapticDeviceHandler();
+    
+    // get access to the first available haptic device
+    cGenericHapticDevice* hapticDevice;
+    handler->getDevice(hapticDevice, 0);
+    
+    // retrieve information about the current haptic device
+    cHapticDeviceInfo info;
+    if (hapticDevice)
+    {
+        info = hapticDevice->getSpecifications();
+    }
+    
+    // create a 3D tool and add it to the world
+    tool = new cGeneric3dofPointer(world);
+    world->addChild(tool);
+    
+    // connect the haptic device to the tool
+    tool->setHapticDevice(hapticDevice);
+    
+    // initialize tool by connecting to haptic device
+    tool->start();
+    
+    // map the physical workspace of the haptic device to a larger virtual workspace.
+    tool->setWorkspaceRadius(1.2);
+    
+    // define a radius for the tool (graphical display)
+    tool->setRadius(0.05);
+    
+    // hide the device sphere. only show proxy.
+    tool->m_deviceSphere->setShowEnabled(false);
+    
+    // set the physical readius of the proxy.
+    proxyRadius = 0.1;
+    tool->m_proxyPointForceModel->setProxyRadius(proxyRadius);
+    
+    // enable if objects in the scene are going to rotate of translate
+    // or possibly collide against the tool. If the environment
+    // is entirely static, you can set this parameter to "false"
+    tool->m_proxyPointForceModel->m_useDynamicProxy = true;
+    
+    // read the scale factor between the physical workspace of the haptic
+    // device and the virtual workspace defined for the tool
+    double workspaceScaleFactor = tool->getWorkspaceScaleFactor();
+    
+    // define a maximum stiffness that can be handled by the current
+    // haptic device. The value is scaled to take into account the
+    // workspace scale factor
+    double stiffnessMax = info.m_maxForceStiffness / workspaceScaleFactor;
+    
+    
+    //-----------------------------------------------------------------------
+    // COMPOSE THE VIRTUAL SCENE
+    //-----------------------------------------------------------------------
+    
+    // create a plane as mesh
+    plane = new cMesh(world);
+    world->addChild(plane);
+    
+    // create two Triangles in plane
+    plane->newTriangle(cVector3d(1,-1,-0.5), cVector3d(1, 1, -0.5), cVector3d(-1, -1, -0.5));
+    plane->newTriangle(cVector3d(1, 1, -0.5), cVector3d(-1, 1, -0.5), cVector3d(-1, -1, -0.5));
+    
+    // setup collision detector
+    plane->createAABBCollisionDetector(0.05, true, false);
+    
+    // the particles, springs and the same square as analytic contact,
+    // shared with the headless tools
+    cTriangleSceneParameters sceneParameters;
+    sceneParameters.m_mass = m;
+    sceneParameters.m_restLength = restLength;
+    sceneParameters.m_stiffness = SPRING_C;
+    sceneParameters.m_restitution = DAMPING_C_z;
+    sceneParameters.m_drag = DAMPING_G;
+    cBuildTriangleScene(sim, sceneParameters);
+    
+    resetParticles();
+    
+    // a single node draws all particles and springs
+    particleNode = new cParticleRenderNode(&sim);
+    world->addChild(particleNode);
+    
+    para[0] = m;
+    para[1] = restLength;
+    para[2] = SPRING_C;
+    para[3] = DAMPING_C_z;
+    para[4] = DAMPING_G;
+    for (int k = 0;k < NUM_PARAMETERS;k++) { parameterRequested[k].store(0.0, std::memory_order_relaxed); }
+    
+    taskPool = new cTaskPool(NUM_SIM_THREADS);
+    sim.setTaskPool(taskPool);
+    std::cout << "simulation threads: " << taskPool->getNumThreads() << std::endl;
+    std::cout << "integrator: " << cGetParticleIntegratorName(sim.getIntegratorType()) << std::endl;
+    
+    //-----------------------------------------------------------------------
+    // OPEN GL - WINDOW DISPLAY
+    //-----------------------------------------------------------------------
+    
+    // initialize GLUT
+    glutInit(&argc, argv);
+    
+    // retrieve the resolution of the computer display and estimate the position
+    // of the GLUT window so that it is located at the center of the screen
+    int screenW = glutGet(GLUT_SCREEN_WIDTH);
+    int screenH = glutGet(GLUT_SCREEN_HEIGHT);
+    int windowPosX = (screenW - WINDOW_SIZE_W) / 2;
+    int windowPosY = (screenH - WINDOW_SIZE_H) / 2;
+    
+    // initialize the OpenGL GLUT window
+    glutInitWindowPosition(windowPosX, windowPosY);
+    glutInitWindowSize(WINDOW_SIZE_W, WINDOW_SIZE_H);
+    glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH | GLUT_DOUBLE);
+    glutCreateWindow(argv[0]);
+    glutDisplayFunc(updateGraphics);
+    glutKeyboardFunc(keySelect);
+    glutReshapeFunc(resizeWindow);
+    glutSetWindowTitle("CHAI 3D");
+    
+    // create a mouse menu (right button)
+    glutCreateMenu(menuSelect);
+    glutAddMenuEntry("full screen", OPTION_FULLSCREEN);
+    glutAddMenuEntry("window display", OPTION_WINDOWDISPLAY);
+    glutAttachMenu(GLUT_RIGHT_BUTTON);
+    
+    
+    //-----------------------------------------------------------------------
+    // START SIMULATION
+    //-----------------------------------------------------------------------
+    
+    // simulation in now running
+    simulationRunning = true;
+    
+    // create a thread which starts the main haptics rendering loop
+    cThread* hapticsThread = new cThread();
+    hapticsThread->set(updateHaptics, CHAI_THREAD_PRIORITY_HAPTICS);
+    
+    // start the main graphics rendering loop
+    glutMainLoop();
+    
+    // close everything
+    close();
+    
+    // exit
+    return (0);
+}
+
+//---------------------------------------------------------------------------
+
+void resizeWindow(int w, int h)
+{
+    // update the size of the viewport
+    displayW = w;
+    displayH = h;
+    glViewport(0, 0, displayW, displayH);
+}
+
+//---------------------------------------------------------------------------
+
+void keySelect(unsigned char key, int x, int y)
+{
+    // escape key
+    if ((key == 27) || (key == 'x'))
+    {
+        // close everything
+        close();
+        
+        // exit application
+        exit(0);
+    }
+    
+    if (key == '2')
+    {
+        randomInitPos = !randomInitPos;
+        if(randomInitPos){
+            std::cout << "random start mode on " << std::endl;
+        }
+        else {
+            std::cout << "random start mode off " << std::endl;
+        }
+        
+    }
+    
+    if (key == '1')
+    {
+        // the haptics thread puts the particles back on its next tick
+        replayTrajectory = false;
+        restartRequested.store(true, std::memory_order_relaxed);
+    }
+    if (key == '3')
+    {
+        useFixedTimestep = !useFixedTimestep;
+        if (useFixedTimestep) {
+            std::cout << "fixed timestep on (" << STEP_RATES[stepRateIndex] << " Hz)" << std::endl;
+        }
+        else {
+            std::cout << "fixed timestep off " << std::endl;
+        }
+    }
+    
+    if (key == '4')
+    {
+        stepRateIndex = (stepRateIndex + 1) % NUM_STEP_RATES;
+        std::cout << "fixed step rate: " << STEP_RATES[stepRateIndex] << " Hz"
+                  << ((STEP_RATES[stepRateIndex] < SERVO_RATE) ? " (interpolated)" : "") << std::endl;
+    }
+    
+    if (key == '5')
+    {
+        // the integrator is replaced by the haptics thread between two steps
+        integratorRequested.store(true, std::memory_order_relaxed);
+    }
+    
+    if (key == '6')
+    {
+        sleepEnabled = !sleepEnabled;
+        std::cout << "sleeping " << (sleepEnabled ? "on" : "off") << std::endl;
+    }
+    
+    if (key == '7')
+    {
+        useAdaptiveTimestep = !useAdaptiveTimestep;
+        if (useAdaptiveTimestep) {
+            std::cout << "adaptive timestep on " << std::endl;
+        }
+        else {
+            std::cout << "adaptive timestep off (" << adaptiveStep.getNumAcceptedSteps() << " accepted, "
+                      << adaptiveStep.getNumRejectedSteps() << " rejected steps)" << std::endl;
+        }
+    }
+    
+    if (key == 'p')
+    {
+        scheduler.print(stdout);
+    }
+    
+    if ((key == 'r') && replayTrajectory)
+    {
+        std::cout << "stop the replay before recording " << std::endl;
+    }
+    else if (key == 'r')
+    {
+        recordTrajectory = !recordTrajectory;
+        if (recordTrajectory) {
+            std::cout << "recording to " << RECORD_FILENAME << std::endl;
+        }
+        else {
+            std::cout << "recording off " << std::endl;
+        }
+    }
+    
+    if (key == 'l')
+    {
+        // the recorder would truncate the file being played
+        recordTrajectory = false;
+        replayTrajectory = !replayTrajectory;
+        replayPaused = false;
+        if (replayTrajectory) {
+            std::cout << "replaying " << RECORD_FILENAME << std::endl;
+        }
+        else {
+            std::cout << "replay off " << std::endl;
+        }
+    }
+    
+    if (key == 'k')
+    {
+        replayPaused = !replayPaused;
+    }
+    
+    if (((key == 'c') || (key == 'v') || (key == 'b')) && replayTrajectory)
+    {
+        std::cout << "stop the replay before using checkpoints " << std::endl;
+    }
+    else
+    {
+        if (key == 'c') { saveRequested.store(true, std::memory_order_relaxed); }
+        if (key == 'v') { restoreRequested.store(true, std::memory_order_relaxed); }
+        if (key == 'b') { addRequest(rewindRequested, 1.0); }
+    }
+    
+    if (key == '[') { addRequest(replaySeek, -1.0); }
+    if (key == ']') { addRequest(replaySeek, 1.0); }
+    if (key == ',') { replayStepFrames.fetch_sub(1, std::memory_order_relaxed); }
+    if (key == '.') { replayStepFrames.fetch_add(1, std::memory_order_relaxed); }
+    
+    if ((key == '9') || (key == '0'))
+    {
+        // the haptics thread applies the change between two steps
+        addRequest(parameterRequested[i], (key == '9') ? PARAMETER_STEPS[i] : -PARAMETER_STEPS[i]);
+    }
+    
+    if (key == ' ')
+    {
+        i = (++i ) % 5;
+        std::cout << "i: " << i << std::endl;
+        switch (i+1)
+        {
+                
+            case 1:
+                std::cout << "m: " << m << std::endl;
+                break;
+            case 2:
+                std::cout << "restLength: " << restLength << std::endl;
+                break;
+            case 3:
+                std::cout << "SPRING_C: " << SPRING_C << std::endl;
+                break;
+            case 4:
+                std::cout << "DAMPING_C_z: " << DAMPING_C_z << std::endl;
+                break;
+            case 5:
+                std::cout << "DAMPING_C: " << DAMPING_G << std::endl;
+                break;
+        }
+        
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void menuSelect(int value)
+{
+    switch (value)
+    {
+            // enable full screen display
+        case OPTION_FULLSCREEN:
+            glutFullScreen();
+            break;
+            
+            // reshape window to original size
+        case OPTION_WINDOWDISPLAY:
+            glutReshapeWindow(WINDOW_SIZE_W, WINDOW_SIZE_H);
+            break;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void close(void)
+{
+    // stop the simulation
+    simulationRunning = false;
+    
+    // wait for graphics and haptics loops to terminate
+    while (!simulationFinished) { cSleepMs(100); }
+    
+    // report the latency of the servo loop, the physics and the display
+    sim.setProfiler(NULL);
+    scheduler.print(stdout);
+    
+    // stop the simulation worker threads
+    sim.setTaskPool(NULL);
+    delete taskPool;
+    taskPool = NULL;
+    
+    // close haptic device
+    tool->stop();
+}
+
+//---------------------------------------------------------------------------
+
+void updateGraphics(void)
+{
+    // wait for the next frame at the display rate
+    scheduler.beginRenderFrame();
+    
+    // render world (particleNode takes the newest simulation frame)
+    camera->renderView(displayW, displayH);
+    
+    // Swap buffers
+    glutSwapBuffers();
+    scheduler.endRenderFrame();
+    
+    // check for any OpenGL errors
+    GLenum err;
+    err = glGetError();
+    if (err != GL_NO_ERROR) printf("Error:  %s\n", gluErrorString(err));
+    
+    // inform the GLUT window to call updateGraphics again (next frame)
+    if (simulationRunning)
+    {
+        glutPostRedisplay();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void updateHaptics(void)
+{
+    //pararestrict();
+    // reset clock
+    simClock.reset();
+    adaptiveStep.reset();
+    
+    // sim.step() charges the forces and collision phases of the physics
+    sim.setProfiler(&scheduler.getPhysicsProfiler());
+    cLoopProfiler& servoProfiler = scheduler.getServoProfiler();
+    scheduler.start();
+    
+    // main haptic simulation loop, one pass per servo tick
+    while (simulationRunning)
+    {
+        // apply the step rate selected from the keyboard
+        if (scheduler.getPhysicsRate() != STEP_RATES[stepRateIndex])
+        {
+            scheduler.setPhysicsRate(STEP_RATES[stepRateIndex]);
+        }
+        
+        // wait for the next servo tick; physicsSteps fixed steps are due
+        unsigned int physicsSteps = scheduler.beginServoTick();
+        
+        // compute global reference frames for each object
+        world->computeGlobalPositions(true);
+        
+        // read the position of the haptic device
+        tool->updatePose();
+        servoProfiler.endPhase(C_LOOP_PHASE_DEVICE_READ);
+        
+        // compute the interaction forces of the proxy
+        tool->computeInteractionForces();
+        servoProfiler.endPhase(C_LOOP_PHASE_COLLISION);
+        
+        // send the forces to the haptic device
+        tool->applyForces();
+        servoProfiler.endPhase(C_LOOP_PHASE_DEVICE_WRITE);
+        
+        // open or close the trajectory file as requested from the keyboard
+        if (recordTrajectory != recorder.isOpen())
+        {
+            if (!recordTrajectory)
+            {
+                recorder.close();
+            }
+            else if (!recorder.open(RECORD_FILENAME, NUM_PARTICLES, NUM_PARAMETERS,
+                                    RECORD_CAPACITY, true))
+            {
+                printf("cannot record to %s\n", RECORD_FILENAME);
+                recordTrajectory = false;
+            }
+        }
+        
+        // stop the simulation clock
+        simClock.stop();
+        
+        // read the time increment in seconds
+        double timeInterval = simClock.getCurrentTimeSeconds();
+        
+        // restart the simulation clock
+        simClock.reset();
+        simClock.start();
+        
+        // open or close the replay as requested from the keyboard
+        if (replayTrajectory != player.isOpen())
+        {
+            if (!replayTrajectory)
+            {
+                player.close();
+            }
+            else if (!player.open(RECORD_FILENAME))
+            {
+                printf("cannot replay %s\n", RECORD_FILENAME);
+                replayTrajectory = false;
+            }
+            else
+            {
+                replayTime = player.getFrameTime(0);
+                replayFrame = player.getNumFrames();
+            }
+        }
+        
+        // replaying: draw recorded frames, the physics is not run
+        if (player.isOpen())
+        {
+            replayParticles(timeInterval);
+            scheduler.endServoTick();
+            continue;
+        }
+        
+        // restart, save, restore or rewind between two steps
+        serveCheckpoints();
+        
+        // follow the sleeping settings of the keyboard
+        if (sim.m_islands.isEnabled() != sleepEnabled)
+        {
+            sim.m_islands.setEnabled(sleepEnabled);
+        }
+        
+        // parameters and integrator changed from the keyboard, also between two steps
+        serveParameters();
+        
+        bool interpolate = false;
+        if (useAdaptiveTimestep)
+        {
+            // take steps of the length chosen by the error control while they are due
+            adaptiveStep.addElapsed(scheduler.getServoPeriod());
+            if (adaptiveStep.isStepDue())
+            {
+                scheduler.beginPhysics();
+                unsigned int steps = 0;
+                while (adaptiveStep.isStepDue() && (steps < MAX_SUBSTEPS))
+                {
+                    stepParticlesAdaptive();
+                    steps++;
+                }
+                scheduler.endPhysics();
+            }
+        }
+        else if (useFixedTimestep)
+        {
+            // substeps of the servo tick, or the step of the lower physics rate when due
+            interpolate = scheduler.isPhysicsInterpolated();
+            if (physicsSteps > 0)
+            {
+                scheduler.beginPhysics();
+                for (unsigned int k = 0;k < physicsSteps;k++)
+                {
+                    if (interpolate) { sim.getSnapshot(previousFrame); }
+                    stepParticles(scheduler.getPhysicsTimeStep());
+                }
+                scheduler.endPhysics();
+            }
+        }
+        else
+        {
+            scheduler.beginPhysics();
+            stepParticles(timeInterval);
+            scheduler.endPhysics();
+        }
+        
+        // hand the new positions to the graphics thread; below the servo
+        // rate, positions are interpolated between the last two steps
+        if (interpolate)
+        {
+            sim.publishSnapshot(previousFrame, scheduler.getInterpolationFactor());
+        }
+        else
+        {
+            sim.publishSnapshot();
+        }
+        
+        scheduler.endServoTick();
+    }
+    
+    // a restart does not overwrite the recording
+    recorder.close();
+    recordTrajectory = false;
+    player.close();
+    replayTrajectory = false;
+    
+    // exit haptics thread
+    simulationFinished = true;
+}
+
+//---------------------------------------------------------------------------
+
+void stepParticles(double dt)
+{
+    //integrate springs, gravity and damping, then collide with the plane
+    sim.step(dt);
+    storeStep();
+}
+
+//---------------------------------------------------------------------------
+
+void stepParticlesAdaptive(void)
+{
+    // rejected steps are undone and retried shorter by the controller
+    adaptiveStep.step(sim);
+    storeStep();
+}
+
+//---------------------------------------------------------------------------
+
+void storeStep(void)
+{
+    // copy the new state into the trajectory file
+    if (recorder.isOpen())
+    {
+        recorder.record(particles, sim.getTime(), sim.getNumSteps(), para);
+    }
+    
+    // keep the state for rewinding; only the pages that changed are copied
+    if ((sim.getNumSteps() % CHECKPOINT_INTERVAL) == 0)
+    {
+        historyCheckpoint.save(sim, para, NUM_PARAMETERS);
+        checkpointHistory.push(historyCheckpoint);
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void replayParticles(double dt)
+{
+    unsigned long long lastFrame = player.getNumFrames() - 1;
+    double startTime = player.getFrameTime(0);
+    double endTime = player.getFrameTime(lastFrame);
+    
+    // pending seeks are taken and cleared at once, so no key press is lost
+    int stepFrames = replayStepFrames.exchange(0, std::memory_order_relaxed);
+    if (stepFrames != 0)
+    {
+        // single steps pause the replay on the frame reached
+        long long frame = (long long)((replayFrame > lastFrame) ? 0 : replayFrame) + stepFrames;
+        if (frame < 0) { frame = 0; }
+        if (frame > (long long)lastFrame) { frame = (long long)lastFrame; }
+        replayPaused = true;
+        replayTime = player.getFrameTime((unsigned long long)frame);
+    }
+    else
+    {
+        if (!replayPaused) { replayTime += dt; }
+        replayTime += replaySeek.exchange(0.0, std::memory_order_relaxed);
+        
+        // loop back to the start at the end of the recording
+        if ((replayTime > endTime) && !replayPaused) { replayTime = startTime; }
+        replayTime = cClamp(replayTime, startTime, endTime);
+    }
+    
+    // publish the frame due, as the simulation would
+    unsigned long long frame = player.findFrame(replayTime);
+    if (frame != replayFrame)
+    {
+        cParticleSnapshot& snapshot = sim.m_snapshots.getWriteBuffer();
+        player.readFrame(frame, snapshot);
+        sim.fillSnapshotTopology(snapshot);
+        sim.m_snapshots.publish();
+        replayFrame = frame;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void serveCheckpoints(void)
+{
+    bool restored = false;
+    
+    // every request is taken and cleared at once, so no key press is lost
+    if (restartRequested.exchange(false, std::memory_order_relaxed))
+    {
+        // same cost at any time: the scene is placed again, no thread is created
+        resetParticles();
+        sim.setClock(0.0, 0);
+        checkpointHistory.clear();
+        recorder.truncate(0.0);
+        scheduler.resetPhysicsClock();
+        adaptiveStep.reset();
+    }
+    
+    if (saveRequested.exchange(false, std::memory_order_relaxed))
+    {
+        savedCheckpoint.save(sim, para, NUM_PARAMETERS);
+        printf("checkpoint saved at %.3f s\n", sim.getTime());
+    }
+    
+    if (restoreRequested.exchange(false, std::memory_order_relaxed))
+    {
+        if (savedCheckpoint.restore(sim, para, NUM_PARAMETERS))
+        {
+            restored = true;
+        }
+        else
+        {
+            printf("no checkpoint saved\n");
+        }
+    }
+    
+    double rewind = rewindRequested.exchange(0.0, std::memory_order_relaxed);
+    if (rewind > 0.0)
+    {
+        double target = sim.getTime() - rewind;
+        if ((checkpointHistory.getNumCheckpoints() > 0) &&
+            checkpointHistory.get(checkpointHistory.findCheckpoint(target), historyCheckpoint) &&
+            historyCheckpoint.restore(sim, para, NUM_PARAMETERS))
+        {
+            restored = true;
+        }
+    }
+    
+    if (restored)
+    {
+        // the checkpoints after the restored state belong to another future
+        checkpointHistory.truncate(sim.getTime());
+        recorder.truncate(sim.getTime());
+        scheduler.resetPhysicsClock();
+        adaptiveStep.reset();
+        
+        m = para[0];
+        restLength = para[1];
+        SPRING_C = para[2];
+        DAMPING_C_z = para[3];
+        DAMPING_G = para[4];
+        printf("restored to %.3f s\n", sim.getTime());
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void addRequest(std::atomic<double>& a_request, double a_value)
+{
+    // the haptics thread may take the request between the load and the store
+    double value = a_request.load(std::memory_order_relaxed);
+    while (!a_request.compare_exchange_weak(value, value + a_value, std::memory_order_relaxed)) {}
+}
+
+//---------------------------------------------------------------------------
+
+void serveParameters(void)
+{
+    bool changed = false;
+    
+    if (integratorRequested.exchange(false, std::memory_order_relaxed))
+    {
+        // the old integrator is deleted, so never while a step runs
+        int type = (sim.getIntegratorType() + 1) % C_NUM_INTEGRATORS;
+        sim.setIntegrator((cParticleIntegratorType)type);
+        printf("integrator: %s\n", cGetParticleIntegratorName(sim.getIntegratorType()));
+    }
+    
+    for (int k = 0;k < NUM_PARAMETERS;k++)
+    {
+        // taken and cleared at once, so a key pressed meanwhile is kept for the next pass
+        double change = parameterRequested[k].exchange(0.0, std::memory_order_relaxed);
+        if (change == 0.0) { continue; }
+        para[k] = para[k] + change;
+        changed = true;
+        
+        switch (k + 1)
+        {
+            case 1:
+                if (para[k] < MIN_MASS) { para[k] = MIN_MASS; }
+                m = para[k];
+                particles.setUniformMass(m);
+                printf("m: %g\n", m);
+                break;
+            case 2:
+                restLength = para[k];
+                springs.setUniformRestLength(restLength);
+                printf("restLength: %g\n", restLength);
+                break;
+            case 3:
+                SPRING_C = para[k];
+                springs.setUniformStiffness(SPRING_C);
+                printf("SPRING_C: %g\n", SPRING_C);
+                break;
+            case 4:
+                DAMPING_C_z = para[k];
+                sim.m_contacts.setRestitution(DAMPING_C_z);
+                sim.m_particleRestitution = DAMPING_C_z;
+                printf("DAMPING_C_z: %g\n", DAMPING_C_z);
+                break;
+            case 5:
+                DAMPING_G = para[k];
+                sim.m_dragCoefficient = DAMPING_G;
+                printf("DAMPING_C: %g\n", DAMPING_G);
+                break;
+        }
+    }
+    
+    // masses and springs are not watched by the simulation
+    if (changed)
+    {
+        sim.wakeUp();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void resetParticles(void)
+{
+    cPlaceTriangleScene(sim, randomInitPos);
+    
+    // the render node follows on the next frame published by the haptics loop
+    for (int k = 0;k < NUM_PARTICLES;k++) {
+        std::cout << "pos[" << k << "]: "
+                  << cVector3d(particles.m_posX[k], particles.m_posY[k], particles.m_posZ[k]) << std::endl;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+/*
+ void pararestrict(void) 
+ {
+	//for m
+	if (para[0] < 0) 
+	{
+ para[0] = 0;
+	};
+	//for restLength
+	if (para[1] < 0.1)
+	{
+ para[1] = 0.1;
+	};
+	//for SPRING_C
+	if (para[2] < 0)
+	{
+ para[2] = 0;
+	};
+	// for DAMPING_C_z
+	if (para[3] < 0)
+	{
+ para[3] = 0;
+	};
+	// for DAMPING_C_z
+	if (para[3] > 1)
+	{
+ para[3] = 1;
+	};
+	// for DAMPING_C
+	if (para[4] < 0)
+	{
+ para[4] = 0;
+	};
+	// for DAMPING_C
+	if (para[4] > 1)
+	{
+ para[4] = 1;
+	};
+	
  }*/
\ No newline at end of file
@@ -0,0 +1,326 @@
+//===========================================================================
+/*
+ This file is part of the Dynamic Simulation with Particles project,
+ built on top of the CHAI 3D visualization and haptics libraries.
+
+ \author    <http://www.chai3d.org>
+ \version   2.0.0
+ */
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+//---------------------------------------------------------------------------
+#include "ParticleSystem/CParticleSimulation.h"
+#include "ParticleSystem/CTriangleScene.h"
+#include "ParticleSystem/CTrajectoryRecorder.h"
+#include "ParticleSystem/CAdaptiveTimestep.h"
+#include "ParticleSystem/CXPBDIntegrator.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*
+ DEMO:    DynamicSimulationwithParticles_Headless.cpp
+
+ Runs the particle scene of DynamicSimulationwithParticles.cpp without
+ GLUT, OpenGL or a haptic device, for display-less machines and for
+ timing the physics on its own. The scene is stepped with a fixed
+ timestep as fast as possible for a number of steps or for a wall-clock
+ duration; timing statistics and the final state are then printed.
+
+ Build (no CHAI 3D needed):
+     g++ -O2 -std=c++11 -pthread DynamicSimulationwithParticles_Headless.cpp
+         ParticleSystem/CParticleArrays.cpp ParticleSystem/CSpringTable.cpp
+         ParticleSystem/CSpringKernels.cpp ParticleSystem/CParticleIntegrators.cpp
+         ParticleSystem/CImplicitEulerIntegrator.cpp ParticleSystem/CParticleContacts.cpp
+         ParticleSystem/CSpatialHash.cpp ParticleSystem/CTaskPool.cpp
+         ParticleSystem/CParticleSimulation.cpp ParticleSystem/CTriangleScene.cpp
+         ParticleSystem/CLoopProfiler.cpp ParticleSystem/CLatencyHistogram.cpp
+         ParticleSystem/CTrajectoryRecorder.cpp ParticleSystem/CParticleIslands.cpp
+         ParticleSystem/CAdaptiveTimestep.cpp ParticleSystem/CXPBDIntegrator.cpp
+         -o DynamicSimulationwithParticles_Headless
+
+ Usage:
+     DynamicSimulationwithParticles_Headless [options]
+         -steps K        number of steps (default 10000)
+         -seconds T      run for T seconds of wall-clock time instead
+         -rate HZ        fixed step rate (default 1000)
+         -integrator I   0 explicit Euler, 1 symplectic Euler,
+                         2 velocity Verlet, 3 RK4, 4 implicit Euler,
+                         5 XPBD
+         -iterations N   constraint iterations of XPBD (default 4)
+         -threads N      simulation threads, 0 for one per core (default 1)
+         -random         random start positions
+         -seed S         seed of the random start positions
+         -record FILE    record every step to a trajectory file (with
+                         -seconds, only the last RING_CAPACITY steps)
+         -sleep          let islands that have come to rest fall asleep
+         -adaptive       size the steps by error control, over the
+                         simulated time of K fixed steps
+ */
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// DECLARED VARIABLES
+//---------------------------------------------------------------------------
+
+// run settings
+long numSteps = 10000;
+double runSeconds = 0.0;
+double stepRate = 1000.0;
+int integratorType = C_DEFAULT_PARTICLE_INTEGRATOR;
+unsigned int numThreads = 1;
+bool randomInitPos = false;
+unsigned int seed = 1;
+const char* recordFilename = NULL;
+bool sleepIslands = false;
+bool adaptiveSteps = false;
+unsigned int xpbdIterations = 4;
+
+// frames kept when recording a run of unknown length
+const unsigned long long RING_CAPACITY = 100000;
+
+//---------------------------------------------------------------------------
+// DECLARED FUNCTIONS
+//---------------------------------------------------------------------------
+
+// read the command line options; returns false on an unknown option
+bool parseOptions(int argc, char* argv[]);
+
+// print the position and velocity of every particle
+void printState(const cParticleSimulation& a_sim);
+
+//===========================================================================
+
+int main(int argc, char* argv[])
+{
+    if (!parseOptions(argc, argv))
+    {
+        printf("usage: %s [-steps K | -seconds T] [-rate HZ] [-integrator I]\n"
+               "          [-threads N] [-random] [-seed S] [-record FILE] [-sleep]\n"
+               "          [-adaptive] [-iterations N]\n", argv[0]);
+        return (1);
+    }
+
+    //-----------------------------------------------------------------------
+    // COMPOSE THE SCENE
+    //-----------------------------------------------------------------------
+
+    cParticleSimulation sim;
+    cTriangleSceneParameters sceneParameters;
+    cBuildTriangleScene(sim, sceneParameters);
+
+    sim.m_random.setSeed(seed);
+    cPlaceTriangleScene(sim, randomInitPos);
+
+    sim.setIntegrator((cParticleIntegratorType)integratorType);
+    if (sim.getIntegratorType() == C_INTEGRATOR_XPBD)
+    {
+        ((cXPBDIntegrator*)sim.getIntegrator())->setNumIterations(xpbdIterations);
+    }
+    sim.m_islands.setEnabled(sleepIslands);
+
+    cTaskPool taskPool(numThreads);
+    sim.setTaskPool(&taskPool);
+
+    double dt = 1.0 / stepRate;
+
+    // adaptive steps cover the time of the fixed ones, with their own limits
+    cAdaptiveTimestep adaptiveStep;
+    double endTime = numSteps * dt;
+
+    // same parameters, in the same order, as para[] of the interactive demo
+    double parameters[5] = { sceneParameters.m_mass, sceneParameters.m_restLength,
+                             sceneParameters.m_stiffness, sceneParameters.m_restitution,
+                             sceneParameters.m_drag };
+    cTrajectoryRecorder recorder;
+    if (recordFilename != NULL)
+    {
+        bool ring = (runSeconds > 0.0);
+        unsigned long long capacity = ring ? RING_CAPACITY : (unsigned long long)numSteps;
+        if ((capacity == 0) ||
+            !recorder.open(recordFilename, sim.m_particles.getNumParticles(), 5, capacity, ring))
+        {
+            printf("cannot record to %s\n", recordFilename);
+            return (1);
+        }
+    }
+
+    printf("particles: %u  springs: %u\n", sim.m_particles.getNumParticles(),
+           sim.m_springs.getNumSprings());
+    printf("integrator: %s  rate: %.0f Hz  threads: %u\n",
+           cGetParticleIntegratorName(sim.getIntegratorType()), stepRate,
+           taskPool.getNumThreads());
+    if (sim.getIntegratorType() == C_INTEGRATOR_XPBD)
+    {
+        printf("XPBD iterations: %u\n", xpbdIterations);
+    }
+    if (runSeconds > 0.0) { printf("running for %.3f s\n\n", runSeconds); }
+    else                  { printf("running %ld steps\n\n", numSteps); }
+
+    //-----------------------------------------------------------------------
+    // RUN
+    //-----------------------------------------------------------------------
+
+    double minStep = HUGE_VAL;
+    double maxStep = 0.0;
+    double sumStep = 0.0;
+    long steps = 0;
+    long contactSteps = 0;
+    long sleepingSteps = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last = start;
+    while (true)
+    {
+        if (runSeconds > 0.0)
+        {
+            if (std::chrono::duration<double>(last - start).count() >= runSeconds) { break; }
+        }
+        else if (adaptiveSteps ? (sim.getTime() >= endTime) : (steps >= numSteps))
+        {
+            break;
+        }
+
+        if (adaptiveSteps)
+        {
+            adaptiveStep.step(sim);
+        }
+        else
+        {
+            sim.step(dt);
+        }
+        recorder.record(sim.m_particles, sim.getTime(), sim.getNumSteps(), parameters);
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        minStep = fmin(minStep, seconds);
+        maxStep = fmax(maxStep, seconds);
+        sumStep += seconds;
+        steps++;
+        if ((sim.getNumContacts() > 0) || (sim.getNumParticleContacts() > 0)) { contactSteps++; }
+        if (sim.m_islands.isAllSleeping()) { sleepingSteps++; }
+    }
+
+    //-----------------------------------------------------------------------
+    // REPORT
+    //-----------------------------------------------------------------------
+
+    double wallTime = std::chrono::duration<double>(last - start).count();
+
+    printf("steps:            %ld\n", steps);
+    printf("simulated time:   %.6f s\n", sim.getTime());
+    printf("wall time:        %.6f s\n", wallTime);
+    if (steps > 0)
+    {
+        printf("step time:        mean %.3f us  min %.3f us  max %.3f us\n",
+               1e6 * sumStep / steps, 1e6 * minStep, 1e6 * maxStep);
+        printf("throughput:       %.0f steps/s  (%.1fx real time)\n",
+               steps / wallTime, sim.getTime() / wallTime);
+        printf("steps in contact: %ld\n", contactSteps);
+        if (sleepIslands) { printf("steps asleep:     %ld\n", sleepingSteps); }
+        if (adaptiveSteps)
+        {
+            printf("adaptive steps:   %llu accepted  %llu rejected  mean dt %.3f ms\n",
+                   adaptiveStep.getNumAcceptedSteps(), adaptiveStep.getNumRejectedSteps(),
+                   1e3 * sim.getTime() / steps);
+        }
+    }
+    if (recorder.isOpen())
+    {
+        printf("recorded:         %llu frames to %s\n", recorder.getNumFrames(), recordFilename);
+        recorder.close();
+    }
+    printf("\n");
+
+    printState(sim);
+
+    return (0);
+}
+
+//---------------------------------------------------------------------------
+
+bool parseOptions(int argc, char* argv[])
+{
+    for (int k = 1; k < argc; k++)
+    {
+        bool hasValue = (k + 1 < argc);
+
+        if ((strcmp(argv[k], "-steps") == 0) && hasValue)
+        {
+            numSteps = atol(argv[++k]);
+        }
+        else if ((strcmp(argv[k], "-seconds") == 0) && hasValue)
+        {
+            runSeconds = atof(argv[++k]);
+        }
+        else if ((strcmp(argv[k], "-rate") == 0) && hasValue)
+        {
+            stepRate = atof(argv[++k]);
+            if (stepRate <= 0.0) { return (false); }
+        }
+        else if ((strcmp(argv[k], "-integrator") == 0) && hasValue)
+        {
+            integratorType = atoi(argv[++k]);
+            if ((integratorType < 0) || (integratorType >= C_NUM_INTEGRATORS)) { return (false); }
+        }
+        else if ((strcmp(argv[k], "-iterations") == 0) && hasValue)
+        {
+            int iterations = atoi(argv[++k]);
+            if (iterations < 1) { return (false); }
+            xpbdIterations = (unsigned int)iterations;
+        }
+        else if ((strcmp(argv[k], "-threads") == 0) && hasValue)
+        {
+            numThreads = (unsigned int)atoi(argv[++k]);
+        }
+        else if ((strcmp(argv[k], "-seed") == 0) && hasValue)
+        {
+            seed = (unsigned int)atoi(argv[++k]);
+        }
+        else if ((strcmp(argv[k], "-record") == 0) && hasValue)
+        {
+            recordFilename = argv[++k];
+        }
+        else if (strcmp(argv[k], "-random") == 0)
+        {
+            randomInitPos = true;
+        }
+        else if (strcmp(argv[k], "-sleep") == 0)
+        {
+            sleepIslands = true;
+        }
+        else if (strcmp(argv[k], "-adaptive") == 0)
+        {
+            adaptiveSteps = true;
+        }
+        else
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+//---------------------------------------------------------------------------
+
+void printState(const cParticleSimulation& a_sim)
+{
+    const cParticleArrays& p = a_sim.m_particles;
+
+    printf("final state:\n");
+    for (unsigned int k = 0; k < p.getNumParticles(); k++)
+    {
+        printf("pos[%u]: %.9f, %.9f, %.9f  vel[%u]: %.9f, %.9f, %.9f\n", k,
+               p.m_posX[k], p.m_posY[k], p.m_posZ[k], k,
+               p.m_velX[k], p.m_velY[k], p.m_velZ[k]);
+    }
+}
+
+//---------------------------------------------------------------------------
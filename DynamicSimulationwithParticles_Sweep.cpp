@@ -0,0 +1,339 @@
+//===========================================================================
+/*
+ This file is part of the Dynamic Simulation with Particles project,
+ built on top of the CHAI 3D visualization and haptics libraries.
+
+ \author    <http://www.chai3d.org>
+ \version   2.0.0
+ */
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+//---------------------------------------------------------------------------
+#include "ParticleSystem/CParameterSweep.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*
+ DEMO:    DynamicSimulationwithParticles_Sweep.cpp
+
+ Batch tuning of the particle scene of DynamicSimulationwithParticles.cpp.
+ Instead of changing one parameter at a time with the '9', '0' and space
+ keys of the demo, every combination of a grid (or a random sample) over
+ the five parameters of the demo and a number of random start positions
+ is run headless, in parallel on all cores, and every run is summarized
+ by its settle time, deepest penetration, energy drift and bounce count.
+
+ Build (no CHAI 3D needed):
+     g++ -O2 -std=c++11 -pthread DynamicSimulationwithParticles_Sweep.cpp
+         ParticleSystem/CParticleArrays.cpp ParticleSystem/CSpringTable.cpp
+         ParticleSystem/CSpringKernels.cpp ParticleSystem/CParticleIntegrators.cpp
+         ParticleSystem/CImplicitEulerIntegrator.cpp ParticleSystem/CParticleContacts.cpp
+         ParticleSystem/CSpatialHash.cpp ParticleSystem/CTaskPool.cpp
+         ParticleSystem/CParticleSimulation.cpp ParticleSystem/CTriangleScene.cpp
+         ParticleSystem/CLoopProfiler.cpp ParticleSystem/CLatencyHistogram.cpp
+         ParticleSystem/CParticleEnsemble.cpp ParticleSystem/CParameterSweep.cpp
+         ParticleSystem/CParticleIslands.cpp ParticleSystem/CXPBDIntegrator.cpp
+         -o DynamicSimulationwithParticles_Sweep
+
+ Usage:
+     DynamicSimulationwithParticles_Sweep [options]
+         -m R            mass of each particle (default 10)
+         -restLength R   rest length of the springs (default 0.5)
+         -SPRING_C R     stiffness of the springs (default 100)
+         -DAMPING_C_z R  restitution of the impacts (default 0.9)
+         -DAMPING_G R    drag rate (default 0.6)
+         -seeds N        random start positions per combination, 0 for the
+                         fixed start of the demo (default 0)
+         -samples N      draw N random combinations instead of the grid
+         -sampleSeed S   seed of the random combinations (default 1)
+         -seconds T      simulated time of every run (default 5)
+         -rate HZ        fixed step rate (default 1000)
+         -integrator I   0 explicit Euler, 1 symplectic Euler,
+                         2 velocity Verlet, 3 RK4, 4 implicit Euler,
+                         5 XPBD
+         -threads N      threads, 0 for one per core (default 0)
+         -ensemble       run the samples side by side in the SIMD lanes of
+                         a cParticleEnsemble (integrators 0 to 2)
+         -o FILE         write the results as columns (see
+                         cParameterSweep::writeColumns())
+         -csv FILE       write the results as CSV
+
+     A range R is a single value, or MIN:MAX:N for N evenly spaced values
+     (MIN:MAX for both bounds only; with -samples, values are drawn
+     uniformly between MIN and MAX and N is ignored).
+     For example, 4 x 5 x 10 combinations with 8 start positions each:
+
+         -SPRING_C 50:500:4 -DAMPING_C_z 0.1:0.9:5 -DAMPING_G 0:1:10 -seeds 8 -o sweep.col
+ */
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// DECLARED VARIABLES
+//---------------------------------------------------------------------------
+
+// values of the swept parameters, defaults of the interactive demo
+cSweepRange ranges[C_NUM_SWEEP_PARAMETERS] = { cSweepRange(10.0), cSweepRange(0.5),
+                                               cSweepRange(100.0), cSweepRange(0.9),
+                                               cSweepRange(0.6) };
+
+// run settings
+unsigned int numSeeds = 0;
+unsigned int numRandomSamples = 0;
+unsigned int sampleSeed = 1;
+double runSeconds = 5.0;
+double stepRate = 1000.0;
+int integratorType = C_DEFAULT_PARTICLE_INTEGRATOR;
+unsigned int numThreads = 0;
+bool useEnsemble = false;
+const char* columnsFilename = NULL;
+const char* csvFilename = NULL;
+
+// runs listed in the report
+const unsigned int NUM_BEST_RUNS = 5;
+
+//---------------------------------------------------------------------------
+// DECLARED FUNCTIONS
+//---------------------------------------------------------------------------
+
+// read the command line options; returns false on an unknown option
+bool parseOptions(int argc, char* argv[]);
+
+// read a range "V" or "MIN:MAX:N"; returns false if malformed
+bool parseRange(const char* a_text, cSweepRange& a_range);
+
+//===========================================================================
+
+int main(int argc, char* argv[])
+{
+    if (!parseOptions(argc, argv))
+    {
+        printf("usage: %s [-m R] [-restLength R] [-SPRING_C R] [-DAMPING_C_z R]\n"
+               "          [-DAMPING_G R] [-seeds N] [-samples N] [-sampleSeed S]\n"
+               "          [-seconds T] [-rate HZ] [-integrator I] [-threads N]\n"
+               "          [-ensemble] [-o FILE] [-csv FILE]\n"
+               "       R is a value or MIN:MAX:N\n", argv[0]);
+        return (1);
+    }
+
+    //-----------------------------------------------------------------------
+    // SAMPLES
+    //-----------------------------------------------------------------------
+
+    cParameterSweep sweep;
+    sweep.m_duration = runSeconds;
+    sweep.m_timeStep = 1.0 / stepRate;
+    sweep.m_integrator = (cParticleIntegratorType)integratorType;
+    sweep.m_useEnsemble = useEnsemble;
+
+    if (numRandomSamples > 0)
+    {
+        sweep.addRandom(ranges, numRandomSamples, numSeeds, sampleSeed);
+    }
+    else
+    {
+        sweep.addGrid(ranges, numSeeds);
+    }
+
+    cTaskPool taskPool(numThreads);
+
+    printf("runs: %u  simulated time: %.3f s  rate: %.0f Hz\n",
+           sweep.getNumSamples(), runSeconds, stepRate);
+    printf("integrator: %s  threads: %u\n",
+           cGetParticleIntegratorName(sweep.m_integrator), taskPool.getNumThreads());
+    if (useEnsemble && !cIsEnsembleIntegrator(sweep.m_integrator))
+    {
+        printf("ensemble: not available with this integrator, running one by one\n");
+    }
+    else if (useEnsemble)
+    {
+        printf("ensemble: %u lanes per group, %s kernel\n",
+               C_SWEEP_ENSEMBLE_LANES, cGetEnsembleKernelName(cGetBestEnsembleKernel()));
+    }
+    printf("\n");
+
+    //-----------------------------------------------------------------------
+    // RUN
+    //-----------------------------------------------------------------------
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    sweep.run(&taskPool);
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    //-----------------------------------------------------------------------
+    // REPORT
+    //-----------------------------------------------------------------------
+
+    unsigned long long steps = 0;
+    unsigned int stable = 0;
+    unsigned int settled = 0;
+    std::vector<unsigned int> best;
+    for (unsigned int k = 0; k < sweep.getNumSamples(); k++)
+    {
+        const cSweepMetrics& metrics = sweep.getMetrics(k);
+        steps += metrics.m_numSteps;
+        if (metrics.m_stable) { stable++; }
+        if (!isnan(metrics.m_settleTime))
+        {
+            settled++;
+            best.push_back(k);
+        }
+    }
+
+    printf("wall time:        %.3f s\n", wallTime);
+    printf("throughput:       %.0f runs/s  %.0f steps/s\n",
+           sweep.getNumSamples() / wallTime, steps / wallTime);
+    printf("stable runs:      %u of %u\n", stable, sweep.getNumSamples());
+    printf("settled runs:     %u of %u\n", settled, sweep.getNumSamples());
+
+    // the runs that came to rest first
+    unsigned int numBest = (best.size() < NUM_BEST_RUNS) ? (unsigned int)best.size() : NUM_BEST_RUNS;
+    std::partial_sort(best.begin(), best.begin() + numBest, best.end(),
+                      [&](unsigned int a, unsigned int b)
+    {
+        return (sweep.getMetrics(a).m_settleTime < sweep.getMetrics(b).m_settleTime);
+    });
+    if (numBest > 0)
+    {
+        printf("\nfastest to settle:\n");
+        printf("  %8s %10s %8s %11s %9s %10s %10s %10s %7s\n", "m", "restLength", "SPRING_C",
+               "DAMPING_C_z", "DAMPING_G", "settle [s]", "pen. [m]", "drift", "bounces");
+    }
+    for (unsigned int k = 0; k < numBest; k++)
+    {
+        const cSweepSample& sample = sweep.getSample(best[k]);
+        const cSweepMetrics& metrics = sweep.getMetrics(best[k]);
+        printf("  %8.3f %10.3f %8.1f %11.3f %9.3f %10.3f %10.5f %10.2e %7u\n",
+               sample.m_parameters[C_SWEEP_MASS], sample.m_parameters[C_SWEEP_REST_LENGTH],
+               sample.m_parameters[C_SWEEP_STIFFNESS], sample.m_parameters[C_SWEEP_RESTITUTION],
+               sample.m_parameters[C_SWEEP_DRAG], metrics.m_settleTime,
+               metrics.m_maxPenetration, metrics.m_energyDrift, metrics.m_numBounces);
+    }
+
+    int result = 0;
+    if ((columnsFilename != NULL) && !sweep.writeColumns(columnsFilename))
+    {
+        printf("cannot write %s\n", columnsFilename);
+        result = 1;
+    }
+    if ((csvFilename != NULL) && !sweep.writeCSV(csvFilename))
+    {
+        printf("cannot write %s\n", csvFilename);
+        result = 1;
+    }
+
+    return (result);
+}
+
+//---------------------------------------------------------------------------
+
+bool parseOptions(int argc, char* argv[])
+{
+    for (int k = 1; k < argc; k++)
+    {
+        bool hasValue = (k + 1 < argc);
+        bool isRange = false;
+
+        // the swept parameters are named after the variables of the demo
+        for (int p = 0; p < C_NUM_SWEEP_PARAMETERS; p++)
+        {
+            if ((argv[k][0] == '-') && hasValue &&
+                (strcmp(argv[k] + 1, cParameterSweep::getParameterName((cSweepParameter)p)) == 0))
+            {
+                if (!parseRange(argv[++k], ranges[p])) { return (false); }
+                isRange = true;
+                break;
+            }
+        }
+        if (isRange) { continue; }
+
+        if ((strcmp(argv[k], "-seeds") == 0) && hasValue)
+        {
+            numSeeds = (unsigned int)atoi(argv[++k]);
+        }
+        else if ((strcmp(argv[k], "-samples") == 0) && hasValue)
+        {
+            numRandomSamples = (unsigned int)atoi(argv[++k]);
+        }
+        else if ((strcmp(argv[k], "-sampleSeed") == 0) && hasValue)
+        {
+            sampleSeed = (unsigned int)atoi(argv[++k]);
+        }
+        else if ((strcmp(argv[k], "-seconds") == 0) && hasValue)
+        {
+            runSeconds = atof(argv[++k]);
+            if (runSeconds <= 0.0) { return (false); }
+        }
+        else if ((strcmp(argv[k], "-rate") == 0) && hasValue)
+        {
+            stepRate = atof(argv[++k]);
+            if (stepRate <= 0.0) { return (false); }
+        }
+        else if ((strcmp(argv[k], "-integrator") == 0) && hasValue)
+        {
+            integratorType = atoi(argv[++k]);
+            if ((integratorType < 0) || (integratorType >= C_NUM_INTEGRATORS)) { return (false); }
+        }
+        else if ((strcmp(argv[k], "-threads") == 0) && hasValue)
+        {
+            numThreads = (unsigned int)atoi(argv[++k]);
+        }
+        else if (strcmp(argv[k], "-ensemble") == 0)
+        {
+            useEnsemble = true;
+        }
+        else if ((strcmp(argv[k], "-o") == 0) && hasValue)
+        {
+            columnsFilename = argv[++k];
+        }
+        else if ((strcmp(argv[k], "-csv") == 0) && hasValue)
+        {
+            csvFilename = argv[++k];
+        }
+        else
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+//---------------------------------------------------------------------------
+
+bool parseRange(const char* a_text, cSweepRange& a_range)
+{
+    double low, high;
+    unsigned int count;
+    char tail;
+
+    if (sscanf(a_text, "%lf:%lf:%u%c", &low, &high, &count, &tail) == 3)
+    {
+        if (count == 0) { return (false); }
+        a_range.m_min = low;
+        a_range.m_max = high;
+        a_range.m_count = count;
+        return (true);
+    }
+    if (sscanf(a_text, "%lf:%lf%c", &low, &high, &tail) == 2)
+    {
+        a_range.m_min = low;
+        a_range.m_max = high;
+        a_range.m_count = 2;
+        return (true);
+    }
+    if (sscanf(a_text, "%lf%c", &low, &tail) == 1)
+    {
+        a_range = cSweepRange(low);
+        return (true);
+    }
+    return (false);
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,269 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CAdaptiveTimestep.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// scale factor of the next step, kept within [0.2, 2]
+static inline double cStepFactor(const double a_factor)
+{
+    return ((a_factor < 0.2) ? 0.2 : ((a_factor > 2.0) ? 2.0 : a_factor));
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cAdaptiveTimestep. The first step is the shortest.
+
+    \fn     cAdaptiveTimestep::cAdaptiveTimestep(const double a_minStep,
+            const double a_maxStep, const unsigned int a_maxSubsteps)
+    \param  a_minStep  Shortest step [s].
+    \param  a_maxStep  Longest step [s].
+    \param  a_maxSubsteps  Most steps that \ref addElapsed() lets pile up.
+*/
+//===========================================================================
+cAdaptiveTimestep::cAdaptiveTimestep(const double a_minStep, const double a_maxStep,
+                                     const unsigned int a_maxSubsteps)
+{
+    m_minStep = 1e-5;
+    m_maxStep = 0.01;
+    m_tolerance = 0.0005;
+    m_maxPenetration = 0.002;
+    setStepLimits(a_minStep, a_maxStep);
+    setMaxSubsteps(a_maxSubsteps);
+    reset();
+}
+
+
+//===========================================================================
+/*!
+    Set the shortest and longest steps. Invalid limits are ignored; the
+    next step is brought within the new limits.
+
+    \fn     void cAdaptiveTimestep::setStepLimits(const double a_minStep,
+            const double a_maxStep)
+    \param  a_minStep  Shortest step [s].
+    \param  a_maxStep  Longest step [s].
+*/
+//===========================================================================
+void cAdaptiveTimestep::setStepLimits(const double a_minStep, const double a_maxStep)
+{
+    if ((a_minStep <= 0.0) || (a_maxStep < a_minStep)) { return; }
+
+    m_minStep = a_minStep;
+    m_maxStep = a_maxStep;
+    m_timeStep = fmin(fmax(m_timeStep, m_minStep), m_maxStep);
+}
+
+
+//===========================================================================
+/*!
+    Take one step of \e a_simulation. Steps are tried from the current
+    step length and shortened until one is accepted; the next step is
+    then sized from the error of the accepted one. While every island of
+    the simulation sleeps, nothing moves and the step is taken as it is.
+
+    \fn     double cAdaptiveTimestep::step(cParticleSimulation& a_simulation)
+    \param  a_simulation  Simulation to advance.
+    \return Return the length of the accepted step [s].
+*/
+//===========================================================================
+double cAdaptiveTimestep::step(cParticleSimulation& a_simulation)
+{
+    while (true)
+    {
+        double dt = m_timeStep;
+        double factor = 2.0;
+        bool accepted;
+
+        if (a_simulation.m_islands.isAllSleeping())
+        {
+            a_simulation.step(dt);
+            m_lastError = 0.0;
+            accepted = true;
+        }
+        else
+        {
+            accepted = attempt(a_simulation, dt, factor);
+        }
+
+        m_timeStep = fmin(fmax(dt * factor, m_minStep), m_maxStep);
+
+        if (accepted)
+        {
+            m_accumulator -= dt;
+            if (m_accumulator < 0.0) { m_accumulator = 0.0; }
+            m_numAccepted++;
+            return (dt);
+        }
+        m_numRejected++;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Add an elapsed wall-clock interval to be covered by steps. If more
+    than \e maxSubsteps steps of the current length would be due, the
+    surplus is dropped instead of being caught up in a burst.
+
+    \fn     void cAdaptiveTimestep::addElapsed(const double a_elapsed)
+    \param  a_elapsed  Wall time elapsed since the previous call, in seconds.
+*/
+//===========================================================================
+void cAdaptiveTimestep::addElapsed(const double a_elapsed)
+{
+    if (a_elapsed > 0.0)
+    {
+        m_accumulator += a_elapsed;
+    }
+
+    // too far behind: forget the backlog rather than spiral
+    double backlog = m_maxSubsteps * m_timeStep;
+    if (m_accumulator > backlog)
+    {
+        m_droppedTime += m_accumulator - backlog;
+        m_accumulator = backlog;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Clear pending time and statistics. The next step is the shortest, as
+    nothing is known yet about the motion.
+
+    \fn     void cAdaptiveTimestep::reset()
+*/
+//===========================================================================
+void cAdaptiveTimestep::reset()
+{
+    m_timeStep = m_minStep;
+    m_accumulator = 0.0;
+    m_lastError = 0.0;
+    m_droppedTime = 0.0;
+    m_numAccepted = 0;
+    m_numRejected = 0;
+}
+
+
+//===========================================================================
+/*!
+    Try a step of \e a_dt seconds. The accelerations of the dynamic
+    particles are taken before and after the step (contacts included)
+    and give the Heun/Euler error estimate; the deepest penetration of
+    the step is read from the contact shapes. A rejected step is undone:
+    positions, velocities and the clock are restored and the integrator
+    is reset.
+
+    Forces evaluated here are handed to the integrator with
+    \ref cParticleIntegrator::setCachedForces(), so that velocity Verlet
+    does not evaluate them again.
+
+    \fn     bool cAdaptiveTimestep::attempt(cParticleSimulation& a_simulation,
+            const double a_dt, double& a_factor)
+    \param  a_simulation  Simulation to advance.
+    \param  a_dt  Length of the step [s].
+    \param  a_factor  Returns the scale factor of the next step.
+    \return Return true if the step is accepted.
+*/
+//===========================================================================
+bool cAdaptiveTimestep::attempt(cParticleSimulation& a_simulation, const double a_dt,
+                                double& a_factor)
+{
+    cParticleArrays& particles = a_simulation.m_particles;
+    cParticleIntegrator* integrator = a_simulation.getIntegrator();
+    unsigned int n = particles.getNumParticles();
+    const double* w = particles.m_invMass;
+
+    double time = a_simulation.getTime();
+    unsigned int numSteps = a_simulation.getNumSteps();
+
+    // state at the start of the step
+    if (!integrator->hasCachedForces())
+    {
+        a_simulation.computeForces(particles);
+        integrator->setCachedForces(particles);
+    }
+
+    m_state.resize(9 * n);
+    double* state = &m_state[0];
+    for (unsigned int i=0; i<n; i++)
+    {
+        state[i]       = particles.m_posX[i];
+        state[n + i]   = particles.m_posY[i];
+        state[2*n + i] = particles.m_posZ[i];
+        state[3*n + i] = particles.m_velX[i];
+        state[4*n + i] = particles.m_velY[i];
+        state[5*n + i] = particles.m_velZ[i];
+        state[6*n + i] = w[i] * particles.m_forceX[i];
+        state[7*n + i] = w[i] * particles.m_forceY[i];
+        state[8*n + i] = w[i] * particles.m_forceZ[i];
+    }
+
+    a_simulation.step(a_dt);
+
+    // forces at the end, reused by the next step
+    if (!integrator->hasCachedForces())
+    {
+        a_simulation.computeForces(particles);
+        integrator->setCachedForces(particles);
+    }
+
+    // Heun and Euler velocities differ by dt/2 times the change of acceleration
+    double error = 0.0;
+    for (unsigned int i=0; i<n; i++)
+    {
+        if (w[i] <= 0.0) { continue; }
+
+        double dax = w[i] * particles.m_forceX[i] - state[6*n + i];
+        double day = w[i] * particles.m_forceY[i] - state[7*n + i];
+        double daz = w[i] * particles.m_forceZ[i] - state[8*n + i];
+        error = fmax(error, dax*dax + day*day + daz*daz);
+    }
+    error = 0.5 * a_dt * sqrt(error);
+
+    double errorRatio = error / m_tolerance;
+    double depthRatio = a_simulation.m_contacts.getMaxPenetration() / m_maxPenetration;
+
+    // the error shrinks with dt squared, the penetration with dt
+    double factor = 2.0;
+    if (errorRatio > 0.0) { factor = fmin(factor, 0.9 / sqrt(errorRatio)); }
+    if (depthRatio > 0.0) { factor = fmin(factor, 0.9 / depthRatio); }
+    a_factor = cStepFactor(factor);
+
+    if (((errorRatio <= 1.0) && (depthRatio <= 1.0)) || (a_dt <= m_minStep))
+    {
+        m_lastError = error;
+        return (true);
+    }
+
+    // undo the step
+    for (unsigned int i=0; i<n; i++)
+    {
+        particles.m_posX[i] = state[i];
+        particles.m_posY[i] = state[n + i];
+        particles.m_posZ[i] = state[2*n + i];
+        particles.m_velX[i] = state[3*n + i];
+        particles.m_velY[i] = state[4*n + i];
+        particles.m_velZ[i] = state[5*n + i];
+    }
+    a_simulation.setClock(time, numSteps);
+    a_simulation.resetIntegrator();
+
+    return (false);
+}
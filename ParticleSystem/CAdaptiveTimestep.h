@@ -0,0 +1,172 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CAdaptiveTimestepH
+#define CAdaptiveTimestepH
+//---------------------------------------------------------------------------
+#include "CParticleSimulation.h"
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CAdaptiveTimestep.h
+
+    \brief
+    <b> Particles </b> \n
+    Adaptive timestep with embedded error control.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cAdaptiveTimestep
+    \ingroup    particles
+
+    \brief
+    cAdaptiveTimestep advances a \ref cParticleSimulation with steps
+    whose length follows the motion: long steps in free fall, short ones
+    around impacts and stiff spring compression.
+
+    The local error of a step is estimated with an embedded Heun/Euler
+    pair: both advance the velocities from the same accelerations at the
+    start of the step, Heun averaging them with the accelerations at the
+    end, so they differ by half the step times the change of
+    acceleration of each particle. A step whose largest difference
+    exceeds the velocity tolerance, or whose deepest particle-shape
+    penetration exceeds the penetration tolerance, is rejected: the
+    particles are put back and the step is retried with a shorter
+    length. Step lengths are then scaled by the usual controller of a
+    second order estimate, within [0.2, 2] and within the step limits.
+    In free fall the acceleration hardly changes, so the steps grow to
+    the maximum step.
+
+    With velocity Verlet, the forces at both ends of a step are the ones
+    the integrator caches, so the estimate costs no extra force
+    evaluation; other schemes pay up to two.
+
+    For real-time loops, \ref addElapsed() accumulates wall time and
+    \ref isStepDue() tells when the accumulated time covers the next
+    step, as \ref cFixedTimestep does for constant steps.
+*/
+//===========================================================================
+class cAdaptiveTimestep
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cAdaptiveTimestep.
+    cAdaptiveTimestep(const double a_minStep = 1e-5, const double a_maxStep = 0.01,
+                      const unsigned int a_maxSubsteps = 10);
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Set the shortest and longest steps [s].
+    void setStepLimits(const double a_minStep, const double a_maxStep);
+
+    //! Shortest step [s]; steps this short are always accepted.
+    inline double getMinStep() const { return (m_minStep); }
+
+    //! Longest step [s].
+    inline double getMaxStep() const { return (m_maxStep); }
+
+    //! Set the largest accepted velocity error of a step [m/s].
+    inline void setTolerance(const double a_tolerance) { if (a_tolerance > 0.0) { m_tolerance = a_tolerance; } }
+
+    //! Largest accepted velocity error of a step [m/s].
+    inline double getTolerance() const { return (m_tolerance); }
+
+    //! Set the largest accepted particle-shape penetration of a step [m].
+    inline void setMaxPenetration(const double a_depth) { if (a_depth > 0.0) { m_maxPenetration = a_depth; } }
+
+    //! Largest accepted particle-shape penetration of a step [m].
+    inline double getMaxPenetration() const { return (m_maxPenetration); }
+
+    //! Set the most steps that \ref addElapsed() lets pile up.
+    inline void setMaxSubsteps(const unsigned int a_maxSubsteps) { m_maxSubsteps = (a_maxSubsteps > 0) ? a_maxSubsteps : 1; }
+
+    //! Most steps that \ref addElapsed() lets pile up.
+    inline unsigned int getMaxSubsteps() const { return (m_maxSubsteps); }
+
+    //! Take one accepted step of \e a_simulation, retrying rejected ones. Returns its length [s].
+    double step(cParticleSimulation& a_simulation);
+
+    //! Add elapsed wall time to be covered by steps.
+    void addElapsed(const double a_elapsed);
+
+    //! True if the accumulated wall time covers the next step.
+    inline bool isStepDue() const { return (m_accumulator >= m_timeStep); }
+
+    //! Length of the next step [s].
+    inline double getTimeStep() const { return (m_timeStep); }
+
+    //! Error estimate of the last accepted step [m/s].
+    inline double getLastError() const { return (m_lastError); }
+
+    //! Number of accepted steps since the last reset.
+    inline unsigned long long getNumAcceptedSteps() const { return (m_numAccepted); }
+
+    //! Number of rejected steps since the last reset.
+    inline unsigned long long getNumRejectedSteps() const { return (m_numRejected); }
+
+    //! Wall time dropped by the max substeps guard since the last reset [s].
+    inline double getDroppedTime() const { return (m_droppedTime); }
+
+    //! Clear pending time and counters, and restart from the shortest step.
+    void reset();
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Try a step of \e a_dt seconds; on return \e a_factor scales the next step.
+    bool attempt(cParticleSimulation& a_simulation, const double a_dt, double& a_factor);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Step limits and tolerances.
+    double m_minStep;
+    double m_maxStep;
+    double m_tolerance;
+    double m_maxPenetration;
+    unsigned int m_maxSubsteps;
+
+    //! Length of the next step.
+    double m_timeStep;
+
+    //! Wall time not yet covered by a step.
+    double m_accumulator;
+
+    //! Positions, velocities and accelerations at the start of a step.
+    std::vector<double> m_state;
+
+    //! Statistics.
+    double m_lastError;
+    double m_droppedTime;
+    unsigned long long m_numAccepted;
+    unsigned long long m_numRejected;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,101 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CFixedTimestep.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cFixedTimestep.
+
+    \fn     cFixedTimestep::cFixedTimestep(const double a_rate,
+            const unsigned int a_maxSubsteps)
+    \param  a_rate  Step rate in Hz.
+    \param  a_maxSubsteps  Maximum number of steps per call to \ref advance().
+*/
+//===========================================================================
+cFixedTimestep::cFixedTimestep(const double a_rate, const unsigned int a_maxSubsteps)
+{
+    m_timeStep = 0.001;
+    setRate(a_rate);
+    setMaxSubsteps(a_maxSubsteps);
+    reset();
+}
+
+
+//===========================================================================
+/*!
+    Set the step rate. Non-positive rates are ignored.
+
+    \fn     void cFixedTimestep::setRate(const double a_rate)
+    \param  a_rate  Step rate in Hz.
+*/
+//===========================================================================
+void cFixedTimestep::setRate(const double a_rate)
+{
+    if (a_rate > 0.0)
+    {
+        m_timeStep = 1.0 / a_rate;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Add an elapsed wall-clock interval to the accumulator and return how
+    many steps of \ref getTimeStep() seconds should be taken now. If more
+    than \e maxSubsteps steps are due, the surplus is dropped.
+
+    \fn     unsigned int cFixedTimestep::advance(const double a_elapsed)
+    \param  a_elapsed  Wall time elapsed since the previous call, in seconds.
+    \return Return the number of steps to take.
+*/
+//===========================================================================
+unsigned int cFixedTimestep::advance(const double a_elapsed)
+{
+    if (a_elapsed > 0.0)
+    {
+        m_accumulator += a_elapsed;
+    }
+
+    unsigned int steps = 0;
+    while ((m_accumulator >= m_timeStep) && (steps < m_maxSubsteps))
+    {
+        m_accumulator -= m_timeStep;
+        steps++;
+    }
+
+    // too far behind: forget the backlog rather than spiral
+    if (m_accumulator >= m_timeStep)
+    {
+        unsigned long long dropped = (unsigned long long)(m_accumulator / m_timeStep);
+        m_accumulator -= dropped * m_timeStep;
+        m_numDroppedSteps += dropped;
+    }
+
+    m_numSteps += steps;
+    return (steps);
+}
+
+
+//===========================================================================
+/*!
+    Clear pending time and statistics.
+
+    \fn     void cFixedTimestep::reset()
+*/
+//===========================================================================
+void cFixedTimestep::reset()
+{
+    m_accumulator = 0.0;
+    m_numSteps = 0;
+    m_numDroppedSteps = 0;
+}
@@ -0,0 +1,114 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CFixedTimestepH
+#define CFixedTimestepH
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CFixedTimestep.h
+
+    \brief
+    <b> Particles </b> \n
+    Fixed timestep accumulator.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cFixedTimestep
+    \ingroup    particles
+
+    \brief
+    cFixedTimestep converts measured wall-clock intervals into a whole
+    number of simulation steps of constant length. The remainder is
+    carried over to the next call, so the simulation advances at exactly
+    the configured rate on average, independently of OS jitter.
+
+    When the caller falls behind (for instance after the window was
+    dragged) at most \e maxSubsteps steps are returned per call and the
+    excess time is dropped instead of being caught up in a burst.
+*/
+//===========================================================================
+class cFixedTimestep
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cFixedTimestep.
+    cFixedTimestep(const double a_rate = 1000.0, const unsigned int a_maxSubsteps = 10);
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Set the step rate in Hz. Pending time is kept.
+    void setRate(const double a_rate);
+
+    //! Step rate in Hz.
+    inline double getRate() const { return (1.0 / m_timeStep); }
+
+    //! Length of one step in seconds.
+    inline double getTimeStep() const { return (m_timeStep); }
+
+    //! Set the maximum number of steps returned by one call to \ref advance().
+    inline void setMaxSubsteps(const unsigned int a_maxSubsteps) { m_maxSubsteps = (a_maxSubsteps > 0) ? a_maxSubsteps : 1; }
+
+    //! Maximum number of steps returned by one call to \ref advance().
+    inline unsigned int getMaxSubsteps() const { return (m_maxSubsteps); }
+
+    //! Add elapsed wall time and return the number of steps to take.
+    unsigned int advance(const double a_elapsed);
+
+    //! Time left before the next step is due, in seconds.
+    inline double getTimeToNextStep() const { return (m_timeStep - m_accumulator); }
+
+    //! Fraction of a step accumulated so far, in [0,1).
+    inline double getInterpolationFactor() const { return (m_accumulator / m_timeStep); }
+
+    //! Total number of steps returned since the last reset.
+    inline unsigned long long getNumSteps() const { return (m_numSteps); }
+
+    //! Number of steps dropped by the max substeps guard since the last reset.
+    inline unsigned long long getNumDroppedSteps() const { return (m_numDroppedSteps); }
+
+    //! Clear pending time and counters.
+    void reset();
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Length of one step in seconds.
+    double m_timeStep;
+
+    //! Time not yet consumed by a step.
+    double m_accumulator;
+
+    //! Maximum number of steps per call.
+    unsigned int m_maxSubsteps;
+
+    //! Statistics.
+    unsigned long long m_numSteps;
+    unsigned long long m_numDroppedSteps;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
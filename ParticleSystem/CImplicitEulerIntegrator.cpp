@@ -0,0 +1,351 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CImplicitEulerIntegrator.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// dot product of two vectors of a_size elements
+static inline double cDot(const double* a_u, const double* a_v, const unsigned int a_size)
+{
+    double sum = 0.0;
+    for (unsigned int i=0; i<a_size; i++) { sum += a_u[i] * a_v[i]; }
+    return (sum);
+}
+
+// grows a buffer without shrinking it
+static inline void cGrow(std::vector<double>& a_buffer, const unsigned int a_size)
+{
+    if (a_buffer.size() < a_size) { a_buffer.resize(a_size, 0.0); }
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cImplicitEulerIntegrator.
+
+    \fn     cImplicitEulerIntegrator::cImplicitEulerIntegrator()
+*/
+//===========================================================================
+cImplicitEulerIntegrator::cImplicitEulerIntegrator()
+{
+    m_maxIterations = 50;
+    m_tolerance = 1e-6;
+    m_lastIterations = 0;
+    m_lastResidual = 0.0;
+    m_numParticles = 0;
+    m_numSprings = 0;
+    m_indexA = NULL;
+    m_indexB = NULL;
+    m_warmStart = false;
+}
+
+
+//===========================================================================
+/*!
+    Forget the warm start, for instance after a restart.
+
+    \fn     void cImplicitEulerIntegrator::reset()
+*/
+//===========================================================================
+void cImplicitEulerIntegrator::reset()
+{
+    m_warmStart = false;
+}
+
+
+//===========================================================================
+/*!
+    Backward Euler step. If the force model exposes no springs, only the
+    drag is treated implicitly.
+
+    \fn     void cImplicitEulerIntegrator::integrate(cParticleForceModel& a_model,
+            cParticleArrays& a_particles, const double a_dt)
+    \param  a_model  Force model.
+    \param  a_particles  Particles to advance.
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cImplicitEulerIntegrator::integrate(cParticleForceModel& a_model,
+                                         cParticleArrays& a_particles,
+                                         const double a_dt)
+{
+    static const cSpringTable noSprings;
+    const cSpringTable* springs = a_model.getImplicitSprings();
+    if (springs == NULL) { springs = &noSprings; }
+    unsigned int n = a_particles.getNumParticles();
+    unsigned int size = 3 * n;
+
+    if (n != m_numParticles) { m_warmStart = false; }
+
+    // total force at the start of the step
+    a_model.computeForces(a_particles);
+
+    buildSystem(*springs, a_particles, a_model.getImplicitDrag(), a_dt);
+
+    double* x = &m_dv[0];
+    double* r = &m_residual[0];
+    double* p = &m_direction[0];
+    double* q = &m_product[0];
+    double* z = &m_preconditioned[0];
+    const double* b = &m_rhs[0];
+    const double* invDiag = &m_invDiagonal[0];
+
+    // initial guess: previous solution or zero
+    if (!m_warmStart)
+    {
+        for (unsigned int i=0; i<size; i++) { x[i] = 0.0; }
+    }
+    for (unsigned int i=0; i<n; i++)
+    {
+        x[i] *= m_filter[i];  x[n+i] *= m_filter[i];  x[2*n+i] *= m_filter[i];
+    }
+
+    // r = b - A.x
+    multiply(x, q);
+    for (unsigned int i=0; i<size; i++) { r[i] = b[i] - q[i]; }
+
+    double normB = cDot(b, b, size);
+    double threshold = m_tolerance * m_tolerance * ((normB > 0.0) ? normB : 1.0);
+
+    for (unsigned int i=0; i<size; i++) { z[i] = invDiag[i] * r[i]; p[i] = z[i]; }
+    double rz = cDot(r, z, size);
+
+    unsigned int iteration = 0;
+    double rr = cDot(r, r, size);
+    while ((iteration < m_maxIterations) && (rr > threshold))
+    {
+        multiply(p, q);
+        double pq = cDot(p, q, size);
+        if (pq <= 0.0) { break; }
+
+        double alpha = rz / pq;
+        for (unsigned int i=0; i<size; i++)
+        {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        }
+
+        rr = cDot(r, r, size);
+        iteration++;
+        if (rr <= threshold) { break; }
+
+        for (unsigned int i=0; i<size; i++) { z[i] = invDiag[i] * r[i]; }
+        double rzNew = cDot(r, z, size);
+        double beta = rzNew / rz;
+        rz = rzNew;
+        for (unsigned int i=0; i<size; i++) { p[i] = z[i] + beta * p[i]; }
+    }
+
+    m_lastIterations = iteration;
+    m_lastResidual = sqrt(rr / ((normB > 0.0) ? normB : 1.0));
+    m_warmStart = true;
+
+    // v += dv, x += h.v
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    double* vx = a_particles.m_velX;
+    double* vy = a_particles.m_velY;
+    double* vz = a_particles.m_velZ;
+    for (unsigned int i=0; i<n; i++)
+    {
+        vx[i] += x[i];
+        vy[i] += x[n+i];
+        vz[i] += x[2*n+i];
+        px[i] += vx[i] * a_dt;
+        py[i] += vy[i] * a_dt;
+        pz[i] += vz[i] * a_dt;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Fill the per-spring blocks h.c.ddT + h^2.Ks, the per-particle mass
+    terms, the Jacobi preconditioner and the right hand side
+    h.(f0 - h.Ks.v0). Expects the particle force accumulators to hold f0.
+
+    \fn     void cImplicitEulerIntegrator::buildSystem(const cSpringTable& a_springs,
+            const cParticleArrays& a_particles, const double a_drag,
+            const double a_dt)
+    \param  a_springs  Springs treated implicitly.
+    \param  a_particles  Particle state at the start of the step.
+    \param  a_drag  Linear drag rate.
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cImplicitEulerIntegrator::buildSystem(const cSpringTable& a_springs,
+                                           const cParticleArrays& a_particles,
+                                           const double a_drag,
+                                           const double a_dt)
+{
+    unsigned int n = a_particles.getNumParticles();
+    unsigned int ns = a_springs.getNumSprings();
+    unsigned int size = 3 * n;
+
+    m_numParticles = n;
+    m_numSprings = ns;
+    m_indexA = a_springs.m_indexA;
+    m_indexB = a_springs.m_indexB;
+
+    cGrow(m_blocks, 6 * ns);
+    cGrow(m_mass, n);
+    cGrow(m_filter, n);
+    cGrow(m_rhs, size);
+    cGrow(m_dv, size);
+    cGrow(m_residual, size);
+    cGrow(m_direction, size);
+    cGrow(m_product, size);
+    cGrow(m_preconditioned, size);
+    cGrow(m_invDiagonal, size);
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+    const double* vx = a_particles.m_velX;
+    const double* vy = a_particles.m_velY;
+    const double* vz = a_particles.m_velZ;
+    const double* fx = a_particles.m_forceX;
+    const double* fy = a_particles.m_forceY;
+    const double* fz = a_particles.m_forceZ;
+    const double* w = a_particles.m_invMass;
+
+    double h = a_dt;
+    double* diag = &m_invDiagonal[0];
+
+    // mass terms and explicit part of the right hand side
+    for (unsigned int i=0; i<n; i++)
+    {
+        bool dynamic = (w[i] > 0.0);
+        double m = dynamic ? (1.0 / w[i]) * (1.0 + h * a_drag) : 0.0;
+        m_mass[i] = m;
+        m_filter[i] = dynamic ? 1.0 : 0.0;
+        diag[i] = diag[n+i] = diag[2*n+i] = m;
+        m_rhs[i] = h * fx[i];
+        m_rhs[n+i] = h * fy[i];
+        m_rhs[2*n+i] = h * fz[i];
+    }
+
+    // spring blocks, their diagonal contribution and the -h^2.K.v0 term
+    double h2 = h * h;
+    for (unsigned int s=0; s<ns; s++)
+    {
+        unsigned int a = m_indexA[s];
+        unsigned int b = m_indexB[s];
+        double* block = &m_blocks[6*s];
+
+        double dx = px[b] - px[a];
+        double dy = py[b] - py[a];
+        double dz = pz[b] - pz[a];
+        double length = sqrt(dx*dx + dy*dy + dz*dz);
+        if (length < 1e-12)
+        {
+            for (int k=0; k<6; k++) { block[k] = 0.0; }
+            continue;
+        }
+        dx /= length;  dy /= length;  dz /= length;
+
+        // Ks = k.ddT + k.(1 - L/l).(I - ddT), lateral term clamped at zero
+        double k = a_springs.m_stiffness[s];
+        double lateral = k * (1.0 - a_springs.m_restLength[s] / length);
+        if (lateral < 0.0) { lateral = 0.0; }
+        double axial = h2 * (k - lateral) + h * a_springs.m_damping[s];
+        double iso = h2 * lateral;
+
+        block[0] = axial * dx * dx + iso;
+        block[1] = axial * dx * dy;
+        block[2] = axial * dx * dz;
+        block[3] = axial * dy * dy + iso;
+        block[4] = axial * dy * dz;
+        block[5] = axial * dz * dz + iso;
+
+        diag[a] += block[0];  diag[n+a] += block[3];  diag[2*n+a] += block[5];
+        diag[b] += block[0];  diag[n+b] += block[3];  diag[2*n+b] += block[5];
+
+        // stiffness part only: -h^2.Ks.(va - vb), the damping part of f0 is already explicit
+        double rvx = vx[a] - vx[b];
+        double rvy = vy[a] - vy[b];
+        double rvz = vz[a] - vz[b];
+        double kAxial = h2 * (k - lateral);
+        double kDot = kAxial * (dx * rvx + dy * rvy + dz * rvz);
+        double cx = kDot * dx + iso * rvx;
+        double cy = kDot * dy + iso * rvy;
+        double cz = kDot * dz + iso * rvz;
+        m_rhs[a] -= cx;  m_rhs[n+a] -= cy;  m_rhs[2*n+a] -= cz;
+        m_rhs[b] += cx;  m_rhs[n+b] += cy;  m_rhs[2*n+b] += cz;
+    }
+
+    // Jacobi preconditioner; static rows are filtered out
+    for (unsigned int i=0; i<n; i++)
+    {
+        double f = m_filter[i];
+        for (unsigned int c=0; c<3; c++)
+        {
+            unsigned int j = c * n + i;
+            diag[j] = (diag[j] > 0.0) ? (f / diag[j]) : 0.0;
+            m_rhs[j] *= f;
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Apply the system matrix to a vector without assembling it.
+
+    \fn     void cImplicitEulerIntegrator::multiply(const double* a_in,
+            double* a_out) const
+    \param  a_in  Input vector of size 3N.
+    \param  a_out  Output vector of size 3N.
+*/
+//===========================================================================
+void cImplicitEulerIntegrator::multiply(const double* a_in, double* a_out) const
+{
+    unsigned int n = m_numParticles;
+
+    for (unsigned int i=0; i<n; i++)
+    {
+        a_out[i] = m_mass[i] * a_in[i];
+        a_out[n+i] = m_mass[i] * a_in[n+i];
+        a_out[2*n+i] = m_mass[i] * a_in[2*n+i];
+    }
+
+    for (unsigned int s=0; s<m_numSprings; s++)
+    {
+        unsigned int a = m_indexA[s];
+        unsigned int b = m_indexB[s];
+        const double* block = &m_blocks[6*s];
+
+        double ux = a_in[a] - a_in[b];
+        double uy = a_in[n+a] - a_in[n+b];
+        double uz = a_in[2*n+a] - a_in[2*n+b];
+
+        double yx = block[0] * ux + block[1] * uy + block[2] * uz;
+        double yy = block[1] * ux + block[3] * uy + block[4] * uz;
+        double yz = block[2] * ux + block[4] * uy + block[5] * uz;
+
+        a_out[a] += yx;  a_out[n+a] += yy;  a_out[2*n+a] += yz;
+        a_out[b] -= yx;  a_out[n+b] -= yy;  a_out[2*n+b] -= yz;
+    }
+
+    for (unsigned int i=0; i<n; i++)
+    {
+        a_out[i] *= m_filter[i];
+        a_out[n+i] *= m_filter[i];
+        a_out[2*n+i] *= m_filter[i];
+    }
+}
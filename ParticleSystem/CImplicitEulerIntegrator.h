@@ -0,0 +1,153 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CImplicitEulerIntegratorH
+#define CImplicitEulerIntegratorH
+//---------------------------------------------------------------------------
+#include "CParticleIntegrators.h"
+#include "CSpringTable.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CImplicitEulerIntegrator.h
+
+    \brief
+    <b> Particles </b> \n
+    Backward Euler integration with a preconditioned conjugate gradient.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cImplicitEulerIntegrator
+    \ingroup    particles
+
+    \brief
+    Linearized backward Euler (Baraff and Witkin). Each step solves
+
+        (M + h.D + h^2.K) dv = h.(f0 - h.K.v0)
+
+    for the velocity change \e dv, where \e K and \e D are the stiffness
+    and damping Jacobians of the springs and of the linear drag, then sets
+    v += dv and x += h.v. Springs are treated implicitly; any other force
+    returned by the force model (gravity, ...) is treated explicitly.
+
+    The Jacobian is stored as one symmetric 3x3 block per spring, in a
+    buffer parallel to the spring table, and the system matrix is never
+    assembled: the conjugate gradient applies it spring by spring. It is
+    preconditioned with the block diagonal trace (Jacobi) and starts from
+    the \e dv of the previous step. All buffers persist between steps.
+
+    Compressed springs only contribute their axial stiffness, which
+    keeps the matrix positive definite. Static particles (zero inverse
+    mass) are held fixed by filtering their rows out of the solve.
+*/
+//===========================================================================
+class cImplicitEulerIntegrator : public cParticleIntegrator
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cImplicitEulerIntegrator.
+    cImplicitEulerIntegrator();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Advance \e a_particles by \e a_dt seconds.
+    virtual void integrate(cParticleForceModel& a_model,
+                           cParticleArrays& a_particles,
+                           const double a_dt);
+
+    //! Forget the warm start.
+    virtual void reset();
+
+    //! Type of the scheme.
+    virtual cParticleIntegratorType getType() const { return (C_INTEGRATOR_IMPLICIT_EULER); }
+
+    //! Set the maximum number of conjugate gradient iterations per step.
+    inline void setMaxIterations(const unsigned int a_maxIterations) { m_maxIterations = a_maxIterations; }
+
+    //! Set the relative residual at which the solve stops.
+    inline void setTolerance(const double a_tolerance) { m_tolerance = a_tolerance; }
+
+    //! Number of iterations used by the last step.
+    inline unsigned int getLastIterations() const { return (m_lastIterations); }
+
+    //! Relative residual reached by the last step.
+    inline double getLastResidual() const { return (m_lastResidual); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Compute the spring blocks, the preconditioner and the right hand side.
+    void buildSystem(const cSpringTable& a_springs, const cParticleArrays& a_particles,
+                     const double a_drag, const double a_dt);
+
+    //! a_out = A.a_in, with static particles filtered out.
+    void multiply(const double* a_in, double* a_out) const;
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Solver settings.
+    unsigned int m_maxIterations;
+    double m_tolerance;
+
+    //! Statistics of the last step.
+    unsigned int m_lastIterations;
+    double m_lastResidual;
+
+    //! Problem size of the current buffers.
+    unsigned int m_numParticles;
+    unsigned int m_numSprings;
+
+    //! Spring endpoints used by the current blocks.
+    const unsigned int* m_indexA;
+    const unsigned int* m_indexB;
+
+    //! Per spring symmetric blocks h.c.ddT + h^2.Ks (xx, xy, xz, yy, yz, zz).
+    std::vector<double> m_blocks;
+
+    //! Per particle diagonal term m.(1 + h.drag), zero for static particles.
+    std::vector<double> m_mass;
+
+    //! Per particle filter: 1 for dynamic particles, 0 for static ones.
+    std::vector<double> m_filter;
+
+    //! Vectors of size 3N stored as [x..., y..., z...].
+    std::vector<double> m_rhs;
+    std::vector<double> m_dv;
+    std::vector<double> m_residual;
+    std::vector<double> m_direction;
+    std::vector<double> m_product;
+    std::vector<double> m_preconditioned;
+    std::vector<double> m_invDiagonal;
+
+    //! True if \e m_dv holds the solution of the previous step.
+    bool m_warmStart;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
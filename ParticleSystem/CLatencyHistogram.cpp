@@ -0,0 +1,158 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CLatencyHistogram.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// bucket counting a_value
+static unsigned int bucketIndex(const unsigned long long a_value)
+{
+    if (a_value < C_LATENCY_EXACT_RANGE) { return ((unsigned int)a_value); }
+
+    // shift that brings the value into [64,128)
+    unsigned int shift = 1;
+    while ((a_value >> shift) >= C_LATENCY_EXACT_RANGE) { shift++; }
+    if (shift > C_LATENCY_OCTAVES) { return (C_LATENCY_NUM_BUCKETS - 1); }
+
+    unsigned int sub = (unsigned int)(a_value >> shift) - C_LATENCY_SUB_BUCKETS;
+    return (C_LATENCY_EXACT_RANGE + (shift - 1) * C_LATENCY_SUB_BUCKETS + sub);
+}
+
+// largest value counted by bucket a_index
+static unsigned long long bucketUpperValue(const unsigned int a_index)
+{
+    if (a_index < C_LATENCY_EXACT_RANGE) { return (a_index); }
+
+    unsigned int shift = (a_index - C_LATENCY_EXACT_RANGE) / C_LATENCY_SUB_BUCKETS + 1;
+    unsigned long long sub = C_LATENCY_SUB_BUCKETS + (a_index - C_LATENCY_EXACT_RANGE) % C_LATENCY_SUB_BUCKETS;
+    return (((sub + 1) << shift) - 1);
+}
+
+// increment a counter that only one thread writes, without a locked operation
+static inline void bump(std::atomic<unsigned long long>& a_counter, const unsigned long long a_amount)
+{
+    a_counter.store(a_counter.load(std::memory_order_relaxed) + a_amount,
+                    std::memory_order_relaxed);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cLatencyHistogram.
+
+    \fn     cLatencyHistogram::cLatencyHistogram()
+*/
+//===========================================================================
+cLatencyHistogram::cLatencyHistogram()
+{
+    reset();
+}
+
+
+//===========================================================================
+/*!
+    Count one duration. Values beyond the range of the table are counted
+    in the last bucket, but still update the exact maximum.
+
+    \fn     void cLatencyHistogram::record(const unsigned long long a_nanoseconds)
+    \param  a_nanoseconds  Duration in nanoseconds.
+*/
+//===========================================================================
+void cLatencyHistogram::record(const unsigned long long a_nanoseconds)
+{
+    bump(m_buckets[bucketIndex(a_nanoseconds)], 1);
+    bump(m_sum, a_nanoseconds);
+    if (a_nanoseconds > m_max.load(std::memory_order_relaxed))
+    {
+        m_max.store(a_nanoseconds, std::memory_order_relaxed);
+    }
+
+    // counted last and released, so a reader that acquires the count
+    // (getCount()) sees at least as many bucket entries as records
+    m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+//===========================================================================
+/*!
+    Remove all values.
+
+    \fn     void cLatencyHistogram::reset()
+*/
+//===========================================================================
+void cLatencyHistogram::reset()
+{
+    m_count.store(0, std::memory_order_relaxed);
+    for (unsigned int k=0; k<C_LATENCY_NUM_BUCKETS; k++)
+    {
+        m_buckets[k].store(0, std::memory_order_relaxed);
+    }
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+
+//===========================================================================
+/*!
+    Mean of the recorded values.
+
+    \fn     double cLatencyHistogram::getMean() const
+    \return Return the mean in nanoseconds, or zero if nothing was recorded.
+*/
+//===========================================================================
+double cLatencyHistogram::getMean() const
+{
+    unsigned long long count = getCount();
+    if (count == 0) { return (0.0); }
+    return ((double)getSum() / (double)count);
+}
+
+
+//===========================================================================
+/*!
+    Find the value below which the fraction \e a_fraction of the records
+    fall. The upper edge of the bucket holding that record is returned,
+    never more than the recorded maximum, so the result is at most 1/64
+    above the true value. A fraction of 1 returns the maximum.
+
+    \fn     unsigned long long cLatencyHistogram::getPercentile(const double a_fraction) const
+    \param  a_fraction  Fraction in [0,1], e.g. 0.99 for the 99th percentile.
+    \return Return the percentile in nanoseconds, or zero if nothing was recorded.
+*/
+//===========================================================================
+unsigned long long cLatencyHistogram::getPercentile(const double a_fraction) const
+{
+    unsigned long long count = getCount();
+    if (count == 0) { return (0); }
+
+    double fraction = (a_fraction < 0.0) ? 0.0 : ((a_fraction > 1.0) ? 1.0 : a_fraction);
+    unsigned long long rank = (unsigned long long)(fraction * count + 0.5);
+    if (rank < 1) { rank = 1; }
+
+    unsigned long long max = getMax();
+    if (rank >= count) { return (max); }
+
+    unsigned long long seen = 0;
+    for (unsigned int k=0; k<C_LATENCY_NUM_BUCKETS; k++)
+    {
+        seen += m_buckets[k].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            unsigned long long value = bucketUpperValue(k);
+            return ((value < max) ? value : max);
+        }
+    }
+    return (max);
+}
@@ -0,0 +1,124 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CLatencyHistogramH
+#define CLatencyHistogramH
+//---------------------------------------------------------------------------
+#include <atomic>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CLatencyHistogram.h
+
+    \brief
+    <b> Particles </b> \n
+    Log-linear latency histogram with one writer and lock-free readers.
+*/
+//===========================================================================
+
+//! Buckets per power of two above the exact range (relative error below 1/64).
+const unsigned int C_LATENCY_SUB_BUCKETS = 64;
+
+//! Values below this many nanoseconds are counted exactly.
+const unsigned int C_LATENCY_EXACT_RANGE = 2 * C_LATENCY_SUB_BUCKETS;
+
+//! Powers of two covered above the exact range (up to 2^40 ns, about 18 minutes).
+const unsigned int C_LATENCY_OCTAVES = 33;
+
+//! Total number of buckets.
+const unsigned int C_LATENCY_NUM_BUCKETS = C_LATENCY_EXACT_RANGE +
+                                           C_LATENCY_OCTAVES * C_LATENCY_SUB_BUCKETS;
+
+//===========================================================================
+/*!
+    \class      cLatencyHistogram
+    \ingroup    particles
+
+    \brief
+    cLatencyHistogram counts durations in nanoseconds in the manner of an
+    HDR histogram: values below 128 ns have a bucket each, and every
+    power of two above is split into 64 equal buckets, so any percentile
+    is reported within 1.6 % of the recorded value over the whole range,
+    in a fixed 18 KB table and without allocation after construction.
+
+    Exactly one thread may call \ref record() and \ref reset(). Any other
+    thread may read counts and percentiles while values are recorded;
+    all counters are atomics accessed with relaxed ordering, so a live
+    reading may mix values of two consecutive records but never blocks
+    or slows down the writer.
+*/
+//===========================================================================
+class cLatencyHistogram
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cLatencyHistogram.
+    cLatencyHistogram();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Count one duration in nanoseconds. Writer thread only.
+    void record(const unsigned long long a_nanoseconds);
+
+    //! Remove all values. Writer thread only, or when no thread records.
+    void reset();
+
+    //! Number of values recorded.
+    inline unsigned long long getCount() const { return (m_count.load(std::memory_order_acquire)); }
+
+    //! Largest value recorded, in nanoseconds.
+    inline unsigned long long getMax() const { return (m_max.load(std::memory_order_relaxed)); }
+
+    //! Sum of all values recorded, in nanoseconds.
+    inline unsigned long long getSum() const { return (m_sum.load(std::memory_order_relaxed)); }
+
+    //! Mean value in nanoseconds, zero if empty.
+    double getMean() const;
+
+    //! Value below which a fraction \e a_fraction of the records fall, in nanoseconds.
+    unsigned long long getPercentile(const double a_fraction) const;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Not copyable.
+    cLatencyHistogram(const cLatencyHistogram&);
+    cLatencyHistogram& operator=(const cLatencyHistogram&);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Number of values per bucket.
+    std::atomic<unsigned long long> m_buckets[C_LATENCY_NUM_BUCKETS];
+
+    //! Number of values, sum and maximum.
+    std::atomic<unsigned long long> m_count;
+    std::atomic<unsigned long long> m_sum;
+    std::atomic<unsigned long long> m_max;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,218 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CLoopProfiler.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// prints one row of percentiles in microseconds
+static void printRow(FILE* a_file, const char* a_name, const cLatencyHistogram& a_histogram)
+{
+    if (a_histogram.getCount() == 0)
+    {
+        fprintf(a_file, "  %-14s %10d %10s %10s %10s %10s %10s\n", a_name, 0, "-", "-", "-", "-", "-");
+        return;
+    }
+
+    fprintf(a_file, "  %-14s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n", a_name,
+            a_histogram.getCount(),
+            1e-3 * a_histogram.getMean(),
+            1e-3 * a_histogram.getPercentile(0.5),
+            1e-3 * a_histogram.getPercentile(0.99),
+            1e-3 * a_histogram.getPercentile(0.999),
+            1e-3 * a_histogram.getMax());
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cLoopProfiler.
+
+    \fn     cLoopProfiler::cLoopProfiler(const double a_deadline)
+    \param  a_deadline  Period above which a tick counts as late, in seconds.
+*/
+//===========================================================================
+cLoopProfiler::cLoopProfiler(const double a_deadline)
+{
+    setDeadline(a_deadline);
+    reset();
+}
+
+
+//===========================================================================
+/*!
+    Mark the start of a tick. The period since the start of the previous
+    completed tick is recorded at \ref endTick().
+
+    \fn     void cLoopProfiler::beginTick()
+*/
+//===========================================================================
+void cLoopProfiler::beginTick()
+{
+    m_tickStart = now();
+    m_phaseStart = m_tickStart;
+    for (int k=0; k<C_NUM_LOOP_PHASES; k++)
+    {
+        m_tickPhases[k] = 0;
+        m_tickPhaseUsed[k] = false;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Charge the time elapsed since the previous phase boundary (the start
+    of the tick, or the last call to \ref endPhase() or \ref skipPhase())
+    to \e a_phase.
+
+    \fn     void cLoopProfiler::endPhase(const cLoopPhase a_phase)
+    \param  a_phase  Phase that just ended.
+*/
+//===========================================================================
+void cLoopProfiler::endPhase(const cLoopPhase a_phase)
+{
+    unsigned long long time = now();
+    m_tickPhases[a_phase] += time - m_phaseStart;
+    m_tickPhaseUsed[a_phase] = true;
+    m_phaseStart = time;
+}
+
+
+//===========================================================================
+/*!
+    Mark the end of the tick: record its duration, its period and the
+    total time of every phase charged during the tick.
+
+    \fn     void cLoopProfiler::endTick()
+*/
+//===========================================================================
+void cLoopProfiler::endTick()
+{
+    unsigned long long time = now();
+
+    for (int k=0; k<C_NUM_LOOP_PHASES; k++)
+    {
+        if (m_tickPhaseUsed[k])
+        {
+            m_phases[k].record(m_tickPhases[k]);
+        }
+    }
+    m_ticks.record(time - m_tickStart);
+
+    if (m_lastTickStart != 0)
+    {
+        unsigned long long period = m_tickStart - m_lastTickStart;
+        m_periods.record(period);
+        if (period > m_deadline)
+        {
+            m_numLateTicks.store(m_numLateTicks.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+        }
+    }
+    m_lastTickStart = m_tickStart;
+}
+
+
+//===========================================================================
+/*!
+    Remove all statistics. The next tick has no period.
+
+    \fn     void cLoopProfiler::reset()
+*/
+//===========================================================================
+void cLoopProfiler::reset()
+{
+    for (int k=0; k<C_NUM_LOOP_PHASES; k++)
+    {
+        m_phases[k].reset();
+        m_tickPhases[k] = 0;
+        m_tickPhaseUsed[k] = false;
+    }
+    m_ticks.reset();
+    m_periods.reset();
+    m_tickStart = 0;
+    m_lastTickStart = 0;
+    m_phaseStart = 0;
+    m_numLateTicks.store(0, std::memory_order_relaxed);
+}
+
+
+//===========================================================================
+/*!
+    Achieved loop rate, from the mean period between tick starts.
+
+    \fn     double cLoopProfiler::getLoopRate() const
+    \return Return the rate in Hz, or zero before two ticks were completed.
+*/
+//===========================================================================
+double cLoopProfiler::getLoopRate() const
+{
+    double mean = m_periods.getMean();
+    if (mean <= 0.0) { return (0.0); }
+    return (1e9 / mean);
+}
+
+
+//===========================================================================
+/*!
+    Print, for every phase and for whole ticks and periods, the count,
+    the mean and the 50th, 99th and 99.9th percentiles and the maximum in
+    microseconds, followed by the loop rate and the late ticks. May be
+    called from any thread while the loop runs.
+
+    \fn     void cLoopProfiler::print(FILE* a_file, const char* a_title) const
+    \param  a_file  Output stream, e.g. stdout.
+    \param  a_title  Title line.
+*/
+//===========================================================================
+void cLoopProfiler::print(FILE* a_file, const char* a_title) const
+{
+    fprintf(a_file, "%s\n", a_title);
+    fprintf(a_file, "  %-14s %10s %10s %10s %10s %10s %10s\n",
+            "[us]", "count", "mean", "p50", "p99", "p99.9", "max");
+    for (int k=0; k<C_NUM_LOOP_PHASES; k++)
+    {
+        printRow(a_file, getPhaseName((cLoopPhase)k), m_phases[k]);
+    }
+    printRow(a_file, "tick", m_ticks);
+    printRow(a_file, "period", m_periods);
+
+    unsigned long long periods = m_periods.getCount();
+    unsigned long long late = getNumLateTicks();
+    fprintf(a_file, "  loop rate %.1f Hz, %llu late ticks above %.0f us (%.3f %%)\n",
+            getLoopRate(), late, 1e-3 * m_deadline,
+            (periods > 0) ? 100.0 * late / periods : 0.0);
+}
+
+
+//===========================================================================
+/*!
+    Name of a phase, for printing.
+
+    \fn     const char* cLoopProfiler::getPhaseName(const cLoopPhase a_phase)
+    \param  a_phase  Phase.
+    \return Return a short name.
+*/
+//===========================================================================
+const char* cLoopProfiler::getPhaseName(const cLoopPhase a_phase)
+{
+    switch (a_phase)
+    {
+        case C_LOOP_PHASE_DEVICE_READ:  return ("device read");
+        case C_LOOP_PHASE_FORCES:       return ("forces");
+        case C_LOOP_PHASE_COLLISION:    return ("collision");
+        case C_LOOP_PHASE_DEVICE_WRITE: return ("device write");
+        default:                        return ("unknown");
+    }
+}
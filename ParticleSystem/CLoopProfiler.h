@@ -0,0 +1,183 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CLoopProfilerH
+#define CLoopProfilerH
+//---------------------------------------------------------------------------
+#include "CLatencyHistogram.h"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CLoopProfiler.h
+
+    \brief
+    <b> Particles </b> \n
+    Per-phase latency profiling of a servo loop.
+*/
+//===========================================================================
+
+//! Phases of one tick of a haptics loop.
+enum cLoopPhase
+{
+    C_LOOP_PHASE_DEVICE_READ,       //!< reading position, velocity and buttons of the device
+    C_LOOP_PHASE_FORCES,            //!< computing forces and integrating the simulation
+    C_LOOP_PHASE_COLLISION,         //!< detecting and resolving contacts
+    C_LOOP_PHASE_DEVICE_WRITE,      //!< sending the force to the device
+    C_NUM_LOOP_PHASES
+};
+
+//===========================================================================
+/*!
+    \class      cLoopProfiler
+    \ingroup    particles
+
+    \brief
+    cLoopProfiler times every tick of a servo loop and the phases within
+    it, with one \ref cLatencyHistogram each:
+
+    \code
+    profiler.beginTick();
+    readDevice();       profiler.endPhase(C_LOOP_PHASE_DEVICE_READ);
+    updateCursor();     profiler.skipPhase();
+    computeForce();     profiler.endPhase(C_LOOP_PHASE_FORCES);
+    profiler.endTick();
+    \endcode
+
+    \ref endPhase() charges the time since the previous phase boundary to
+    a phase; a phase may be charged several times per tick (once per
+    device, or once per substep) and is recorded once, as its total, at
+    \ref endTick(). Work that belongs to no phase is passed over with
+    \ref skipPhase() and only counts in the tick duration.
+
+    Besides the phases, the profiler records the duration of each tick
+    and the period between the starts of consecutive ticks, from which
+    the achieved loop rate and the number of late ticks (period above the
+    deadline) follow. A tick started but not ended, e.g. an idle pass of
+    a fixed timestep loop, is simply restarted by the next
+    \ref beginTick().
+
+    All timing methods must be called from the loop thread. Statistics
+    may be read and printed from any thread while the loop runs.
+*/
+//===========================================================================
+class cLoopProfiler
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cLoopProfiler.
+    cLoopProfiler(const double a_deadline = 0.001);
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Mark the start of a tick.
+    void beginTick();
+
+    //! Charge the time since the last phase boundary to \e a_phase.
+    void endPhase(const cLoopPhase a_phase);
+
+    //! Move the phase boundary without charging any phase.
+    inline void skipPhase() { m_phaseStart = now(); }
+
+    //! Mark the end of the tick and record its phases.
+    void endTick();
+
+    //! Remove all statistics. Loop thread only, or when the loop is stopped.
+    void reset();
+
+    //! Set the period above which a tick counts as late, in seconds.
+    inline void setDeadline(const double a_deadline) { m_deadline = (unsigned long long)(a_deadline * 1e9); }
+
+    //! Period above which a tick counts as late, in seconds.
+    inline double getDeadline() const { return (1e-9 * m_deadline); }
+
+    //! Histogram of the time spent in phase \e a_phase per tick.
+    inline const cLatencyHistogram& getPhase(const cLoopPhase a_phase) const { return (m_phases[a_phase]); }
+
+    //! Histogram of the tick durations.
+    inline const cLatencyHistogram& getTicks() const { return (m_ticks); }
+
+    //! Histogram of the periods between tick starts.
+    inline const cLatencyHistogram& getPeriods() const { return (m_periods); }
+
+    //! Number of ticks whose period exceeded the deadline.
+    inline unsigned long long getNumLateTicks() const { return (m_numLateTicks.load(std::memory_order_relaxed)); }
+
+    //! Achieved loop rate in Hz, from the mean period.
+    double getLoopRate() const;
+
+    //! Print a table of percentiles per phase, the loop rate and the late ticks.
+    void print(FILE* a_file, const char* a_title) const;
+
+    //! Name of phase \e a_phase.
+    static const char* getPhaseName(const cLoopPhase a_phase);
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Current time in nanoseconds.
+    static inline unsigned long long now()
+    {
+        return ((unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    //! Not copyable.
+    cLoopProfiler(const cLoopProfiler&);
+    cLoopProfiler& operator=(const cLoopProfiler&);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Time per phase, per tick.
+    cLatencyHistogram m_phases[C_NUM_LOOP_PHASES];
+
+    //! Tick durations and periods.
+    cLatencyHistogram m_ticks;
+    cLatencyHistogram m_periods;
+
+    //! Time charged to each phase during the current tick [ns].
+    unsigned long long m_tickPhases[C_NUM_LOOP_PHASES];
+
+    //! Phases charged during the current tick.
+    bool m_tickPhaseUsed[C_NUM_LOOP_PHASES];
+
+    //! Start of the current tick, of the previous completed tick, and of the current phase [ns].
+    unsigned long long m_tickStart;
+    unsigned long long m_lastTickStart;
+    unsigned long long m_phaseStart;
+
+    //! Late tick threshold [ns].
+    unsigned long long m_deadline;
+
+    //! Number of late ticks.
+    std::atomic<unsigned long long> m_numLateTicks;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
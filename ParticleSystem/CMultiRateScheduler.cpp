@@ -0,0 +1,254 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CMultiRateScheduler.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <thread>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cMultiRateScheduler.
+
+    \fn     cMultiRateScheduler::cMultiRateScheduler(const double a_servoRate,
+            const double a_physicsRate, const double a_renderRate)
+    \param  a_servoRate  Servo rate in Hz.
+    \param  a_physicsRate  Physics rate in Hz.
+    \param  a_renderRate  Render rate in Hz.
+*/
+//===========================================================================
+cMultiRateScheduler::cMultiRateScheduler(const double a_servoRate, const double a_physicsRate,
+                                         const double a_renderRate)
+{
+    m_servo.m_period = 0.001;
+    m_render.m_period = 1.0 / 60.0;
+    m_spinTime = std::chrono::microseconds(200);
+
+    setServoRate(a_servoRate);
+    setRenderRate(a_renderRate);
+    setPhysicsRate(a_physicsRate);
+
+    m_servo.start();
+    m_render.start();
+}
+
+
+//===========================================================================
+/*!
+    Set the servo rate. Non-positive rates are ignored. The physics rate
+    is kept, so its number of substeps or its interpolation follows.
+
+    \fn     void cMultiRateScheduler::setServoRate(const double a_rate)
+    \param  a_rate  Servo rate in Hz.
+*/
+//===========================================================================
+void cMultiRateScheduler::setServoRate(const double a_rate)
+{
+    if (a_rate <= 0.0) { return; }
+
+    m_servo.m_period = 1.0 / a_rate;
+    m_servoProfiler.setDeadline(1.5 * m_servo.m_period);
+    updatePhysics();
+}
+
+
+//===========================================================================
+/*!
+    Set the physics rate. At or above the servo rate, every servo tick
+    takes the physics steps of one servo period; below, a step is taken
+    on the servo ticks where one is due. Non-positive rates are ignored.
+
+    \fn     void cMultiRateScheduler::setPhysicsRate(const double a_rate)
+    \param  a_rate  Physics rate in Hz.
+*/
+//===========================================================================
+void cMultiRateScheduler::setPhysicsRate(const double a_rate)
+{
+    if (a_rate <= 0.0) { return; }
+
+    m_physicsClock.setRate(a_rate);
+    updatePhysics();
+}
+
+
+//===========================================================================
+/*!
+    Set the render rate. Non-positive rates are ignored.
+
+    \fn     void cMultiRateScheduler::setRenderRate(const double a_rate)
+    \param  a_rate  Render rate in Hz.
+*/
+//===========================================================================
+void cMultiRateScheduler::setRenderRate(const double a_rate)
+{
+    if (a_rate <= 0.0) { return; }
+
+    m_render.m_period = 1.0 / a_rate;
+    m_renderProfiler.setDeadline(1.5 * m_render.m_period);
+}
+
+
+//===========================================================================
+/*!
+    Start the servo clock and clear the physics accumulator. The first
+    call to \ref beginServoTick() returns at once.
+
+    \fn     void cMultiRateScheduler::start()
+*/
+//===========================================================================
+void cMultiRateScheduler::start()
+{
+    m_physicsClock.reset();
+    m_servo.start();
+}
+
+
+//===========================================================================
+/*!
+    Wait for the next servo deadline, start timing the tick and advance
+    the physics clock by one servo period.
+
+    \fn     unsigned int cMultiRateScheduler::beginServoTick()
+    \return Return the number of physics steps of \ref getPhysicsTimeStep()
+            seconds to take during this tick.
+*/
+//===========================================================================
+unsigned int cMultiRateScheduler::beginServoTick()
+{
+    m_servo.wait(m_spinTime);
+    m_servoProfiler.beginTick();
+
+    return (m_physicsClock.advance(m_servo.m_period));
+}
+
+
+//===========================================================================
+/*!
+    Wait for the next render deadline and start timing the frame.
+
+    \fn     void cMultiRateScheduler::beginRenderFrame()
+*/
+//===========================================================================
+void cMultiRateScheduler::beginRenderFrame()
+{
+    m_render.wait(m_spinTime);
+    m_renderProfiler.beginTick();
+}
+
+
+//===========================================================================
+/*!
+    Print the loop statistics of the servo, physics and render rates,
+    with the deadlines each of them skipped.
+
+    \fn     void cMultiRateScheduler::print(FILE* a_file) const
+    \param  a_file  Output stream, e.g. stdout.
+*/
+//===========================================================================
+void cMultiRateScheduler::print(FILE* a_file) const
+{
+    char title[96];
+
+    snprintf(title, sizeof(title), "servo loop (%.0f Hz):", getServoRate());
+    m_servoProfiler.print(a_file, title);
+    fprintf(a_file, "  %llu deadlines skipped\n", getNumSkippedServoTicks());
+
+    if (isPhysicsInterpolated())
+    {
+        snprintf(title, sizeof(title), "physics (%.0f Hz, interpolated):", getPhysicsRate());
+    }
+    else
+    {
+        snprintf(title, sizeof(title), "physics (%.0f Hz, %.0f substeps per servo tick):",
+                 getPhysicsRate(), getServoPeriod() / getPhysicsTimeStep());
+    }
+    m_physicsProfiler.print(a_file, title);
+
+    snprintf(title, sizeof(title), "render (%.0f Hz):", getRenderRate());
+    m_renderProfiler.print(a_file, title);
+    fprintf(a_file, "  %llu deadlines skipped\n", getNumSkippedRenderFrames());
+}
+
+
+//===========================================================================
+/*!
+    Let the physics clock return every step due in a servo period, and
+    set the physics deadline. Physics ticks land on servo ticks, so a
+    rate that does not divide the servo rate alternates between two
+    whole numbers of servo periods; a physics tick is late when it comes
+    half a servo period after the longer of the two.
+
+    \fn     void cMultiRateScheduler::updatePhysics()
+*/
+//===========================================================================
+void cMultiRateScheduler::updatePhysics()
+{
+    double servoPeriod = m_servo.m_period;
+    double physicsPeriod = m_physicsClock.getTimeStep();
+
+    // one more than needed absorbs the rounding of the accumulator
+    m_physicsClock.setMaxSubsteps((unsigned int)ceil(servoPeriod / physicsPeriod) + 1);
+
+    double ticks = ceil(physicsPeriod / servoPeriod - 1e-9);
+    m_physicsProfiler.setDeadline((fmax(ticks, 1.0) + 0.5) * servoPeriod);
+}
+
+
+//===========================================================================
+/*!
+    Make the next deadline due now.
+
+    \fn     void cMultiRateScheduler::cPacer::start()
+*/
+//===========================================================================
+void cMultiRateScheduler::cPacer::start()
+{
+    m_next = std::chrono::steady_clock::now();
+    m_numSkipped.store(0, std::memory_order_relaxed);
+}
+
+
+//===========================================================================
+/*!
+    Wait for the next deadline: sleep until \e a_spinTime before it,
+    then spin. If the deadline has passed already, return at once and
+    skip the deadlines missed, so that the next one stays on the grid
+    of periods.
+
+    \fn     void cMultiRateScheduler::cPacer::wait(const std::chrono::nanoseconds a_spinTime)
+    \param  a_spinTime  Time spent spinning before the deadline.
+*/
+//===========================================================================
+void cMultiRateScheduler::cPacer::wait(const std::chrono::nanoseconds a_spinTime)
+{
+    std::chrono::steady_clock::duration period =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(m_period));
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (now < m_next)
+    {
+        if (m_next - now > a_spinTime)
+        {
+            std::this_thread::sleep_until(m_next - a_spinTime);
+        }
+        while (std::chrono::steady_clock::now() < m_next) {}
+        m_next += period;
+        return;
+    }
+
+    // late: the deadlines that went by are skipped
+    long long missed = (long long)((now - m_next) / period);
+    m_numSkipped.store(m_numSkipped.load(std::memory_order_relaxed) + (unsigned long long)missed,
+                       std::memory_order_relaxed);
+    m_next += (missed + 1) * period;
+}
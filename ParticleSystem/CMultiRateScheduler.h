@@ -0,0 +1,221 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CMultiRateSchedulerH
+#define CMultiRateSchedulerH
+//---------------------------------------------------------------------------
+#include "CFixedTimestep.h"
+#include "CLoopProfiler.h"
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CMultiRateScheduler.h
+
+    \brief
+    <b> Particles </b> \n
+    Servo, physics and render rates of a haptic simulation.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cMultiRateScheduler
+    \ingroup    particles
+
+    \brief
+    cMultiRateScheduler paces the three rates of a haptic simulation:
+
+    - the servo loop, which reads the device and sends its force, runs
+      at a fixed rate (1 kHz by default) on the haptics thread. Ticks
+      start at absolute deadlines: the thread sleeps until shortly
+      before the deadline and spins for the rest, so that sleep
+      granularity does not lower the rate. Deadlines that have already
+      passed when a tick ends are skipped and counted, rather than
+      caught up in a burst.
+    - the physics runs on the servo thread, either in N substeps per
+      servo tick when its rate is a multiple of the servo rate or above,
+      or at its own lower rate. The physics clock advances by exactly one
+      servo period per tick, so the simulation follows the servo clock
+      and not the jitter of the wall clock. Below the servo rate,
+      \ref getInterpolationFactor() tells how far the servo tick lies
+      between the last two physics states.
+    - rendering, paced the same way at the display rate on the graphics
+      thread.
+
+    Each rate has its own \ref cLoopProfiler. A tick is late when its
+    period exceeds one and a half periods of its rate, which leaves room
+    for timer jitter but catches any missed deadline. The servo profiler
+    is meant for the device phases, the physics profiler for the phases
+    of the simulation step.
+
+    Servo and physics methods must be called from the haptics thread,
+    render methods from the graphics thread. Statistics may be printed
+    from any thread.
+*/
+//===========================================================================
+class cMultiRateScheduler
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cMultiRateScheduler.
+    cMultiRateScheduler(const double a_servoRate = 1000.0, const double a_physicsRate = 1000.0,
+                        const double a_renderRate = 60.0);
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Set the servo rate in Hz. Servo thread only, or before \ref start().
+    void setServoRate(const double a_rate);
+
+    //! Servo rate in Hz.
+    inline double getServoRate() const { return (1.0 / m_servo.m_period); }
+
+    //! Servo period in seconds.
+    inline double getServoPeriod() const { return (m_servo.m_period); }
+
+    //! Set the physics rate in Hz. Servo thread only, or before \ref start().
+    void setPhysicsRate(const double a_rate);
+
+    //! Physics rate in Hz.
+    inline double getPhysicsRate() const { return (m_physicsClock.getRate()); }
+
+    //! Length of one physics step in seconds.
+    inline double getPhysicsTimeStep() const { return (m_physicsClock.getTimeStep()); }
+
+    //! True if the physics runs below the servo rate and its states are interpolated.
+    inline bool isPhysicsInterpolated() const { return (m_physicsClock.getTimeStep() > m_servo.m_period); }
+
+    //! Set the render rate in Hz. Graphics thread only.
+    void setRenderRate(const double a_rate);
+
+    //! Render rate in Hz.
+    inline double getRenderRate() const { return (1.0 / m_render.m_period); }
+
+    //! Set how long before a deadline the waiting thread stops sleeping and spins [s].
+    inline void setSpinTime(const double a_spinTime) { m_spinTime = std::chrono::nanoseconds((long long)(a_spinTime * 1e9)); }
+
+    //! Start the servo and physics clocks; the first servo tick is due now.
+    void start();
+
+    //! Wait for the next servo deadline and start the tick. Returns the number of physics steps due.
+    unsigned int beginServoTick();
+
+    //! End the servo tick.
+    inline void endServoTick() { m_servoProfiler.endTick(); }
+
+    //! Start timing the physics steps of the current servo tick.
+    inline void beginPhysics() { m_physicsProfiler.beginTick(); }
+
+    //! End timing the physics steps of the current servo tick.
+    inline void endPhysics() { m_physicsProfiler.endTick(); }
+
+    //! Drop the physics time accumulated so far, e.g. after a restart.
+    inline void resetPhysicsClock() { m_physicsClock.reset(); }
+
+    //! Fraction of a physics step elapsed since the last one, in [0,1); 0 when substepping.
+    inline double getInterpolationFactor() const { return (isPhysicsInterpolated() ? m_physicsClock.getInterpolationFactor() : 0.0); }
+
+    //! Wait for the next render deadline and start the frame.
+    void beginRenderFrame();
+
+    //! End the render frame.
+    inline void endRenderFrame() { m_renderProfiler.endTick(); }
+
+    //! Profiler of the servo ticks.
+    inline cLoopProfiler& getServoProfiler() { return (m_servoProfiler); }
+
+    //! Profiler of the physics steps.
+    inline cLoopProfiler& getPhysicsProfiler() { return (m_physicsProfiler); }
+
+    //! Profiler of the render frames.
+    inline cLoopProfiler& getRenderProfiler() { return (m_renderProfiler); }
+
+    //! Number of servo deadlines skipped because a tick overran.
+    inline unsigned long long getNumSkippedServoTicks() const { return (m_servo.m_numSkipped.load(std::memory_order_relaxed)); }
+
+    //! Number of render deadlines skipped because a frame overran.
+    inline unsigned long long getNumSkippedRenderFrames() const { return (m_render.m_numSkipped.load(std::memory_order_relaxed)); }
+
+    //! Print the statistics of the three rates.
+    void print(FILE* a_file) const;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // TYPES:
+    //-----------------------------------------------------------------------
+
+    //! Deadlines of one rate.
+    struct cPacer
+    {
+        //! Period [s].
+        double m_period;
+
+        //! Next deadline.
+        std::chrono::steady_clock::time_point m_next;
+
+        //! Deadlines skipped, written by the paced thread and read by \ref print().
+        std::atomic<unsigned long long> m_numSkipped;
+
+        //! Make the next deadline due now.
+        void start();
+
+        //! Wait for the next deadline, spinning for the last \e a_spinTime.
+        void wait(const std::chrono::nanoseconds a_spinTime);
+    };
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Size the physics clock and the physics deadline after a rate change.
+    void updatePhysics();
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Servo and render deadlines.
+    cPacer m_servo;
+    cPacer m_render;
+
+    //! Physics steps due per servo period.
+    cFixedTimestep m_physicsClock;
+
+    //! Time spent spinning before a deadline.
+    std::chrono::nanoseconds m_spinTime;
+
+    //! Statistics of each rate.
+    cLoopProfiler m_servoProfiler;
+    cLoopProfiler m_physicsProfiler;
+    cLoopProfiler m_renderProfiler;
+
+    //! Not copyable.
+    cMultiRateScheduler(const cMultiRateScheduler&);
+    cMultiRateScheduler& operator=(const cMultiRateScheduler&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
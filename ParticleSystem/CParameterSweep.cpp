@@ -0,0 +1,647 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParameterSweep.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// columns written after the parameters, in order
+static const char* const s_metricColumns[] =
+{
+    "random", "seed", "settle_time", "max_penetration", "energy_drift",
+    "final_energy", "bounces", "steps", "stable"
+};
+static const unsigned int s_numMetricColumns = 9;
+
+// value number a_index of a_count evenly spaced over a_range
+static double gridValue(const cSweepRange& a_range, const unsigned int a_index)
+{
+    if (a_range.m_count <= 1) { return (a_range.m_min); }
+    return (a_range.m_min + (a_range.m_max - a_range.m_min) * a_index / (a_range.m_count - 1));
+}
+
+// kinetic energy, work of the constant external force and spring energy
+static double totalEnergy(const cParticleSimulation& a_sim)
+{
+    const cParticleArrays& p = a_sim.m_particles;
+    const cSpringTable& s = a_sim.m_springs;
+    double energy = 0.0;
+
+    for (unsigned int i=0; i<p.getNumParticles(); i++)
+    {
+        if (p.m_invMass[i] <= 0.0) { continue; }
+        double v2 = p.m_velX[i] * p.m_velX[i] + p.m_velY[i] * p.m_velY[i] + p.m_velZ[i] * p.m_velZ[i];
+        energy += 0.5 * v2 / p.m_invMass[i];
+        energy -= a_sim.m_externalForce[0] * p.m_posX[i] +
+                  a_sim.m_externalForce[1] * p.m_posY[i] +
+                  a_sim.m_externalForce[2] * p.m_posZ[i];
+    }
+
+    for (unsigned int k=0; k<s.getNumSprings(); k++)
+    {
+        unsigned int a = s.m_indexA[k];
+        unsigned int b = s.m_indexB[k];
+        double dx = p.m_posX[b] - p.m_posX[a];
+        double dy = p.m_posY[b] - p.m_posY[a];
+        double dz = p.m_posZ[b] - p.m_posZ[a];
+        double stretch = sqrt(dx * dx + dy * dy + dz * dz) - s.m_restLength[k];
+        energy += 0.5 * s.m_stiffness[k] * stretch * stretch;
+    }
+
+    return (energy);
+}
+
+// largest speed of the particles, or a negative value if the state is not finite
+static double maxSpeed(const cParticleArrays& a_particles)
+{
+    double max2 = 0.0;
+    for (unsigned int i=0; i<a_particles.getNumParticles(); i++)
+    {
+        double v2 = a_particles.m_velX[i] * a_particles.m_velX[i] +
+                    a_particles.m_velY[i] * a_particles.m_velY[i] +
+                    a_particles.m_velZ[i] * a_particles.m_velZ[i];
+        double x = a_particles.m_posX[i] + a_particles.m_posY[i] + a_particles.m_posZ[i];
+        if (!isfinite(v2) || !isfinite(x)) { return (-1.0); }
+        if (v2 > max2) { max2 = v2; }
+    }
+    return (sqrt(max2));
+}
+
+// summary of a run built step by step, for single and ensemble runs
+struct cRunTracker
+{
+    cSweepMetrics m_metrics;
+    double m_initialEnergy;
+    double m_energyScale;
+    double m_maxEnergy;
+    double m_lastMoving;
+    std::vector<double> m_lastVelZ;
+    bool m_running;
+
+    // starts with the initial state of a_sim
+    void begin(const cParticleSimulation& a_sim)
+    {
+        m_metrics.m_maxPenetration = 0.0;
+        m_metrics.m_energyDrift = 0.0;
+        m_metrics.m_numBounces = 0;
+        m_metrics.m_numSteps = 0;
+        m_metrics.m_stable = true;
+
+        m_initialEnergy = totalEnergy(a_sim);
+        m_energyScale = (fabs(m_initialEnergy) > 1e-12) ? fabs(m_initialEnergy) : 1.0;
+        m_maxEnergy = m_initialEnergy;
+        m_lastMoving = 0.0;
+        m_lastVelZ.assign(a_sim.m_particles.getNumParticles(), 0.0);
+        m_running = true;
+    }
+
+    // accounts for the step that led to the state of a_sim; stops the run
+    // once the state is no longer finite
+    void update(const cParticleSimulation& a_sim, const unsigned int a_numContacts,
+                const double a_penetration, const double a_settleSpeed)
+    {
+        m_metrics.m_numSteps++;
+
+        double speed = maxSpeed(a_sim.m_particles);
+        if (speed < 0.0)
+        {
+            m_metrics.m_stable = false;
+            m_running = false;
+            return;
+        }
+        if (speed > a_settleSpeed) { m_lastMoving = a_sim.getTime(); }
+
+        // a bounce sends a particle back up faster than it could settle;
+        // resting particles touch the shape every other step and do not count
+        const cParticleArrays& particles = a_sim.m_particles;
+        for (unsigned int i=0; i<particles.getNumParticles(); i++)
+        {
+            double vz = particles.m_velZ[i];
+            if ((a_numContacts > 0) && (m_lastVelZ[i] < -a_settleSpeed) && (vz > a_settleSpeed))
+            {
+                m_metrics.m_numBounces++;
+            }
+            m_lastVelZ[i] = vz;
+        }
+
+        if (a_penetration > m_metrics.m_maxPenetration)
+        {
+            m_metrics.m_maxPenetration = a_penetration;
+        }
+
+        double energy = totalEnergy(a_sim);
+        if (energy > m_maxEnergy) { m_maxEnergy = energy; }
+    }
+
+    // completes the summary with the final state of a_sim
+    const cSweepMetrics& end(const cParticleSimulation& a_sim)
+    {
+        bool settled = m_metrics.m_stable && (m_lastMoving < a_sim.getTime());
+        m_metrics.m_settleTime = settled ? m_lastMoving : NAN;
+        m_metrics.m_finalEnergy = m_metrics.m_stable ? totalEnergy(a_sim) : NAN;
+        m_metrics.m_energyDrift = m_metrics.m_stable ? (m_maxEnergy - m_initialEnergy) / m_energyScale : NAN;
+        return (m_metrics);
+    }
+};
+
+
+//===========================================================================
+/*!
+    Constructor of cParameterSweep. Runs last 5 s at 1 kHz with the
+    default integrator, and particles slower than 1 cm/s count as
+    settled.
+
+    \fn     cParameterSweep::cParameterSweep()
+*/
+//===========================================================================
+cParameterSweep::cParameterSweep()
+{
+    m_duration = 5.0;
+    m_timeStep = 0.001;
+    m_integrator = C_DEFAULT_PARTICLE_INTEGRATOR;
+    m_settleSpeed = 0.01;
+    m_useEnsemble = false;
+}
+
+
+//===========================================================================
+/*!
+    Add the full grid over \e a_ranges. The last parameter varies
+    fastest, and the start positions fastest of all: with \e a_numSeeds
+    of zero every sample starts at the fixed positions of the demo,
+    otherwise at random positions drawn from seeds 1 to \e a_numSeeds.
+
+    \fn     void cParameterSweep::addGrid(const cSweepRange a_ranges[C_NUM_SWEEP_PARAMETERS],
+            const unsigned int a_numSeeds)
+    \param  a_ranges  Values of every parameter.
+    \param  a_numSeeds  Number of random start positions per combination.
+*/
+//===========================================================================
+void cParameterSweep::addGrid(const cSweepRange a_ranges[C_NUM_SWEEP_PARAMETERS],
+                              const unsigned int a_numSeeds)
+{
+    unsigned int count[C_NUM_SWEEP_PARAMETERS];
+    unsigned long long total = 1;
+    for (int k=0; k<C_NUM_SWEEP_PARAMETERS; k++)
+    {
+        count[k] = (a_ranges[k].m_count > 0) ? a_ranges[k].m_count : 1;
+        total *= count[k];
+    }
+
+    unsigned int seeds = (a_numSeeds > 0) ? a_numSeeds : 1;
+    m_samples.reserve(m_samples.size() + (size_t)(total * seeds));
+
+    for (unsigned long long combination=0; combination<total; combination++)
+    {
+        cSweepSample sample;
+        unsigned long long rest = combination;
+        for (int k=C_NUM_SWEEP_PARAMETERS-1; k>=0; k--)
+        {
+            sample.m_parameters[k] = gridValue(a_ranges[k], (unsigned int)(rest % count[k]));
+            rest /= count[k];
+        }
+        for (unsigned int s=0; s<seeds; s++)
+        {
+            sample.m_random = (a_numSeeds > 0);
+            sample.m_seed = s + 1;
+            m_samples.push_back(sample);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Add \e a_count samples whose parameters are drawn uniformly in
+    \e a_ranges (the counts of the ranges are ignored). Random samples
+    cover many parameters better than a grid of the same size.
+
+    \fn     void cParameterSweep::addRandom(const cSweepRange a_ranges[C_NUM_SWEEP_PARAMETERS],
+            const unsigned int a_count, const unsigned int a_numSeeds,
+            const uint64_t a_seed)
+    \param  a_ranges  Bounds of every parameter.
+    \param  a_count  Number of parameter combinations.
+    \param  a_numSeeds  Number of random start positions per combination, 0 for the fixed start.
+    \param  a_seed  Seed of the parameter values.
+*/
+//===========================================================================
+void cParameterSweep::addRandom(const cSweepRange a_ranges[C_NUM_SWEEP_PARAMETERS],
+                                const unsigned int a_count, const unsigned int a_numSeeds,
+                                const uint64_t a_seed)
+{
+    cParticleRandom random(a_seed);
+    unsigned int seeds = (a_numSeeds > 0) ? a_numSeeds : 1;
+    m_samples.reserve(m_samples.size() + (size_t)a_count * seeds);
+
+    for (unsigned int n=0; n<a_count; n++)
+    {
+        cSweepSample sample;
+        for (int k=0; k<C_NUM_SWEEP_PARAMETERS; k++)
+        {
+            sample.m_parameters[k] = random.nextDouble(a_ranges[k].m_min, a_ranges[k].m_max);
+        }
+        for (unsigned int s=0; s<seeds; s++)
+        {
+            sample.m_random = (a_numSeeds > 0);
+            sample.m_seed = s + 1;
+            m_samples.push_back(sample);
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Remove all samples and results.
+
+    \fn     void cParameterSweep::clear()
+*/
+//===========================================================================
+void cParameterSweep::clear()
+{
+    m_samples.clear();
+    m_metrics.clear();
+}
+
+
+//===========================================================================
+/*!
+    Run every sample. Runs are handed to the threads of \e a_pool one at
+    a time, so that unstable runs, which stop early, do not leave cores
+    idle at the end of the sweep. Ensemble runs are handed over by groups
+    of \ref C_SWEEP_ENSEMBLE_LANES.
+
+    \fn     void cParameterSweep::run(cTaskPool* a_pool)
+    \param  a_pool  Thread pool, or NULL to run on the calling thread.
+*/
+//===========================================================================
+void cParameterSweep::run(cTaskPool* a_pool)
+{
+    unsigned int numSamples = (unsigned int)m_samples.size();
+    m_metrics.resize(numSamples);
+
+    if (m_useEnsemble && cIsEnsembleIntegrator(m_integrator))
+    {
+        unsigned int numGroups = (numSamples + C_SWEEP_ENSEMBLE_LANES - 1) / C_SWEEP_ENSEMBLE_LANES;
+        cParallelFor(a_pool, 0, numGroups, 1, [&](unsigned int a_begin, unsigned int a_end)
+        {
+            for (unsigned int g=a_begin; g<a_end; g++)
+            {
+                unsigned int first = g * C_SWEEP_ENSEMBLE_LANES;
+                unsigned int last = (first + C_SWEEP_ENSEMBLE_LANES < numSamples) ?
+                                    (first + C_SWEEP_ENSEMBLE_LANES) : numSamples;
+                evaluateEnsemble(first, last);
+            }
+        });
+        return;
+    }
+
+    cParallelFor(a_pool, 0, numSamples, 1, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int k=a_begin; k<a_end; k++)
+        {
+            m_metrics[k] = evaluate(m_samples[k]);
+        }
+    });
+}
+
+
+//===========================================================================
+/*!
+    Build the triangle scene with the parameters of \e a_sample, run it
+    for \e m_duration seconds and summarize the run. A run stops as soon
+    as its state is no longer finite.
+
+    \fn     cSweepMetrics cParameterSweep::evaluate(const cSweepSample& a_sample) const
+    \param  a_sample  Sample to run.
+    \return Return the summary of the run.
+*/
+//===========================================================================
+cSweepMetrics cParameterSweep::evaluate(const cSweepSample& a_sample) const
+{
+    cParticleSimulation sim;
+    buildScene(a_sample, sim);
+
+    cRunTracker tracker;
+    tracker.begin(sim);
+
+    unsigned int numSteps = getNumSteps();
+    for (unsigned int k=0; (k<numSteps) && tracker.m_running; k++)
+    {
+        sim.step(m_timeStep);
+        tracker.update(sim, sim.getNumContacts(), sim.m_contacts.getMaxPenetration(), m_settleSpeed);
+    }
+
+    return (tracker.end(sim));
+}
+
+
+//===========================================================================
+/*!
+    Run samples [a_first, a_last) together, one per lane of an ensemble.
+    After every step, the particles of each lane still running are
+    copied back into the simulation its sample was built in, and
+    summarized as in \ref evaluate(). Unstable lanes keep stepping with the others but
+    are no longer summarized.
+
+    \fn     void cParameterSweep::evaluateEnsemble(const unsigned int a_first,
+            const unsigned int a_last)
+    \param  a_first  First sample.
+    \param  a_last  One past the last sample.
+*/
+//===========================================================================
+void cParameterSweep::evaluateEnsemble(const unsigned int a_first, const unsigned int a_last)
+{
+    unsigned int numLanes = a_last - a_first;
+    std::vector< std::unique_ptr<cParticleSimulation> > sims(numLanes);
+    std::vector<cRunTracker> trackers(numLanes);
+    for (unsigned int lane=0; lane<numLanes; lane++)
+    {
+        sims[lane].reset(new cParticleSimulation());
+        buildScene(m_samples[a_first + lane], *sims[lane]);
+        trackers[lane].begin(*sims[lane]);
+    }
+
+    cParticleEnsemble ensemble;
+    if (!ensemble.create(*sims[0], numLanes))
+    {
+        for (unsigned int lane=0; lane<numLanes; lane++)
+        {
+            m_metrics[a_first + lane] = evaluate(m_samples[a_first + lane]);
+        }
+        return;
+    }
+    for (unsigned int lane=1; lane<numLanes; lane++)
+    {
+        ensemble.setLane(lane, *sims[lane]);
+    }
+
+    unsigned int numRunning = numLanes;
+    unsigned int numSteps = getNumSteps();
+    for (unsigned int k=0; (k<numSteps) && (numRunning > 0); k++)
+    {
+        ensemble.step(m_timeStep);
+        for (unsigned int lane=0; lane<numLanes; lane++)
+        {
+            cRunTracker& tracker = trackers[lane];
+            if (!tracker.m_running) { continue; }
+
+            ensemble.getParticles(lane, sims[lane]->m_particles);
+            sims[lane]->setClock(ensemble.getTime(), ensemble.getNumSteps());
+            tracker.update(*sims[lane], ensemble.getNumContacts(lane),
+                           ensemble.getMaxPenetration(lane), m_settleSpeed);
+            if (!tracker.m_running) { numRunning--; }
+        }
+    }
+
+    for (unsigned int lane=0; lane<numLanes; lane++)
+    {
+        m_metrics[a_first + lane] = trackers[lane].end(*sims[lane]);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Build the triangle scene with the parameters and start positions of
+    \e a_sample.
+
+    \fn     void cParameterSweep::buildScene(const cSweepSample& a_sample,
+            cParticleSimulation& a_simulation) const
+    \param  a_sample  Sample to build.
+    \param  a_simulation  Empty simulation to fill.
+*/
+//===========================================================================
+void cParameterSweep::buildScene(const cSweepSample& a_sample, cParticleSimulation& a_simulation) const
+{
+    cTriangleSceneParameters parameters;
+    parameters.m_mass = a_sample.m_parameters[C_SWEEP_MASS];
+    parameters.m_restLength = a_sample.m_parameters[C_SWEEP_REST_LENGTH];
+    parameters.m_stiffness = a_sample.m_parameters[C_SWEEP_STIFFNESS];
+    parameters.m_restitution = a_sample.m_parameters[C_SWEEP_RESTITUTION];
+    parameters.m_drag = a_sample.m_parameters[C_SWEEP_DRAG];
+
+    cBuildTriangleScene(a_simulation, parameters);
+    a_simulation.m_random.setSeed(a_sample.m_seed);
+    cPlaceTriangleScene(a_simulation, a_sample.m_random);
+    a_simulation.setIntegrator(m_integrator);
+}
+
+
+//===========================================================================
+/*!
+    Number of steps of every run: \e m_duration rounded up to a whole
+    number of timesteps.
+
+    \fn     unsigned int cParameterSweep::getNumSteps() const
+    \return Return the number of steps.
+*/
+//===========================================================================
+unsigned int cParameterSweep::getNumSteps() const
+{
+    return ((unsigned int)ceil(m_duration / m_timeStep - 1e-9));
+}
+
+
+//===========================================================================
+/*!
+    Name of a parameter.
+
+    \fn     const char* cParameterSweep::getParameterName(const cSweepParameter a_parameter)
+    \param  a_parameter  Parameter.
+    \return Return the name of the demo variable holding it.
+*/
+//===========================================================================
+const char* cParameterSweep::getParameterName(const cSweepParameter a_parameter)
+{
+    switch (a_parameter)
+    {
+        case C_SWEEP_MASS:          return ("m");
+        case C_SWEEP_REST_LENGTH:   return ("restLength");
+        case C_SWEEP_STIFFNESS:     return ("SPRING_C");
+        case C_SWEEP_RESTITUTION:   return ("DAMPING_C_z");
+        case C_SWEEP_DRAG:          return ("DAMPING_G");
+        default:                    return ("unknown");
+    }
+}
+
+
+//===========================================================================
+/*!
+    Number of columns of the output.
+
+    \fn     unsigned int cParameterSweep::getNumColumns()
+    \return Return the number of parameters plus the number of metrics.
+*/
+//===========================================================================
+unsigned int cParameterSweep::getNumColumns()
+{
+    return (C_NUM_SWEEP_PARAMETERS + s_numMetricColumns);
+}
+
+
+//===========================================================================
+/*!
+    Name of a column of the output.
+
+    \fn     const char* cParameterSweep::getColumnName(const unsigned int a_column)
+    \param  a_column  Column index.
+    \return Return the name.
+*/
+//===========================================================================
+const char* cParameterSweep::getColumnName(const unsigned int a_column)
+{
+    if (a_column < (unsigned int)C_NUM_SWEEP_PARAMETERS)
+    {
+        return (getParameterName((cSweepParameter)a_column));
+    }
+    return (s_metricColumns[a_column - C_NUM_SWEEP_PARAMETERS]);
+}
+
+
+//===========================================================================
+/*!
+    One value of the output.
+
+    \fn     double cParameterSweep::getValue(const unsigned int a_row,
+            const unsigned int a_column) const
+    \param  a_row  Sample index.
+    \param  a_column  Column index.
+    \return Return the value; counts and flags are converted to double.
+*/
+//===========================================================================
+double cParameterSweep::getValue(const unsigned int a_row, const unsigned int a_column) const
+{
+    const cSweepSample& sample = m_samples[a_row];
+    if (a_column < (unsigned int)C_NUM_SWEEP_PARAMETERS)
+    {
+        return (sample.m_parameters[a_column]);
+    }
+
+    const cSweepMetrics& metrics = m_metrics[a_row];
+    switch (a_column - C_NUM_SWEEP_PARAMETERS)
+    {
+        case 0:  return (sample.m_random ? 1.0 : 0.0);
+        case 1:  return ((double)sample.m_seed);
+        case 2:  return (metrics.m_settleTime);
+        case 3:  return (metrics.m_maxPenetration);
+        case 4:  return (metrics.m_energyDrift);
+        case 5:  return (metrics.m_finalEnergy);
+        case 6:  return ((double)metrics.m_numBounces);
+        case 7:  return ((double)metrics.m_numSteps);
+        default: return (metrics.m_stable ? 1.0 : 0.0);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Write the samples and their results column by column, in the byte
+    order of the machine:
+
+    \code
+    char     magic[8];                  // C_SWEEP_COLUMNS_MAGIC
+    uint32_t version;                   // 1
+    uint32_t numColumns;
+    uint64_t numRows;
+    char     names[numColumns][32];     // zero terminated
+    double   columns[numColumns][numRows];
+    \endcode
+
+    Every column is contiguous and 8-byte aligned, so a tool reads one
+    metric of every run without touching the others; with numpy, column
+    \e c is np.fromfile(f, np.float64, numRows, offset=24 + 32 * numColumns
+    + 8 * numRows * c). Counts and flags are stored as doubles, and a run
+    that never settled has a NaN settle time.
+
+    \fn     bool cParameterSweep::writeColumns(const std::string& a_filename) const
+    \param  a_filename  File to create.
+    \return Return true if the file was written.
+*/
+//===========================================================================
+bool cParameterSweep::writeColumns(const std::string& a_filename) const
+{
+    if (m_metrics.size() != m_samples.size()) { return (false); }
+
+    FILE* file = fopen(a_filename.c_str(), "wb");
+    if (file == NULL) { return (false); }
+
+    uint32_t version = 1;
+    uint32_t numColumns = getNumColumns();
+    uint64_t numRows = m_samples.size();
+    bool ok = (fwrite(C_SWEEP_COLUMNS_MAGIC, sizeof(C_SWEEP_COLUMNS_MAGIC), 1, file) == 1) &&
+              (fwrite(&version, sizeof(version), 1, file) == 1) &&
+              (fwrite(&numColumns, sizeof(numColumns), 1, file) == 1) &&
+              (fwrite(&numRows, sizeof(numRows), 1, file) == 1);
+
+    for (unsigned int c=0; ok && (c<numColumns); c++)
+    {
+        char name[C_SWEEP_COLUMN_NAME_SIZE];
+        memset(name, 0, sizeof(name));
+        strncpy(name, getColumnName(c), sizeof(name) - 1);
+        ok = (fwrite(name, sizeof(name), 1, file) == 1);
+    }
+
+    std::vector<double> column(m_samples.size());
+    for (unsigned int c=0; ok && (c<numColumns); c++)
+    {
+        for (unsigned int r=0; r<column.size(); r++)
+        {
+            column[r] = getValue(r, c);
+        }
+        ok = column.empty() || (fwrite(&column[0], sizeof(double), column.size(), file) == column.size());
+    }
+
+    ok = (fclose(file) == 0) && ok;
+    return (ok);
+}
+
+
+//===========================================================================
+/*!
+    Write the samples and their results as CSV with a header line, one
+    row per sample.
+
+    \fn     bool cParameterSweep::writeCSV(const std::string& a_filename) const
+    \param  a_filename  File to create.
+    \return Return true if the file was written.
+*/
+//===========================================================================
+bool cParameterSweep::writeCSV(const std::string& a_filename) const
+{
+    if (m_metrics.size() != m_samples.size()) { return (false); }
+
+    FILE* file = fopen(a_filename.c_str(), "w");
+    if (file == NULL) { return (false); }
+
+    unsigned int numColumns = getNumColumns();
+    for (unsigned int c=0; c<numColumns; c++)
+    {
+        fprintf(file, "%s%s", getColumnName(c), (c + 1 < numColumns) ? "," : "\n");
+    }
+    for (unsigned int r=0; r<m_samples.size(); r++)
+    {
+        for (unsigned int c=0; c<numColumns; c++)
+        {
+            fprintf(file, "%.9g%s", getValue(r, c), (c + 1 < numColumns) ? "," : "\n");
+        }
+    }
+
+    return ((fclose(file) == 0));
+}
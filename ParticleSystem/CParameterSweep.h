@@ -0,0 +1,262 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParameterSweepH
+#define CParameterSweepH
+//---------------------------------------------------------------------------
+#include "CTriangleScene.h"
+#include "CParticleEnsemble.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParameterSweep.h
+
+    \brief
+    <b> Particles </b> \n
+    Batch runs of the triangle scene over a grid or a random sample of
+    its parameters.
+*/
+//===========================================================================
+
+//! Parameters of the triangle scene that can be swept, in the order of para[] in the demo.
+enum cSweepParameter
+{
+    C_SWEEP_MASS,           //!< mass of each particle [kg]
+    C_SWEEP_REST_LENGTH,    //!< rest length of the springs [m]
+    C_SWEEP_STIFFNESS,      //!< stiffness of the springs [N/m]
+    C_SWEEP_RESTITUTION,    //!< restitution of the impacts
+    C_SWEEP_DRAG            //!< linear drag rate [1/s]
+};
+
+//! Number of entries in \ref cSweepParameter.
+const int C_NUM_SWEEP_PARAMETERS = 5;
+
+//! Magic number at the start of every column file written by \ref cParameterSweep.
+const char C_SWEEP_COLUMNS_MAGIC[8] = { 'P', 'C', 'O', 'L', 'U', 'M', 'N', 'S' };
+
+//! Size of a column name in a column file, terminating zero included.
+const unsigned int C_SWEEP_COLUMN_NAME_SIZE = 32;
+
+//! Samples run together in one \ref cParticleEnsemble when \e m_useEnsemble is set.
+const unsigned int C_SWEEP_ENSEMBLE_LANES = 64;
+
+//===========================================================================
+/*!
+    \struct     cSweepRange
+    \ingroup    particles
+
+    \brief
+    Values taken by one parameter: \e m_count values evenly spaced from
+    \e m_min to \e m_max in a grid, or uniform in [m_min, m_max] in a
+    random sample. A count of one, or equal bounds, fixes the parameter.
+*/
+//===========================================================================
+struct cSweepRange
+{
+    double m_min;
+    double m_max;
+    unsigned int m_count;
+
+    //! Constructor of cSweepRange.
+    cSweepRange(const double a_value = 0.0) : m_min(a_value), m_max(a_value), m_count(1) {}
+};
+
+//===========================================================================
+/*!
+    \struct     cSweepSample
+    \ingroup    particles
+
+    \brief
+    One run of a sweep: the scene parameters and the start positions.
+    With \e m_random set, the particles start at positions drawn from
+    \e m_seed; otherwise at the fixed start of the demo.
+*/
+//===========================================================================
+struct cSweepSample
+{
+    double m_parameters[C_NUM_SWEEP_PARAMETERS];
+    bool m_random;
+    unsigned int m_seed;
+};
+
+//===========================================================================
+/*!
+    \struct     cSweepMetrics
+    \ingroup    particles
+
+    \brief
+    Summary of one run.
+*/
+//===========================================================================
+struct cSweepMetrics
+{
+    //! Time after which no particle moved faster than the settle speed [s], NaN if never.
+    double m_settleTime;
+
+    //! Deepest penetration into a contact shape before it was resolved [m].
+    double m_maxPenetration;
+
+    //! Largest rise of the total energy above its initial value, relative to the initial energy.
+    double m_energyDrift;
+
+    //! Total energy at the end of the run [J].
+    double m_finalEnergy;
+
+    //! Number of times a particle in contact reversed from falling to rising faster than the settle speed.
+    unsigned int m_numBounces;
+
+    //! Steps taken (fewer than requested if the run became unstable).
+    unsigned int m_numSteps;
+
+    //! False if a position or a velocity stopped being finite.
+    bool m_stable;
+};
+
+//===========================================================================
+/*!
+    \class      cParameterSweep
+    \ingroup    particles
+
+    \brief
+    cParameterSweep runs the triangle scene of the interactive demo once
+    per sample, headless and with a fixed timestep, and summarizes every
+    run in a \ref cSweepMetrics. Samples come from a full grid or a
+    random sample over the five scene parameters, each combined with
+    a number of start positions.
+
+    Runs are independent, so \ref run() spreads them over a task pool,
+    one run per task, each with its own single-threaded simulation: the
+    scene is far too small to benefit from parallel loops, while
+    thousands of runs keep every core busy without any synchronization.
+    Each run draws its start positions from its own seed, so the
+    results do not depend on the number of threads.
+
+    With \e m_useEnsemble set, and an integrator the ensemble supports,
+    groups of \ref C_SWEEP_ENSEMBLE_LANES samples are instead run in the
+    SIMD lanes of a \ref cParticleEnsemble, one group per task. The
+    results are those of the one-by-one runs, unless a particle touches
+    both others in the same step (see \ref cParticleEnsemble).
+
+    Results are written as columns (see \ref writeColumns()) or as CSV,
+    one row per sample, parameters first.
+*/
+//===========================================================================
+class cParameterSweep
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParameterSweep.
+    cParameterSweep();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Add every combination of the values of \e a_ranges, each with \e a_numSeeds start positions.
+    void addGrid(const cSweepRange a_ranges[C_NUM_SWEEP_PARAMETERS], const unsigned int a_numSeeds);
+
+    //! Add \e a_count samples drawn uniformly in \e a_ranges from \e a_seed, each with \e a_numSeeds start positions.
+    void addRandom(const cSweepRange a_ranges[C_NUM_SWEEP_PARAMETERS], const unsigned int a_count,
+                   const unsigned int a_numSeeds, const uint64_t a_seed);
+
+    //! Add one sample.
+    inline void addSample(const cSweepSample& a_sample) { m_samples.push_back(a_sample); }
+
+    //! Remove all samples and results.
+    void clear();
+
+    //! Run every sample on \e a_pool (NULL: on the calling thread).
+    void run(cTaskPool* a_pool);
+
+    //! Simulate one sample and summarize it.
+    cSweepMetrics evaluate(const cSweepSample& a_sample) const;
+
+    //! Write the samples and their results as columns of doubles.
+    bool writeColumns(const std::string& a_filename) const;
+
+    //! Write the samples and their results as CSV.
+    bool writeCSV(const std::string& a_filename) const;
+
+    //! Number of samples.
+    inline unsigned int getNumSamples() const { return ((unsigned int)m_samples.size()); }
+
+    //! Sample \e a_index.
+    inline const cSweepSample& getSample(const unsigned int a_index) const { return (m_samples[a_index]); }
+
+    //! Result of sample \e a_index, after \ref run().
+    inline const cSweepMetrics& getMetrics(const unsigned int a_index) const { return (m_metrics[a_index]); }
+
+    //! Name of a parameter, as used for its column.
+    static const char* getParameterName(const cSweepParameter a_parameter);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Simulated time of every run [s].
+    double m_duration;
+
+    //! Fixed timestep [s].
+    double m_timeStep;
+
+    //! Integration scheme.
+    cParticleIntegratorType m_integrator;
+
+    //! Speed under which a particle counts as settled [m/s].
+    double m_settleSpeed;
+
+    //! Run the samples in the lanes of an ensemble when the integrator allows it.
+    bool m_useEnsemble;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Build the triangle scene of \e a_sample in the empty simulation \e a_simulation.
+    void buildScene(const cSweepSample& a_sample, cParticleSimulation& a_simulation) const;
+
+    //! Number of steps of every run.
+    unsigned int getNumSteps() const;
+
+    //! Simulate samples [a_first, a_last) in one ensemble and store their results.
+    void evaluateEnsemble(const unsigned int a_first, const unsigned int a_last);
+
+    //! Number of columns, and column \e a_column of row \e a_row.
+    static unsigned int getNumColumns();
+    static const char* getColumnName(const unsigned int a_column);
+    double getValue(const unsigned int a_row, const unsigned int a_column) const;
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Samples, and their results once run.
+    std::vector<cSweepSample> m_samples;
+    std::vector<cSweepMetrics> m_metrics;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,298 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+//---------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Allocate a block of memory aligned on \ref C_PARTICLE_ALIGNMENT bytes.
+
+    \fn     void* cParticleAlignedMalloc(size_t a_size)
+    \param  a_size  Size of the block in bytes.
+    \return Return a pointer to the block, or NULL if allocation failed.
+*/
+//===========================================================================
+void* cParticleAlignedMalloc(size_t a_size)
+{
+    if (a_size == 0) { return (NULL); }
+
+#if defined(_WIN32)
+    return (_aligned_malloc(a_size, C_PARTICLE_ALIGNMENT));
+#else
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, C_PARTICLE_ALIGNMENT, a_size) != 0) { return (NULL); }
+    return (ptr);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Release a block allocated with \ref cParticleAlignedMalloc.
+
+    \fn     void cParticleAlignedFree(void* a_ptr)
+    \param  a_ptr  Block to release. May be NULL.
+*/
+//===========================================================================
+void cParticleAlignedFree(void* a_ptr)
+{
+#if defined(_WIN32)
+    _aligned_free(a_ptr);
+#else
+    free(a_ptr);
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cParticleArrays.
+
+    \fn     cParticleArrays::cParticleArrays()
+*/
+//===========================================================================
+cParticleArrays::cParticleArrays()
+{
+    m_posX = m_posY = m_posZ = NULL;
+    m_velX = m_velY = m_velZ = NULL;
+    m_forceX = m_forceY = m_forceZ = NULL;
+    m_invMass = NULL;
+
+    m_numParticles = 0;
+    m_capacity = 0;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cParticleArrays.
+
+    \fn     cParticleArrays::~cParticleArrays()
+*/
+//===========================================================================
+cParticleArrays::~cParticleArrays()
+{
+    double* arrays[] = { m_posX, m_posY, m_posZ,
+                         m_velX, m_velY, m_velZ,
+                         m_forceX, m_forceY, m_forceZ,
+                         m_invMass };
+
+    for (unsigned int k=0; k<sizeof(arrays)/sizeof(arrays[0]); k++)
+    {
+        cParticleAlignedFree(arrays[k]);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Make room for at least \e a_capacity particles. Existing particles
+    are preserved.
+
+    \fn     void cParticleArrays::reserve(const unsigned int a_capacity)
+    \param  a_capacity  Requested number of particles.
+*/
+//===========================================================================
+void cParticleArrays::reserve(const unsigned int a_capacity)
+{
+    if (a_capacity > m_capacity)
+    {
+        reallocate(a_capacity);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Append a particle at rest and return its index. Storage grows
+    geometrically, so adding N particles one by one costs O(N).
+
+    \fn     unsigned int cParticleArrays::addParticle(const double a_x,
+            const double a_y, const double a_z, const double a_mass)
+    \param  a_x  Position along x.
+    \param  a_y  Position along y.
+    \param  a_z  Position along z.
+    \param  a_mass  Mass of the particle. Zero creates a static particle.
+    \return Return the index of the new particle.
+*/
+//===========================================================================
+unsigned int cParticleArrays::addParticle(const double a_x, const double a_y,
+                                          const double a_z, const double a_mass)
+{
+    if (m_numParticles == m_capacity)
+    {
+        reallocate(2 * m_capacity + 1);
+    }
+
+    unsigned int index = m_numParticles++;
+
+    m_posX[index] = a_x;
+    m_posY[index] = a_y;
+    m_posZ[index] = a_z;
+    m_velX[index] = 0.0;
+    m_velY[index] = 0.0;
+    m_velZ[index] = 0.0;
+    m_forceX[index] = 0.0;
+    m_forceY[index] = 0.0;
+    m_forceZ[index] = 0.0;
+    setMass(index, a_mass);
+
+    return (index);
+}
+
+
+//===========================================================================
+/*!
+    Remove all particles. Allocated memory is kept for reuse and the
+    whole capacity is cleared so that padding elements stay at zero.
+
+    \fn     void cParticleArrays::clear()
+*/
+//===========================================================================
+void cParticleArrays::clear()
+{
+    double* arrays[] = { m_posX, m_posY, m_posZ,
+                         m_velX, m_velY, m_velZ,
+                         m_forceX, m_forceY, m_forceZ,
+                         m_invMass };
+
+    for (unsigned int k=0; k<sizeof(arrays)/sizeof(arrays[0]); k++)
+    {
+        if (arrays[k] != NULL)
+        {
+            memset(arrays[k], 0, m_capacity * sizeof(double));
+        }
+    }
+    m_static.assign(m_static.size(), 0);
+
+    m_numParticles = 0;
+}
+
+
+//===========================================================================
+/*!
+    Set the force accumulators of all particles to zero.
+
+    \fn     void cParticleArrays::clearForces()
+*/
+//===========================================================================
+void cParticleArrays::clearForces()
+{
+    if (m_numParticles == 0) { return; }
+
+    size_t size = m_numParticles * sizeof(double);
+    memset(m_forceX, 0, size);
+    memset(m_forceY, 0, size);
+    memset(m_forceZ, 0, size);
+}
+
+
+//===========================================================================
+/*!
+    Set the velocities of all particles to zero.
+
+    \fn     void cParticleArrays::clearVelocities()
+*/
+//===========================================================================
+void cParticleArrays::clearVelocities()
+{
+    if (m_numParticles == 0) { return; }
+
+    size_t size = m_numParticles * sizeof(double);
+    memset(m_velX, 0, size);
+    memset(m_velY, 0, size);
+    memset(m_velZ, 0, size);
+}
+
+
+//===========================================================================
+/*!
+    Set the mass of a particle. A mass of zero (or less) makes the
+    particle static.
+
+    \fn     void cParticleArrays::setMass(const unsigned int a_index,
+            const double a_mass)
+    \param  a_index  Index of the particle.
+    \param  a_mass  New mass.
+*/
+//===========================================================================
+void cParticleArrays::setMass(const unsigned int a_index, const double a_mass)
+{
+    m_invMass[a_index] = (a_mass > 0.0) ? (1.0 / a_mass) : 0.0;
+    m_static[a_index] = (a_mass > 0.0) ? 0 : 1;
+}
+
+
+//===========================================================================
+/*!
+    Set the same mass on every particle, leaving static particles static.
+    Static particles are those pinned by \ref setMass(), not those whose
+    inverse mass happens to be zero, so a mass of zero or less is ignored
+    rather than pinning every particle for good.
+
+    \fn     void cParticleArrays::setUniformMass(const double a_mass)
+    \param  a_mass  New mass, greater than zero.
+*/
+//===========================================================================
+void cParticleArrays::setUniformMass(const double a_mass)
+{
+    if (a_mass <= 0.0) { return; }
+
+    double invMass = 1.0 / a_mass;
+    for (unsigned int i=0; i<m_numParticles; i++)
+    {
+        if (m_static[i] == 0) { m_invMass[i] = invMass; }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Grow every array to \e a_capacity elements (rounded up to
+    \ref C_PARTICLE_PADDING), copying the particles in use and zeroing
+    the remainder.
+
+    \fn     void cParticleArrays::reallocate(const unsigned int a_capacity)
+    \param  a_capacity  New minimum capacity.
+*/
+//===========================================================================
+void cParticleArrays::reallocate(const unsigned int a_capacity)
+{
+    unsigned int capacity = (a_capacity + C_PARTICLE_PADDING - 1) /
+                            C_PARTICLE_PADDING * C_PARTICLE_PADDING;
+
+    double** arrays[] = { &m_posX, &m_posY, &m_posZ,
+                          &m_velX, &m_velY, &m_velZ,
+                          &m_forceX, &m_forceY, &m_forceZ,
+                          &m_invMass };
+
+    for (unsigned int k=0; k<sizeof(arrays)/sizeof(arrays[0]); k++)
+    {
+        double* data = (double*)cParticleAlignedMalloc(capacity * sizeof(double));
+        memset(data, 0, capacity * sizeof(double));
+        if (*arrays[k] != NULL)
+        {
+            memcpy(data, *arrays[k], m_numParticles * sizeof(double));
+            cParticleAlignedFree(*arrays[k]);
+        }
+        *arrays[k] = data;
+    }
+    m_static.resize(capacity, 0);
+
+    m_capacity = capacity;
+}
@@ -0,0 +1,175 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleArraysH
+#define CParticleArraysH
+//---------------------------------------------------------------------------
+#include <stddef.h>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleArrays.h
+
+    \brief
+    <b> Particles </b> \n
+    Structure-of-arrays particle store.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// DECLARED CONSTANTS
+//---------------------------------------------------------------------------
+
+//! Alignment in bytes of every particle array (one cache line).
+const unsigned int C_PARTICLE_ALIGNMENT = 64;
+
+//! Array capacities are rounded up to a multiple of this many elements.
+const unsigned int C_PARTICLE_PADDING = 8;
+
+
+//---------------------------------------------------------------------------
+// GLOBAL FUNCTIONS
+//---------------------------------------------------------------------------
+
+//! Allocate a block of memory aligned on \ref C_PARTICLE_ALIGNMENT bytes.
+void* cParticleAlignedMalloc(size_t a_size);
+
+//! Release a block allocated with \ref cParticleAlignedMalloc.
+void cParticleAlignedFree(void* a_ptr);
+
+
+//===========================================================================
+/*!
+    \class      cParticleArrays
+    \ingroup    particles
+
+    \brief
+    cParticleArrays stores the state of N point masses as contiguous,
+    aligned arrays of doubles (one array per component) so that the
+    simulation loops can walk them linearly.
+
+    The arrays are public so that solvers can access them directly.
+    Capacity is always padded to a multiple of \ref C_PARTICLE_PADDING
+    and the padding elements are kept at zero, which allows vectorized
+    loops to run over whole blocks without a scalar tail.
+
+    A particle with an inverse mass of zero is static (pinned). Whether
+    a particle was created static is also kept apart from its mass, so
+    \ref setUniformMass() never pins or releases a particle.
+*/
+//===========================================================================
+class cParticleArrays
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleArrays.
+    cParticleArrays();
+
+    //! Destructor of cParticleArrays.
+    ~cParticleArrays();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Make room for at least \e a_capacity particles.
+    void reserve(const unsigned int a_capacity);
+
+    //! Append a particle at rest and return its index.
+    unsigned int addParticle(const double a_x, const double a_y, const double a_z,
+                             const double a_mass);
+
+    //! Remove all particles. Memory is kept for reuse.
+    void clear();
+
+    //! Set the force accumulators of all particles to zero.
+    void clearForces();
+
+    //! Set the velocities of all particles to zero.
+    void clearVelocities();
+
+    //! Set the mass of particle \e a_index. A mass of zero pins the particle.
+    void setMass(const unsigned int a_index, const double a_mass);
+
+    //! Set the same mass on every particle that is not pinned. Non-positive masses are ignored.
+    void setUniformMass(const double a_mass);
+
+    //! Return true if particle \e a_index was made static by \ref setMass().
+    inline bool isStatic(const unsigned int a_index) const { return (m_static[a_index] != 0); }
+
+    //! Number of particles currently stored.
+    inline unsigned int getNumParticles() const { return (m_numParticles); }
+
+    //! Number of particles that fit without reallocating.
+    inline unsigned int getCapacity() const { return (m_capacity); }
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Positions.
+    double* m_posX;
+    double* m_posY;
+    double* m_posZ;
+
+    //! Velocities.
+    double* m_velX;
+    double* m_velY;
+    double* m_velZ;
+
+    //! Force accumulators.
+    double* m_forceX;
+    double* m_forceY;
+    double* m_forceZ;
+
+    //! Inverse masses (zero for static particles).
+    double* m_invMass;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Grow every array to \e a_capacity elements, preserving contents.
+    void reallocate(const unsigned int a_capacity);
+
+    //! Not copyable.
+    cParticleArrays(const cParticleArrays&);
+    cParticleArrays& operator=(const cParticleArrays&);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Number of particles in use.
+    unsigned int m_numParticles;
+
+    //! Number of allocated elements per array.
+    unsigned int m_capacity;
+
+    //! Per particle: 1 if static, whatever its inverse mass.
+    std::vector<unsigned char> m_static;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
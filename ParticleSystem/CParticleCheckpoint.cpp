@@ -0,0 +1,448 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleCheckpoint.h"
+//---------------------------------------------------------------------------
+#include <string.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// copies a_bytes from a_source to a_dest and advances a_dest
+static inline void writeBytes(char*& a_dest, const void* a_source, const size_t a_bytes)
+{
+    if (a_bytes > 0) { memcpy(a_dest, a_source, a_bytes); }
+    a_dest += a_bytes;
+}
+
+// copies a_bytes from a_source to a_dest and advances a_source
+static inline void readBytes(void* a_dest, const char*& a_source, const size_t a_bytes)
+{
+    if (a_bytes > 0) { memcpy(a_dest, a_source, a_bytes); }
+    a_source += a_bytes;
+}
+
+
+//===========================================================================
+/*!
+    Size of a checkpoint.
+
+    \fn     size_t cParticleCheckpoint::getSize(const unsigned int a_numParticles,
+            const unsigned int a_numSprings, const unsigned int a_numShapes,
+            const unsigned int a_numParameters)
+    \param  a_numParticles  Number of particles.
+    \param  a_numSprings  Number of springs.
+    \param  a_numShapes  Number of contact shapes.
+    \param  a_numParameters  Number of application parameters.
+    \return Return the size in bytes.
+*/
+//===========================================================================
+size_t cParticleCheckpoint::getSize(const unsigned int a_numParticles,
+                                    const unsigned int a_numSprings,
+                                    const unsigned int a_numShapes,
+                                    const unsigned int a_numParameters)
+{
+    return (sizeof(cCheckpointHeader) +
+            10 * (size_t)a_numParticles * sizeof(double) +
+            3 * (size_t)a_numSprings * sizeof(double) +
+            (size_t)a_numShapes * sizeof(cContactShape) +
+            (size_t)a_numParameters * sizeof(double));
+}
+
+
+//===========================================================================
+/*!
+    Copy the state of \e a_simulation, and \e a_numParameters values of
+    the application (e.g. the settings shown to the user), into the
+    block. Must not run concurrently with a step of the simulation.
+
+    \fn     void cParticleCheckpoint::save(const cParticleSimulation& a_simulation,
+            const double* a_parameters, const unsigned int a_numParameters)
+    \param  a_simulation  Simulation to save.
+    \param  a_parameters  Application parameters, may be NULL if there are none.
+    \param  a_numParameters  Number of application parameters.
+*/
+//===========================================================================
+void cParticleCheckpoint::save(const cParticleSimulation& a_simulation,
+                               const double* a_parameters,
+                               const unsigned int a_numParameters)
+{
+    const cParticleArrays& particles = a_simulation.m_particles;
+    const cSpringTable& springs = a_simulation.m_springs;
+    const cParticleContacts& contacts = a_simulation.m_contacts;
+
+    unsigned int n = particles.getNumParticles();
+    unsigned int numSprings = springs.getNumSprings();
+    unsigned int numShapes = contacts.getNumShapes();
+    m_data.resize(getSize(n, numSprings, numShapes, a_numParameters));
+
+    cCheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, C_CHECKPOINT_MAGIC, sizeof(C_CHECKPOINT_MAGIC));
+    header.m_version = C_CHECKPOINT_VERSION;
+    header.m_headerSize = sizeof(cCheckpointHeader);
+    header.m_numParticles = n;
+    header.m_numSprings = numSprings;
+    header.m_numShapes = numShapes;
+    header.m_numParameters = a_numParameters;
+    header.m_integrator = (uint32_t)a_simulation.getIntegratorType();
+    header.m_numSteps = a_simulation.getNumSteps();
+    header.m_time = a_simulation.getTime();
+    header.m_randomState = a_simulation.m_random.getState();
+    header.m_externalForce[0] = a_simulation.m_externalForce[0];
+    header.m_externalForce[1] = a_simulation.m_externalForce[1];
+    header.m_externalForce[2] = a_simulation.m_externalForce[2];
+    header.m_dragCoefficient = a_simulation.m_dragCoefficient;
+    header.m_particleRadius = a_simulation.m_particleRadius;
+    header.m_particleRestitution = a_simulation.m_particleRestitution;
+    header.m_collideParticles = a_simulation.m_collideParticles ? 1 : 0;
+    header.m_cachedForces = a_simulation.getIntegrator()->hasCachedForces() ? 1 : 0;
+
+    char* p = &m_data[0];
+    writeBytes(p, &header, sizeof(header));
+
+    size_t bytes = n * sizeof(double);
+    writeBytes(p, particles.m_posX, bytes);
+    writeBytes(p, particles.m_posY, bytes);
+    writeBytes(p, particles.m_posZ, bytes);
+    writeBytes(p, particles.m_velX, bytes);
+    writeBytes(p, particles.m_velY, bytes);
+    writeBytes(p, particles.m_velZ, bytes);
+    writeBytes(p, particles.m_invMass, bytes);
+    writeBytes(p, particles.m_forceX, bytes);
+    writeBytes(p, particles.m_forceY, bytes);
+    writeBytes(p, particles.m_forceZ, bytes);
+
+    bytes = numSprings * sizeof(double);
+    writeBytes(p, springs.m_restLength, bytes);
+    writeBytes(p, springs.m_stiffness, bytes);
+    writeBytes(p, springs.m_damping, bytes);
+
+    for (unsigned int k=0; k<numShapes; k++)
+    {
+        writeBytes(p, &contacts.getShape(k), sizeof(cContactShape));
+    }
+
+    writeBytes(p, a_parameters, a_numParameters * sizeof(double));
+}
+
+
+//===========================================================================
+/*!
+    Copy the saved state back into \e a_simulation and \e a_parameters.
+    Nothing is changed unless the simulation has as many particles,
+    springs and shapes as when the checkpoint was saved, and as many
+    parameters are requested. The integrator is switched back to the
+    saved one if it was changed since, and its cached forces restored.
+
+    \fn     bool cParticleCheckpoint::restore(cParticleSimulation& a_simulation,
+            double* a_parameters, const unsigned int a_numParameters) const
+    \param  a_simulation  Simulation to restore.
+    \param  a_parameters  Receives the application parameters, may be NULL if there are none.
+    \param  a_numParameters  Number of application parameters.
+    \return Return true if the state was restored.
+*/
+//===========================================================================
+bool cParticleCheckpoint::restore(cParticleSimulation& a_simulation, double* a_parameters,
+                                  const unsigned int a_numParameters) const
+{
+    if (m_data.empty()) { return (false); }
+
+    cParticleArrays& particles = a_simulation.m_particles;
+    cSpringTable& springs = a_simulation.m_springs;
+    cParticleContacts& contacts = a_simulation.m_contacts;
+
+    const cCheckpointHeader& header = getHeader();
+    unsigned int n = header.m_numParticles;
+    if ((n != particles.getNumParticles()) ||
+        (header.m_numSprings != springs.getNumSprings()) ||
+        (header.m_numShapes != contacts.getNumShapes()) ||
+        (header.m_numParameters != a_numParameters))
+    {
+        return (false);
+    }
+
+    const char* p = &m_data[0] + header.m_headerSize;
+
+    size_t bytes = n * sizeof(double);
+    readBytes(particles.m_posX, p, bytes);
+    readBytes(particles.m_posY, p, bytes);
+    readBytes(particles.m_posZ, p, bytes);
+    readBytes(particles.m_velX, p, bytes);
+    readBytes(particles.m_velY, p, bytes);
+    readBytes(particles.m_velZ, p, bytes);
+    readBytes(particles.m_invMass, p, bytes);
+    readBytes(particles.m_forceX, p, bytes);
+    readBytes(particles.m_forceY, p, bytes);
+    readBytes(particles.m_forceZ, p, bytes);
+
+    bytes = header.m_numSprings * sizeof(double);
+    readBytes(springs.m_restLength, p, bytes);
+    readBytes(springs.m_stiffness, p, bytes);
+    readBytes(springs.m_damping, p, bytes);
+
+    for (unsigned int k=0; k<header.m_numShapes; k++)
+    {
+        readBytes(&contacts.getShape(k), p, sizeof(cContactShape));
+    }
+
+    readBytes(a_parameters, p, a_numParameters * sizeof(double));
+
+    a_simulation.m_externalForce[0] = header.m_externalForce[0];
+    a_simulation.m_externalForce[1] = header.m_externalForce[1];
+    a_simulation.m_externalForce[2] = header.m_externalForce[2];
+    a_simulation.m_dragCoefficient = header.m_dragCoefficient;
+    a_simulation.m_particleRadius = header.m_particleRadius;
+    a_simulation.m_particleRestitution = header.m_particleRestitution;
+    a_simulation.m_collideParticles = (header.m_collideParticles != 0);
+    a_simulation.m_random.setState(header.m_randomState);
+    a_simulation.setClock(header.m_time, header.m_numSteps);
+    a_simulation.setIntegrator((cParticleIntegratorType)header.m_integrator);
+    if (header.m_cachedForces != 0)
+    {
+        a_simulation.getIntegrator()->setCachedForces(particles);
+    }
+    else
+    {
+        a_simulation.resetIntegrator();
+    }
+
+    // islands asleep before the restore may hold moving particles now
+    a_simulation.m_islands.wakeAll();
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Replace the block with a copy of \e a_size bytes at \e a_data, for
+    example a checkpoint read from a file. The block is left unchanged
+    if the data does not start with a valid header or has the wrong size.
+
+    \fn     bool cParticleCheckpoint::load(const void* a_data, const size_t a_size)
+    \param  a_data  Checkpoint data.
+    \param  a_size  Size of the data in bytes.
+    \return Return true if the data was accepted.
+*/
+//===========================================================================
+bool cParticleCheckpoint::load(const void* a_data, const size_t a_size)
+{
+    if ((a_data == NULL) || (a_size < sizeof(cCheckpointHeader))) { return (false); }
+
+    cCheckpointHeader header;
+    memcpy(&header, a_data, sizeof(header));
+    if ((memcmp(header.m_magic, C_CHECKPOINT_MAGIC, sizeof(C_CHECKPOINT_MAGIC)) != 0) ||
+        (header.m_version != C_CHECKPOINT_VERSION) ||
+        (header.m_headerSize != sizeof(cCheckpointHeader)) ||
+        (header.m_integrator >= (uint32_t)C_NUM_INTEGRATORS) ||
+        (a_size != getSize(header.m_numParticles, header.m_numSprings,
+                           header.m_numShapes, header.m_numParameters)))
+    {
+        return (false);
+    }
+
+    const char* data = (const char*)a_data;
+    m_data.assign(data, data + a_size);
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cCheckpointHistory.
+
+    \fn     cCheckpointHistory::cCheckpointHistory(const unsigned int a_capacity)
+    \param  a_capacity  Maximum number of checkpoints kept.
+*/
+//===========================================================================
+cCheckpointHistory::cCheckpointHistory(const unsigned int a_capacity)
+{
+    m_capacity = (a_capacity > 0) ? a_capacity : 1;
+}
+
+
+//===========================================================================
+/*!
+    Set the maximum number of checkpoints kept, dropping the oldest ones
+    if more are stored.
+
+    \fn     void cCheckpointHistory::setCapacity(const unsigned int a_capacity)
+    \param  a_capacity  Maximum number of checkpoints, at least one.
+*/
+//===========================================================================
+void cCheckpointHistory::setCapacity(const unsigned int a_capacity)
+{
+    m_capacity = (a_capacity > 0) ? a_capacity : 1;
+    while (m_entries.size() > m_capacity)
+    {
+        m_entries.pop_front();
+    }
+}
+
+
+//===========================================================================
+/*!
+    Append \e a_checkpoint as the newest checkpoint. Each page is
+    compared with the same page of the previous checkpoint and shared
+    with it if equal, so pushing costs one memcmp of the block plus one
+    copy of the pages that changed.
+
+    \fn     void cCheckpointHistory::push(const cParticleCheckpoint& a_checkpoint)
+    \param  a_checkpoint  Checkpoint to store; ignored if empty.
+*/
+//===========================================================================
+void cCheckpointHistory::push(const cParticleCheckpoint& a_checkpoint)
+{
+    if (a_checkpoint.isEmpty()) { return; }
+
+    // reuse the page table of the oldest entry if it is about to be dropped
+    cCheckpointEntry entry;
+    if (m_entries.size() >= m_capacity)
+    {
+        entry.m_pages.swap(m_entries.front().m_pages);
+        m_entries.pop_front();
+    }
+
+    const char* data = a_checkpoint.getData();
+    size_t size = a_checkpoint.getSize();
+    size_t numPages = (size + C_CHECKPOINT_PAGE_SIZE - 1) / C_CHECKPOINT_PAGE_SIZE;
+    const cCheckpointEntry* previous = m_entries.empty() ? NULL : &m_entries.back();
+
+    entry.m_time = a_checkpoint.getTime();
+    entry.m_size = size;
+    entry.m_pages.resize(numPages);
+
+    for (size_t k=0; k<numPages; k++)
+    {
+        size_t offset = k * C_CHECKPOINT_PAGE_SIZE;
+        size_t bytes = size - offset;
+        if (bytes > C_CHECKPOINT_PAGE_SIZE) { bytes = C_CHECKPOINT_PAGE_SIZE; }
+
+        if ((previous != NULL) && (k < previous->m_pages.size()))
+        {
+            const cCheckpointPage& page = previous->m_pages[k];
+            if ((page->size() == bytes) && (memcmp(&(*page)[0], data + offset, bytes) == 0))
+            {
+                entry.m_pages[k] = page;
+                continue;
+            }
+        }
+        entry.m_pages[k] = std::make_shared< const std::vector<char> >(data + offset, data + offset + bytes);
+    }
+
+    m_entries.push_back(entry);
+}
+
+
+//===========================================================================
+/*!
+    Reassemble checkpoint \e a_index into \e a_checkpoint, reusing the
+    memory of \e a_checkpoint, so that it can be restored.
+
+    \fn     bool cCheckpointHistory::get(const unsigned int a_index,
+            cParticleCheckpoint& a_checkpoint) const
+    \param  a_index  Checkpoint, 0 being the oldest.
+    \param  a_checkpoint  Receives the checkpoint.
+    \return Return true if \e a_index exists.
+*/
+//===========================================================================
+bool cCheckpointHistory::get(const unsigned int a_index, cParticleCheckpoint& a_checkpoint) const
+{
+    if (a_index >= m_entries.size()) { return (false); }
+
+    const cCheckpointEntry& entry = m_entries[a_index];
+    std::vector<char>& data = a_checkpoint.m_data;
+    data.resize(entry.m_size);
+
+    char* p = &data[0];
+    for (size_t k=0; k<entry.m_pages.size(); k++)
+    {
+        writeBytes(p, &(*entry.m_pages[k])[0], entry.m_pages[k]->size());
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Find the checkpoint to rewind to for a given time.
+
+    \fn     unsigned int cCheckpointHistory::findCheckpoint(const double a_time) const
+    \param  a_time  Simulated time [s].
+    \return Return the index of the last checkpoint taken at or before
+            \e a_time, 0 if all are later. The history must not be empty.
+*/
+//===========================================================================
+unsigned int cCheckpointHistory::findCheckpoint(const double a_time) const
+{
+    // checkpoints are pushed in time order; find the first one after a_time
+    unsigned int lo = 0;
+    unsigned int hi = (unsigned int)m_entries.size();
+    while (lo < hi)
+    {
+        unsigned int mid = (lo + hi) / 2;
+        if (m_entries[mid].m_time <= a_time) { lo = mid + 1; }
+        else { hi = mid; }
+    }
+    return ((lo > 0) ? lo - 1 : 0);
+}
+
+
+//===========================================================================
+/*!
+    Drop the checkpoints taken after \e a_time. After a rewind or a
+    restore, this removes the checkpoints of the abandoned future so that
+    the history stays in time order.
+
+    \fn     void cCheckpointHistory::truncate(const double a_time)
+    \param  a_time  Simulated time of the restored state [s].
+*/
+//===========================================================================
+void cCheckpointHistory::truncate(const double a_time)
+{
+    while (!m_entries.empty() && (m_entries.back().m_time > a_time))
+    {
+        m_entries.pop_back();
+    }
+}
+
+
+//===========================================================================
+/*!
+    Memory held by the pages of the history. A page shared by several
+    checkpoints is counted once.
+
+    \fn     size_t cCheckpointHistory::getMemoryUsed() const
+    \return Return the size in bytes.
+*/
+//===========================================================================
+size_t cCheckpointHistory::getMemoryUsed() const
+{
+    // pages are only ever shared with the same page of the previous entry
+    size_t bytes = 0;
+    for (size_t i=0; i<m_entries.size(); i++)
+    {
+        const std::vector<cCheckpointPage>& pages = m_entries[i].m_pages;
+        const std::vector<cCheckpointPage>* previous = (i > 0) ? &m_entries[i-1].m_pages : NULL;
+        for (size_t k=0; k<pages.size(); k++)
+        {
+            if ((previous == NULL) || (k >= previous->size()) || ((*previous)[k] != pages[k]))
+            {
+                bytes += pages[k]->size();
+            }
+        }
+    }
+    return (bytes);
+}
@@ -0,0 +1,294 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleCheckpointH
+#define CParticleCheckpointH
+//---------------------------------------------------------------------------
+#include "CParticleSimulation.h"
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleCheckpoint.h
+
+    \brief
+    <b> Particles </b> \n
+    Checkpoints of a whole simulation and a history of them.
+*/
+//===========================================================================
+
+//! Magic number at the start of every checkpoint.
+const char C_CHECKPOINT_MAGIC[8] = { 'P', 'C', 'H', 'E', 'C', 'K', 'P', 'T' };
+
+//! Version of the checkpoint layout.
+const uint32_t C_CHECKPOINT_VERSION = 1;
+
+//! Size of the pages shared between checkpoints of a \ref cCheckpointHistory.
+const unsigned int C_CHECKPOINT_PAGE_SIZE = 4096;
+
+//===========================================================================
+/*!
+    \struct     cCheckpointHeader
+    \ingroup    particles
+
+    \brief
+    Start of a checkpoint, in the byte order of the machine that wrote
+    it. The header is followed by, in order:
+
+    \code
+    double posX[numParticles], posY[numParticles], posZ[numParticles];
+    double velX[numParticles], velY[numParticles], velZ[numParticles];
+    double invMass[numParticles];
+    double forceX[numParticles], forceY[numParticles], forceZ[numParticles];
+    double restLength[numSprings], stiffness[numSprings], damping[numSprings];
+    cContactShape shapes[numShapes];
+    double parameters[numParameters];
+    \endcode
+
+    Arrays that rarely change (masses, springs, shapes) are kept apart
+    from positions and velocities, so that in a \ref cCheckpointHistory
+    their pages are shared by consecutive checkpoints.
+*/
+//===========================================================================
+struct cCheckpointHeader
+{
+    //! \ref C_CHECKPOINT_MAGIC.
+    char m_magic[8];
+
+    //! \ref C_CHECKPOINT_VERSION.
+    uint32_t m_version;
+
+    //! Size of this header in bytes.
+    uint32_t m_headerSize;
+
+    //! Sizes of the arrays that follow the header.
+    uint32_t m_numParticles;
+    uint32_t m_numSprings;
+    uint32_t m_numShapes;
+    uint32_t m_numParameters;
+
+    //! Integration scheme, a \ref cParticleIntegratorType.
+    uint32_t m_integrator;
+
+    //! Step count and simulated time [s].
+    uint32_t m_numSteps;
+    double m_time;
+
+    //! State of \ref cParticleSimulation::m_random.
+    uint64_t m_randomState;
+
+    //! Global settings of the simulation.
+    double m_externalForce[3];
+    double m_dragCoefficient;
+    double m_particleRadius;
+    double m_particleRestitution;
+    uint32_t m_collideParticles;
+
+    //! Nonzero if the integrator cached the forces stored in the checkpoint.
+    uint32_t m_cachedForces;
+};
+
+//===========================================================================
+/*!
+    \class      cParticleCheckpoint
+    \ingroup    particles
+
+    \brief
+    cParticleCheckpoint holds the complete state of a
+    \ref cParticleSimulation in one contiguous binary block: positions,
+    velocities and masses, spring settings, contact shapes, global
+    settings, the simulated time and step count, the state of the
+    random generator, plus any number of application parameters.
+    Saving and restoring are a series of memcpy calls into memory kept
+    from one save to the next, so both take microseconds for the scenes
+    of the demo and do not allocate once the block has grown.
+
+    Topology (which particles a spring connects) is not stored: a
+    checkpoint restores into the simulation it was saved from, or into
+    one built the same way. The forces cached by the integrator are
+    stored too, so that a run continued from a restored checkpoint
+    repeats the original run exactly with the explicit schemes; the
+    implicit scheme loses its warm start and agrees to the tolerance of
+    its solver.
+
+    The block can be written to a file as is with \ref getData() and
+    \ref getSize() and read back with \ref load().
+*/
+//===========================================================================
+class cParticleCheckpoint
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleCheckpoint.
+    cParticleCheckpoint() {}
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Copy the state of \e a_simulation and \e a_numParameters parameters.
+    void save(const cParticleSimulation& a_simulation, const double* a_parameters,
+              const unsigned int a_numParameters);
+
+    //! Copy the saved state back. Returns false if empty or if the counts differ.
+    bool restore(cParticleSimulation& a_simulation, double* a_parameters,
+                 const unsigned int a_numParameters) const;
+
+    //! Replace the block with \e a_size bytes at \e a_data. Returns false if it is not a checkpoint.
+    bool load(const void* a_data, const size_t a_size);
+
+    //! Forget the saved state.
+    inline void clear() { m_data.clear(); }
+
+    //! True if nothing was saved.
+    inline bool isEmpty() const { return (m_data.empty()); }
+
+    //! Start of the block.
+    inline const char* getData() const { return (m_data.empty() ? NULL : &m_data[0]); }
+
+    //! Size of the block in bytes.
+    inline size_t getSize() const { return (m_data.size()); }
+
+    //! Header of the block; only valid if not empty.
+    inline const cCheckpointHeader& getHeader() const { return (*(const cCheckpointHeader*)&m_data[0]); }
+
+    //! Simulated time of the saved state [s].
+    inline double getTime() const { return (m_data.empty() ? 0.0 : getHeader().m_time); }
+
+    //! Size in bytes of a checkpoint of the given counts.
+    static size_t getSize(const unsigned int a_numParticles, const unsigned int a_numSprings,
+                          const unsigned int a_numShapes, const unsigned int a_numParameters);
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! The block: a \ref cCheckpointHeader followed by the arrays.
+    std::vector<char> m_data;
+
+    //! Reassembles blocks in place.
+    friend class cCheckpointHistory;
+};
+
+
+//===========================================================================
+/*!
+    \class      cCheckpointHistory
+    \ingroup    particles
+
+    \brief
+    cCheckpointHistory keeps the last checkpoints of a run in memory, for
+    rewinding. Each checkpoint is cut into pages of
+    \ref C_CHECKPOINT_PAGE_SIZE bytes; a page equal to the same page of
+    the previous checkpoint is not copied but shared with it, and pages
+    are immutable once stored, so they are freed when the last
+    checkpoint using them is dropped. Masses, springs and shapes, and
+    the particles that did not move, are thus stored once for the whole
+    history rather than once per checkpoint.
+
+    Checkpoints are numbered from 0, the oldest, to
+    \ref getNumCheckpoints() - 1. When the history is full, pushing a
+    checkpoint drops the oldest one.
+
+    A history must be used from one thread.
+*/
+//===========================================================================
+class cCheckpointHistory
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cCheckpointHistory.
+    cCheckpointHistory(const unsigned int a_capacity = 64);
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Maximum number of checkpoints kept. Drops the oldest ones if needed.
+    void setCapacity(const unsigned int a_capacity);
+
+    //! Maximum number of checkpoints kept.
+    inline unsigned int getCapacity() const { return (m_capacity); }
+
+    //! Append a checkpoint, sharing its unchanged pages with the previous one.
+    void push(const cParticleCheckpoint& a_checkpoint);
+
+    //! Reassemble checkpoint \e a_index into \e a_checkpoint.
+    bool get(const unsigned int a_index, cParticleCheckpoint& a_checkpoint) const;
+
+    //! Last checkpoint taken at or before \e a_time (the oldest one if earlier).
+    unsigned int findCheckpoint(const double a_time) const;
+
+    //! Drop the checkpoints taken after \e a_time, e.g. the abandoned future after a rewind.
+    void truncate(const double a_time);
+
+    //! Remove all checkpoints.
+    inline void clear() { m_entries.clear(); }
+
+    //! Number of checkpoints kept.
+    inline unsigned int getNumCheckpoints() const { return ((unsigned int)m_entries.size()); }
+
+    //! Simulated time of checkpoint \e a_index [s].
+    inline double getTime(const unsigned int a_index) const { return (m_entries[a_index].m_time); }
+
+    //! Bytes of page data held by the history.
+    size_t getMemoryUsed() const;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // TYPES:
+    //-----------------------------------------------------------------------
+
+    //! One stored page, shared between checkpoints.
+    typedef std::shared_ptr< const std::vector<char> > cCheckpointPage;
+
+    //! One checkpoint of the history.
+    struct cCheckpointEntry
+    {
+        double m_time;
+        size_t m_size;
+        std::vector<cCheckpointPage> m_pages;
+    };
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Checkpoints, oldest first.
+    std::deque<cCheckpointEntry> m_entries;
+
+    //! Maximum number of checkpoints.
+    unsigned int m_capacity;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,516 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleContacts.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <string.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// copies a 3 vector, normalizing it if requested
+static inline void cCopy3(double a_dst[3], const double a_src[3], const bool a_normalize)
+{
+    double scale = 1.0;
+    if (a_normalize)
+    {
+        double length = sqrt(a_src[0]*a_src[0] + a_src[1]*a_src[1] + a_src[2]*a_src[2]);
+        scale = (length > 0.0) ? (1.0 / length) : 0.0;
+    }
+    a_dst[0] = a_src[0] * scale;
+    a_dst[1] = a_src[1] * scale;
+    a_dst[2] = a_src[2] * scale;
+}
+
+// returns a shape with every field cleared
+static inline cContactShape cNewShape(const cContactShapeType a_type, const double a_restitution)
+{
+    cContactShape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.m_type = a_type;
+    shape.m_restitution = a_restitution;
+    return (shape);
+}
+
+// pushes particle i out along (nx,ny,nz) by a_depth and reflects its
+// normal velocity if it is moving inwards; a particle out of contact
+// (a_depth zero) is left untouched, since splitting and rebuilding its
+// velocity along a normal would change its last bits; returns 1 for a
+// contact and 0 otherwise
+static inline unsigned int cRespond(cParticleArrays& a_particles, const unsigned int i,
+                                    const double nx, const double ny, const double nz,
+                                    const double a_depth, const double a_restitution,
+                                    const double a_friction)
+{
+    if (a_depth <= 0.0) { return (0); }
+
+    a_particles.m_posX[i] += nx * a_depth;
+    a_particles.m_posY[i] += ny * a_depth;
+    a_particles.m_posZ[i] += nz * a_depth;
+
+    double vx = a_particles.m_velX[i];
+    double vy = a_particles.m_velY[i];
+    double vz = a_particles.m_velZ[i];
+    double vn = vx*nx + vy*ny + vz*nz;
+
+    double impulse = (vn < 0.0) ? -(1.0 + a_restitution) * vn : 0.0;
+    double tn = vn + impulse;
+
+    // tangential velocity is (v - vn.n), scaled by (1 - slip)
+    a_particles.m_velX[i] = (vx - vn*nx) * (1.0 - a_friction) + tn * nx;
+    a_particles.m_velY[i] = (vy - vn*ny) * (1.0 - a_friction) + tn * ny;
+    a_particles.m_velZ[i] = (vz - vn*nz) * (1.0 - a_friction) + tn * nz;
+
+    return (1);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cParticleContacts.
+
+    \fn     cParticleContacts::cParticleContacts()
+*/
+//===========================================================================
+cParticleContacts::cParticleContacts()
+{
+    m_maxPenetration = 0.0;
+}
+
+
+//===========================================================================
+/*!
+    Add an infinite plane. Particles are kept on the side the normal
+    points to.
+
+    \fn     unsigned int cParticleContacts::addPlane(const double a_point[3],
+            const double a_normal[3], const double a_restitution)
+    \param  a_point  Any point of the plane.
+    \param  a_normal  Normal of the plane (normalized internally).
+    \param  a_restitution  Fraction of the normal velocity kept after impact.
+    \return Return the index of the new shape.
+*/
+//===========================================================================
+unsigned int cParticleContacts::addPlane(const double a_point[3],
+                                         const double a_normal[3],
+                                         const double a_restitution)
+{
+    cContactShape shape = cNewShape(C_CONTACT_PLANE, a_restitution);
+    cCopy3(shape.m_center, a_point, false);
+    cCopy3(shape.m_normal, a_normal, true);
+
+    m_shapes.push_back(shape);
+    return ((unsigned int)m_shapes.size() - 1);
+}
+
+
+//===========================================================================
+/*!
+    Add a rectangular plate. Particles collide with it only above the
+    rectangle and no deeper than \e a_thickness below its surface, so
+    they can fall past its edges.
+
+    \fn     unsigned int cParticleContacts::addBoundedPlane(const double a_point[3],
+            const double a_normal[3], const double a_tangent[3],
+            const double a_halfU, const double a_halfV,
+            const double a_thickness, const double a_restitution)
+    \param  a_point  Center of the rectangle.
+    \param  a_normal  Normal of the rectangle (normalized internally).
+    \param  a_tangent  Direction of the first side; must be orthogonal to the normal.
+    \param  a_halfU  Half size along \e a_tangent.
+    \param  a_halfV  Half size along normal x tangent.
+    \param  a_thickness  Depth below the surface at which contact is still resolved.
+    \param  a_restitution  Fraction of the normal velocity kept after impact.
+    \return Return the index of the new shape.
+*/
+//===========================================================================
+unsigned int cParticleContacts::addBoundedPlane(const double a_point[3],
+                                                const double a_normal[3],
+                                                const double a_tangent[3],
+                                                const double a_halfU,
+                                                const double a_halfV,
+                                                const double a_thickness,
+                                                const double a_restitution)
+{
+    cContactShape shape = cNewShape(C_CONTACT_PLANE, a_restitution);
+    cCopy3(shape.m_center, a_point, false);
+    cCopy3(shape.m_normal, a_normal, true);
+    cCopy3(shape.m_tangent, a_tangent, true);
+    shape.m_halfSize[0] = a_halfU;
+    shape.m_halfSize[1] = a_halfV;
+    shape.m_halfSize[2] = a_thickness;
+
+    m_shapes.push_back(shape);
+    return ((unsigned int)m_shapes.size() - 1);
+}
+
+
+//===========================================================================
+/*!
+    Add a solid axis aligned box.
+
+    \fn     unsigned int cParticleContacts::addBox(const double a_center[3],
+            const double a_halfExtents[3], const double a_restitution)
+    \param  a_center  Center of the box.
+    \param  a_halfExtents  Half sizes along x, y and z.
+    \param  a_restitution  Fraction of the normal velocity kept after impact.
+    \return Return the index of the new shape.
+*/
+//===========================================================================
+unsigned int cParticleContacts::addBox(const double a_center[3],
+                                       const double a_halfExtents[3],
+                                       const double a_restitution)
+{
+    cContactShape shape = cNewShape(C_CONTACT_BOX, a_restitution);
+    cCopy3(shape.m_center, a_center, false);
+    cCopy3(shape.m_halfSize, a_halfExtents, false);
+
+    m_shapes.push_back(shape);
+    return ((unsigned int)m_shapes.size() - 1);
+}
+
+
+//===========================================================================
+/*!
+    Add a solid sphere.
+
+    \fn     unsigned int cParticleContacts::addSphere(const double a_center[3],
+            const double a_radius, const double a_restitution)
+    \param  a_center  Center of the sphere.
+    \param  a_radius  Radius of the sphere.
+    \param  a_restitution  Fraction of the normal velocity kept after impact.
+    \return Return the index of the new shape.
+*/
+//===========================================================================
+unsigned int cParticleContacts::addSphere(const double a_center[3],
+                                          const double a_radius,
+                                          const double a_restitution)
+{
+    cContactShape shape = cNewShape(C_CONTACT_SPHERE, a_restitution);
+    cCopy3(shape.m_center, a_center, false);
+    shape.m_radius = a_radius;
+
+    m_shapes.push_back(shape);
+    return ((unsigned int)m_shapes.size() - 1);
+}
+
+
+//===========================================================================
+/*!
+    Set the restitution of every shape.
+
+    \fn     void cParticleContacts::setRestitution(const double a_restitution)
+    \param  a_restitution  Fraction of the normal velocity kept after impact.
+*/
+//===========================================================================
+void cParticleContacts::setRestitution(const double a_restitution)
+{
+    for (unsigned int i=0; i<m_shapes.size(); i++)
+    {
+        m_shapes[i].m_restitution = a_restitution;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Set the friction of every shape.
+
+    \fn     void cParticleContacts::setFriction(const double a_friction)
+    \param  a_friction  Fraction of the tangential velocity removed per contact.
+*/
+//===========================================================================
+void cParticleContacts::setFriction(const double a_friction)
+{
+    for (unsigned int i=0; i<m_shapes.size(); i++)
+    {
+        m_shapes[i].m_friction = a_friction;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Resolve contacts between every particle and every shape.
+
+    \fn     unsigned int cParticleContacts::resolve(cParticleArrays& a_particles,
+            const double a_radius, cTaskPool* a_pool)
+    \param  a_particles  Particles to test.
+    \param  a_radius  Radius of the particles.
+    \param  a_pool  Thread pool, or NULL.
+    \return Return the number of particle-shape contacts found.
+*/
+//===========================================================================
+unsigned int cParticleContacts::resolve(cParticleArrays& a_particles,
+                                        const double a_radius,
+                                        cTaskPool* a_pool)
+{
+    unsigned int numParticles = a_particles.getNumParticles();
+    if ((a_pool == NULL) || (a_pool->getNumThreads() <= 1))
+    {
+        m_maxPenetration = 0.0;
+        return (resolveRange(a_particles, a_radius, 0, numParticles, m_maxPenetration));
+    }
+
+    unsigned int numChunks = cTaskPool::getNumChunks(0, numParticles, C_TASK_GRAIN);
+    m_chunkContacts.assign(numChunks, 0);
+    m_chunkPenetration.assign(numChunks, 0.0);
+
+    a_pool->parallelFor(0, numParticles, C_TASK_GRAIN,
+        [&](unsigned int a_begin, unsigned int a_end)
+        {
+            unsigned int chunk = a_begin / C_TASK_GRAIN;
+            m_chunkContacts[chunk] = resolveRange(a_particles, a_radius, a_begin, a_end,
+                                                  m_chunkPenetration[chunk]);
+        });
+
+    unsigned int contacts = 0;
+    m_maxPenetration = 0.0;
+    for (unsigned int k=0; k<numChunks; k++)
+    {
+        contacts += m_chunkContacts[k];
+        m_maxPenetration = fmax(m_maxPenetration, m_chunkPenetration[k]);
+    }
+
+    return (contacts);
+}
+
+
+//===========================================================================
+/*!
+    Resolve contacts of particles [a_first, a_last) against every shape,
+    in the order the shapes were added.
+
+    \fn     unsigned int cParticleContacts::resolveRange(cParticleArrays& a_particles,
+            const double a_radius, const unsigned int a_first,
+            const unsigned int a_last, double& a_maxPenetration) const
+    \param  a_particles  Particles to test.
+    \param  a_radius  Radius of the particles.
+    \param  a_first  First particle.
+    \param  a_last  One past the last particle.
+    \param  a_maxPenetration  Raised to the deepest penetration found.
+    \return Return the number of particle-shape contacts found.
+*/
+//===========================================================================
+unsigned int cParticleContacts::resolveRange(cParticleArrays& a_particles,
+                                             const double a_radius,
+                                             const unsigned int a_first,
+                                             const unsigned int a_last,
+                                             double& a_maxPenetration) const
+{
+    unsigned int contacts = 0;
+    for (unsigned int k=0; k<m_shapes.size(); k++)
+    {
+        const cContactShape& shape = m_shapes[k];
+        switch (shape.m_type)
+        {
+            case C_CONTACT_PLANE:
+                contacts += resolvePlane(shape, a_particles, a_radius,
+                                         a_first, a_last, a_maxPenetration);
+                break;
+
+            case C_CONTACT_BOX:
+                contacts += resolveBox(shape, a_particles, a_radius,
+                                       a_first, a_last, a_maxPenetration);
+                break;
+
+            case C_CONTACT_SPHERE:
+                contacts += resolveSphere(shape, a_particles, a_radius,
+                                          a_first, a_last, a_maxPenetration);
+                break;
+        }
+    }
+
+    return (contacts);
+}
+
+
+//===========================================================================
+/*!
+    Resolve contacts against a plane: the penetration is the radius minus
+    the signed distance of the center to the plane.
+
+    \fn     unsigned int cParticleContacts::resolvePlane(const cContactShape& a_shape,
+            cParticleArrays& a_particles, const double a_radius,
+            const unsigned int a_first, const unsigned int a_last,
+            double& a_maxPenetration) const
+*/
+//===========================================================================
+unsigned int cParticleContacts::resolvePlane(const cContactShape& a_shape,
+                                             cParticleArrays& a_particles,
+                                             const double a_radius,
+                                             const unsigned int a_first,
+                                             const unsigned int a_last,
+                                             double& a_maxPenetration) const
+{
+    const double* n = a_shape.m_normal;
+    const double* t = a_shape.m_tangent;
+    const double* c = a_shape.m_center;
+    double b[3] = { n[1]*t[2] - n[2]*t[1],
+                    n[2]*t[0] - n[0]*t[2],
+                    n[0]*t[1] - n[1]*t[0] };
+
+    // zero sizes mean unbounded
+    double halfU = (a_shape.m_halfSize[0] > 0.0) ? a_shape.m_halfSize[0] : HUGE_VAL;
+    double halfV = (a_shape.m_halfSize[1] > 0.0) ? a_shape.m_halfSize[1] : HUGE_VAL;
+    double maxDepth = (a_shape.m_halfSize[2] > 0.0) ? (a_radius + a_shape.m_halfSize[2]) : HUGE_VAL;
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+    const double* w = a_particles.m_invMass;
+
+    unsigned int contacts = 0;
+    double maxPenetration = a_maxPenetration;
+    for (unsigned int i=a_first; i<a_last; i++)
+    {
+        double qx = px[i] - c[0];
+        double qy = py[i] - c[1];
+        double qz = pz[i] - c[2];
+
+        double depth = a_radius - (qx*n[0] + qy*n[1] + qz*n[2]);
+        double u = fabs(qx*t[0] + qy*t[1] + qz*t[2]);
+        double v = fabs(qx*b[0] + qy*b[1] + qz*b[2]);
+
+        bool inside = (depth > 0.0) && (depth < maxDepth) &&
+                      (u <= halfU) && (v <= halfV) && (w[i] > 0.0);
+        depth = inside ? depth : 0.0;
+        maxPenetration = fmax(maxPenetration, depth);
+
+        contacts += cRespond(a_particles, i, n[0], n[1], n[2], depth,
+                             a_shape.m_restitution, a_shape.m_friction);
+    }
+
+    a_maxPenetration = maxPenetration;
+    return (contacts);
+}
+
+
+//===========================================================================
+/*!
+    Resolve contacts against a solid box. A particle overlaps the box if
+    its center lies inside the box grown by the particle radius; it is
+    pushed out through the nearest face.
+
+    \fn     unsigned int cParticleContacts::resolveBox(const cContactShape& a_shape,
+            cParticleArrays& a_particles, const double a_radius,
+            const unsigned int a_first, const unsigned int a_last,
+            double& a_maxPenetration) const
+*/
+//===========================================================================
+unsigned int cParticleContacts::resolveBox(const cContactShape& a_shape,
+                                           cParticleArrays& a_particles,
+                                           const double a_radius,
+                                           const unsigned int a_first,
+                                           const unsigned int a_last,
+                                           double& a_maxPenetration) const
+{
+    const double* c = a_shape.m_center;
+    double hx = a_shape.m_halfSize[0] + a_radius;
+    double hy = a_shape.m_halfSize[1] + a_radius;
+    double hz = a_shape.m_halfSize[2] + a_radius;
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+    const double* w = a_particles.m_invMass;
+
+    unsigned int contacts = 0;
+    double maxPenetration = a_maxPenetration;
+    for (unsigned int i=a_first; i<a_last; i++)
+    {
+        double qx = px[i] - c[0];
+        double qy = py[i] - c[1];
+        double qz = pz[i] - c[2];
+
+        // distance to the nearest face along each axis
+        double dx = hx - fabs(qx);
+        double dy = hy - fabs(qy);
+        double dz = hz - fabs(qz);
+
+        bool alongX = (dx <= dy) && (dx <= dz);
+        bool alongY = !alongX && (dy <= dz);
+        bool alongZ = !alongX && !alongY;
+
+        double depth = fmin(dx, fmin(dy, dz));
+        bool inside = (depth > 0.0) && (w[i] > 0.0);
+        depth = inside ? depth : 0.0;
+        maxPenetration = fmax(maxPenetration, depth);
+
+        double nx = alongX ? ((qx >= 0.0) ? 1.0 : -1.0) : 0.0;
+        double ny = alongY ? ((qy >= 0.0) ? 1.0 : -1.0) : 0.0;
+        double nz = alongZ ? ((qz >= 0.0) ? 1.0 : -1.0) : 0.0;
+
+        contacts += cRespond(a_particles, i, nx, ny, nz, depth,
+                             a_shape.m_restitution, a_shape.m_friction);
+    }
+
+    a_maxPenetration = maxPenetration;
+    return (contacts);
+}
+
+
+//===========================================================================
+/*!
+    Resolve contacts against a solid sphere.
+
+    \fn     unsigned int cParticleContacts::resolveSphere(const cContactShape& a_shape,
+            cParticleArrays& a_particles, const double a_radius,
+            const unsigned int a_first, const unsigned int a_last,
+            double& a_maxPenetration) const
+*/
+//===========================================================================
+unsigned int cParticleContacts::resolveSphere(const cContactShape& a_shape,
+                                              cParticleArrays& a_particles,
+                                              const double a_radius,
+                                              const unsigned int a_first,
+                                              const unsigned int a_last,
+                                              double& a_maxPenetration) const
+{
+    const double* c = a_shape.m_center;
+    double reach = a_shape.m_radius + a_radius;
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+    const double* w = a_particles.m_invMass;
+
+    unsigned int contacts = 0;
+    double maxPenetration = a_maxPenetration;
+    for (unsigned int i=a_first; i<a_last; i++)
+    {
+        double qx = px[i] - c[0];
+        double qy = py[i] - c[1];
+        double qz = pz[i] - c[2];
+
+        double distance = sqrt(qx*qx + qy*qy + qz*qz);
+        double depth = reach - distance;
+        bool inside = (depth > 0.0) && (w[i] > 0.0);
+        depth = inside ? depth : 0.0;
+        maxPenetration = fmax(maxPenetration, depth);
+
+        // a particle exactly at the center is pushed upwards
+        bool degenerate = (distance < 1e-12);
+        double invDistance = degenerate ? 0.0 : (1.0 / fmax(distance, 1e-12));
+        double nx = qx * invDistance;
+        double ny = qy * invDistance;
+        double nz = degenerate ? 1.0 : qz * invDistance;
+
+        contacts += cRespond(a_particles, i, nx, ny, nz, depth,
+                             a_shape.m_restitution, a_shape.m_friction);
+    }
+
+    a_maxPenetration = maxPenetration;
+    return (contacts);
+}
@@ -0,0 +1,198 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleContactsH
+#define CParticleContactsH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+#include "CTaskPool.h"
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleContacts.h
+
+    \brief
+    <b> Particles </b> \n
+    Analytic contact between particles and static primitives.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// DECLARED TYPES
+//---------------------------------------------------------------------------
+
+//! Kinds of static collision primitives.
+enum cContactShapeType
+{
+    C_CONTACT_PLANE,        //!< infinite half space, or a bounded rectangle
+    C_CONTACT_BOX,          //!< solid axis aligned box
+    C_CONTACT_SPHERE        //!< solid sphere
+};
+
+
+//! Description of one static collision primitive.
+struct cContactShape
+{
+    //! Kind of primitive.
+    cContactShapeType m_type;
+
+    //! Point on the plane, or center of the box or sphere.
+    double m_center[3];
+
+    //! Unit normal of the plane.
+    double m_normal[3];
+
+    //! Plane: unit tangent along which \e m_halfSize[0] is measured.
+    double m_tangent[3];
+
+    //! Plane: half sizes along the tangent and bitangent (0 = unbounded), thickness.
+    //! Box: half extents along x, y and z.
+    double m_halfSize[3];
+
+    //! Sphere radius.
+    double m_radius;
+
+    //! Fraction of the normal velocity kept after an impact, in [0,1].
+    double m_restitution;
+
+    //! Fraction of the tangential velocity removed during contact, in [0,1].
+    double m_friction;
+};
+
+
+//===========================================================================
+/*!
+    \class      cParticleContacts
+    \ingroup    particles
+
+    \brief
+    cParticleContacts keeps a list of static primitives (planes, boxes,
+    spheres) and resolves contacts between them and every particle of a
+    \ref cParticleArrays. Penetration depth and contact normal are
+    computed in closed form; each primitive is processed in its own
+    loop over the particle arrays, written with selects instead of
+    branches so that the compiler can vectorize it.
+
+    A particle in contact is pushed back to the surface, and if it is
+    moving into the surface its normal velocity is reflected and scaled
+    by the restitution. Memory is only allocated when shapes are added.
+
+    Particles are independent of each other here, so with a task pool
+    the particle range is split into chunks that each run every shape;
+    contact counts and penetrations are reduced per chunk.
+*/
+//===========================================================================
+class cParticleContacts
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleContacts.
+    cParticleContacts();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Add an infinite plane through \e a_point with normal \e a_normal.
+    unsigned int addPlane(const double a_point[3], const double a_normal[3],
+                          const double a_restitution = 1.0);
+
+    //! Add a rectangle of half sizes \e a_halfU x \e a_halfV and given thickness.
+    unsigned int addBoundedPlane(const double a_point[3], const double a_normal[3],
+                                 const double a_tangent[3],
+                                 const double a_halfU, const double a_halfV,
+                                 const double a_thickness,
+                                 const double a_restitution = 1.0);
+
+    //! Add a solid axis aligned box.
+    unsigned int addBox(const double a_center[3], const double a_halfExtents[3],
+                        const double a_restitution = 1.0);
+
+    //! Add a solid sphere.
+    unsigned int addSphere(const double a_center[3], const double a_radius,
+                           const double a_restitution = 1.0);
+
+    //! Remove all shapes.
+    inline void clear() { m_shapes.clear(); }
+
+    //! Number of shapes.
+    inline unsigned int getNumShapes() const { return ((unsigned int)m_shapes.size()); }
+
+    //! Access a shape to change its placement or material.
+    inline cContactShape& getShape(const unsigned int a_index) { return (m_shapes[a_index]); }
+    inline const cContactShape& getShape(const unsigned int a_index) const { return (m_shapes[a_index]); }
+
+    //! Set the restitution of every shape.
+    void setRestitution(const double a_restitution);
+
+    //! Set the friction of every shape.
+    void setFriction(const double a_friction);
+
+    //! Resolve contacts of all particles of radius \e a_radius. Returns the number of contacts.
+    unsigned int resolve(cParticleArrays& a_particles, const double a_radius,
+                         cTaskPool* a_pool = NULL);
+
+    //! Deepest penetration found by the last call to \ref resolve().
+    inline double getMaxPenetration() const { return (m_maxPenetration); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Resolve contacts of particles [a_first, a_last) against every shape.
+    unsigned int resolveRange(cParticleArrays& a_particles, const double a_radius,
+                              const unsigned int a_first, const unsigned int a_last,
+                              double& a_maxPenetration) const;
+
+    //! Resolve contacts against one plane.
+    unsigned int resolvePlane(const cContactShape& a_shape, cParticleArrays& a_particles,
+                              const double a_radius, const unsigned int a_first,
+                              const unsigned int a_last, double& a_maxPenetration) const;
+
+    //! Resolve contacts against one box.
+    unsigned int resolveBox(const cContactShape& a_shape, cParticleArrays& a_particles,
+                            const double a_radius, const unsigned int a_first,
+                            const unsigned int a_last, double& a_maxPenetration) const;
+
+    //! Resolve contacts against one sphere.
+    unsigned int resolveSphere(const cContactShape& a_shape, cParticleArrays& a_particles,
+                               const double a_radius, const unsigned int a_first,
+                               const unsigned int a_last, double& a_maxPenetration) const;
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Static primitives.
+    std::vector<cContactShape> m_shapes;
+
+    //! Deepest penetration found by the last resolve.
+    double m_maxPenetration;
+
+    //! Per-chunk contact counts and penetrations of a parallel resolve.
+    std::vector<unsigned int> m_chunkContacts;
+    std::vector<double> m_chunkPenetration;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,898 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleEnsemble.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <string.h>
+#if defined(C_PARTICLE_ENSEMBLE_X86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// DECLARED MACROS
+//---------------------------------------------------------------------------
+
+// the kernels are written once and instantiated for every instruction set;
+// the AVX2 and AVX-512 instances are compiled for their instruction set
+// only, without fusing multiply-adds, so that every kernel rounds like the
+// scalar simulation (MSVC always allows the intrinsics and never fuses)
+#if defined(__GNUC__)
+#define C_ALWAYS_INLINE     inline __attribute__((always_inline))
+#define C_TARGET_AVX2       __attribute__((target("avx2")))
+#define C_TARGET_AVX512     __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#elif defined(_MSC_VER)
+#define C_ALWAYS_INLINE     __forceinline
+#define C_TARGET_AVX2
+#define C_TARGET_AVX512
+#else
+#define C_ALWAYS_INLINE     inline
+#define C_TARGET_AVX2
+#define C_TARGET_AVX512
+#endif
+
+// springs shorter than this exert no force (direction is undefined)
+#define C_SPRING_MIN_LENGTH     1e-12
+
+// blocks per parallel-for chunk
+#define C_ENSEMBLE_GRAIN        4
+
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// rows of a block: values of the scenario, then of every particle, spring,
+// shape and pair of particles
+enum
+{
+    C_ROW_DRAG,
+    C_ROW_PARTICLE_RESTITUTION,
+    C_ROW_CACHE_VALID,
+    C_ROW_CONTACTS,
+    C_ROW_PARTICLE_CONTACTS,
+    C_ROW_PENETRATION,
+    C_NUM_LANE_ROWS
+};
+
+enum
+{
+    C_ROW_POS_X, C_ROW_POS_Y, C_ROW_POS_Z,
+    C_ROW_VEL_X, C_ROW_VEL_Y, C_ROW_VEL_Z,
+    C_ROW_FORCE_X, C_ROW_FORCE_Y, C_ROW_FORCE_Z,
+    C_ROW_CACHE_X, C_ROW_CACHE_Y, C_ROW_CACHE_Z,
+    C_ROW_INV_MASS,
+    C_NUM_PARTICLE_ROWS
+};
+
+enum
+{
+    C_ROW_REST_LENGTH,
+    C_ROW_STIFFNESS,
+    C_ROW_DAMPING,
+    C_NUM_SPRING_ROWS
+};
+
+enum
+{
+    C_ROW_RESTITUTION,
+    C_ROW_FRICTION,
+    C_NUM_SHAPE_ROWS
+};
+
+enum
+{
+    C_ROW_PAIR_X, C_ROW_PAIR_Y, C_ROW_PAIR_Z, C_ROW_PAIR_D2,
+    C_NUM_PAIR_ROWS
+};
+
+// shared description of the scene, handed to the kernels
+struct cEnsembleScene
+{
+    unsigned int m_numParticles;
+    unsigned int m_numSprings;
+    unsigned int m_numShapes;
+    const unsigned int* m_springA;
+    const unsigned int* m_springB;
+    const cContactShape* m_shapes;
+    double m_externalForce[3];
+    double m_radius;
+    bool m_collideParticles;
+    cParticleIntegratorType m_integrator;
+
+    // first row of every section of a block
+    unsigned int m_particleRow;
+    unsigned int m_springRow;
+    unsigned int m_shapeRow;
+    unsigned int m_pairRow;
+};
+
+// number of pairs of n particles
+static inline unsigned int cNumPairs(const unsigned int a_numParticles)
+{
+    return (a_numParticles * (a_numParticles - 1) / 2);
+}
+
+
+//---------------------------------------------------------------------------
+// LANE OPERATIONS
+//---------------------------------------------------------------------------
+
+// one scenario at a time
+struct cLanesScalar
+{
+    typedef double V;
+    typedef bool M;
+    enum { C_WIDTH = 1 };
+
+    static inline V set1(const double a) { return (a); }
+    static inline V load(const double* p) { return (*p); }
+    static inline void store(double* p, const V a) { *p = a; }
+    static inline V get(const double* p, const unsigned int r) { return (p[r * C_ENSEMBLE_BLOCK_LANES]); }
+    static inline void set(double* p, const unsigned int r, const V a) { p[r * C_ENSEMBLE_BLOCK_LANES] = a; }
+    static inline V add(const V a, const V b) { return (a + b); }
+    static inline V sub(const V a, const V b) { return (a - b); }
+    static inline V mul(const V a, const V b) { return (a * b); }
+    static inline V div(const V a, const V b) { return (a / b); }
+    static inline V sqrt(const V a) { return (::sqrt(a)); }
+    static inline V min(const V a, const V b) { return ((a < b) ? a : b); }
+    static inline V max(const V a, const V b) { return ((a > b) ? a : b); }
+    static inline V abs(const V a) { return (fabs(a)); }
+    static inline V neg(const V a) { return (-a); }
+    static inline M lt(const V a, const V b) { return (a < b); }
+    static inline M le(const V a, const V b) { return (a <= b); }
+    static inline M gt(const V a, const V b) { return (a > b); }
+    static inline M ge(const V a, const V b) { return (a >= b); }
+    static inline M land(const M a, const M b) { return (a && b); }
+    static inline M lnot(const M a) { return (!a); }
+    static inline V select(const M m, const V a, const V b) { return (m ? a : b); }
+    static inline bool all(const M m) { return (m); }
+};
+
+#if defined(C_PARTICLE_ENSEMBLE_X86)
+
+// two scenarios per instruction
+struct cLanesSSE2
+{
+    typedef __m128d V;
+    typedef __m128d M;
+    enum { C_WIDTH = 2 };
+
+    static inline V set1(const double a) { return (_mm_set1_pd(a)); }
+    static inline V load(const double* p) { return (_mm_load_pd(p)); }
+    static inline void store(double* p, const V a) { _mm_store_pd(p, a); }
+    static inline V get(const double* p, const unsigned int r) { return (_mm_load_pd(p + r * C_ENSEMBLE_BLOCK_LANES)); }
+    static inline void set(double* p, const unsigned int r, const V a) { _mm_store_pd(p + r * C_ENSEMBLE_BLOCK_LANES, a); }
+    static inline V add(const V a, const V b) { return (_mm_add_pd(a, b)); }
+    static inline V sub(const V a, const V b) { return (_mm_sub_pd(a, b)); }
+    static inline V mul(const V a, const V b) { return (_mm_mul_pd(a, b)); }
+    static inline V div(const V a, const V b) { return (_mm_div_pd(a, b)); }
+    static inline V sqrt(const V a) { return (_mm_sqrt_pd(a)); }
+    static inline V min(const V a, const V b) { return (_mm_min_pd(a, b)); }
+    static inline V max(const V a, const V b) { return (_mm_max_pd(a, b)); }
+    static inline V abs(const V a) { return (_mm_andnot_pd(_mm_set1_pd(-0.0), a)); }
+    static inline V neg(const V a) { return (_mm_xor_pd(_mm_set1_pd(-0.0), a)); }
+    static inline M lt(const V a, const V b) { return (_mm_cmplt_pd(a, b)); }
+    static inline M le(const V a, const V b) { return (_mm_cmple_pd(a, b)); }
+    static inline M gt(const V a, const V b) { return (_mm_cmpgt_pd(a, b)); }
+    static inline M ge(const V a, const V b) { return (_mm_cmpge_pd(a, b)); }
+    static inline M land(const M a, const M b) { return (_mm_and_pd(a, b)); }
+    static inline M lnot(const M a) { return (_mm_xor_pd(a, _mm_castsi128_pd(_mm_set1_epi32(-1)))); }
+    static inline V select(const M m, const V a, const V b) { return (_mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b))); }
+    static inline bool all(const M m) { return (_mm_movemask_pd(m) == 3); }
+};
+
+// four scenarios per instruction
+struct cLanesAVX2
+{
+    typedef __m256d V;
+    typedef __m256d M;
+    enum { C_WIDTH = 4 };
+
+    C_TARGET_AVX2 static inline V set1(const double a) { return (_mm256_set1_pd(a)); }
+    C_TARGET_AVX2 static inline V load(const double* p) { return (_mm256_load_pd(p)); }
+    C_TARGET_AVX2 static inline void store(double* p, const V a) { _mm256_store_pd(p, a); }
+    C_TARGET_AVX2 static inline V get(const double* p, const unsigned int r) { return (_mm256_load_pd(p + r * C_ENSEMBLE_BLOCK_LANES)); }
+    C_TARGET_AVX2 static inline void set(double* p, const unsigned int r, const V a) { _mm256_store_pd(p + r * C_ENSEMBLE_BLOCK_LANES, a); }
+    C_TARGET_AVX2 static inline V add(const V a, const V b) { return (_mm256_add_pd(a, b)); }
+    C_TARGET_AVX2 static inline V sub(const V a, const V b) { return (_mm256_sub_pd(a, b)); }
+    C_TARGET_AVX2 static inline V mul(const V a, const V b) { return (_mm256_mul_pd(a, b)); }
+    C_TARGET_AVX2 static inline V div(const V a, const V b) { return (_mm256_div_pd(a, b)); }
+    C_TARGET_AVX2 static inline V sqrt(const V a) { return (_mm256_sqrt_pd(a)); }
+    C_TARGET_AVX2 static inline V min(const V a, const V b) { return (_mm256_min_pd(a, b)); }
+    C_TARGET_AVX2 static inline V max(const V a, const V b) { return (_mm256_max_pd(a, b)); }
+    C_TARGET_AVX2 static inline V abs(const V a) { return (_mm256_andnot_pd(_mm256_set1_pd(-0.0), a)); }
+    C_TARGET_AVX2 static inline V neg(const V a) { return (_mm256_xor_pd(_mm256_set1_pd(-0.0), a)); }
+    C_TARGET_AVX2 static inline M lt(const V a, const V b) { return (_mm256_cmp_pd(a, b, _CMP_LT_OQ)); }
+    C_TARGET_AVX2 static inline M le(const V a, const V b) { return (_mm256_cmp_pd(a, b, _CMP_LE_OQ)); }
+    C_TARGET_AVX2 static inline M gt(const V a, const V b) { return (_mm256_cmp_pd(a, b, _CMP_GT_OQ)); }
+    C_TARGET_AVX2 static inline M ge(const V a, const V b) { return (_mm256_cmp_pd(a, b, _CMP_GE_OQ)); }
+    C_TARGET_AVX2 static inline M land(const M a, const M b) { return (_mm256_and_pd(a, b)); }
+    C_TARGET_AVX2 static inline M lnot(const M a) { return (_mm256_xor_pd(a, _mm256_castsi256_pd(_mm256_set1_epi32(-1)))); }
+    C_TARGET_AVX2 static inline V select(const M m, const V a, const V b) { return (_mm256_blendv_pd(b, a, m)); }
+    C_TARGET_AVX2 static inline bool all(const M m) { return (_mm256_movemask_pd(m) == 15); }
+};
+
+// eight scenarios per instruction; sqrt, min and max use the masked forms
+// with every lane set, whose source is defined (GCC 12 warns about the
+// undefined source of the plain forms)
+struct cLanesAVX512
+{
+    typedef __m512d V;
+    typedef __mmask8 M;
+    enum { C_WIDTH = 8 };
+
+    C_TARGET_AVX512 static inline V set1(const double a) { return (_mm512_set1_pd(a)); }
+    C_TARGET_AVX512 static inline V load(const double* p) { return (_mm512_load_pd(p)); }
+    C_TARGET_AVX512 static inline void store(double* p, const V a) { _mm512_store_pd(p, a); }
+    C_TARGET_AVX512 static inline V get(const double* p, const unsigned int r) { return (_mm512_load_pd(p + r * C_ENSEMBLE_BLOCK_LANES)); }
+    C_TARGET_AVX512 static inline void set(double* p, const unsigned int r, const V a) { _mm512_store_pd(p + r * C_ENSEMBLE_BLOCK_LANES, a); }
+    C_TARGET_AVX512 static inline V add(const V a, const V b) { return (_mm512_add_pd(a, b)); }
+    C_TARGET_AVX512 static inline V sub(const V a, const V b) { return (_mm512_sub_pd(a, b)); }
+    C_TARGET_AVX512 static inline V mul(const V a, const V b) { return (_mm512_mul_pd(a, b)); }
+    C_TARGET_AVX512 static inline V div(const V a, const V b) { return (_mm512_div_pd(a, b)); }
+    C_TARGET_AVX512 static inline V sqrt(const V a) { return (_mm512_mask_sqrt_pd(a, 0xFF, a)); }
+    C_TARGET_AVX512 static inline V min(const V a, const V b) { return (_mm512_mask_min_pd(a, 0xFF, a, b)); }
+    C_TARGET_AVX512 static inline V max(const V a, const V b) { return (_mm512_mask_max_pd(a, 0xFF, a, b)); }
+    C_TARGET_AVX512 static inline V abs(const V a) { return (_mm512_abs_pd(a)); }
+    C_TARGET_AVX512 static inline V neg(const V a) { return (_mm512_sub_pd(_mm512_setzero_pd(), a)); }
+    C_TARGET_AVX512 static inline M lt(const V a, const V b) { return (_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ)); }
+    C_TARGET_AVX512 static inline M le(const V a, const V b) { return (_mm512_cmp_pd_mask(a, b, _CMP_LE_OQ)); }
+    C_TARGET_AVX512 static inline M gt(const V a, const V b) { return (_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ)); }
+    C_TARGET_AVX512 static inline M ge(const V a, const V b) { return (_mm512_cmp_pd_mask(a, b, _CMP_GE_OQ)); }
+    C_TARGET_AVX512 static inline M land(const M a, const M b) { return ((M)(a & b)); }
+    C_TARGET_AVX512 static inline M lnot(const M a) { return ((M)~a); }
+    C_TARGET_AVX512 static inline V select(const M m, const V a, const V b) { return (_mm512_mask_blend_pd(m, b, a)); }
+    C_TARGET_AVX512 static inline bool all(const M m) { return (m == 0xFF); }
+};
+
+#endif
+
+
+//---------------------------------------------------------------------------
+// KERNEL
+//---------------------------------------------------------------------------
+
+// the kernels, compiled once per instruction set: the AVX2 and AVX-512
+// copies with the options of C_TARGET_AVX2 and C_TARGET_AVX512, so that no
+// function passing their vectors is compiled without the instruction set
+namespace cEnsembleKernelDefault
+{
+#include "CParticleEnsembleKernel.h"
+}
+
+#if defined(C_PARTICLE_ENSEMBLE_X86) && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace cEnsembleKernelAVX2
+{
+#include "CParticleEnsembleKernel.h"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+namespace cEnsembleKernelAVX512
+{
+#include "CParticleEnsembleKernel.h"
+}
+#pragma GCC pop_options
+#else
+namespace cEnsembleKernelAVX2 = cEnsembleKernelDefault;
+namespace cEnsembleKernelAVX512 = cEnsembleKernelDefault;
+#endif
+
+// one step of a whole block, with every instruction set
+static void cEnsembleStepScalar(const cEnsembleScene& a_scene, double* a_block, const double a_dt)
+{
+    for (unsigned int l=0; l<C_ENSEMBLE_BLOCK_LANES; l+=cLanesScalar::C_WIDTH)
+    {
+        cEnsembleKernelDefault::cEnsembleStep<cLanesScalar>(a_scene, a_block + l, a_dt);
+    }
+}
+
+#if defined(C_PARTICLE_ENSEMBLE_X86)
+
+static void cEnsembleStepSSE2(const cEnsembleScene& a_scene, double* a_block, const double a_dt)
+{
+    for (unsigned int l=0; l<C_ENSEMBLE_BLOCK_LANES; l+=cLanesSSE2::C_WIDTH)
+    {
+        cEnsembleKernelDefault::cEnsembleStep<cLanesSSE2>(a_scene, a_block + l, a_dt);
+    }
+}
+
+C_TARGET_AVX2
+static void cEnsembleStepAVX2(const cEnsembleScene& a_scene, double* a_block, const double a_dt)
+{
+    for (unsigned int l=0; l<C_ENSEMBLE_BLOCK_LANES; l+=cLanesAVX2::C_WIDTH)
+    {
+        cEnsembleKernelAVX2::cEnsembleStep<cLanesAVX2>(a_scene, a_block + l, a_dt);
+    }
+}
+
+C_TARGET_AVX512
+static void cEnsembleStepAVX512(const cEnsembleScene& a_scene, double* a_block, const double a_dt)
+{
+    cEnsembleKernelAVX512::cEnsembleStep<cLanesAVX512>(a_scene, a_block, a_dt);
+}
+
+#endif
+
+
+//===========================================================================
+/*!
+    Return true if \e a_kernel can run on this CPU. The result of the
+    CPU query is computed once.
+
+    \fn     bool cIsEnsembleKernelSupported(const cEnsembleKernelType a_kernel)
+    \param  a_kernel  Kernel to test.
+    \return Return \b true if the kernel is available.
+*/
+//===========================================================================
+bool cIsEnsembleKernelSupported(const cEnsembleKernelType a_kernel)
+{
+    switch (a_kernel)
+    {
+        case C_ENSEMBLE_KERNEL_AUTO:
+        case C_ENSEMBLE_KERNEL_SCALAR:
+            return (true);
+
+#if defined(C_PARTICLE_ENSEMBLE_X86)
+        case C_ENSEMBLE_KERNEL_SSE2:
+            return (true);
+
+        case C_ENSEMBLE_KERNEL_AVX2:
+        case C_ENSEMBLE_KERNEL_AVX512:
+        {
+#if defined(_MSC_VER)
+            static int supported = -1;
+            if (supported < 0)
+            {
+                int info[4];
+                __cpuid(info, 1);
+                bool osxsave = (info[2] & (1 << 27)) != 0;
+                unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+                __cpuidex(info, 7, 0);
+                bool avx2 = ((xcr0 & 6) == 6) && ((info[1] & (1 << 5)) != 0);
+                bool avx512 = ((xcr0 & 0xE6) == 0xE6) && ((info[1] & (1 << 16)) != 0);
+                supported = (avx2 ? 1 : 0) | (avx512 ? 2 : 0);
+            }
+            return ((supported & ((a_kernel == C_ENSEMBLE_KERNEL_AVX2) ? 1 : 2)) != 0);
+#else
+            static const bool avx2 = __builtin_cpu_supports("avx2");
+            static const bool avx512 = __builtin_cpu_supports("avx512f");
+            return ((a_kernel == C_ENSEMBLE_KERNEL_AVX2) ? avx2 : avx512);
+#endif
+        }
+#endif
+
+        default:
+            return (false);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Return the fastest ensemble kernel supported by the running CPU.
+
+    \fn     cEnsembleKernelType cGetBestEnsembleKernel()
+    \return Return the kernel type.
+*/
+//===========================================================================
+cEnsembleKernelType cGetBestEnsembleKernel()
+{
+    if (cIsEnsembleKernelSupported(C_ENSEMBLE_KERNEL_AVX512)) { return (C_ENSEMBLE_KERNEL_AVX512); }
+    if (cIsEnsembleKernelSupported(C_ENSEMBLE_KERNEL_AVX2)) { return (C_ENSEMBLE_KERNEL_AVX2); }
+    if (cIsEnsembleKernelSupported(C_ENSEMBLE_KERNEL_SSE2)) { return (C_ENSEMBLE_KERNEL_SSE2); }
+    return (C_ENSEMBLE_KERNEL_SCALAR);
+}
+
+
+//===========================================================================
+/*!
+    Return a printable name for \e a_kernel.
+
+    \fn     const char* cGetEnsembleKernelName(const cEnsembleKernelType a_kernel)
+    \param  a_kernel  Kernel type.
+    \return Return the name of the kernel.
+*/
+//===========================================================================
+const char* cGetEnsembleKernelName(const cEnsembleKernelType a_kernel)
+{
+    switch (a_kernel)
+    {
+        case C_ENSEMBLE_KERNEL_AUTO:   return ("auto");
+        case C_ENSEMBLE_KERNEL_SCALAR: return ("scalar");
+        case C_ENSEMBLE_KERNEL_SSE2:   return ("sse2");
+        case C_ENSEMBLE_KERNEL_AVX2:   return ("avx2");
+        case C_ENSEMBLE_KERNEL_AVX512: return ("avx512");
+    }
+    return ("unknown");
+}
+
+
+//===========================================================================
+/*!
+    Return true if an ensemble can use the integration scheme \e a_type:
+    explicit Euler, symplectic Euler and velocity Verlet.
+
+    \fn     bool cIsEnsembleIntegrator(const cParticleIntegratorType a_type)
+    \param  a_type  Integration scheme.
+    \return Return \b true if the scheme is supported.
+*/
+//===========================================================================
+bool cIsEnsembleIntegrator(const cParticleIntegratorType a_type)
+{
+    return ((a_type == C_INTEGRATOR_EXPLICIT_EULER) ||
+            (a_type == C_INTEGRATOR_SYMPLECTIC_EULER) ||
+            (a_type == C_INTEGRATOR_VELOCITY_VERLET));
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cParticleEnsemble.
+
+    \fn     cParticleEnsemble::cParticleEnsemble()
+*/
+//===========================================================================
+cParticleEnsemble::cParticleEnsemble()
+{
+    m_numLanes = 0;
+    m_numBlocks = 0;
+    m_numParticles = 0;
+    m_numSprings = 0;
+    m_numShapes = 0;
+    m_blockSize = 0;
+    m_data = NULL;
+    m_externalForce[0] = 0.0;
+    m_externalForce[1] = 0.0;
+    m_externalForce[2] = 0.0;
+    m_particleRadius = 0.0;
+    m_collideParticles = false;
+    m_integrator = C_DEFAULT_PARTICLE_INTEGRATOR;
+    m_kernel = C_ENSEMBLE_KERNEL_AUTO;
+    m_pool = NULL;
+    m_time = 0.0;
+    m_numSteps = 0;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cParticleEnsemble.
+
+    \fn     cParticleEnsemble::~cParticleEnsemble()
+*/
+//===========================================================================
+cParticleEnsemble::~cParticleEnsemble()
+{
+    release();
+}
+
+
+//===========================================================================
+/*!
+    Release the blocks.
+
+    \fn     void cParticleEnsemble::release()
+*/
+//===========================================================================
+void cParticleEnsemble::release()
+{
+    cParticleAlignedFree(m_data);
+    m_data = NULL;
+    m_numLanes = 0;
+    m_numBlocks = 0;
+}
+
+
+//===========================================================================
+/*!
+    Create \e a_numLanes scenarios with the topology, shared parameters
+    and integration scheme of \e a_template, and fill every lane with
+    its state and parameters. The clock starts at zero.
+
+    \fn     bool cParticleEnsemble::create(const cParticleSimulation& a_template,
+            const unsigned int a_numLanes)
+    \param  a_template  Simulation giving the scene.
+    \param  a_numLanes  Number of scenarios.
+    \return Return \b true on success, \b false if the integrator of the
+            template is not supported or memory ran out.
+*/
+//===========================================================================
+bool cParticleEnsemble::create(const cParticleSimulation& a_template, const unsigned int a_numLanes)
+{
+    release();
+    if (!cIsEnsembleIntegrator(a_template.getIntegratorType())) { return (false); }
+
+    const cSpringTable& springs = a_template.m_springs;
+    m_numParticles = a_template.m_particles.getNumParticles();
+    m_numSprings = springs.getNumSprings();
+    m_numShapes = a_template.m_contacts.getNumShapes();
+
+    m_springA.assign(springs.m_indexA, springs.m_indexA + m_numSprings);
+    m_springB.assign(springs.m_indexB, springs.m_indexB + m_numSprings);
+    m_shapes.clear();
+    for (unsigned int k=0; k<m_numShapes; k++)
+    {
+        m_shapes.push_back(a_template.m_contacts.getShape(k));
+    }
+
+    m_externalForce[0] = a_template.m_externalForce[0];
+    m_externalForce[1] = a_template.m_externalForce[1];
+    m_externalForce[2] = a_template.m_externalForce[2];
+    m_particleRadius = a_template.m_particleRadius;
+    m_collideParticles = a_template.m_collideParticles && (m_numParticles > 1);
+    m_integrator = a_template.getIntegratorType();
+
+    unsigned int numRows = C_NUM_LANE_ROWS + m_numParticles * C_NUM_PARTICLE_ROWS +
+                           m_numSprings * C_NUM_SPRING_ROWS + m_numShapes * C_NUM_SHAPE_ROWS;
+    if (m_collideParticles) { numRows += cNumPairs(m_numParticles) * C_NUM_PAIR_ROWS; }
+
+    m_blockSize = numRows * C_ENSEMBLE_BLOCK_LANES;
+    m_numBlocks = (a_numLanes + C_ENSEMBLE_BLOCK_LANES - 1) / C_ENSEMBLE_BLOCK_LANES;
+    size_t size = (size_t)m_numBlocks * m_blockSize * sizeof(double);
+    if (size > 0)
+    {
+        m_data = (double*)cParticleAlignedMalloc(size);
+        if (m_data == NULL)
+        {
+            m_numBlocks = 0;
+            return (false);
+        }
+
+        // unused lanes of the last block hold static particles only
+        memset(m_data, 0, size);
+    }
+    m_numLanes = a_numLanes;
+
+    for (unsigned int lane=0; lane<m_numLanes; lane++)
+    {
+        setLane(lane, a_template);
+    }
+
+    m_time = 0.0;
+    m_numSteps = 0;
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Copy the positions, velocities and masses of \e a_simulation, the
+    parameters of its springs and shapes, its drag and its particle
+    restitution into lane \e a_lane. The lane starts as after
+    \ref cParticleSimulation::resetIntegrator().
+
+    \fn     bool cParticleEnsemble::setLane(const unsigned int a_lane,
+            const cParticleSimulation& a_simulation)
+    \param  a_lane  Scenario to overwrite.
+    \param  a_simulation  Simulation with the topology of the template.
+    \return Return \b true on success, \b false if the lane does not exist
+            or the topology differs.
+*/
+//===========================================================================
+bool cParticleEnsemble::setLane(const unsigned int a_lane, const cParticleSimulation& a_simulation)
+{
+    const cParticleArrays& particles = a_simulation.m_particles;
+    const cSpringTable& springs = a_simulation.m_springs;
+    const cParticleContacts& contacts = a_simulation.m_contacts;
+
+    if ((a_lane >= m_numLanes) ||
+        (particles.getNumParticles() != m_numParticles) ||
+        (springs.getNumSprings() != m_numSprings) ||
+        (contacts.getNumShapes() != m_numShapes))
+    {
+        return (false);
+    }
+    for (unsigned int k=0; k<m_numSprings; k++)
+    {
+        if ((springs.m_indexA[k] != m_springA[k]) || (springs.m_indexB[k] != m_springB[k])) { return (false); }
+    }
+    for (unsigned int k=0; k<m_numShapes; k++)
+    {
+        if (contacts.getShape(k).m_type != m_shapes[k].m_type) { return (false); }
+    }
+
+    getValue(a_lane, C_ROW_DRAG) = a_simulation.m_dragCoefficient;
+    getValue(a_lane, C_ROW_PARTICLE_RESTITUTION) = a_simulation.m_particleRestitution;
+    getValue(a_lane, C_ROW_CACHE_VALID) = 0.0;
+    getValue(a_lane, C_ROW_CONTACTS) = 0.0;
+    getValue(a_lane, C_ROW_PARTICLE_CONTACTS) = 0.0;
+    getValue(a_lane, C_ROW_PENETRATION) = 0.0;
+
+    for (unsigned int i=0; i<m_numParticles; i++)
+    {
+        unsigned int r = getParticleRow(i);
+        getValue(a_lane, r + C_ROW_POS_X) = particles.m_posX[i];
+        getValue(a_lane, r + C_ROW_POS_Y) = particles.m_posY[i];
+        getValue(a_lane, r + C_ROW_POS_Z) = particles.m_posZ[i];
+        getValue(a_lane, r + C_ROW_VEL_X) = particles.m_velX[i];
+        getValue(a_lane, r + C_ROW_VEL_Y) = particles.m_velY[i];
+        getValue(a_lane, r + C_ROW_VEL_Z) = particles.m_velZ[i];
+        getValue(a_lane, r + C_ROW_INV_MASS) = particles.m_invMass[i];
+    }
+
+    for (unsigned int k=0; k<m_numSprings; k++)
+    {
+        unsigned int r = getSpringRow(k);
+        getValue(a_lane, r + C_ROW_REST_LENGTH) = springs.m_restLength[k];
+        getValue(a_lane, r + C_ROW_STIFFNESS) = springs.m_stiffness[k];
+        getValue(a_lane, r + C_ROW_DAMPING) = springs.m_damping[k];
+    }
+
+    for (unsigned int k=0; k<m_numShapes; k++)
+    {
+        unsigned int r = getShapeRow(k);
+        getValue(a_lane, r + C_ROW_RESTITUTION) = contacts.getShape(k).m_restitution;
+        getValue(a_lane, r + C_ROW_FRICTION) = contacts.getShape(k).m_friction;
+    }
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Copy the positions and velocities of lane \e a_lane and the clock of
+    the ensemble into \e a_simulation, which must have the topology of
+    the template. Forces cached by velocity Verlet are handed over, so
+    that \e a_simulation continues exactly as the lane would.
+
+    \fn     void cParticleEnsemble::getLane(const unsigned int a_lane,
+            cParticleSimulation& a_simulation) const
+    \param  a_lane  Scenario to read.
+    \param  a_simulation  Simulation to overwrite.
+*/
+//===========================================================================
+void cParticleEnsemble::getLane(const unsigned int a_lane, cParticleSimulation& a_simulation) const
+{
+    cParticleArrays& particles = a_simulation.m_particles;
+    if ((a_lane >= m_numLanes) || (particles.getNumParticles() != m_numParticles)) { return; }
+
+    getParticles(a_lane, particles);
+    for (unsigned int i=0; i<m_numParticles; i++)
+    {
+        unsigned int r = getParticleRow(i);
+        particles.m_forceX[i] = getValue(a_lane, r + C_ROW_CACHE_X);
+        particles.m_forceY[i] = getValue(a_lane, r + C_ROW_CACHE_Y);
+        particles.m_forceZ[i] = getValue(a_lane, r + C_ROW_CACHE_Z);
+    }
+
+    if (getValue(a_lane, C_ROW_CACHE_VALID) > 0.0)
+    {
+        a_simulation.getIntegrator()->setCachedForces(particles);
+    }
+    else
+    {
+        a_simulation.resetIntegrator();
+    }
+
+    // particles asleep in a_simulation may be moving in the lane
+    a_simulation.m_islands.wakeAll();
+    a_simulation.setClock(m_time, m_numSteps);
+}
+
+
+//===========================================================================
+/*!
+    Copy the positions and velocities of lane \e a_lane into
+    \e a_particles, e.g. to measure the state of a scenario after every
+    step without the cost of a full \ref getLane().
+
+    \fn     void cParticleEnsemble::getParticles(const unsigned int a_lane,
+            cParticleArrays& a_particles) const
+    \param  a_lane  Scenario to read.
+    \param  a_particles  Particles to overwrite, as many as in the template.
+*/
+//===========================================================================
+void cParticleEnsemble::getParticles(const unsigned int a_lane, cParticleArrays& a_particles) const
+{
+    if ((a_lane >= m_numLanes) || (a_particles.getNumParticles() != m_numParticles)) { return; }
+
+    for (unsigned int i=0; i<m_numParticles; i++)
+    {
+        unsigned int r = getParticleRow(i);
+        a_particles.m_posX[i] = getValue(a_lane, r + C_ROW_POS_X);
+        a_particles.m_posY[i] = getValue(a_lane, r + C_ROW_POS_Y);
+        a_particles.m_posZ[i] = getValue(a_lane, r + C_ROW_POS_Z);
+        a_particles.m_velX[i] = getValue(a_lane, r + C_ROW_VEL_X);
+        a_particles.m_velY[i] = getValue(a_lane, r + C_ROW_VEL_Y);
+        a_particles.m_velZ[i] = getValue(a_lane, r + C_ROW_VEL_Z);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Advance every scenario by \e a_dt seconds. With a task pool, groups
+    of blocks are stepped in parallel; scenarios are independent, so the
+    result does not depend on the number of threads.
+
+    \fn     void cParticleEnsemble::step(const double a_dt)
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cParticleEnsemble::step(const double a_dt)
+{
+    if ((a_dt <= 0.0) || (m_numBlocks == 0)) { return; }
+
+    cEnsembleKernelType kernel = m_kernel;
+    if (kernel == C_ENSEMBLE_KERNEL_AUTO)
+    {
+        static const cEnsembleKernelType best = cGetBestEnsembleKernel();
+        kernel = best;
+    }
+    else if (!cIsEnsembleKernelSupported(kernel))
+    {
+        kernel = C_ENSEMBLE_KERNEL_SCALAR;
+    }
+
+    void (*stepBlock)(const cEnsembleScene&, double*, const double) = cEnsembleStepScalar;
+#if defined(C_PARTICLE_ENSEMBLE_X86)
+    if (kernel == C_ENSEMBLE_KERNEL_SSE2) { stepBlock = cEnsembleStepSSE2; }
+    if (kernel == C_ENSEMBLE_KERNEL_AVX2) { stepBlock = cEnsembleStepAVX2; }
+    if (kernel == C_ENSEMBLE_KERNEL_AVX512) { stepBlock = cEnsembleStepAVX512; }
+#endif
+
+    cEnsembleScene scene;
+    scene.m_numParticles = m_numParticles;
+    scene.m_numSprings = m_numSprings;
+    scene.m_numShapes = m_numShapes;
+    scene.m_springA = m_springA.empty() ? NULL : &m_springA[0];
+    scene.m_springB = m_springB.empty() ? NULL : &m_springB[0];
+    scene.m_shapes = m_shapes.empty() ? NULL : &m_shapes[0];
+    scene.m_externalForce[0] = m_externalForce[0];
+    scene.m_externalForce[1] = m_externalForce[1];
+    scene.m_externalForce[2] = m_externalForce[2];
+    scene.m_radius = m_particleRadius;
+    scene.m_collideParticles = m_collideParticles;
+    scene.m_integrator = m_integrator;
+    scene.m_particleRow = getParticleRow(0);
+    scene.m_springRow = getSpringRow(0);
+    scene.m_shapeRow = getShapeRow(0);
+    scene.m_pairRow = getShapeRow(m_numShapes);
+
+    double* data = m_data;
+    unsigned int blockSize = m_blockSize;
+    cParallelFor(m_pool, 0, m_numBlocks, C_ENSEMBLE_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int b=a_begin; b<a_end; b++)
+        {
+            stepBlock(scene, data + (size_t)b * blockSize, a_dt);
+        }
+    });
+
+    m_time += a_dt;
+    m_numSteps++;
+}
+
+
+//===========================================================================
+/*!
+    Position of a particle of a scenario.
+
+    \fn     void cParticleEnsemble::getPosition(const unsigned int a_lane,
+            const unsigned int a_index, double a_pos[3]) const
+    \param  a_lane  Scenario.
+    \param  a_index  Particle.
+    \param  a_pos  Receives the position.
+*/
+//===========================================================================
+void cParticleEnsemble::getPosition(const unsigned int a_lane, const unsigned int a_index,
+                                    double a_pos[3]) const
+{
+    unsigned int r = getParticleRow(a_index);
+    a_pos[0] = getValue(a_lane, r + C_ROW_POS_X);
+    a_pos[1] = getValue(a_lane, r + C_ROW_POS_Y);
+    a_pos[2] = getValue(a_lane, r + C_ROW_POS_Z);
+}
+
+
+//===========================================================================
+/*!
+    Velocity of a particle of a scenario.
+
+    \fn     void cParticleEnsemble::getVelocity(const unsigned int a_lane,
+            const unsigned int a_index, double a_vel[3]) const
+    \param  a_lane  Scenario.
+    \param  a_index  Particle.
+    \param  a_vel  Receives the velocity.
+*/
+//===========================================================================
+void cParticleEnsemble::getVelocity(const unsigned int a_lane, const unsigned int a_index,
+                                    double a_vel[3]) const
+{
+    unsigned int r = getParticleRow(a_index);
+    a_vel[0] = getValue(a_lane, r + C_ROW_VEL_X);
+    a_vel[1] = getValue(a_lane, r + C_ROW_VEL_Y);
+    a_vel[2] = getValue(a_lane, r + C_ROW_VEL_Z);
+}
+
+
+//===========================================================================
+/*!
+    Number of particle-shape contacts resolved in a scenario by the last
+    step.
+
+    \fn     unsigned int cParticleEnsemble::getNumContacts(const unsigned int a_lane) const
+    \param  a_lane  Scenario.
+    \return Return the number of contacts.
+*/
+//===========================================================================
+unsigned int cParticleEnsemble::getNumContacts(const unsigned int a_lane) const
+{
+    return ((unsigned int)getValue(a_lane, C_ROW_CONTACTS));
+}
+
+
+//===========================================================================
+/*!
+    Number of particle-particle contacts resolved in a scenario by the
+    last step.
+
+    \fn     unsigned int cParticleEnsemble::getNumParticleContacts(const unsigned int a_lane) const
+    \param  a_lane  Scenario.
+    \return Return the number of contacts.
+*/
+//===========================================================================
+unsigned int cParticleEnsemble::getNumParticleContacts(const unsigned int a_lane) const
+{
+    return ((unsigned int)getValue(a_lane, C_ROW_PARTICLE_CONTACTS));
+}
+
+
+//===========================================================================
+/*!
+    Deepest particle-shape penetration of a scenario in the last step,
+    as \ref cParticleContacts::getMaxPenetration().
+
+    \fn     double cParticleEnsemble::getMaxPenetration(const unsigned int a_lane) const
+    \param  a_lane  Scenario.
+    \return Return the penetration [m].
+*/
+//===========================================================================
+double cParticleEnsemble::getMaxPenetration(const unsigned int a_lane) const
+{
+    return (getValue(a_lane, C_ROW_PENETRATION));
+}
+
+
+//===========================================================================
+/*!
+    First row of a particle, of a spring and of a shape in a block.
+
+    \fn     unsigned int cParticleEnsemble::getParticleRow(const unsigned int a_index) const
+    \param  a_index  Particle, spring or shape.
+    \return Return the row index.
+*/
+//===========================================================================
+unsigned int cParticleEnsemble::getParticleRow(const unsigned int a_index) const
+{
+    return (C_NUM_LANE_ROWS + a_index * C_NUM_PARTICLE_ROWS);
+}
+
+unsigned int cParticleEnsemble::getSpringRow(const unsigned int a_index) const
+{
+    return (getParticleRow(m_numParticles) + a_index * C_NUM_SPRING_ROWS);
+}
+
+unsigned int cParticleEnsemble::getShapeRow(const unsigned int a_index) const
+{
+    return (getSpringRow(m_numSprings) + a_index * C_NUM_SHAPE_ROWS);
+}
@@ -0,0 +1,248 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleEnsembleH
+#define CParticleEnsembleH
+//---------------------------------------------------------------------------
+#include "CParticleSimulation.h"
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleEnsemble.h
+
+    \brief
+    <b> Particles </b> \n
+    Many scenarios of one scene advanced in lockstep, one per SIMD lane.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define C_PARTICLE_ENSEMBLE_X86
+#endif
+//---------------------------------------------------------------------------
+
+//! Number of scenarios stored side by side in a block of a \ref cParticleEnsemble.
+const unsigned int C_ENSEMBLE_BLOCK_LANES = 8;
+
+//---------------------------------------------------------------------------
+// DECLARED TYPES
+//---------------------------------------------------------------------------
+
+//! Implementations of the ensemble step.
+enum cEnsembleKernelType
+{
+    C_ENSEMBLE_KERNEL_AUTO,     //!< best kernel supported by the running CPU
+    C_ENSEMBLE_KERNEL_SCALAR,   //!< portable C++, one scenario at a time
+    C_ENSEMBLE_KERNEL_SSE2,     //!< two scenarios per instruction
+    C_ENSEMBLE_KERNEL_AVX2,     //!< four scenarios per instruction
+    C_ENSEMBLE_KERNEL_AVX512    //!< eight scenarios per instruction
+};
+
+
+//---------------------------------------------------------------------------
+// GLOBAL FUNCTIONS
+//---------------------------------------------------------------------------
+
+//! Return the fastest ensemble kernel supported by the running CPU.
+cEnsembleKernelType cGetBestEnsembleKernel();
+
+//! Return true if \e a_kernel can run on this CPU.
+bool cIsEnsembleKernelSupported(const cEnsembleKernelType a_kernel);
+
+//! Return a printable name for \e a_kernel.
+const char* cGetEnsembleKernelName(const cEnsembleKernelType a_kernel);
+
+//! Return true if an ensemble can use the integration scheme \e a_type.
+bool cIsEnsembleIntegrator(const cParticleIntegratorType a_type);
+
+
+//===========================================================================
+/*!
+    \class      cParticleEnsemble
+    \ingroup    particles
+
+    \brief
+    cParticleEnsemble advances many scenarios of one scene in lockstep.
+    Every scenario has the particles, springs and contact shapes of a
+    template simulation, but its own positions, velocities and masses,
+    its own spring, contact and drag parameters, and lives in its own
+    lane of the SIMD registers: one instruction advances 2 (SSE2),
+    4 (AVX2) or 8 (AVX-512) scenarios.
+
+    Scenarios are stored in blocks of \ref C_ENSEMBLE_BLOCK_LANES. In a
+    block, every quantity (a coordinate of a particle, the stiffness of a
+    spring, the friction of a shape) is a row of consecutive lanes,
+    aligned on 64 bytes, so that registers are filled by plain loads and
+    no gather or scatter is needed. Since the topology is shared, every
+    lane runs the same instructions; the conditions of the contact
+    response become masks, as in \ref cParticleContacts.
+
+    The step repeats the operations of \ref cParticleSimulation in the
+    same order and without fused multiply-adds, so every kernel gives
+    the same result bit for bit, and the same as a simulation of the
+    scenario on its own as long as its springs are evaluated by the
+    scalar spring kernel (fewer than four springs). Two differences
+    remain: particle-particle contacts are searched among all
+    pairs, which only suits small scenes such as the triangle of the
+    demo, and resolved in index order rather than in spatial hash order,
+    which changes the result when a particle touches two others in the
+    same step. Only explicit Euler, symplectic Euler and velocity Verlet
+    are supported (see \ref cIsEnsembleIntegrator()).
+
+    The external force, the particle radius and the geometry of the
+    contact shapes are shared by all scenarios.
+*/
+//===========================================================================
+class cParticleEnsemble
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleEnsemble.
+    cParticleEnsemble();
+
+    //! Destructor of cParticleEnsemble.
+    ~cParticleEnsemble();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Create \e a_numLanes copies of \e a_template. Returns false if its integrator is not supported.
+    bool create(const cParticleSimulation& a_template, const unsigned int a_numLanes);
+
+    //! Copy the state and parameters of \e a_simulation into lane \e a_lane.
+    bool setLane(const unsigned int a_lane, const cParticleSimulation& a_simulation);
+
+    //! Copy the state of lane \e a_lane into \e a_simulation, created like the template.
+    void getLane(const unsigned int a_lane, cParticleSimulation& a_simulation) const;
+
+    //! Copy the positions and velocities of lane \e a_lane into \e a_particles.
+    void getParticles(const unsigned int a_lane, cParticleArrays& a_particles) const;
+
+    //! Advance every scenario by \e a_dt seconds.
+    void step(const double a_dt);
+
+    //! Run the steps on \e a_pool, one task per group of blocks (NULL: on the calling thread).
+    inline void setTaskPool(cTaskPool* a_pool) { m_pool = a_pool; }
+
+    //! Select the kernel (an unsupported kernel falls back to scalar code).
+    inline void setKernel(const cEnsembleKernelType a_kernel) { m_kernel = a_kernel; }
+
+    //! Selected kernel.
+    inline cEnsembleKernelType getKernel() const { return (m_kernel); }
+
+    //! Number of scenarios.
+    inline unsigned int getNumLanes() const { return (m_numLanes); }
+
+    //! Number of particles of every scenario.
+    inline unsigned int getNumParticles() const { return (m_numParticles); }
+
+    //! Integration scheme of every scenario.
+    inline cParticleIntegratorType getIntegratorType() const { return (m_integrator); }
+
+    //! Simulated time since \ref create() [s].
+    inline double getTime() const { return (m_time); }
+
+    //! Number of steps taken since \ref create().
+    inline unsigned int getNumSteps() const { return (m_numSteps); }
+
+    //! Position of particle \e a_index of scenario \e a_lane.
+    void getPosition(const unsigned int a_lane, const unsigned int a_index, double a_pos[3]) const;
+
+    //! Velocity of particle \e a_index of scenario \e a_lane.
+    void getVelocity(const unsigned int a_lane, const unsigned int a_index, double a_vel[3]) const;
+
+    //! Number of particle-shape contacts resolved in scenario \e a_lane by the last step.
+    unsigned int getNumContacts(const unsigned int a_lane) const;
+
+    //! Number of particle-particle contacts resolved in scenario \e a_lane by the last step.
+    unsigned int getNumParticleContacts(const unsigned int a_lane) const;
+
+    //! Deepest particle-shape penetration of scenario \e a_lane in the last step.
+    double getMaxPenetration(const unsigned int a_lane) const;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Value of row \e a_row for scenario \e a_lane.
+    inline double& getValue(const unsigned int a_lane, const unsigned int a_row) const
+    {
+        return (m_data[(a_lane / C_ENSEMBLE_BLOCK_LANES) * m_blockSize +
+                       a_row * C_ENSEMBLE_BLOCK_LANES + (a_lane % C_ENSEMBLE_BLOCK_LANES)]);
+    }
+
+    //! First row of particle \e a_index, spring \e a_index and shape \e a_index.
+    unsigned int getParticleRow(const unsigned int a_index) const;
+    unsigned int getSpringRow(const unsigned int a_index) const;
+    unsigned int getShapeRow(const unsigned int a_index) const;
+
+    //! Release the blocks.
+    void release();
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Number of scenarios, and of blocks holding them.
+    unsigned int m_numLanes;
+    unsigned int m_numBlocks;
+
+    //! Size of the scene.
+    unsigned int m_numParticles;
+    unsigned int m_numSprings;
+    unsigned int m_numShapes;
+
+    //! Number of doubles per block.
+    unsigned int m_blockSize;
+
+    //! Blocks, aligned on \ref C_PARTICLE_ALIGNMENT bytes.
+    double* m_data;
+
+    //! Shared topology: spring endpoints and contact shapes.
+    std::vector<unsigned int> m_springA;
+    std::vector<unsigned int> m_springB;
+    std::vector<cContactShape> m_shapes;
+
+    //! Shared parameters.
+    double m_externalForce[3];
+    double m_particleRadius;
+    bool m_collideParticles;
+    cParticleIntegratorType m_integrator;
+
+    //! Kernel and thread pool, not owned.
+    cEnsembleKernelType m_kernel;
+    cTaskPool* m_pool;
+
+    //! Simulated time and step count.
+    double m_time;
+    unsigned int m_numSteps;
+
+    //! Not copyable.
+    cParticleEnsemble(const cParticleEnsemble&);
+    cParticleEnsemble& operator=(const cParticleEnsemble&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
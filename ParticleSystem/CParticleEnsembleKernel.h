@@ -0,0 +1,398 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// Kernels of cParticleEnsemble, written once for every lane type P (see
+// the lane operations of CParticleEnsemble.cpp). This file has no include
+// guard: CParticleEnsemble.cpp includes it once per instruction set, each
+// time in its own namespace and compiled for that instruction set, so that
+// no function handling AVX2 or AVX-512 vectors is compiled without them.
+//---------------------------------------------------------------------------
+
+// overwrites the force rows with the external force, the drag and the
+// springs, as cParticleSimulation::computeForces() and the spring kernels
+template <class P>
+static C_ALWAYS_INLINE void cEnsembleForces(const cEnsembleScene& a_scene, double* a_lanes)
+{
+    typedef typename P::V V;
+    const V zero = P::set1(0.0);
+    const V one = P::set1(1.0);
+    const V minLength = P::set1(C_SPRING_MIN_LENGTH);
+    const V ex = P::set1(a_scene.m_externalForce[0]);
+    const V ey = P::set1(a_scene.m_externalForce[1]);
+    const V ez = P::set1(a_scene.m_externalForce[2]);
+    const V drag = P::get(a_lanes, C_ROW_DRAG);
+
+    for (unsigned int i=0; i<a_scene.m_numParticles; i++)
+    {
+        unsigned int r = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+
+        // drag force = -rate * mass * velocity; static particles get none
+        V w = P::get(a_lanes, r + C_ROW_INV_MASS);
+        V c = P::select(P::gt(w, zero), P::div(drag, w), zero);
+        P::set(a_lanes, r + C_ROW_FORCE_X, P::sub(ex, P::mul(c, P::get(a_lanes, r + C_ROW_VEL_X))));
+        P::set(a_lanes, r + C_ROW_FORCE_Y, P::sub(ey, P::mul(c, P::get(a_lanes, r + C_ROW_VEL_Y))));
+        P::set(a_lanes, r + C_ROW_FORCE_Z, P::sub(ez, P::mul(c, P::get(a_lanes, r + C_ROW_VEL_Z))));
+    }
+
+    for (unsigned int k=0; k<a_scene.m_numSprings; k++)
+    {
+        unsigned int ra = a_scene.m_particleRow + a_scene.m_springA[k] * C_NUM_PARTICLE_ROWS;
+        unsigned int rb = a_scene.m_particleRow + a_scene.m_springB[k] * C_NUM_PARTICLE_ROWS;
+        unsigned int rs = a_scene.m_springRow + k * C_NUM_SPRING_ROWS;
+
+        V dx = P::sub(P::get(a_lanes, rb + C_ROW_POS_X), P::get(a_lanes, ra + C_ROW_POS_X));
+        V dy = P::sub(P::get(a_lanes, rb + C_ROW_POS_Y), P::get(a_lanes, ra + C_ROW_POS_Y));
+        V dz = P::sub(P::get(a_lanes, rb + C_ROW_POS_Z), P::get(a_lanes, ra + C_ROW_POS_Z));
+        V dvx = P::sub(P::get(a_lanes, rb + C_ROW_VEL_X), P::get(a_lanes, ra + C_ROW_VEL_X));
+        V dvy = P::sub(P::get(a_lanes, rb + C_ROW_VEL_Y), P::get(a_lanes, ra + C_ROW_VEL_Y));
+        V dvz = P::sub(P::get(a_lanes, rb + C_ROW_VEL_Z), P::get(a_lanes, ra + C_ROW_VEL_Z));
+
+        V length = P::sqrt(P::add(P::add(P::mul(dx, dx), P::mul(dy, dy)), P::mul(dz, dz)));
+
+        // zero length springs get a zero inverse length, hence no force
+        V invLength = P::select(P::ge(length, minLength), P::div(one, P::max(length, minLength)), zero);
+
+        V stretchRate = P::mul(P::add(P::add(P::mul(dvx, dx), P::mul(dvy, dy)), P::mul(dvz, dz)), invLength);
+        V stretch = P::sub(length, P::get(a_lanes, rs + C_ROW_REST_LENGTH));
+        V f = P::mul(P::add(P::mul(P::get(a_lanes, rs + C_ROW_STIFFNESS), stretch),
+                            P::mul(P::get(a_lanes, rs + C_ROW_DAMPING), stretchRate)), invLength);
+
+        V tx = P::mul(f, dx);
+        V ty = P::mul(f, dy);
+        V tz = P::mul(f, dz);
+        P::set(a_lanes, ra + C_ROW_FORCE_X, P::add(P::get(a_lanes, ra + C_ROW_FORCE_X), tx));
+        P::set(a_lanes, ra + C_ROW_FORCE_Y, P::add(P::get(a_lanes, ra + C_ROW_FORCE_Y), ty));
+        P::set(a_lanes, ra + C_ROW_FORCE_Z, P::add(P::get(a_lanes, ra + C_ROW_FORCE_Z), tz));
+        P::set(a_lanes, rb + C_ROW_FORCE_X, P::sub(P::get(a_lanes, rb + C_ROW_FORCE_X), tx));
+        P::set(a_lanes, rb + C_ROW_FORCE_Y, P::sub(P::get(a_lanes, rb + C_ROW_FORCE_Y), ty));
+        P::set(a_lanes, rb + C_ROW_FORCE_Z, P::sub(P::get(a_lanes, rb + C_ROW_FORCE_Z), tz));
+    }
+}
+
+// pushes particle row a_row out along n by a_depth (zero when not in
+// contact) and reflects its normal velocity, as cRespond() of
+// cParticleContacts; counts the contact and raises the penetration
+template <class P>
+static C_ALWAYS_INLINE void cEnsembleRespond(double* a_lanes, const unsigned int a_row,
+                                             const typename P::V& nx, const typename P::V& ny,
+                                             const typename P::V& nz, const typename P::M& a_inside,
+                                             const typename P::V& a_depth, const typename P::V& a_restitution,
+                                             const typename P::V& a_friction)
+{
+    typedef typename P::V V;
+    typedef typename P::M M;
+    const V zero = P::set1(0.0);
+    const V one = P::set1(1.0);
+
+    V depth = P::select(a_inside, a_depth, zero);
+    M touching = P::gt(depth, zero);
+    V contact = P::select(touching, one, zero);
+    P::set(a_lanes, C_ROW_CONTACTS, P::add(P::get(a_lanes, C_ROW_CONTACTS), contact));
+    P::set(a_lanes, C_ROW_PENETRATION, P::max(P::get(a_lanes, C_ROW_PENETRATION), depth));
+
+    // lanes out of contact keep their state bit for bit, as cRespond() skips them
+    V px = P::get(a_lanes, a_row + C_ROW_POS_X);
+    V py = P::get(a_lanes, a_row + C_ROW_POS_Y);
+    V pz = P::get(a_lanes, a_row + C_ROW_POS_Z);
+    P::set(a_lanes, a_row + C_ROW_POS_X, P::select(touching, P::add(px, P::mul(nx, depth)), px));
+    P::set(a_lanes, a_row + C_ROW_POS_Y, P::select(touching, P::add(py, P::mul(ny, depth)), py));
+    P::set(a_lanes, a_row + C_ROW_POS_Z, P::select(touching, P::add(pz, P::mul(nz, depth)), pz));
+
+    V vx = P::get(a_lanes, a_row + C_ROW_VEL_X);
+    V vy = P::get(a_lanes, a_row + C_ROW_VEL_Y);
+    V vz = P::get(a_lanes, a_row + C_ROW_VEL_Z);
+    V vn = P::add(P::add(P::mul(vx, nx), P::mul(vy, ny)), P::mul(vz, nz));
+
+    V impulse = P::select(P::lt(vn, zero), P::mul(P::neg(P::add(one, a_restitution)), vn), zero);
+    V keep = P::sub(one, a_friction);
+    V tn = P::add(vn, impulse);
+
+    // tangential velocity is (v - vn.n), scaled by (1 - slip)
+    P::set(a_lanes, a_row + C_ROW_VEL_X, P::select(touching, P::add(P::mul(P::sub(vx, P::mul(vn, nx)), keep), P::mul(tn, nx)), vx));
+    P::set(a_lanes, a_row + C_ROW_VEL_Y, P::select(touching, P::add(P::mul(P::sub(vy, P::mul(vn, ny)), keep), P::mul(tn, ny)), vy));
+    P::set(a_lanes, a_row + C_ROW_VEL_Z, P::select(touching, P::add(P::mul(P::sub(vz, P::mul(vn, nz)), keep), P::mul(tn, nz)), vz));
+}
+
+// resolves every particle against every shape, in the order of
+// cParticleContacts::resolveRange()
+template <class P>
+static C_ALWAYS_INLINE void cEnsembleShapeContacts(const cEnsembleScene& a_scene, double* a_lanes)
+{
+    typedef typename P::V V;
+    typedef typename P::M M;
+    const V zero = P::set1(0.0);
+    const V one = P::set1(1.0);
+    const V radius = P::set1(a_scene.m_radius);
+
+    for (unsigned int k=0; k<a_scene.m_numShapes; k++)
+    {
+        const cContactShape& shape = a_scene.m_shapes[k];
+        unsigned int rs = a_scene.m_shapeRow + k * C_NUM_SHAPE_ROWS;
+        V restitution = P::get(a_lanes, rs + C_ROW_RESTITUTION);
+        V friction = P::get(a_lanes, rs + C_ROW_FRICTION);
+        V cx = P::set1(shape.m_center[0]);
+        V cy = P::set1(shape.m_center[1]);
+        V cz = P::set1(shape.m_center[2]);
+
+        for (unsigned int i=0; i<a_scene.m_numParticles; i++)
+        {
+            unsigned int r = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+            V qx = P::sub(P::get(a_lanes, r + C_ROW_POS_X), cx);
+            V qy = P::sub(P::get(a_lanes, r + C_ROW_POS_Y), cy);
+            V qz = P::sub(P::get(a_lanes, r + C_ROW_POS_Z), cz);
+            M dynamic = P::gt(P::get(a_lanes, r + C_ROW_INV_MASS), zero);
+
+            if (shape.m_type == C_CONTACT_PLANE)
+            {
+                const double* n = shape.m_normal;
+                const double* t = shape.m_tangent;
+                double b[3] = { n[1]*t[2] - n[2]*t[1],
+                                n[2]*t[0] - n[0]*t[2],
+                                n[0]*t[1] - n[1]*t[0] };
+
+                // zero sizes mean unbounded
+                V halfU = P::set1((shape.m_halfSize[0] > 0.0) ? shape.m_halfSize[0] : HUGE_VAL);
+                V halfV = P::set1((shape.m_halfSize[1] > 0.0) ? shape.m_halfSize[1] : HUGE_VAL);
+                V maxDepth = P::set1((shape.m_halfSize[2] > 0.0) ? (a_scene.m_radius + shape.m_halfSize[2]) : HUGE_VAL);
+                V nx = P::set1(n[0]);
+                V ny = P::set1(n[1]);
+                V nz = P::set1(n[2]);
+
+                V depth = P::sub(radius, P::add(P::add(P::mul(qx, nx), P::mul(qy, ny)), P::mul(qz, nz)));
+                V u = P::abs(P::add(P::add(P::mul(qx, P::set1(t[0])), P::mul(qy, P::set1(t[1]))),
+                                    P::mul(qz, P::set1(t[2]))));
+                V v = P::abs(P::add(P::add(P::mul(qx, P::set1(b[0])), P::mul(qy, P::set1(b[1]))),
+                                    P::mul(qz, P::set1(b[2]))));
+
+                M inside = P::land(P::land(P::gt(depth, zero), P::lt(depth, maxDepth)),
+                                   P::land(P::land(P::le(u, halfU), P::le(v, halfV)), dynamic));
+                cEnsembleRespond<P>(a_lanes, r, nx, ny, nz, inside, depth, restitution, friction);
+            }
+            else if (shape.m_type == C_CONTACT_BOX)
+            {
+                // distance to the nearest face along each axis
+                V dx = P::sub(P::set1(shape.m_halfSize[0] + a_scene.m_radius), P::abs(qx));
+                V dy = P::sub(P::set1(shape.m_halfSize[1] + a_scene.m_radius), P::abs(qy));
+                V dz = P::sub(P::set1(shape.m_halfSize[2] + a_scene.m_radius), P::abs(qz));
+
+                M alongX = P::land(P::le(dx, dy), P::le(dx, dz));
+                M alongY = P::land(P::lnot(alongX), P::le(dy, dz));
+                M alongZ = P::land(P::lnot(alongX), P::lnot(alongY));
+
+                V depth = P::min(dx, P::min(dy, dz));
+                M inside = P::land(P::gt(depth, zero), dynamic);
+
+                V nx = P::select(alongX, P::select(P::ge(qx, zero), one, P::neg(one)), zero);
+                V ny = P::select(alongY, P::select(P::ge(qy, zero), one, P::neg(one)), zero);
+                V nz = P::select(alongZ, P::select(P::ge(qz, zero), one, P::neg(one)), zero);
+                cEnsembleRespond<P>(a_lanes, r, nx, ny, nz, inside, depth, restitution, friction);
+            }
+            else
+            {
+                V distance = P::sqrt(P::add(P::add(P::mul(qx, qx), P::mul(qy, qy)), P::mul(qz, qz)));
+                V depth = P::sub(P::set1(shape.m_radius + a_scene.m_radius), distance);
+                M inside = P::land(P::gt(depth, zero), dynamic);
+
+                // a particle exactly at the center is pushed upwards
+                const V minDistance = P::set1(1e-12);
+                M degenerate = P::lt(distance, minDistance);
+                V invDistance = P::select(degenerate, zero, P::div(one, P::max(distance, minDistance)));
+                V nx = P::mul(qx, invDistance);
+                V ny = P::mul(qy, invDistance);
+                V nz = P::select(degenerate, one, P::mul(qz, invDistance));
+                cEnsembleRespond<P>(a_lanes, r, nx, ny, nz, inside, depth, restitution, friction);
+            }
+        }
+    }
+}
+
+// separates overlapping particles as cParticlePairResponse, taking the
+// pairs in index order; separations are measured before any response,
+// as the spatial hash does
+template <class P>
+static C_ALWAYS_INLINE void cEnsembleParticleContacts(const cEnsembleScene& a_scene, double* a_lanes)
+{
+    typedef typename P::V V;
+    typedef typename P::M M;
+    const V zero = P::set1(0.0);
+    const V one = P::set1(1.0);
+    const double diameter = 2.0 * a_scene.m_radius;
+    const V diameterV = P::set1(diameter);
+    const V diameter2 = P::set1(diameter * diameter);
+    const V minD2 = P::set1(1e-24);
+    const V restitution = P::get(a_lanes, C_ROW_PARTICLE_RESTITUTION);
+    const unsigned int n = a_scene.m_numParticles;
+
+    unsigned int rp = a_scene.m_pairRow;
+    for (unsigned int i=0; i<n; i++)
+    {
+        unsigned int ri = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+        for (unsigned int j=i+1; j<n; j++, rp+=C_NUM_PAIR_ROWS)
+        {
+            unsigned int rj = a_scene.m_particleRow + j * C_NUM_PARTICLE_ROWS;
+            V dx = P::sub(P::get(a_lanes, rj + C_ROW_POS_X), P::get(a_lanes, ri + C_ROW_POS_X));
+            V dy = P::sub(P::get(a_lanes, rj + C_ROW_POS_Y), P::get(a_lanes, ri + C_ROW_POS_Y));
+            V dz = P::sub(P::get(a_lanes, rj + C_ROW_POS_Z), P::get(a_lanes, ri + C_ROW_POS_Z));
+            P::set(a_lanes, rp + C_ROW_PAIR_X, dx);
+            P::set(a_lanes, rp + C_ROW_PAIR_Y, dy);
+            P::set(a_lanes, rp + C_ROW_PAIR_Z, dz);
+            P::set(a_lanes, rp + C_ROW_PAIR_D2, P::add(P::add(P::mul(dx, dx), P::mul(dy, dy)), P::mul(dz, dz)));
+        }
+    }
+
+    rp = a_scene.m_pairRow;
+    for (unsigned int i=0; i<n; i++)
+    {
+        unsigned int ri = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+        for (unsigned int j=i+1; j<n; j++, rp+=C_NUM_PAIR_ROWS)
+        {
+            unsigned int rj = a_scene.m_particleRow + j * C_NUM_PARTICLE_ROWS;
+            V d2 = P::get(a_lanes, rp + C_ROW_PAIR_D2);
+            V wi = P::get(a_lanes, ri + C_ROW_INV_MASS);
+            V wj = P::get(a_lanes, rj + C_ROW_INV_MASS);
+            V wsum = P::add(wi, wj);
+            M overlap = P::land(P::land(P::lt(d2, diameter2), P::ge(d2, minD2)), P::gt(wsum, zero));
+            P::set(a_lanes, C_ROW_PARTICLE_CONTACTS,
+                    P::add(P::get(a_lanes, C_ROW_PARTICLE_CONTACTS), P::select(overlap, one, zero)));
+
+            // other lanes divide by one and move by zero
+            V distance = P::sqrt(P::select(overlap, d2, one));
+            V nx = P::div(P::get(a_lanes, rp + C_ROW_PAIR_X), distance);
+            V ny = P::div(P::get(a_lanes, rp + C_ROW_PAIR_Y), distance);
+            V nz = P::div(P::get(a_lanes, rp + C_ROW_PAIR_Z), distance);
+
+            // split the overlap in proportion to the inverse masses
+            V depth = P::select(overlap, P::div(P::sub(diameterV, distance), wsum), zero);
+            P::set(a_lanes, ri + C_ROW_POS_X, P::sub(P::get(a_lanes, ri + C_ROW_POS_X), P::mul(P::mul(nx, depth), wi)));
+            P::set(a_lanes, ri + C_ROW_POS_Y, P::sub(P::get(a_lanes, ri + C_ROW_POS_Y), P::mul(P::mul(ny, depth), wi)));
+            P::set(a_lanes, ri + C_ROW_POS_Z, P::sub(P::get(a_lanes, ri + C_ROW_POS_Z), P::mul(P::mul(nz, depth), wi)));
+            P::set(a_lanes, rj + C_ROW_POS_X, P::add(P::get(a_lanes, rj + C_ROW_POS_X), P::mul(P::mul(nx, depth), wj)));
+            P::set(a_lanes, rj + C_ROW_POS_Y, P::add(P::get(a_lanes, rj + C_ROW_POS_Y), P::mul(P::mul(ny, depth), wj)));
+            P::set(a_lanes, rj + C_ROW_POS_Z, P::add(P::get(a_lanes, rj + C_ROW_POS_Z), P::mul(P::mul(nz, depth), wj)));
+
+            // normal impulse if the particles are approaching
+            V vxi = P::get(a_lanes, ri + C_ROW_VEL_X);
+            V vyi = P::get(a_lanes, ri + C_ROW_VEL_Y);
+            V vzi = P::get(a_lanes, ri + C_ROW_VEL_Z);
+            V vxj = P::get(a_lanes, rj + C_ROW_VEL_X);
+            V vyj = P::get(a_lanes, rj + C_ROW_VEL_Y);
+            V vzj = P::get(a_lanes, rj + C_ROW_VEL_Z);
+            V vn = P::add(P::add(P::mul(P::sub(vxj, vxi), nx), P::mul(P::sub(vyj, vyi), ny)),
+                          P::mul(P::sub(vzj, vzi), nz));
+            V impulse = P::select(P::land(overlap, P::lt(vn, zero)),
+                                  P::div(P::mul(P::neg(P::add(one, restitution)), vn), wsum), zero);
+            P::set(a_lanes, ri + C_ROW_VEL_X, P::sub(vxi, P::mul(P::mul(nx, impulse), wi)));
+            P::set(a_lanes, ri + C_ROW_VEL_Y, P::sub(vyi, P::mul(P::mul(ny, impulse), wi)));
+            P::set(a_lanes, ri + C_ROW_VEL_Z, P::sub(vzi, P::mul(P::mul(nz, impulse), wi)));
+            P::set(a_lanes, rj + C_ROW_VEL_X, P::add(vxj, P::mul(P::mul(nx, impulse), wj)));
+            P::set(a_lanes, rj + C_ROW_VEL_Y, P::add(vyj, P::mul(P::mul(ny, impulse), wj)));
+            P::set(a_lanes, rj + C_ROW_VEL_Z, P::add(vzj, P::mul(P::mul(nz, impulse), wj)));
+        }
+    }
+}
+
+// one step of the lanes starting at a_lanes, as cParticleSimulation::step()
+template <class P>
+static C_ALWAYS_INLINE void cEnsembleStep(const cEnsembleScene& a_scene, double* a_lanes, const double a_dt)
+{
+    typedef typename P::V V;
+    typedef typename P::M M;
+    const V zero = P::set1(0.0);
+    const V one = P::set1(1.0);
+    const V dt = P::set1(a_dt);
+    const unsigned int n = a_scene.m_numParticles;
+
+    if (a_scene.m_integrator == C_INTEGRATOR_VELOCITY_VERLET)
+    {
+        // forces at the start of the step, for the lanes without a cache
+        M cached = P::gt(P::get(a_lanes, C_ROW_CACHE_VALID), zero);
+        if (!P::all(cached))
+        {
+            cEnsembleForces<P>(a_scene, a_lanes);
+            for (unsigned int i=0; i<n; i++)
+            {
+                unsigned int r = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+                for (unsigned int c=0; c<3; c++)
+                {
+                    P::set(a_lanes, r + C_ROW_CACHE_X + c, P::select(cached, P::get(a_lanes, r + C_ROW_CACHE_X + c),
+                                                                      P::get(a_lanes, r + C_ROW_FORCE_X + c)));
+                }
+            }
+        }
+
+        // half kick, drift, and predict the end velocity for the force model
+        const V halfDt = P::set1(0.5 * a_dt);
+        for (unsigned int i=0; i<n; i++)
+        {
+            unsigned int r = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+            V w = P::get(a_lanes, r + C_ROW_INV_MASS);
+            for (unsigned int c=0; c<3; c++)
+            {
+                V a = P::mul(P::get(a_lanes, r + C_ROW_CACHE_X + c), w);
+                V v = P::get(a_lanes, r + C_ROW_VEL_X + c);
+                P::set(a_lanes, r + C_ROW_POS_X + c, P::add(P::get(a_lanes, r + C_ROW_POS_X + c),
+                                                             P::mul(P::add(v, P::mul(a, halfDt)), dt)));
+                P::set(a_lanes, r + C_ROW_VEL_X + c, P::add(v, P::mul(a, dt)));
+            }
+        }
+
+        // forces at the end of the step
+        cEnsembleForces<P>(a_scene, a_lanes);
+
+        // replace the predicted velocity by the average of both accelerations
+        for (unsigned int i=0; i<n; i++)
+        {
+            unsigned int r = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+            V w = P::get(a_lanes, r + C_ROW_INV_MASS);
+            for (unsigned int c=0; c<3; c++)
+            {
+                V f = P::get(a_lanes, r + C_ROW_FORCE_X + c);
+                V dv = P::mul(P::mul(P::sub(f, P::get(a_lanes, r + C_ROW_CACHE_X + c)), w), halfDt);
+                P::set(a_lanes, r + C_ROW_VEL_X + c, P::add(P::get(a_lanes, r + C_ROW_VEL_X + c), dv));
+                P::set(a_lanes, r + C_ROW_CACHE_X + c, f);
+            }
+        }
+        P::set(a_lanes, C_ROW_CACHE_VALID, one);
+    }
+    else
+    {
+        cEnsembleForces<P>(a_scene, a_lanes);
+
+        // explicit Euler moves with the old velocity, symplectic Euler with the new one
+        bool symplectic = (a_scene.m_integrator == C_INTEGRATOR_SYMPLECTIC_EULER);
+        for (unsigned int i=0; i<n; i++)
+        {
+            unsigned int r = a_scene.m_particleRow + i * C_NUM_PARTICLE_ROWS;
+            V w = P::get(a_lanes, r + C_ROW_INV_MASS);
+            for (unsigned int c=0; c<3; c++)
+            {
+                V v = P::get(a_lanes, r + C_ROW_VEL_X + c);
+                V vNew = P::add(v, P::mul(P::mul(P::get(a_lanes, r + C_ROW_FORCE_X + c), w), dt));
+                P::set(a_lanes, r + C_ROW_POS_X + c, P::add(P::get(a_lanes, r + C_ROW_POS_X + c),
+                                                             P::mul(symplectic ? vNew : v, dt)));
+                P::set(a_lanes, r + C_ROW_VEL_X + c, vNew);
+            }
+        }
+    }
+
+    P::set(a_lanes, C_ROW_CONTACTS, zero);
+    P::set(a_lanes, C_ROW_PARTICLE_CONTACTS, zero);
+    P::set(a_lanes, C_ROW_PENETRATION, zero);
+    cEnsembleShapeContacts<P>(a_scene, a_lanes);
+    if (a_scene.m_collideParticles)
+    {
+        cEnsembleParticleContacts<P>(a_scene, a_lanes);
+    }
+
+    // a contact invalidates the forces cached by velocity Verlet
+    M touched = P::gt(P::add(P::get(a_lanes, C_ROW_CONTACTS), P::get(a_lanes, C_ROW_PARTICLE_CONTACTS)), zero);
+    P::set(a_lanes, C_ROW_CACHE_VALID, P::select(touched, zero, P::get(a_lanes, C_ROW_CACHE_VALID)));
+}
@@ -0,0 +1,351 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleGenerators.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <algorithm>
+#include <utility>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// neighbour offsets of each kind of spring, one per pair of opposite directions
+static const int C_STRUCTURAL_OFFSETS[3][3] = { {1,0,0}, {0,1,0}, {0,0,1} };
+static const int C_SHEAR_OFFSETS[6][3] = { {1,1,0}, {1,-1,0}, {1,0,1}, {1,0,-1}, {0,1,1}, {0,1,-1} };
+static const int C_BRACE_OFFSETS[4][3] = { {1,1,1}, {1,1,-1}, {1,-1,1}, {1,-1,-1} };
+static const int C_BEND_OFFSETS[3][3] = { {2,0,0}, {0,2,0}, {0,0,2} };
+
+// spreads the low 21 bits of a_value to every third bit
+static inline unsigned long long cSpreadBits(const unsigned int a_value)
+{
+    unsigned long long x = a_value & 0x1fffff;
+    x = (x | (x << 32)) & 0x1f00000000ffffULL;
+    x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+    x = (x | (x << 8))  & 0x100f00f00f00f00fULL;
+    x = (x | (x << 4))  & 0x10c30c30c30c30c3ULL;
+    x = (x | (x << 2))  & 0x1249249249249249ULL;
+    return (x);
+}
+
+// Morton (Z order) code of a grid point
+static inline unsigned long long cMortonCode(const unsigned int a_x, const unsigned int a_y,
+                                             const unsigned int a_z)
+{
+    return (cSpreadBits(a_x) | (cSpreadBits(a_y) << 1) | (cSpreadBits(a_z) << 2));
+}
+
+// one kind of spring of a grid: neighbour offsets and stiffness
+struct cGridSpringKind
+{
+    const int (*m_offsets)[3];
+    unsigned int m_numOffsets;
+    double m_stiffness;
+};
+
+// spring from a particle to a neighbour of higher index
+struct cGridSpring
+{
+    unsigned int m_neighbour;
+    double m_restLength;
+    double m_stiffness;
+
+    bool operator<(const cGridSpring& a_other) const { return (m_neighbour < a_other.m_neighbour); }
+};
+
+// adds the springs of the grid, each from its endpoint of lower index and
+// in particle order, so that the table stays sorted by endpoints; returns
+// the number of springs added
+static unsigned int cAddGridSprings(cSpringTable& a_springs, const cParticleBlock& a_block,
+                                    const std::vector< std::pair<unsigned long long, unsigned int> >& a_order,
+                                    const double a_step[3][3], const cGridSpringKind* a_kinds,
+                                    const unsigned int a_numKinds, const double a_damping)
+{
+    const unsigned int* size = a_block.m_size;
+    unsigned int numSprings = 0;
+    std::vector<cGridSpring> neighbours;
+
+    for (unsigned int r=0; r<a_order.size(); r++)
+    {
+        unsigned int index = a_block.m_firstParticle + r;
+        unsigned int cell = a_order[r].second;
+        int x = (int)(cell % size[0]);
+        int y = (int)((cell / size[0]) % size[1]);
+        int z = (int)(cell / (size[0] * size[1]));
+
+        // neighbours on both sides of every offset; the ones of lower index own the spring
+        neighbours.clear();
+        for (unsigned int k=0; k<a_numKinds; k++)
+        {
+            if (a_kinds[k].m_stiffness <= 0.0) { continue; }
+
+            for (unsigned int m=0; m<2*a_kinds[k].m_numOffsets; m++)
+            {
+                int sign = (m & 1) ? -1 : 1;
+                int dx = sign * a_kinds[k].m_offsets[m/2][0];
+                int dy = sign * a_kinds[k].m_offsets[m/2][1];
+                int dz = sign * a_kinds[k].m_offsets[m/2][2];
+                int nx = x + dx;
+                int ny = y + dy;
+                int nz = z + dz;
+                if ((nx < 0) || (ny < 0) || (nz < 0) || (nx >= (int)size[0]) ||
+                    (ny >= (int)size[1]) || (nz >= (int)size[2]))
+                {
+                    continue;
+                }
+
+                unsigned int neighbour = a_block.getIndex(nx, ny, nz);
+                if (neighbour < index) { continue; }
+
+                double ex = dx * a_step[0][0] + dy * a_step[1][0] + dz * a_step[2][0];
+                double ey = dx * a_step[0][1] + dy * a_step[1][1] + dz * a_step[2][1];
+                double ez = dx * a_step[0][2] + dy * a_step[1][2] + dz * a_step[2][2];
+
+                cGridSpring spring;
+                spring.m_neighbour = neighbour;
+                spring.m_restLength = sqrt(ex*ex + ey*ey + ez*ez);
+                spring.m_stiffness = a_kinds[k].m_stiffness;
+                neighbours.push_back(spring);
+            }
+        }
+
+        std::sort(neighbours.begin(), neighbours.end());
+        for (unsigned int k=0; k<neighbours.size(); k++)
+        {
+            a_springs.addSpring(index, neighbours[k].m_neighbour, neighbours[k].m_restLength,
+                                neighbours[k].m_stiffness, a_damping);
+        }
+        numSprings += (unsigned int)neighbours.size();
+    }
+
+    return (numSprings);
+}
+
+// appends a grid of a_size points spaced by the three step vectors from
+// a_origin, in Morton order, with its springs; the spring table is then
+// colored
+static void cGenerateGrid(cParticleSimulation& a_simulation, const double a_origin[3],
+                          const double a_step[3][3], const unsigned int a_size[3],
+                          const cGeneratorMaterial& a_material, const bool a_braced,
+                          cParticleBlock* a_block)
+{
+    cParticleBlock local;
+    cParticleBlock& block = (a_block != NULL) ? *a_block : local;
+
+    cParticleArrays& particles = a_simulation.m_particles;
+    cSpringTable& springs = a_simulation.m_springs;
+
+    unsigned int count = a_size[0] * a_size[1] * a_size[2];
+    block.m_size[0] = a_size[0];
+    block.m_size[1] = a_size[1];
+    block.m_size[2] = a_size[2];
+    block.m_firstParticle = particles.getNumParticles();
+    block.m_numParticles = count;
+    block.m_numSprings = 0;
+    block.m_index.resize(count);
+    if (count == 0) { return; }
+
+    // sorting the grid points by Morton code keeps neighbours along every axis close
+    std::vector< std::pair<unsigned long long, unsigned int> > order(count);
+    for (unsigned int cell=0; cell<count; cell++)
+    {
+        unsigned int x = cell % a_size[0];
+        unsigned int y = (cell / a_size[0]) % a_size[1];
+        unsigned int z = cell / (a_size[0] * a_size[1]);
+        order[cell] = std::make_pair(cMortonCode(x, y, z), cell);
+    }
+    std::sort(order.begin(), order.end());
+
+    particles.reserve(block.m_firstParticle + count);
+    for (unsigned int r=0; r<count; r++)
+    {
+        unsigned int cell = order[r].second;
+        double x = (double)(cell % a_size[0]);
+        double y = (double)((cell / a_size[0]) % a_size[1]);
+        double z = (double)(cell / (a_size[0] * a_size[1]));
+
+        particles.addParticle(a_origin[0] + x * a_step[0][0] + y * a_step[1][0] + z * a_step[2][0],
+                              a_origin[1] + x * a_step[0][1] + y * a_step[1][1] + z * a_step[2][1],
+                              a_origin[2] + x * a_step[0][2] + y * a_step[1][2] + z * a_step[2][2],
+                              a_material.m_mass);
+        block.m_index[cell] = block.m_firstParticle + r;
+    }
+
+    // at most 3 structural, 6 shear, 4 brace and 3 bend springs per particle
+    unsigned int perParticle = 3 + 6 + (a_braced ? 4 : 0) + 3;
+    springs.reserve(springs.getNumSprings() + perParticle * count);
+
+    cGridSpringKind kinds[4] = { { C_STRUCTURAL_OFFSETS, 3, a_material.m_stiffness },
+                                 { C_SHEAR_OFFSETS, 6, a_material.m_shearStiffness },
+                                 { C_BRACE_OFFSETS, 4, a_braced ? a_material.m_shearStiffness : 0.0 },
+                                 { C_BEND_OFFSETS, 3, a_material.m_bendStiffness } };
+    block.m_numSprings = cAddGridSprings(springs, block, order, a_step, kinds, 4,
+                                         a_material.m_damping);
+
+    // the new springs come sorted by endpoints, which colorSprings() keeps within each color
+    springs.colorSprings();
+    a_simulation.resetIntegrator();
+}
+
+// spacing of a_count points spread over a_length
+static inline double cSpacing(const double a_length, const unsigned int a_count)
+{
+    return ((a_count > 1) ? (a_length / (a_count - 1)) : 0.0);
+}
+
+
+//===========================================================================
+/*!
+    Append a rope of particles evenly spaced on the segment from
+    \e a_start to \e a_end. Neighbours are joined by structural springs
+    and, if the material has a bend stiffness, every other particle by a
+    bend spring that resists folding; without bend springs the rope is a
+    chain. Springs are at rest.
+
+    Like every generator, the particles and springs are appended to the
+    flat arrays of \e a_simulation, no scene node is created, and the
+    spring table is sorted and colored again for the parallel loops.
+
+    \fn     void cGenerateRope(cParticleSimulation& a_simulation,
+            const double a_start[3], const double a_end[3],
+            const unsigned int a_numParticles,
+            const cGeneratorMaterial& a_material, cParticleBlock* a_block)
+    \param  a_simulation  Simulation to append to.
+    \param  a_start  Position of the first particle.
+    \param  a_end  Position of the last particle.
+    \param  a_numParticles  Number of particles.
+    \param  a_material  Mass and springs.
+    \param  a_block  Returns the particles emitted, if not NULL.
+*/
+//===========================================================================
+void cGenerateRope(cParticleSimulation& a_simulation, const double a_start[3],
+                   const double a_end[3], const unsigned int a_numParticles,
+                   const cGeneratorMaterial& a_material, cParticleBlock* a_block)
+{
+    double step[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+    for (unsigned int k=0; k<3; k++)
+    {
+        step[0][k] = cSpacing(a_end[k] - a_start[k], a_numParticles);
+    }
+
+    unsigned int size[3] = { a_numParticles, 1, 1 };
+    cGenerateGrid(a_simulation, a_start, step, size, a_material, false, a_block);
+}
+
+
+//===========================================================================
+/*!
+    Append a rectangular cloth: a grid of \e a_numU x \e a_numV particles
+    spanning the parallelogram of edges \e a_edgeU and \e a_edgeV from
+    \e a_origin. Structural springs join the neighbours along both edges,
+    shear springs the two diagonals of every cell, and bend springs every
+    other particle along both edges. Particles are stored in Morton order;
+    use \ref cParticleBlock::getIndex() to find a corner to pin.
+
+    \fn     void cGenerateCloth(cParticleSimulation& a_simulation,
+            const double a_origin[3], const double a_edgeU[3],
+            const double a_edgeV[3], const unsigned int a_numU,
+            const unsigned int a_numV, const cGeneratorMaterial& a_material,
+            cParticleBlock* a_block)
+    \param  a_simulation  Simulation to append to.
+    \param  a_origin  Position of the first corner.
+    \param  a_edgeU  Edge from the first corner along the first axis.
+    \param  a_edgeV  Edge from the first corner along the second axis.
+    \param  a_numU  Number of particles along \e a_edgeU.
+    \param  a_numV  Number of particles along \e a_edgeV.
+    \param  a_material  Mass and springs.
+    \param  a_block  Returns the particles emitted, if not NULL.
+*/
+//===========================================================================
+void cGenerateCloth(cParticleSimulation& a_simulation, const double a_origin[3],
+                    const double a_edgeU[3], const double a_edgeV[3],
+                    const unsigned int a_numU, const unsigned int a_numV,
+                    const cGeneratorMaterial& a_material, cParticleBlock* a_block)
+{
+    double step[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+    for (unsigned int k=0; k<3; k++)
+    {
+        step[0][k] = cSpacing(a_edgeU[k], a_numU);
+        step[1][k] = cSpacing(a_edgeV[k], a_numV);
+    }
+
+    unsigned int size[3] = { a_numU, a_numV, 1 };
+    cGenerateGrid(a_simulation, a_origin, step, size, a_material, false, a_block);
+}
+
+
+//===========================================================================
+/*!
+    Append an axis aligned lattice of \e a_count[0] x \e a_count[1] x
+    \e a_count[2] particles filling the box of size \e a_size from
+    \e a_origin. Structural springs join the neighbours along the three
+    axes, shear springs the diagonals of every face, and bend springs
+    every other particle along each axis.
+
+    \fn     void cGenerateLattice(cParticleSimulation& a_simulation,
+            const double a_origin[3], const double a_size[3],
+            const unsigned int a_count[3],
+            const cGeneratorMaterial& a_material, cParticleBlock* a_block)
+    \param  a_simulation  Simulation to append to.
+    \param  a_origin  Corner of the box with the lowest coordinates.
+    \param  a_size  Size of the box along x, y and z.
+    \param  a_count  Number of particles along x, y and z.
+    \param  a_material  Mass and springs.
+    \param  a_block  Returns the particles emitted, if not NULL.
+*/
+//===========================================================================
+void cGenerateLattice(cParticleSimulation& a_simulation, const double a_origin[3],
+                      const double a_size[3], const unsigned int a_count[3],
+                      const cGeneratorMaterial& a_material, cParticleBlock* a_block)
+{
+    double step[3][3] = { { cSpacing(a_size[0], a_count[0]), 0, 0 },
+                          { 0, cSpacing(a_size[1], a_count[1]), 0 },
+                          { 0, 0, cSpacing(a_size[2], a_count[2]) } };
+
+    cGenerateGrid(a_simulation, a_origin, step, a_count, a_material, false, a_block);
+}
+
+
+//===========================================================================
+/*!
+    Append a jelly cube: a lattice of \e a_numPerEdge particles per edge,
+    braced in every direction so that it keeps its shape and volume.
+    Besides the springs of \ref cGenerateLattice(), shear springs also
+    join the opposite corners of every cell, which gives each interior
+    particle springs to all of its 26 neighbours.
+
+    \fn     void cGenerateJellyCube(cParticleSimulation& a_simulation,
+            const double a_center[3], const double a_edge,
+            const unsigned int a_numPerEdge,
+            const cGeneratorMaterial& a_material, cParticleBlock* a_block)
+    \param  a_simulation  Simulation to append to.
+    \param  a_center  Center of the cube.
+    \param  a_edge  Edge length of the cube.
+    \param  a_numPerEdge  Number of particles along each edge.
+    \param  a_material  Mass and springs.
+    \param  a_block  Returns the particles emitted, if not NULL.
+*/
+//===========================================================================
+void cGenerateJellyCube(cParticleSimulation& a_simulation, const double a_center[3],
+                        const double a_edge, const unsigned int a_numPerEdge,
+                        const cGeneratorMaterial& a_material, cParticleBlock* a_block)
+{
+    double spacing = cSpacing(a_edge, a_numPerEdge);
+    double origin[3] = { a_center[0] - 0.5 * a_edge,
+                         a_center[1] - 0.5 * a_edge,
+                         a_center[2] - 0.5 * a_edge };
+    double step[3][3] = { { spacing, 0, 0 }, { 0, spacing, 0 }, { 0, 0, spacing } };
+    unsigned int size[3] = { a_numPerEdge, a_numPerEdge, a_numPerEdge };
+
+    cGenerateGrid(a_simulation, origin, step, size, a_material, true, a_block);
+}
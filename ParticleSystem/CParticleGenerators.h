@@ -0,0 +1,134 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleGeneratorsH
+#define CParticleGeneratorsH
+//---------------------------------------------------------------------------
+#include "CParticleSimulation.h"
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleGenerators.h
+
+    \brief
+    <b> Particles </b> \n
+    Procedural ropes, cloths, lattices and jelly cubes.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cGeneratorMaterial
+    \ingroup    particles
+
+    \brief
+    Mass and springs of a generated body. Springs whose stiffness is
+    zero are not created, so the same material describes a chain (no
+    bend springs) or a rope (with them).
+*/
+//===========================================================================
+struct cGeneratorMaterial
+{
+    //! Mass of each particle [kg].
+    double m_mass;
+
+    //! Stiffness of the structural springs, between direct neighbours [N/m].
+    double m_stiffness;
+
+    //! Stiffness of the shear springs, along the diagonals of the grid cells [N/m].
+    double m_shearStiffness;
+
+    //! Stiffness of the bend springs, which skip one particle along each axis [N/m].
+    double m_bendStiffness;
+
+    //! Damping of every spring along its axis [N.s/m].
+    double m_damping;
+
+    //! Constructor of cGeneratorMaterial.
+    cGeneratorMaterial() : m_mass(0.01), m_stiffness(100.0), m_shearStiffness(50.0),
+                           m_bendStiffness(10.0), m_damping(0.01) {}
+};
+
+
+//===========================================================================
+/*!
+    \struct     cParticleBlock
+    \ingroup    particles
+
+    \brief
+    Particles emitted by one generator. Particles are stored in the order
+    that keeps neighbours close in memory, not in grid order, so the
+    particle of a grid point, e.g. a corner to pin, is looked up with
+    \ref getIndex().
+*/
+//===========================================================================
+struct cParticleBlock
+{
+    //! Number of grid points along each axis, 1 for unused axes.
+    unsigned int m_size[3];
+
+    //! Index of the first particle emitted; the block is contiguous.
+    unsigned int m_firstParticle;
+
+    //! Number of particles emitted.
+    unsigned int m_numParticles;
+
+    //! Number of springs emitted.
+    unsigned int m_numSprings;
+
+    //! Particle index of each grid point, x fastest, then y, then z.
+    std::vector<unsigned int> m_index;
+
+    //! Particle index of grid point (\e a_x, \e a_y, \e a_z).
+    inline unsigned int getIndex(const unsigned int a_x, const unsigned int a_y = 0,
+                                 const unsigned int a_z = 0) const
+    {
+        return (m_index[(a_z * m_size[1] + a_y) * m_size[0] + a_x]);
+    }
+
+    //! Constructor of cParticleBlock.
+    cParticleBlock() : m_firstParticle(0), m_numParticles(0), m_numSprings(0)
+    {
+        m_size[0] = m_size[1] = m_size[2] = 0;
+    }
+};
+
+
+//---------------------------------------------------------------------------
+// GLOBAL FUNCTIONS
+//---------------------------------------------------------------------------
+
+//! Append a rope (or chain) of \e a_numParticles particles from \e a_start to \e a_end.
+void cGenerateRope(cParticleSimulation& a_simulation, const double a_start[3],
+                   const double a_end[3], const unsigned int a_numParticles,
+                   const cGeneratorMaterial& a_material, cParticleBlock* a_block = NULL);
+
+//! Append a rectangular cloth of \e a_numU x \e a_numV particles spanning two edges from \e a_origin.
+void cGenerateCloth(cParticleSimulation& a_simulation, const double a_origin[3],
+                    const double a_edgeU[3], const double a_edgeV[3],
+                    const unsigned int a_numU, const unsigned int a_numV,
+                    const cGeneratorMaterial& a_material, cParticleBlock* a_block = NULL);
+
+//! Append an axis aligned lattice of \e a_count particles per axis spanning \e a_size from \e a_origin.
+void cGenerateLattice(cParticleSimulation& a_simulation, const double a_origin[3],
+                      const double a_size[3], const unsigned int a_count[3],
+                      const cGeneratorMaterial& a_material, cParticleBlock* a_block = NULL);
+
+//! Append a fully braced cube of \e a_numPerEdge^3 particles and edge \e a_edge around \e a_center.
+void cGenerateJellyCube(cParticleSimulation& a_simulation, const double a_center[3],
+                        const double a_edge, const unsigned int a_numPerEdge,
+                        const cGeneratorMaterial& a_material, cParticleBlock* a_block = NULL);
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,372 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleIntegrators.h"
+#include "CImplicitEulerIntegrator.h"
+#include "CXPBDIntegrator.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// copies the first a_count elements of a_src into a_dst, growing it if needed
+static inline void cSave(std::vector<double>& a_dst, const double* a_src,
+                         const unsigned int a_count)
+{
+    if (a_dst.size() < a_count) { a_dst.resize(a_count); }
+    for (unsigned int i=0; i<a_count; i++) { a_dst[i] = a_src[i]; }
+}
+
+
+//===========================================================================
+/*!
+    Forward Euler step.
+
+    \fn     void cExplicitEulerIntegrator::integrate(cParticleForceModel& a_model,
+            cParticleArrays& a_particles, const double a_dt)
+    \param  a_model  Force model.
+    \param  a_particles  Particles to advance.
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cExplicitEulerIntegrator::integrate(cParticleForceModel& a_model,
+                                         cParticleArrays& a_particles,
+                                         const double a_dt)
+{
+    a_model.computeForces(a_particles);
+
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    double* vx = a_particles.m_velX;
+    double* vy = a_particles.m_velY;
+    double* vz = a_particles.m_velZ;
+    const double* fx = a_particles.m_forceX;
+    const double* fy = a_particles.m_forceY;
+    const double* fz = a_particles.m_forceZ;
+    const double* w = a_particles.m_invMass;
+    unsigned int n = a_particles.getNumParticles();
+
+    cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int i=a_begin; i<a_end; i++)
+        {
+            px[i] += vx[i] * a_dt;
+            py[i] += vy[i] * a_dt;
+            pz[i] += vz[i] * a_dt;
+            vx[i] += fx[i] * w[i] * a_dt;
+            vy[i] += fy[i] * w[i] * a_dt;
+            vz[i] += fz[i] * w[i] * a_dt;
+        }
+    });
+}
+
+
+//===========================================================================
+/*!
+    Symplectic Euler step.
+
+    \fn     void cSymplecticEulerIntegrator::integrate(cParticleForceModel& a_model,
+            cParticleArrays& a_particles, const double a_dt)
+    \param  a_model  Force model.
+    \param  a_particles  Particles to advance.
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cSymplecticEulerIntegrator::integrate(cParticleForceModel& a_model,
+                                           cParticleArrays& a_particles,
+                                           const double a_dt)
+{
+    a_model.computeForces(a_particles);
+
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    double* vx = a_particles.m_velX;
+    double* vy = a_particles.m_velY;
+    double* vz = a_particles.m_velZ;
+    const double* fx = a_particles.m_forceX;
+    const double* fy = a_particles.m_forceY;
+    const double* fz = a_particles.m_forceZ;
+    const double* w = a_particles.m_invMass;
+    unsigned int n = a_particles.getNumParticles();
+
+    cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int i=a_begin; i<a_end; i++)
+        {
+            vx[i] += fx[i] * w[i] * a_dt;
+            vy[i] += fy[i] * w[i] * a_dt;
+            vz[i] += fz[i] * w[i] * a_dt;
+            px[i] += vx[i] * a_dt;
+            py[i] += vy[i] * a_dt;
+            pz[i] += vz[i] * a_dt;
+        }
+    });
+}
+
+
+//===========================================================================
+/*!
+    Velocity Verlet step. Velocity dependent forces (damping) are
+    evaluated with the velocity predicted at the end of the step.
+
+    \fn     void cVelocityVerletIntegrator::integrate(cParticleForceModel& a_model,
+            cParticleArrays& a_particles, const double a_dt)
+    \param  a_model  Force model.
+    \param  a_particles  Particles to advance.
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cVelocityVerletIntegrator::integrate(cParticleForceModel& a_model,
+                                          cParticleArrays& a_particles,
+                                          const double a_dt)
+{
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    double* vx = a_particles.m_velX;
+    double* vy = a_particles.m_velY;
+    double* vz = a_particles.m_velZ;
+    const double* fx = a_particles.m_forceX;
+    const double* fy = a_particles.m_forceY;
+    const double* fz = a_particles.m_forceZ;
+    const double* w = a_particles.m_invMass;
+    unsigned int n = a_particles.getNumParticles();
+    if (n == 0) { return; }
+
+    // forces at the start of the step
+    if (!m_cacheValid || (m_forceX.size() != n))
+    {
+        a_model.computeForces(a_particles);
+        m_forceX.assign(fx, fx + n);
+        m_forceY.assign(fy, fy + n);
+        m_forceZ.assign(fz, fz + n);
+    }
+
+    // half kick, drift, and predict the end velocity for the force model
+    double halfDt = 0.5 * a_dt;
+    double* cx = &m_forceX[0];
+    double* cy = &m_forceY[0];
+    double* cz = &m_forceZ[0];
+    cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int i=a_begin; i<a_end; i++)
+        {
+            double ax = cx[i] * w[i];
+            double ay = cy[i] * w[i];
+            double az = cz[i] * w[i];
+            px[i] += (vx[i] + ax * halfDt) * a_dt;
+            py[i] += (vy[i] + ay * halfDt) * a_dt;
+            pz[i] += (vz[i] + az * halfDt) * a_dt;
+            vx[i] += ax * a_dt;
+            vy[i] += ay * a_dt;
+            vz[i] += az * a_dt;
+        }
+    });
+
+    // forces at the end of the step
+    a_model.computeForces(a_particles);
+
+    // replace the predicted velocity by the average of both accelerations
+    cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int i=a_begin; i<a_end; i++)
+        {
+            vx[i] += (fx[i] - cx[i]) * w[i] * halfDt;
+            vy[i] += (fy[i] - cy[i]) * w[i] * halfDt;
+            vz[i] += (fz[i] - cz[i]) * w[i] * halfDt;
+            cx[i] = fx[i];
+            cy[i] = fy[i];
+            cz[i] = fz[i];
+        }
+    });
+
+    m_cacheValid = true;
+}
+
+
+//===========================================================================
+/*!
+    Take the force accumulators of \e a_particles as the forces at the
+    start of the next step. They must have been computed for the current
+    state, as they are at the end of a step without contacts.
+
+    \fn     void cVelocityVerletIntegrator::setCachedForces(const cParticleArrays& a_particles)
+    \param  a_particles  Particles whose force accumulators are cached.
+*/
+//===========================================================================
+void cVelocityVerletIntegrator::setCachedForces(const cParticleArrays& a_particles)
+{
+    unsigned int n = a_particles.getNumParticles();
+    m_forceX.assign(a_particles.m_forceX, a_particles.m_forceX + n);
+    m_forceY.assign(a_particles.m_forceY, a_particles.m_forceY + n);
+    m_forceZ.assign(a_particles.m_forceZ, a_particles.m_forceZ + n);
+    m_cacheValid = true;
+}
+
+
+//===========================================================================
+/*!
+    Classic fourth order Runge-Kutta step.
+
+    \fn     void cRK4Integrator::integrate(cParticleForceModel& a_model,
+            cParticleArrays& a_particles, const double a_dt)
+    \param  a_model  Force model.
+    \param  a_particles  Particles to advance.
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cRK4Integrator::integrate(cParticleForceModel& a_model,
+                               cParticleArrays& a_particles,
+                               const double a_dt)
+{
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    double* vx = a_particles.m_velX;
+    double* vy = a_particles.m_velY;
+    double* vz = a_particles.m_velZ;
+    const double* fx = a_particles.m_forceX;
+    const double* fy = a_particles.m_forceY;
+    const double* fz = a_particles.m_forceZ;
+    const double* w = a_particles.m_invMass;
+    unsigned int n = a_particles.getNumParticles();
+    if (n == 0) { return; }
+
+    // save the initial state
+    cSave(m_posX, px, n);
+    cSave(m_posY, py, n);
+    cSave(m_posZ, pz, n);
+    cSave(m_velX, vx, n);
+    cSave(m_velY, vy, n);
+    cSave(m_velZ, vz, n);
+    cSave(m_sumPosX, px, n);
+    cSave(m_sumPosY, py, n);
+    cSave(m_sumPosZ, pz, n);
+    cSave(m_sumVelX, vx, n);
+    cSave(m_sumVelY, vy, n);
+    cSave(m_sumVelZ, vz, n);
+
+    // stage k evaluates the derivative at the current particle state, adds
+    // it with weight dt*weight[k] to the sums, and moves the particles to
+    // the next stage at offset dt*offset[k] from the initial state
+    const double weight[4] = { 1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0 };
+    const double offset[4] = { 0.5, 0.5, 1.0, 0.0 };
+
+    double* px0 = &m_posX[0];
+    double* py0 = &m_posY[0];
+    double* pz0 = &m_posZ[0];
+    double* vx0 = &m_velX[0];
+    double* vy0 = &m_velY[0];
+    double* vz0 = &m_velZ[0];
+    double* spx = &m_sumPosX[0];
+    double* spy = &m_sumPosY[0];
+    double* spz = &m_sumPosZ[0];
+    double* svx = &m_sumVelX[0];
+    double* svy = &m_sumVelY[0];
+    double* svz = &m_sumVelZ[0];
+
+    for (int k=0; k<4; k++)
+    {
+        a_model.computeForces(a_particles);
+
+        double h = a_dt * weight[k];
+        double o = a_dt * offset[k];
+        bool last = (k == 3);
+
+        cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+        {
+            for (unsigned int i=a_begin; i<a_end; i++)
+            {
+                double ax = fx[i] * w[i];
+                double ay = fy[i] * w[i];
+                double az = fz[i] * w[i];
+
+                spx[i] += h * vx[i];
+                spy[i] += h * vy[i];
+                spz[i] += h * vz[i];
+                svx[i] += h * ax;
+                svy[i] += h * ay;
+                svz[i] += h * az;
+
+                if (last)
+                {
+                    px[i] = spx[i];
+                    py[i] = spy[i];
+                    pz[i] = spz[i];
+                    vx[i] = svx[i];
+                    vy[i] = svy[i];
+                    vz[i] = svz[i];
+                }
+                else
+                {
+                    px[i] = px0[i] + o * vx[i];
+                    py[i] = py0[i] + o * vy[i];
+                    pz[i] = pz0[i] + o * vz[i];
+                    vx[i] = vx0[i] + o * ax;
+                    vy[i] = vy0[i] + o * ay;
+                    vz[i] = vz0[i] + o * az;
+                }
+            }
+        });
+    }
+}
+
+
+//===========================================================================
+/*!
+    Create an integrator of the given type.
+
+    \fn     cParticleIntegrator* cCreateParticleIntegrator(
+            const cParticleIntegratorType a_type)
+    \param  a_type  Integration scheme.
+    \return Return a new integrator. The caller is responsible for deleting it.
+*/
+//===========================================================================
+cParticleIntegrator* cCreateParticleIntegrator(const cParticleIntegratorType a_type)
+{
+    switch (a_type)
+    {
+        case C_INTEGRATOR_EXPLICIT_EULER:   return (new cExplicitEulerIntegrator());
+        case C_INTEGRATOR_SYMPLECTIC_EULER: return (new cSymplecticEulerIntegrator());
+        case C_INTEGRATOR_VELOCITY_VERLET:  return (new cVelocityVerletIntegrator());
+        case C_INTEGRATOR_RK4:              return (new cRK4Integrator());
+        case C_INTEGRATOR_IMPLICIT_EULER:   return (new cImplicitEulerIntegrator());
+        case C_INTEGRATOR_XPBD:             return (new cXPBDIntegrator());
+    }
+    return (new cSymplecticEulerIntegrator());
+}
+
+
+//===========================================================================
+/*!
+    Return a printable name for \e a_type.
+
+    \fn     const char* cGetParticleIntegratorName(const cParticleIntegratorType a_type)
+    \param  a_type  Integration scheme.
+    \return Return the name of the scheme.
+*/
+//===========================================================================
+const char* cGetParticleIntegratorName(const cParticleIntegratorType a_type)
+{
+    switch (a_type)
+    {
+        case C_INTEGRATOR_EXPLICIT_EULER:   return ("explicit Euler");
+        case C_INTEGRATOR_SYMPLECTIC_EULER: return ("symplectic Euler");
+        case C_INTEGRATOR_VELOCITY_VERLET:  return ("velocity Verlet");
+        case C_INTEGRATOR_RK4:              return ("RK4");
+        case C_INTEGRATOR_IMPLICIT_EULER:   return ("implicit Euler");
+        case C_INTEGRATOR_XPBD:             return ("XPBD");
+    }
+    return ("unknown");
+}
@@ -0,0 +1,252 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleIntegratorsH
+#define CParticleIntegratorsH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+#include "CTaskPool.h"
+#include <vector>
+//---------------------------------------------------------------------------
+class cSpringTable;
+class cParticleContacts;
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleIntegrators.h
+
+    \brief
+    <b> Particles </b> \n
+    Time integration schemes for particle systems.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// DECLARED TYPES
+//---------------------------------------------------------------------------
+
+//! Available time integration schemes.
+enum cParticleIntegratorType
+{
+    C_INTEGRATOR_EXPLICIT_EULER,    //!< x += v.dt, then v += a.dt (first order, unstable for springs)
+    C_INTEGRATOR_SYMPLECTIC_EULER,  //!< v += a.dt, then x += v.dt (first order, energy bounded)
+    C_INTEGRATOR_VELOCITY_VERLET,   //!< second order, one force evaluation per step
+    C_INTEGRATOR_RK4,               //!< classic fourth order Runge-Kutta, four evaluations per step
+    C_INTEGRATOR_IMPLICIT_EULER,    //!< backward Euler, springs solved with conjugate gradient
+    C_INTEGRATOR_XPBD               //!< extended position based dynamics, springs as compliant constraints
+};
+
+//! Number of entries in \ref cParticleIntegratorType.
+const int C_NUM_INTEGRATORS = 6;
+
+//! Integrator used when none is selected explicitly. May be overridden at compile time.
+#ifndef C_DEFAULT_PARTICLE_INTEGRATOR
+#define C_DEFAULT_PARTICLE_INTEGRATOR   C_INTEGRATOR_VELOCITY_VERLET
+#endif
+
+
+//===========================================================================
+/*!
+    \class      cParticleForceModel
+    \ingroup    particles
+
+    \brief
+    Interface of anything that can evaluate the forces acting on a set of
+    particles from their current positions and velocities.
+*/
+//===========================================================================
+class cParticleForceModel
+{
+  public:
+
+    //! Destructor of cParticleForceModel.
+    virtual ~cParticleForceModel() {}
+
+    //! Overwrite the force accumulators with the total force on each particle.
+    virtual void computeForces(cParticleArrays& a_particles) = 0;
+
+    //! Overwrite the force accumulators with every force but those of \ref getImplicitSprings().
+    virtual void computeExternalForces(cParticleArrays& a_particles) { computeForces(a_particles); }
+
+    //! Springs that implicit integrators should treat implicitly, or NULL.
+    virtual const cSpringTable* getImplicitSprings() const { return (NULL); }
+
+    //! Linear drag rate [1/s] that implicit integrators should treat implicitly.
+    virtual double getImplicitDrag() const { return (0.0); }
+
+    //! Static shapes that position based integrators may treat as constraints, or NULL.
+    virtual const cParticleContacts* getContactShapes() const { return (NULL); }
+
+    //! Collision radius of the particles against \ref getContactShapes().
+    virtual double getContactRadius() const { return (0.0); }
+};
+
+
+//===========================================================================
+/*!
+    \class      cParticleIntegrator
+    \ingroup    particles
+
+    \brief
+    Base class of the time integration schemes. An integrator advances
+    the positions and velocities stored in a \ref cParticleArrays by one
+    step, calling the force model as many times as the scheme requires.
+    Integrators may keep scratch buffers and cached forces between
+    steps; \ref reset() must be called whenever positions or velocities
+    are changed from outside the integrator.
+
+    Per-particle updates are split into chunks on the task pool given to
+    \ref setTaskPool(), if any.
+*/
+//===========================================================================
+class cParticleIntegrator
+{
+  public:
+
+    //! Constructor of cParticleIntegrator.
+    cParticleIntegrator() : m_pool(NULL) {}
+
+    //! Destructor of cParticleIntegrator.
+    virtual ~cParticleIntegrator() {}
+
+    //! Run per-particle updates on \e a_pool (NULL: on the calling thread).
+    inline void setTaskPool(cTaskPool* a_pool) { m_pool = a_pool; }
+
+    //! Advance \e a_particles by \e a_dt seconds.
+    virtual void integrate(cParticleForceModel& a_model,
+                           cParticleArrays& a_particles,
+                           const double a_dt) = 0;
+
+    //! Forget any state cached from previous steps.
+    virtual void reset() {}
+
+    //! True if the next step reuses forces cached by the previous one, equal to the particle force accumulators.
+    virtual bool hasCachedForces() const { return (false); }
+
+    //! Cache the particle force accumulators as the forces of the current state, e.g. after restoring a checkpoint.
+    virtual void setCachedForces(const cParticleArrays& a_particles) { (void)a_particles; reset(); }
+
+    //! Type of the scheme.
+    virtual cParticleIntegratorType getType() const = 0;
+
+  protected:
+
+    //! Thread pool for per-particle loops, or NULL.
+    cTaskPool* m_pool;
+};
+
+
+//===========================================================================
+/*!
+    \class      cExplicitEulerIntegrator
+    \ingroup    particles
+
+    \brief
+    Forward Euler: positions advance with the old velocities.
+*/
+//===========================================================================
+class cExplicitEulerIntegrator : public cParticleIntegrator
+{
+  public:
+    virtual void integrate(cParticleForceModel& a_model, cParticleArrays& a_particles, const double a_dt);
+    virtual cParticleIntegratorType getType() const { return (C_INTEGRATOR_EXPLICIT_EULER); }
+};
+
+
+//===========================================================================
+/*!
+    \class      cSymplecticEulerIntegrator
+    \ingroup    particles
+
+    \brief
+    Semi-implicit Euler: positions advance with the new velocities.
+*/
+//===========================================================================
+class cSymplecticEulerIntegrator : public cParticleIntegrator
+{
+  public:
+    virtual void integrate(cParticleForceModel& a_model, cParticleArrays& a_particles, const double a_dt);
+    virtual cParticleIntegratorType getType() const { return (C_INTEGRATOR_SYMPLECTIC_EULER); }
+};
+
+
+//===========================================================================
+/*!
+    \class      cVelocityVerletIntegrator
+    \ingroup    particles
+
+    \brief
+    Velocity Verlet. The forces computed at the end of a step are kept
+    and reused at the start of the next one, so a step costs a single
+    force evaluation as long as nothing else moves the particles.
+*/
+//===========================================================================
+class cVelocityVerletIntegrator : public cParticleIntegrator
+{
+  public:
+    cVelocityVerletIntegrator() : m_cacheValid(false) {}
+    virtual void integrate(cParticleForceModel& a_model, cParticleArrays& a_particles, const double a_dt);
+    virtual void reset() { m_cacheValid = false; }
+    virtual bool hasCachedForces() const { return (m_cacheValid); }
+    virtual void setCachedForces(const cParticleArrays& a_particles);
+    virtual cParticleIntegratorType getType() const { return (C_INTEGRATOR_VELOCITY_VERLET); }
+
+  private:
+    //! Forces at the end of the previous step.
+    std::vector<double> m_forceX, m_forceY, m_forceZ;
+
+    //! True if the cached forces match the current state.
+    bool m_cacheValid;
+};
+
+
+//===========================================================================
+/*!
+    \class      cRK4Integrator
+    \ingroup    particles
+
+    \brief
+    Classic fourth order Runge-Kutta. Intermediate states are written
+    into the particle arrays so that any force model can be used; the
+    initial state and the weighted sums live in preallocated buffers.
+*/
+//===========================================================================
+class cRK4Integrator : public cParticleIntegrator
+{
+  public:
+    virtual void integrate(cParticleForceModel& a_model, cParticleArrays& a_particles, const double a_dt);
+    virtual cParticleIntegratorType getType() const { return (C_INTEGRATOR_RK4); }
+
+  private:
+    //! State at the start of the step.
+    std::vector<double> m_posX, m_posY, m_posZ;
+    std::vector<double> m_velX, m_velY, m_velZ;
+
+    //! Weighted sums of the stage derivatives.
+    std::vector<double> m_sumPosX, m_sumPosY, m_sumPosZ;
+    std::vector<double> m_sumVelX, m_sumVelY, m_sumVelZ;
+};
+
+
+//---------------------------------------------------------------------------
+// GLOBAL FUNCTIONS
+//---------------------------------------------------------------------------
+
+//! Create an integrator of the given type. The caller owns the result.
+cParticleIntegrator* cCreateParticleIntegrator(const cParticleIntegratorType a_type);
+
+//! Return a printable name for \e a_type.
+const char* cGetParticleIntegratorName(const cParticleIntegratorType a_type);
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
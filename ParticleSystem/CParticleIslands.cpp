@@ -0,0 +1,408 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleIslands.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cParticleIslands. Sleeping is disabled.
+
+    \fn     cParticleIslands::cParticleIslands()
+*/
+//===========================================================================
+cParticleIslands::cParticleIslands()
+{
+    m_enabled = false;
+    m_sleepEnergy = 0.01;
+    m_sleepDelay = 0.5;
+    m_numDynamic = 0;
+    m_numSleeping = 0;
+    m_numSleepingIslands = 0;
+    m_springVersion = 0;
+    m_springRootValid = false;
+    m_islandsValid = false;
+    m_islandsHaveContacts = false;
+    m_version = 0;
+}
+
+
+//===========================================================================
+/*!
+    Enable or disable sleeping. Islands are awake in both cases and
+    restart counting their rest time.
+
+    \fn     void cParticleIslands::setEnabled(const bool a_enabled)
+    \param  a_enabled  Let resting islands fall asleep.
+*/
+//===========================================================================
+void cParticleIslands::setEnabled(const bool a_enabled)
+{
+    m_enabled = a_enabled;
+    m_contacts.clear();
+    wakeAll();
+}
+
+
+//===========================================================================
+/*!
+    Update the islands from the springs and from the contacts recorded
+    since the last call, after a step of \e a_dt seconds. Must be called
+    with the real masses, that is after \ref thaw().
+
+    The components joined by springs are only rebuilt when the spring
+    topology changed or \ref wakeAll() was called, and the islands only
+    when contacts were recorded now or in the previous call; otherwise
+    the islands of the previous call are kept.
+
+    An island holding at least one awake particle is awake as a whole:
+    sleeping particles reached by a contact wake up with it. Its rest
+    time is the shortest rest time of its particles, grown by \e a_dt
+    while its kinetic energy stays under the threshold and reset to zero
+    otherwise. Islands that have rested for the sleep delay fall asleep
+    and their velocities are cleared. Particles of sleeping islands are
+    not visited.
+
+    \fn     bool cParticleIslands::update(cParticleArrays& a_particles,
+            const cSpringTable& a_springs, const double a_dt)
+    \param  a_particles  Particles of the step.
+    \param  a_springs  Springs between them.
+    \param  a_dt  Duration of the step [s].
+    \return Return true if a particle fell asleep or woke up.
+*/
+//===========================================================================
+bool cParticleIslands::update(cParticleArrays& a_particles, const cSpringTable& a_springs,
+                              const double a_dt)
+{
+    unsigned int n = a_particles.getNumParticles();
+    const double* w = a_particles.m_invMass;
+
+    if (!m_enabled)
+    {
+        m_contacts.clear();
+        return (false);
+    }
+
+    // the scene was rebuilt: start awake
+    if (m_sleeping.size() != n)
+    {
+        m_parent.resize(n);
+        m_island.resize(n);
+        m_springRoot.resize(n);
+        m_sleeping.assign(n, 0);
+        m_restTime.assign(n, 0.0);
+        m_numSleeping = 0;
+        m_springRootValid = false;
+    }
+
+    // springs only join other particles when the topology changed
+    if (!m_springRootValid || (m_springVersion != a_springs.getTopologyVersion()))
+    {
+        buildSpringRoots(a_particles, a_springs);
+        m_islandsValid = false;
+    }
+
+    // contacts of this or of the previous update change the islands
+    bool hasContacts = !m_contacts.empty();
+    if (!m_islandsValid || hasContacts || m_islandsHaveContacts)
+    {
+        buildIslands(a_particles);
+        m_islandsHaveContacts = hasContacts;
+    }
+    m_contacts.clear();
+
+    // advance the rest time of the awake islands and put resting ones to sleep
+    bool changed = false;
+    m_numSleeping = 0;
+    m_numSleepingIslands = 0;
+    for (unsigned int k=0; k<m_islands.size(); k++)
+    {
+        cIsland& island = m_islands[k];
+        const unsigned int* members = &m_members[m_memberStart[k]];
+        if (!island.m_sleeping)
+        {
+            island.m_energy = 0.0;
+            island.m_restTime = m_restTime[members[0]];
+            for (unsigned int p=0; p<island.m_numParticles; p++)
+            {
+                unsigned int i = members[p];
+                double v2 = a_particles.m_velX[i] * a_particles.m_velX[i] +
+                            a_particles.m_velY[i] * a_particles.m_velY[i] +
+                            a_particles.m_velZ[i] * a_particles.m_velZ[i];
+                island.m_energy += 0.5 * v2 / w[i];
+                island.m_restTime = (m_restTime[i] < island.m_restTime) ? m_restTime[i] : island.m_restTime;
+            }
+
+            bool resting = (island.m_energy <= m_sleepEnergy * island.m_numParticles);
+            island.m_restTime = resting ? (island.m_restTime + a_dt) : 0.0;
+            island.m_sleeping = (island.m_restTime >= m_sleepDelay);
+
+            unsigned char sleeping = island.m_sleeping ? 1 : 0;
+            for (unsigned int p=0; p<island.m_numParticles; p++)
+            {
+                unsigned int i = members[p];
+                changed = changed || (sleeping != m_sleeping[i]);
+                m_sleeping[i] = sleeping;
+                m_restTime[i] = island.m_restTime;
+                if (sleeping != 0)
+                {
+                    a_particles.m_velX[i] = 0.0;
+                    a_particles.m_velY[i] = 0.0;
+                    a_particles.m_velZ[i] = 0.0;
+                }
+            }
+        }
+
+        if (island.m_sleeping)
+        {
+            m_numSleepingIslands++;
+            m_numSleeping += island.m_numParticles;
+        }
+    }
+
+    if (changed) { m_version++; }
+    return (changed);
+}
+
+
+//===========================================================================
+/*!
+    Wake every island. Rest times start again from zero, so that islands
+    only fall asleep again after resting for the sleep delay. Masses may
+    have changed, so the spring components are rebuilt by the next
+    \ref update().
+
+    \fn     void cParticleIslands::wakeAll()
+*/
+//===========================================================================
+void cParticleIslands::wakeAll()
+{
+    m_sleeping.assign(m_sleeping.size(), 0);
+    m_restTime.assign(m_restTime.size(), 0.0);
+    m_numSleeping = 0;
+    m_numSleepingIslands = 0;
+    m_springRootValid = false;
+    m_islandsValid = false;
+    m_version++;
+}
+
+
+//===========================================================================
+/*!
+    Set the inverse mass and the velocity of every sleeping particle to
+    zero, so that the step treats them as static: forces, integration
+    and shape contacts leave them alone, and awake particles bounce off
+    them. Their masses are kept for \ref thaw().
+
+    \fn     void cParticleIslands::freeze(cParticleArrays& a_particles)
+    \param  a_particles  Particles to freeze.
+*/
+//===========================================================================
+void cParticleIslands::freeze(cParticleArrays& a_particles)
+{
+    m_frozen.clear();
+    m_frozenInvMass.clear();
+    if (m_numSleeping == 0) { return; }
+
+    unsigned int n = a_particles.getNumParticles();
+    for (unsigned int i=0; (i<n) && (i<m_sleeping.size()); i++)
+    {
+        if (m_sleeping[i] == 0) { continue; }
+
+        m_frozen.push_back(i);
+        m_frozenInvMass.push_back(a_particles.m_invMass[i]);
+        a_particles.m_invMass[i] = 0.0;
+        a_particles.m_velX[i] = 0.0;
+        a_particles.m_velY[i] = 0.0;
+        a_particles.m_velZ[i] = 0.0;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Restore the inverse masses of the particles frozen by \ref freeze().
+
+    \fn     void cParticleIslands::thaw(cParticleArrays& a_particles)
+    \param  a_particles  Particles frozen by \ref freeze().
+*/
+//===========================================================================
+void cParticleIslands::thaw(cParticleArrays& a_particles)
+{
+    for (unsigned int k=0; k<m_frozen.size(); k++)
+    {
+        a_particles.m_invMass[m_frozen[k]] = m_frozenInvMass[k];
+    }
+    m_frozen.clear();
+    m_frozenInvMass.clear();
+}
+
+
+//===========================================================================
+/*!
+    Return the root of the set holding particle \e a_index, halving the
+    path on the way.
+
+    \fn     unsigned int cParticleIslands::findRoot(unsigned int a_index)
+    \param  a_index  Particle index.
+    \return Return the index of the root particle.
+*/
+//===========================================================================
+unsigned int cParticleIslands::findRoot(unsigned int a_index)
+{
+    while (m_parent[a_index] != a_index)
+    {
+        m_parent[a_index] = m_parent[m_parent[a_index]];
+        a_index = m_parent[a_index];
+    }
+    return (a_index);
+}
+
+
+//===========================================================================
+/*!
+    Merge the sets of particles \e a_i and \e a_j, unless one of them is
+    static.
+
+    \fn     void cParticleIslands::join(const cParticleArrays& a_particles,
+            const unsigned int a_i, const unsigned int a_j)
+    \param  a_particles  Particles, for their masses.
+    \param  a_i  First particle.
+    \param  a_j  Second particle.
+*/
+//===========================================================================
+void cParticleIslands::join(const cParticleArrays& a_particles, const unsigned int a_i,
+                            const unsigned int a_j)
+{
+    if ((a_particles.m_invMass[a_i] <= 0.0) || (a_particles.m_invMass[a_j] <= 0.0)) { return; }
+
+    unsigned int rootI = findRoot(a_i);
+    unsigned int rootJ = findRoot(a_j);
+    if (rootI == rootJ) { return; }
+
+    // the smaller index becomes the root, so islands are numbered in particle order
+    if (rootI < rootJ) { m_parent[rootJ] = rootI; }
+    else               { m_parent[rootI] = rootJ; }
+}
+
+
+//===========================================================================
+/*!
+    Join the dynamic particles connected by springs and store the root
+    of every particle in \e m_springRoot.
+
+    \fn     void cParticleIslands::buildSpringRoots(const cParticleArrays& a_particles,
+            const cSpringTable& a_springs)
+    \param  a_particles  Particles, for their masses.
+    \param  a_springs  Springs between them.
+*/
+//===========================================================================
+void cParticleIslands::buildSpringRoots(const cParticleArrays& a_particles,
+                                        const cSpringTable& a_springs)
+{
+    unsigned int n = a_particles.getNumParticles();
+    for (unsigned int i=0; i<n; i++)
+    {
+        m_parent[i] = i;
+    }
+    for (unsigned int k=0; k<a_springs.getNumSprings(); k++)
+    {
+        join(a_particles, a_springs.m_indexA[k], a_springs.m_indexB[k]);
+    }
+    for (unsigned int i=0; i<n; i++)
+    {
+        m_springRoot[i] = findRoot(i);
+    }
+
+    m_springVersion = a_springs.getTopologyVersion();
+    m_springRootValid = true;
+}
+
+
+//===========================================================================
+/*!
+    Join the recorded contacts to the spring components, number the
+    islands in particle order and list the particles of each. An island
+    sleeps if all its particles sleep; static particles belong to no
+    island.
+
+    \fn     void cParticleIslands::buildIslands(const cParticleArrays& a_particles)
+    \param  a_particles  Particles, for their masses.
+*/
+//===========================================================================
+void cParticleIslands::buildIslands(const cParticleArrays& a_particles)
+{
+    unsigned int n = a_particles.getNumParticles();
+    const double* w = a_particles.m_invMass;
+
+    m_parent = m_springRoot;
+    for (unsigned int k=0; k+1<m_contacts.size(); k+=2)
+    {
+        join(a_particles, m_contacts[k], m_contacts[k+1]);
+    }
+
+    // number the islands and count their particles
+    m_islands.clear();
+    for (unsigned int i=0; i<n; i++)
+    {
+        m_island[i] = C_NO_ISLAND;
+    }
+
+    m_numDynamic = 0;
+    for (unsigned int i=0; i<n; i++)
+    {
+        if (w[i] <= 0.0)
+        {
+            m_sleeping[i] = 0;
+            continue;
+        }
+
+        unsigned int root = findRoot(i);
+        if (m_island[root] == C_NO_ISLAND)
+        {
+            cIsland island;
+            island.m_energy = 0.0;
+            island.m_restTime = 0.0;
+            island.m_numParticles = 0;
+            island.m_sleeping = true;
+            m_island[root] = (unsigned int)m_islands.size();
+            m_islands.push_back(island);
+        }
+
+        cIsland& island = m_islands[m_island[root]];
+        m_island[i] = m_island[root];
+        island.m_numParticles++;
+        island.m_sleeping = island.m_sleeping && (m_sleeping[i] != 0);
+        m_numDynamic++;
+    }
+
+    // list the particles of every island; each start is advanced while
+    // filling, then shifted back by one island
+    unsigned int numIslands = (unsigned int)m_islands.size();
+    m_memberStart.assign(numIslands + 1, 0);
+    for (unsigned int k=1; k<numIslands; k++)
+    {
+        m_memberStart[k] = m_memberStart[k-1] + m_islands[k-1].m_numParticles;
+    }
+    m_members.resize(m_numDynamic);
+    for (unsigned int i=0; i<n; i++)
+    {
+        if (m_island[i] == C_NO_ISLAND) { continue; }
+        m_members[m_memberStart[m_island[i]]++] = i;
+    }
+    for (unsigned int k=numIslands; k>0; k--)
+    {
+        m_memberStart[k] = m_memberStart[k-1];
+    }
+    m_memberStart[0] = 0;
+
+    m_islandsValid = true;
+}
@@ -0,0 +1,227 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleIslandsH
+#define CParticleIslandsH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+#include "CSpringTable.h"
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleIslands.h
+
+    \brief
+    <b> Particles </b> \n
+    Islands of connected particles and their sleeping state.
+*/
+//===========================================================================
+
+//! Island index of a static particle, which belongs to no island.
+const unsigned int C_NO_ISLAND = 0xffffffffu;
+
+//===========================================================================
+/*!
+    \class      cParticleIslands
+    \ingroup    particles
+
+    \brief
+    cParticleIslands groups the dynamic particles into islands: two
+    particles belong to the same island if a chain of springs and of
+    particle-particle contacts of the last step joins them. Static
+    particles join nothing, so bodies resting on the same anchor or
+    touching the same static particle stay apart.
+
+    An island falls asleep once its kinetic energy has stayed below
+    \ref getSleepEnergy() times its number of particles for
+    \ref getSleepDelay() seconds; its velocities are then set to zero.
+    A sleeping island wakes up as soon as it shares an island with an
+    awake particle, that is when an awake particle touches it, or when
+    \ref wakeAll() is called.
+
+    The components joined by springs alone are cached and only rebuilt
+    when the spring topology or the set of static particles changes;
+    islands are renumbered from them only when contacts join them, and
+    the particles of sleeping islands are not visited by \ref update().
+
+    The simulation steps only the awake particles, freezes the sleeping
+    ones with \ref freeze() and \ref thaw() while awake particles may
+    collide with them, and skips the step altogether while every island
+    sleeps.
+*/
+//===========================================================================
+class cParticleIslands
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleIslands.
+    cParticleIslands();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Enable or disable sleeping. Disabling wakes every island.
+    void setEnabled(const bool a_enabled);
+
+    //! Return true if islands may fall asleep.
+    inline bool isEnabled() const { return (m_enabled); }
+
+    //! Set the kinetic energy per particle under which an island rests [J].
+    inline void setSleepEnergy(const double a_energy) { m_sleepEnergy = a_energy; }
+
+    //! Kinetic energy per particle under which an island rests [J].
+    inline double getSleepEnergy() const { return (m_sleepEnergy); }
+
+    //! Set the time an island must rest before it falls asleep [s].
+    inline void setSleepDelay(const double a_delay) { m_sleepDelay = a_delay; }
+
+    //! Time an island must rest before it falls asleep [s].
+    inline double getSleepDelay() const { return (m_sleepDelay); }
+
+    //! Record a contact between particles \e a_i and \e a_j for the next \ref update().
+    inline void addContact(const unsigned int a_i, const unsigned int a_j)
+    {
+        m_contacts.push_back(a_i);
+        m_contacts.push_back(a_j);
+    }
+
+    //! Counter incremented whenever particles fall asleep or wake up.
+    inline unsigned int getVersion() const { return (m_version); }
+
+    //! Rebuild the islands after a step of \e a_dt seconds and put resting ones to sleep.
+    bool update(cParticleArrays& a_particles, const cSpringTable& a_springs, const double a_dt);
+
+    //! Wake every island.
+    void wakeAll();
+
+    //! Make the sleeping particles static until \ref thaw() is called.
+    void freeze(cParticleArrays& a_particles);
+
+    //! Restore the masses of the particles frozen by \ref freeze().
+    void thaw(cParticleArrays& a_particles);
+
+    //! Return true if particle \e a_index sleeps.
+    inline bool isSleeping(const unsigned int a_index) const
+    {
+        return ((a_index < m_sleeping.size()) && (m_sleeping[a_index] != 0));
+    }
+
+    //! Return true if there are dynamic particles and all of them sleep.
+    inline bool isAllSleeping() const { return ((m_numDynamic > 0) && (m_numSleeping == m_numDynamic)); }
+
+    //! Island of particle \e a_index after the last \ref update(), or \ref C_NO_ISLAND.
+    inline unsigned int getIsland(const unsigned int a_index) const { return (m_island[a_index]); }
+
+    //! Number of islands after the last \ref update().
+    inline unsigned int getNumIslands() const { return ((unsigned int)m_islands.size()); }
+
+    //! Number of sleeping islands after the last \ref update().
+    inline unsigned int getNumSleepingIslands() const { return (m_numSleepingIslands); }
+
+    //! Number of sleeping particles.
+    inline unsigned int getNumSleepingParticles() const { return (m_numSleeping); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // TYPES:
+    //-----------------------------------------------------------------------
+
+    //! State of an island during \ref update().
+    struct cIsland
+    {
+        double m_energy;
+        double m_restTime;
+        unsigned int m_numParticles;
+        bool m_sleeping;
+    };
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Root of the set of particle \e a_index, with path halving.
+    unsigned int findRoot(unsigned int a_index);
+
+    //! Merge the sets of two dynamic particles.
+    void join(const cParticleArrays& a_particles, const unsigned int a_i, const unsigned int a_j);
+
+    //! Rebuild \e m_springRoot from the springs alone.
+    void buildSpringRoots(const cParticleArrays& a_particles, const cSpringTable& a_springs);
+
+    //! Join the recorded contacts to the spring components and number the islands.
+    void buildIslands(const cParticleArrays& a_particles);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Sleeping is enabled.
+    bool m_enabled;
+
+    //! Sleep thresholds.
+    double m_sleepEnergy;
+    double m_sleepDelay;
+
+    //! Contacts recorded since the last update, as pairs of indices.
+    std::vector<unsigned int> m_contacts;
+
+    //! Union-find parents and island of every particle.
+    std::vector<unsigned int> m_parent;
+    std::vector<unsigned int> m_island;
+
+    //! Root of every particle over the springs alone, and the topology it was built for.
+    std::vector<unsigned int> m_springRoot;
+    unsigned int m_springVersion;
+    bool m_springRootValid;
+
+    //! The islands are up to date, and whether contacts took part in them.
+    bool m_islandsValid;
+    bool m_islandsHaveContacts;
+
+    //! Particles of every island: island k holds m_members[m_memberStart[k]] up to m_memberStart[k+1].
+    std::vector<unsigned int> m_memberStart;
+    std::vector<unsigned int> m_members;
+
+    //! Sleeping flag and rest time of every particle.
+    std::vector<unsigned char> m_sleeping;
+    std::vector<double> m_restTime;
+
+    //! Islands of the last update.
+    std::vector<cIsland> m_islands;
+
+    //! Particles frozen by \ref freeze() and their inverse masses.
+    std::vector<unsigned int> m_frozen;
+    std::vector<double> m_frozenInvMass;
+
+    //! Counts of the last update.
+    unsigned int m_numDynamic;
+    unsigned int m_numSleeping;
+    unsigned int m_numSleepingIslands;
+
+    //! See \ref getVersion().
+    unsigned int m_version;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,103 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleRandomH
+#define CParticleRandomH
+//---------------------------------------------------------------------------
+#include <stdint.h>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleRandom.h
+
+    \brief
+    <b> Particles </b> \n
+    Random number generator with a saveable state.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cParticleRandom
+    \ingroup    particles
+
+    \brief
+    cParticleRandom is a xorshift64* generator whose whole state is one
+    64-bit word. Unlike rand(), whose state is hidden in the C library
+    and shared by the whole process, the state can be read with
+    \ref getState() and written back with \ref setState(), so that a
+    checkpoint of a simulation also restores the random numbers drawn
+    after it. The sequence only depends on the seed, on every platform.
+*/
+//===========================================================================
+class cParticleRandom
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleRandom.
+    cParticleRandom(const uint64_t a_seed = 1) { setSeed(a_seed); }
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Restart the sequence from \e a_seed. Any seed is valid, including zero.
+    inline void setSeed(const uint64_t a_seed)
+    {
+        // one splitmix64 round spreads nearby seeds and avoids the zero state
+        uint64_t z = a_seed + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z = z ^ (z >> 31);
+        m_state = (z != 0) ? z : 0x9e3779b97f4a7c15ULL;
+    }
+
+    //! Current state, to be saved.
+    inline uint64_t getState() const { return (m_state); }
+
+    //! Continue the sequence from a state returned by \ref getState().
+    inline void setState(const uint64_t a_state) { if (a_state != 0) { m_state = a_state; } }
+
+    //! Next 64 random bits.
+    inline uint64_t next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return (m_state * 0x2545f4914f6cdd1dULL);
+    }
+
+    //! Uniform number in [0, 1).
+    inline double nextDouble() { return ((double)(next() >> 11) * (1.0 / 9007199254740992.0)); }
+
+    //! Uniform number in [a_min, a_max).
+    inline double nextDouble(const double a_min, const double a_max) { return (a_min + (a_max - a_min) * nextDouble()); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Generator state, never zero.
+    uint64_t m_state;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,287 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleRenderNode.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cParticleRenderNode.
+
+    \fn     cParticleRenderNode::cParticleRenderNode(cParticleSimulation* a_simulation)
+    \param  a_simulation  Simulation whose snapshots are drawn.
+*/
+//===========================================================================
+cParticleRenderNode::cParticleRenderNode(cParticleSimulation* a_simulation)
+{
+    m_simulation = a_simulation;
+    m_renderMode = C_PARTICLE_RENDER_AUTO;
+
+    m_showParticles = true;
+    m_showSprings = true;
+    m_springColor.set(1.0f, 1.0f, 1.0f, 1.0f);
+    m_pointColor.set(0.8f, 0.8f, 0.8f, 1.0f);
+    m_maxSpheres = 1000;
+    m_sphereResolution = 16;
+
+    m_numVertices = 0;
+    m_particleRadius = 0.0;
+    m_lineTopologyVersion = 0;
+    m_lineNumVertices = 0;
+    for (int k=0; k<3; k++)
+    {
+        m_min[k] = 0.0;
+        m_max[k] = 0.0;
+    }
+
+    m_sphereList = 0;
+    m_sphereListRadius = 0.0;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cParticleRenderNode.
+
+    \fn     cParticleRenderNode::~cParticleRenderNode()
+*/
+//===========================================================================
+cParticleRenderNode::~cParticleRenderNode()
+{
+    if (m_sphereList != 0)
+    {
+        glDeleteLists(m_sphereList, 1);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Take the newest simulation frame, if any, and draw springs and
+    particles from it. Without a new frame, the previous one is drawn
+    again.
+
+    \fn     void cParticleRenderNode::render(const int a_renderMode)
+    \param  a_renderMode  Rendering pass, see cGenericObject.
+*/
+//===========================================================================
+void cParticleRenderNode::render(const int a_renderMode)
+{
+    if (m_simulation->m_snapshots.update())
+    {
+        const cParticleSnapshot& frame = m_simulation->m_snapshots.getReadBuffer();
+        fillVertices(frame);
+        fillLineIndices(frame);
+    }
+    if (m_numVertices == 0) { return; }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, &m_vertices[0]);
+
+    // springs: one indexed draw over the shared vertex array
+    if (m_showSprings && !m_lineIndices.empty())
+    {
+        glDisable(GL_LIGHTING);
+        glColor4fv(m_springColor.pColor());
+        glDrawElements(GL_LINES, (GLsizei)m_lineIndices.size(),
+                       GL_UNSIGNED_INT, &m_lineIndices[0]);
+        glEnable(GL_LIGHTING);
+    }
+
+    if (m_showParticles)
+    {
+        bool spheres = (m_renderMode == C_PARTICLE_RENDER_SPHERES) ||
+                       ((m_renderMode == C_PARTICLE_RENDER_AUTO) &&
+                        (m_numVertices <= m_maxSpheres));
+        if (spheres)
+        {
+            renderSpheres();
+        }
+        else
+        {
+            renderPoints();
+        }
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+
+//===========================================================================
+/*!
+    Pack the positions of \e a_frame into the interleaved float array
+    used as vertex array, and compute the bounds of the frame from its
+    positions and particle radius.
+
+    \fn     void cParticleRenderNode::fillVertices(const cParticleSnapshot& a_frame)
+    \param  a_frame  Frame to draw.
+*/
+//===========================================================================
+void cParticleRenderNode::fillVertices(const cParticleSnapshot& a_frame)
+{
+    unsigned int n = (unsigned int)a_frame.m_posX.size();
+    m_vertices.resize(3 * n);
+    m_numVertices = n;
+    m_particleRadius = a_frame.m_particleRadius;
+    if (n == 0) { return; }
+
+    const double* px = &a_frame.m_posX[0];
+    const double* py = &a_frame.m_posY[0];
+    const double* pz = &a_frame.m_posZ[0];
+    float* v = &m_vertices[0];
+
+    double minX = px[0], minY = py[0], minZ = pz[0];
+    double maxX = px[0], maxY = py[0], maxZ = pz[0];
+    for (unsigned int i=0; i<n; i++)
+    {
+        v[3*i+0] = (float)px[i];
+        v[3*i+1] = (float)py[i];
+        v[3*i+2] = (float)pz[i];
+        minX = fmin(minX, px[i]);  maxX = fmax(maxX, px[i]);
+        minY = fmin(minY, py[i]);  maxY = fmax(maxY, py[i]);
+        minZ = fmin(minZ, pz[i]);  maxZ = fmax(maxZ, pz[i]);
+    }
+
+    double r = m_particleRadius;
+    m_min[0] = minX - r;  m_max[0] = maxX + r;
+    m_min[1] = minY - r;  m_max[1] = maxY + r;
+    m_min[2] = minZ - r;  m_max[2] = maxZ + r;
+}
+
+
+//===========================================================================
+/*!
+    Copy the spring endpoints of \e a_frame into the line index array.
+    The array is only rebuilt when the spring topology version of the
+    frame or the number of particles changes; springs referring to
+    particles outside the frame are skipped.
+
+    \fn     void cParticleRenderNode::fillLineIndices(const cParticleSnapshot& a_frame)
+    \param  a_frame  Frame to draw.
+*/
+//===========================================================================
+void cParticleRenderNode::fillLineIndices(const cParticleSnapshot& a_frame)
+{
+    if ((a_frame.m_topologyVersion == m_lineTopologyVersion) &&
+        (m_numVertices == m_lineNumVertices)) { return; }
+
+    unsigned int numSprings = (unsigned int)a_frame.m_springA.size();
+    m_lineTopologyVersion = a_frame.m_topologyVersion;
+    m_lineNumVertices = m_numVertices;
+    m_lineIndices.clear();
+    m_lineIndices.reserve(2 * numSprings);
+    for (unsigned int k=0; k<numSprings; k++)
+    {
+        if ((a_frame.m_springA[k] >= m_numVertices) ||
+            (a_frame.m_springB[k] >= m_numVertices)) { continue; }
+        m_lineIndices.push_back(a_frame.m_springA[k]);
+        m_lineIndices.push_back(a_frame.m_springB[k]);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Draw every particle as a round point in one call. The point size is
+    the particle diameter projected at the depth of the center of the
+    cloud, so particles much nearer or farther than the center appear
+    slightly too small or too large.
+
+    \fn     void cParticleRenderNode::renderPoints()
+*/
+//===========================================================================
+void cParticleRenderNode::renderPoints()
+{
+    GLint viewport[4];
+    GLdouble projection[16];
+    GLdouble modelview[16];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetDoublev(GL_PROJECTION_MATRIX, projection);
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+
+    // eye space depth of the center of the cloud
+    double cx = 0.5 * (m_min[0] + m_max[0]);
+    double cy = 0.5 * (m_min[1] + m_max[1]);
+    double cz = 0.5 * (m_min[2] + m_max[2]);
+    double depth = -(modelview[2]*cx + modelview[6]*cy + modelview[10]*cz + modelview[14]);
+
+    // pixels per unit length at that depth (perspective projection)
+    double pixelsPerUnit = 0.5 * viewport[3] * projection[5] / fmax(depth, 1e-6);
+    double size = 2.0 * m_particleRadius * pixelsPerUnit;
+    size = fmin(fmax(size, 1.0), 64.0);
+
+    glDisable(GL_LIGHTING);
+    glEnable(GL_POINT_SMOOTH);
+    glPointSize((GLfloat)size);
+    glColor4fv(m_pointColor.pColor());
+
+    glDrawArrays(GL_POINTS, 0, (GLsizei)m_numVertices);
+
+    glPointSize(1.0f);
+    glDisable(GL_POINT_SMOOTH);
+    glEnable(GL_LIGHTING);
+}
+
+
+//===========================================================================
+/*!
+    Draw every particle as a lit sphere. The sphere is compiled once
+    into a display list, rebuilt only if the particle radius changes.
+
+    \fn     void cParticleRenderNode::renderSpheres()
+*/
+//===========================================================================
+void cParticleRenderNode::renderSpheres()
+{
+    double radius = m_particleRadius;
+    if ((m_sphereList == 0) || (m_sphereListRadius != radius))
+    {
+        if (m_sphereList == 0) { m_sphereList = glGenLists(1); }
+
+        GLUquadricObj* quadric = gluNewQuadric();
+        glNewList(m_sphereList, GL_COMPILE);
+        gluSphere(quadric, radius, m_sphereResolution, m_sphereResolution);
+        glEndList();
+        gluDeleteQuadric(quadric);
+
+        m_sphereListRadius = radius;
+    }
+
+    if (m_useMaterialProperty)
+    {
+        m_material.render();
+    }
+
+    const float* v = &m_vertices[0];
+    for (unsigned int i=0; i<m_numVertices; i++)
+    {
+        glPushMatrix();
+        glTranslatef(v[3*i+0], v[3*i+1], v[3*i+2]);
+        glCallList(m_sphereList);
+        glPopMatrix();
+    }
+}
+
+
+//===========================================================================
+/*!
+    Set the bounding box of the node to the bounds of the last frame.
+
+    \fn     void cParticleRenderNode::updateBoundaryBox()
+*/
+//===========================================================================
+void cParticleRenderNode::updateBoundaryBox()
+{
+    m_boundaryBoxMin.set(m_min[0], m_min[1], m_min[2]);
+    m_boundaryBoxMax.set(m_max[0], m_max[1], m_max[2]);
+}
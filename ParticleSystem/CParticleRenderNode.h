@@ -0,0 +1,174 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleRenderNodeH
+#define CParticleRenderNodeH
+//---------------------------------------------------------------------------
+#include "chai3d.h"
+#include "CParticleSimulation.h"
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleRenderNode.h
+
+    \brief
+    <b> Particles </b> \n
+    Scene graph node drawing a whole particle system.
+*/
+//===========================================================================
+
+//! How \ref cParticleRenderNode draws the particles.
+enum cParticleRenderMode
+{
+    C_PARTICLE_RENDER_AUTO,     //!< spheres up to \e m_maxSpheres particles, points above
+    C_PARTICLE_RENDER_SPHERES,  //!< one lit sphere per particle, from a shared display list
+    C_PARTICLE_RENDER_POINTS    //!< one round point per particle, a single draw call
+};
+
+//===========================================================================
+/*!
+    \class      cParticleRenderNode
+    \ingroup    particles
+
+    \brief
+    cParticleRenderNode replaces one cShapeSphere per particle and one
+    cShapeLine per spring by a single node. On every render it takes the
+    newest frame from the simulation's snapshot buffer, packs the
+    positions once into an interleaved vertex array, and draws all
+    springs with one glDrawElements(GL_LINES) call over that array.
+
+    Particles are drawn either as round points sized to the particle
+    radius at the depth of the cloud (one glDrawArrays call, suited to
+    hundreds of thousands of particles), or as lit spheres sharing one
+    display list (closer to the look of cShapeSphere, for small systems).
+
+    The node is the only reader of the simulation's snapshot buffer and
+    must be rendered from a single thread. Everything drawn, including
+    the spring endpoints and the particle radius, comes from the
+    snapshot; the live simulation is never read while it runs.
+*/
+//===========================================================================
+class cParticleRenderNode : public cGenericObject
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleRenderNode.
+    cParticleRenderNode(cParticleSimulation* a_simulation);
+
+    //! Destructor of cParticleRenderNode.
+    virtual ~cParticleRenderNode();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Render the particles and springs in OpenGL.
+    virtual void render(const int a_renderMode=0);
+
+    //! Select how particles are drawn.
+    inline void setRenderMode(const cParticleRenderMode a_mode) { m_renderMode = a_mode; }
+
+    //! Current particle drawing mode.
+    inline cParticleRenderMode getRenderMode() const { return (m_renderMode); }
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Draw the particles.
+    bool m_showParticles;
+
+    //! Draw the springs.
+    bool m_showSprings;
+
+    //! Color of the springs.
+    cColorf m_springColor;
+
+    //! Color of the particles in point mode (sphere mode uses \e m_material).
+    cColorf m_pointColor;
+
+    //! Largest particle count drawn as spheres in \ref C_PARTICLE_RENDER_AUTO mode.
+    unsigned int m_maxSpheres;
+
+    //! Slices and stacks of the sphere display list.
+    int m_sphereResolution;
+
+
+  protected:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Update the bounding box from the last frame drawn.
+    virtual void updateBoundaryBox();
+
+    //! Copy the frame into the vertex array and update the bounds.
+    void fillVertices(const cParticleSnapshot& a_frame);
+
+    //! Rebuild the line index array if the spring topology or particle count changed.
+    void fillLineIndices(const cParticleSnapshot& a_frame);
+
+    //! Draw every particle as a point of the particle diameter.
+    void renderPoints();
+
+    //! Draw every particle as a lit sphere.
+    void renderSpheres();
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Simulation drawn by the node.
+    cParticleSimulation* m_simulation;
+
+    //! Drawing mode.
+    cParticleRenderMode m_renderMode;
+
+    //! Interleaved xyz positions of the last frame.
+    std::vector<float> m_vertices;
+
+    //! Particle pairs of every spring.
+    std::vector<unsigned int> m_lineIndices;
+
+    //! Spring topology version and particle count \e m_lineIndices was built for.
+    unsigned int m_lineTopologyVersion;
+    unsigned int m_lineNumVertices;
+
+    //! Number of particles in \e m_vertices.
+    unsigned int m_numVertices;
+
+    //! Particle radius of the last frame.
+    double m_particleRadius;
+
+    //! Bounds of the last frame.
+    double m_min[3];
+    double m_max[3];
+
+    //! Display list of one particle sphere (0 until created).
+    GLuint m_sphereList;
+
+    //! Radius the display list was built with.
+    double m_sphereListRadius;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,720 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CParticleSimulation.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// pair visitor that resolves one particle-particle contact
+struct cParticlePairResponse
+{
+    cParticleArrays* m_particles;
+    double m_diameter;
+    double m_restitution;
+    unsigned int m_numContacts;
+    cParticleIslands* m_islands;
+
+    void operator()(const unsigned int i, const unsigned int j,
+                    const double dx, const double dy, const double dz,
+                    const double d2)
+    {
+        double wi = m_particles->m_invMass[i];
+        double wj = m_particles->m_invMass[j];
+
+        // sleeping particles are static here, but a contact with an awake one joins their islands
+        if ((m_islands != NULL) && ((wi > 0.0) || (wj > 0.0)) &&
+            !m_particles->isStatic(i) && !m_particles->isStatic(j))
+        {
+            m_islands->addContact(i, j);
+        }
+
+        double wsum = wi + wj;
+        if ((wsum <= 0.0) || (d2 < 1e-24)) { return; }
+
+        double distance = sqrt(d2);
+        double nx = dx / distance;
+        double ny = dy / distance;
+        double nz = dz / distance;
+
+        // split the overlap in proportion to the inverse masses
+        double depth = (m_diameter - distance) / wsum;
+        m_particles->m_posX[i] -= nx * depth * wi;
+        m_particles->m_posY[i] -= ny * depth * wi;
+        m_particles->m_posZ[i] -= nz * depth * wi;
+        m_particles->m_posX[j] += nx * depth * wj;
+        m_particles->m_posY[j] += ny * depth * wj;
+        m_particles->m_posZ[j] += nz * depth * wj;
+
+        // normal impulse if the particles are approaching
+        double vn = (m_particles->m_velX[j] - m_particles->m_velX[i]) * nx +
+                    (m_particles->m_velY[j] - m_particles->m_velY[i]) * ny +
+                    (m_particles->m_velZ[j] - m_particles->m_velZ[i]) * nz;
+        if (vn < 0.0)
+        {
+            double impulse = -(1.0 + m_restitution) * vn / wsum;
+            m_particles->m_velX[i] -= nx * impulse * wi;
+            m_particles->m_velY[i] -= ny * impulse * wi;
+            m_particles->m_velZ[i] -= nz * impulse * wi;
+            m_particles->m_velX[j] += nx * impulse * wj;
+            m_particles->m_velY[j] += ny * impulse * wj;
+            m_particles->m_velZ[j] += nz * impulse * wj;
+        }
+
+        m_numContacts++;
+    }
+};
+
+// pair visitor that records pairs for later response
+template <class T> struct cParticlePairCollector
+{
+    std::vector<T>* m_pairs;
+
+    void operator()(const unsigned int i, const unsigned int j,
+                    const double dx, const double dy, const double dz,
+                    const double d2)
+    {
+        T pair;
+        pair.m_i = i;
+        pair.m_j = j;
+        pair.m_dx = dx;
+        pair.m_dy = dy;
+        pair.m_dz = dz;
+        pair.m_d2 = d2;
+        m_pairs->push_back(pair);
+    }
+};
+
+
+//===========================================================================
+/*!
+    Constructor of cParticleSimulation.
+
+    \fn     cParticleSimulation::cParticleSimulation()
+*/
+//===========================================================================
+cParticleSimulation::cParticleSimulation()
+{
+    m_externalForce[0] = 0.0;
+    m_externalForce[1] = 0.0;
+    m_externalForce[2] = 0.0;
+    m_dragCoefficient = 0.0;
+    m_particleRadius = 0.05;
+    m_collideParticles = false;
+    m_particleRestitution = 0.5;
+    m_numContacts = 0;
+    m_numParticleContacts = 0;
+    m_pool = NULL;
+    m_profiler = NULL;
+    m_time = 0.0;
+    m_numSteps = 0;
+    for (unsigned int k=0; k<6; k++)
+    {
+        m_sleepParameters[k] = 0.0;
+    }
+    m_activeSprings = &m_springs;
+    m_awakeIslandVersion = 0;
+    m_awakeTopologyVersion = 0;
+    m_awakeNumParticles = 0;
+    m_awakeValid = false;
+    m_steppedAwake = false;
+
+    m_integrator = cCreateParticleIntegrator(C_DEFAULT_PARTICLE_INTEGRATOR);
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cParticleSimulation.
+
+    \fn     cParticleSimulation::~cParticleSimulation()
+*/
+//===========================================================================
+cParticleSimulation::~cParticleSimulation()
+{
+    delete m_integrator;
+}
+
+
+//===========================================================================
+/*!
+    Select the integration scheme. Scratch buffers of the previous
+    integrator are released, and the previous integrator is deleted, so
+    call it from the thread that runs \ref step(), between two steps.
+
+    \fn     void cParticleSimulation::setIntegrator(const cParticleIntegratorType a_type)
+    \param  a_type  Integration scheme.
+*/
+//===========================================================================
+void cParticleSimulation::setIntegrator(const cParticleIntegratorType a_type)
+{
+    if (m_integrator->getType() == a_type) { return; }
+
+    delete m_integrator;
+    m_integrator = cCreateParticleIntegrator(a_type);
+    m_integrator->setTaskPool(m_pool);
+}
+
+
+//===========================================================================
+/*!
+    Run force accumulation, integration, contact response and the broad
+    phase on a thread pool. The pool is not owned and must outlive the
+    simulation or be replaced first. Springs should be colored with
+    \ref cSpringTable::colorSprings() for their forces to be accumulated,
+    or their XPBD constraints projected, in parallel.
+
+    \fn     void cParticleSimulation::setTaskPool(cTaskPool* a_pool)
+    \param  a_pool  Thread pool, or NULL to run on the calling thread.
+*/
+//===========================================================================
+void cParticleSimulation::setTaskPool(cTaskPool* a_pool)
+{
+    m_pool = a_pool;
+    m_integrator->setTaskPool(a_pool);
+}
+
+
+//===========================================================================
+/*!
+    Advance the simulation by \e a_dt seconds, then resolve contacts.
+    Contact response changes positions and velocities behind the back of
+    the integrator, so its cached state is dropped when it happens.
+
+    With sleeping enabled, the step only advances the clock while every
+    island sleeps. While only some sleep, the awake particles are copied
+    into compact arrays, integrated and tested against the contact
+    shapes there, and copied back; sleeping particles are frozen during
+    particle-particle collisions, and islands are updated at the end of
+    the step. An awake particle that touches a sleeping one bounces off
+    it as off a static particle, and the island it touched moves from
+    the next step on. The integrator is reset whenever the set of
+    particles it advances changes.
+
+    With a profiler set, integration (forces included) and contact
+    resolution are charged to the forces and collision phases.
+
+    \fn     void cParticleSimulation::step(const double a_dt)
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cParticleSimulation::step(const double a_dt)
+{
+    if (a_dt <= 0.0) { return; }
+
+    bool sleeping = m_islands.isEnabled();
+    if (sleeping)
+    {
+        if (haveSleepParametersChanged()) { wakeUp(); }
+
+        if (m_islands.isAllSleeping())
+        {
+            m_numContacts = 0;
+            m_numParticleContacts = 0;
+            m_time += a_dt;
+            m_numSteps++;
+            return;
+        }
+    }
+
+    if (m_profiler != NULL) { m_profiler->skipPhase(); }
+
+    // step only the awake particles while some sleep
+    bool awake = sleeping && (m_islands.getNumSleepingParticles() > 0);
+    if (awake)
+    {
+        if (!m_awakeValid ||
+            (m_awakeIslandVersion != m_islands.getVersion()) ||
+            (m_awakeTopologyVersion != m_springs.getTopologyVersion()) ||
+            (m_awakeNumParticles != m_particles.getNumParticles()))
+        {
+            buildAwakeSet();
+            m_integrator->reset();
+        }
+        gatherAwake();
+    }
+    if (awake != m_steppedAwake)
+    {
+        m_integrator->reset();
+        m_steppedAwake = awake;
+    }
+
+    cParticleArrays& particles = awake ? m_awakeParticles : m_particles;
+    m_activeSprings = awake ? &m_awakeSprings : &m_springs;
+    m_integrator->integrate(*this, particles, a_dt);
+    m_activeSprings = &m_springs;
+
+    if (m_profiler != NULL) { m_profiler->endPhase(C_LOOP_PHASE_FORCES); }
+
+    m_numContacts = m_contacts.resolve(particles, m_particleRadius, m_pool);
+    if (awake) { scatterAwake(); }
+
+    m_numParticleContacts = 0;
+    if (m_collideParticles)
+    {
+        if (awake) { m_islands.freeze(m_particles); }
+        m_numParticleContacts = resolveParticleCollisions();
+        if (awake) { m_islands.thaw(m_particles); }
+    }
+
+    // islands falling asleep lose their velocities
+    bool islandsChanged = false;
+    if (sleeping)
+    {
+        islandsChanged = m_islands.update(m_particles, m_springs, a_dt);
+    }
+
+    if (m_profiler != NULL) { m_profiler->endPhase(C_LOOP_PHASE_COLLISION); }
+    if ((m_numContacts > 0) || (m_numParticleContacts > 0) || islandsChanged)
+    {
+        m_integrator->reset();
+    }
+
+    m_time += a_dt;
+    m_numSteps++;
+}
+
+
+//===========================================================================
+/*!
+    Copy the particle positions, the particle radius and the spring
+    endpoints into the write buffer of \e m_snapshots and publish it.
+    Must always be called from the thread that steps the simulation;
+    readers take the frame with \e m_snapshots.update(). No memory is
+    allocated once the buffers have grown to the number of particles
+    and springs.
+
+    \fn     void cParticleSimulation::publishSnapshot()
+*/
+//===========================================================================
+void cParticleSimulation::publishSnapshot()
+{
+    cParticleSnapshot& frame = m_snapshots.getWriteBuffer();
+    unsigned int n = m_particles.getNumParticles();
+
+    frame.m_posX.assign(m_particles.m_posX, m_particles.m_posX + n);
+    frame.m_posY.assign(m_particles.m_posY, m_particles.m_posY + n);
+    frame.m_posZ.assign(m_particles.m_posZ, m_particles.m_posZ + n);
+    frame.m_time = m_time;
+    frame.m_step = m_numSteps;
+    fillSnapshotTopology(frame);
+
+    m_snapshots.publish();
+}
+
+
+//===========================================================================
+/*!
+    Publish positions interpolated between \e a_previous, taken with
+    \ref getSnapshot() before the last step, and the current ones, for
+    readers running faster than the physics. The time of the frame is
+    interpolated the same way. If \e a_previous does not hold every
+    particle, the current positions are published.
+
+    \fn     void cParticleSimulation::publishSnapshot(const cParticleSnapshot& a_previous,
+            const double a_alpha)
+    \param  a_previous  Positions before the last step.
+    \param  a_alpha  Interpolation factor in [0,1].
+*/
+//===========================================================================
+void cParticleSimulation::publishSnapshot(const cParticleSnapshot& a_previous, const double a_alpha)
+{
+    unsigned int n = m_particles.getNumParticles();
+    if ((a_previous.m_posX.size() != n) || (a_previous.m_posY.size() != n) ||
+        (a_previous.m_posZ.size() != n))
+    {
+        publishSnapshot();
+        return;
+    }
+
+    cParticleSnapshot& frame = m_snapshots.getWriteBuffer();
+    frame.m_posX.resize(n);
+    frame.m_posY.resize(n);
+    frame.m_posZ.resize(n);
+
+    double beta = 1.0 - a_alpha;
+    for (unsigned int i=0; i<n; i++)
+    {
+        frame.m_posX[i] = beta * a_previous.m_posX[i] + a_alpha * m_particles.m_posX[i];
+        frame.m_posY[i] = beta * a_previous.m_posY[i] + a_alpha * m_particles.m_posY[i];
+        frame.m_posZ[i] = beta * a_previous.m_posZ[i] + a_alpha * m_particles.m_posZ[i];
+    }
+    frame.m_time = beta * a_previous.m_time + a_alpha * m_time;
+    frame.m_step = m_numSteps;
+    fillSnapshotTopology(frame);
+
+    m_snapshots.publish();
+}
+
+
+//===========================================================================
+/*!
+    Copy the particle radius into \e a_frame, and the spring endpoints
+    if the topology of \e m_springs changed since they were last copied
+    into this frame, so that readers never touch the live spring table.
+    Called by \ref publishSnapshot(); frames filled by other means, such
+    as a trajectory replay, must be completed with it before publishing.
+
+    \fn     void cParticleSimulation::fillSnapshotTopology(cParticleSnapshot& a_frame) const
+    \param  a_frame  Frame to fill.
+*/
+//===========================================================================
+void cParticleSimulation::fillSnapshotTopology(cParticleSnapshot& a_frame) const
+{
+    a_frame.m_particleRadius = m_particleRadius;
+
+    unsigned int version = m_springs.getTopologyVersion();
+    if ((a_frame.m_topologyVersion == version) &&
+        (a_frame.m_springA.size() == m_springs.getNumSprings()))
+    {
+        return;
+    }
+
+    unsigned int numSprings = m_springs.getNumSprings();
+    a_frame.m_springA.assign(m_springs.m_indexA, m_springs.m_indexA + numSprings);
+    a_frame.m_springB.assign(m_springs.m_indexB, m_springs.m_indexB + numSprings);
+    a_frame.m_topologyVersion = version;
+}
+
+
+//===========================================================================
+/*!
+    Copy the current positions, time and step count into \e a_frame.
+    No memory is allocated once \e a_frame has grown to the number of
+    particles.
+
+    \fn     void cParticleSimulation::getSnapshot(cParticleSnapshot& a_frame) const
+    \param  a_frame  Frame to fill.
+*/
+//===========================================================================
+void cParticleSimulation::getSnapshot(cParticleSnapshot& a_frame) const
+{
+    unsigned int n = m_particles.getNumParticles();
+
+    a_frame.m_posX.assign(m_particles.m_posX, m_particles.m_posX + n);
+    a_frame.m_posY.assign(m_particles.m_posY, m_particles.m_posY + n);
+    a_frame.m_posZ.assign(m_particles.m_posZ, m_particles.m_posZ + n);
+    a_frame.m_time = m_time;
+    a_frame.m_step = m_numSteps;
+}
+
+
+//===========================================================================
+/*!
+    Notify the integrator that positions or velocities were changed from
+    outside (restart, collision response, user interaction), so that it
+    does not reuse forces computed for the previous state. Moved
+    particles may no longer be at rest, so every island is woken.
+
+    \fn     void cParticleSimulation::resetIntegrator()
+*/
+//===========================================================================
+void cParticleSimulation::resetIntegrator()
+{
+    m_integrator->reset();
+    m_islands.wakeAll();
+}
+
+
+//===========================================================================
+/*!
+    Wake every island. Changes of the external force, drag, particle
+    radius or particle restitution are detected by \ref step(); changes
+    of masses, springs or contact shapes are not, and must be followed
+    by a call to this method for sleeping particles to feel them.
+
+    \fn     void cParticleSimulation::wakeUp()
+*/
+//===========================================================================
+void cParticleSimulation::wakeUp()
+{
+    m_islands.wakeAll();
+    m_integrator->reset();
+}
+
+
+//===========================================================================
+/*!
+    Overwrite the force accumulators of \e a_particles with the external
+    force, the drag and the spring forces.
+
+    \fn     void cParticleSimulation::computeForces(cParticleArrays& a_particles)
+    \param  a_particles  Particles to evaluate.
+*/
+//===========================================================================
+void cParticleSimulation::computeForces(cParticleArrays& a_particles)
+{
+    computeExternalForces(a_particles);
+    m_activeSprings->accumulateForces(a_particles, C_SPRING_KERNEL_AUTO, m_pool);
+}
+
+
+//===========================================================================
+/*!
+    Overwrite the force accumulators of \e a_particles with the external
+    force and the drag, leaving out the springs, which position based
+    integrators handle as constraints.
+
+    \fn     void cParticleSimulation::computeExternalForces(cParticleArrays& a_particles)
+    \param  a_particles  Particles to evaluate.
+*/
+//===========================================================================
+void cParticleSimulation::computeExternalForces(cParticleArrays& a_particles)
+{
+    const double* vx = a_particles.m_velX;
+    const double* vy = a_particles.m_velY;
+    const double* vz = a_particles.m_velZ;
+    const double* w = a_particles.m_invMass;
+    double* fx = a_particles.m_forceX;
+    double* fy = a_particles.m_forceY;
+    double* fz = a_particles.m_forceZ;
+    unsigned int n = a_particles.getNumParticles();
+
+    double ex = m_externalForce[0];
+    double ey = m_externalForce[1];
+    double ez = m_externalForce[2];
+    double drag = m_dragCoefficient;
+
+    cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int i=a_begin; i<a_end; i++)
+        {
+            // drag force = -rate * mass * velocity; static particles get none
+            double c = (w[i] > 0.0) ? (drag / w[i]) : 0.0;
+            fx[i] = ex - c * vx[i];
+            fy[i] = ey - c * vy[i];
+            fz[i] = ez - c * vz[i];
+        }
+    });
+}
+
+
+//===========================================================================
+/*!
+    Rebuild the spatial hash with cells one particle diameter wide and
+    resolve every overlapping pair: the overlap is removed in proportion
+    to the inverse masses, and approaching pairs exchange a normal
+    impulse scaled by \e m_particleRestitution.
+
+    With a task pool, the pair search runs in parallel chunks that only
+    record the pairs; the response is then applied on the calling thread
+    in the same order as a serial search, so results do not depend on
+    the number of threads.
+
+    \fn     unsigned int cParticleSimulation::resolveParticleCollisions()
+    \return Return the number of overlapping pairs.
+*/
+//===========================================================================
+unsigned int cParticleSimulation::resolveParticleCollisions()
+{
+    double diameter = 2.0 * m_particleRadius;
+    if (m_hash.getCellSize() != diameter)
+    {
+        m_hash.setCellSize(diameter);
+    }
+    m_hash.build(m_particles);
+
+    cParticlePairResponse response;
+    response.m_particles = &m_particles;
+    response.m_diameter = diameter;
+    response.m_restitution = m_particleRestitution;
+    response.m_numContacts = 0;
+    response.m_islands = m_islands.isEnabled() ? &m_islands : NULL;
+
+    if ((m_pool == NULL) || (m_pool->getNumThreads() <= 1))
+    {
+        m_hash.forEachPair(m_particles, diameter, response);
+        return (response.m_numContacts);
+    }
+
+    unsigned int numEntries = m_hash.getNumEntries();
+    unsigned int numChunks = cTaskPool::getNumChunks(0, numEntries, C_TASK_GRAIN);
+    if (m_pairChunks.size() < numChunks) { m_pairChunks.resize(numChunks); }
+
+    m_pool->parallelFor(0, numEntries, C_TASK_GRAIN,
+        [&](unsigned int a_begin, unsigned int a_end)
+        {
+            cParticlePairCollector<cParticlePair> collector;
+            collector.m_pairs = &m_pairChunks[a_begin / C_TASK_GRAIN];
+            collector.m_pairs->clear();
+            m_hash.forEachPair(m_particles, diameter, collector, a_begin, a_end);
+        });
+
+    for (unsigned int k=0; k<numChunks; k++)
+    {
+        const std::vector<cParticlePair>& pairs = m_pairChunks[k];
+        for (unsigned int p=0; p<pairs.size(); p++)
+        {
+            response(pairs[p].m_i, pairs[p].m_j, pairs[p].m_dx,
+                     pairs[p].m_dy, pairs[p].m_dz, pairs[p].m_d2);
+        }
+    }
+
+    return (response.m_numContacts);
+}
+
+
+//===========================================================================
+/*!
+    Compare the external force, drag, particle radius and particle
+    restitution with the values seen by the previous call, and remember
+    the current ones.
+
+    \fn     bool cParticleSimulation::haveSleepParametersChanged()
+    \return Return true if one of them changed.
+*/
+//===========================================================================
+bool cParticleSimulation::haveSleepParametersChanged()
+{
+    double parameters[6] = { m_externalForce[0], m_externalForce[1], m_externalForce[2],
+                             m_dragCoefficient, m_particleRadius, m_particleRestitution };
+
+    bool changed = false;
+    for (unsigned int k=0; k<6; k++)
+    {
+        changed = changed || (parameters[k] != m_sleepParameters[k]);
+        m_sleepParameters[k] = parameters[k];
+    }
+
+    return (changed);
+}
+
+
+//===========================================================================
+/*!
+    Gather the awake dynamic particles, the static particles held by
+    their springs, and the springs between them, into
+    \e m_awakeParticles and \e m_awakeSprings. Particles keep their
+    order, so springs sorted by \ref cSpringTable::sortForLocality() stay
+    sorted; they are colored again if \e m_springs is colored. Springs
+    between an awake and a sleeping particle cannot exist, since both
+    would belong to the same island.
+
+    \fn     void cParticleSimulation::buildAwakeSet()
+*/
+//===========================================================================
+void cParticleSimulation::buildAwakeSet()
+{
+    unsigned int n = m_particles.getNumParticles();
+    const double* w = m_particles.m_invMass;
+
+    // 1 + index in the compact arrays, 0 for particles left out
+    std::vector<unsigned int> compact(n, 0);
+    for (unsigned int i=0; i<n; i++)
+    {
+        if ((w[i] > 0.0) && !m_islands.isSleeping(i)) { compact[i] = 1; }
+    }
+
+    unsigned int numSprings = m_springs.getNumSprings();
+    for (unsigned int k=0; k<numSprings; k++)
+    {
+        unsigned int a = m_springs.m_indexA[k];
+        unsigned int b = m_springs.m_indexB[k];
+        if ((compact[a] == 0) && (compact[b] == 0)) { continue; }
+        if (w[a] <= 0.0) { compact[a] = 1; }
+        if (w[b] <= 0.0) { compact[b] = 1; }
+    }
+
+    m_awakeIndex.clear();
+    for (unsigned int i=0; i<n; i++)
+    {
+        if (compact[i] == 0) { continue; }
+        m_awakeIndex.push_back(i);
+        compact[i] = (unsigned int)m_awakeIndex.size();
+    }
+
+    // particles, with the inverse masses copied exactly
+    unsigned int numAwake = (unsigned int)m_awakeIndex.size();
+    m_awakeParticles.clear();
+    m_awakeParticles.reserve(numAwake);
+    for (unsigned int k=0; k<numAwake; k++)
+    {
+        unsigned int i = m_awakeIndex[k];
+        double mass = (w[i] > 0.0) ? (1.0 / w[i]) : 0.0;
+        m_awakeParticles.addParticle(m_particles.m_posX[i], m_particles.m_posY[i],
+                                     m_particles.m_posZ[i], mass);
+        m_awakeParticles.m_invMass[k] = w[i];
+    }
+
+    m_awakeSprings.clear();
+    for (unsigned int k=0; k<numSprings; k++)
+    {
+        unsigned int a = compact[m_springs.m_indexA[k]];
+        unsigned int b = compact[m_springs.m_indexB[k]];
+        if ((a == 0) || (b == 0)) { continue; }
+        m_awakeSprings.addSpring(a - 1, b - 1, m_springs.m_restLength[k],
+                                 m_springs.m_stiffness[k], m_springs.m_damping[k]);
+    }
+    if (m_springs.getNumColors() > 0)
+    {
+        m_awakeSprings.colorSprings();
+    }
+
+    m_awakeIslandVersion = m_islands.getVersion();
+    m_awakeTopologyVersion = m_springs.getTopologyVersion();
+    m_awakeNumParticles = n;
+    m_awakeValid = true;
+}
+
+
+//===========================================================================
+/*!
+    Copy the positions and velocities of the awake particles, and of the
+    static particles their springs hold, into \e m_awakeParticles.
+
+    \fn     void cParticleSimulation::gatherAwake()
+*/
+//===========================================================================
+void cParticleSimulation::gatherAwake()
+{
+    unsigned int numAwake = (unsigned int)m_awakeIndex.size();
+    for (unsigned int k=0; k<numAwake; k++)
+    {
+        unsigned int i = m_awakeIndex[k];
+        m_awakeParticles.m_posX[k] = m_particles.m_posX[i];
+        m_awakeParticles.m_posY[k] = m_particles.m_posY[i];
+        m_awakeParticles.m_posZ[k] = m_particles.m_posZ[i];
+        m_awakeParticles.m_velX[k] = m_particles.m_velX[i];
+        m_awakeParticles.m_velY[k] = m_particles.m_velY[i];
+        m_awakeParticles.m_velZ[k] = m_particles.m_velZ[i];
+    }
+}
+
+
+//===========================================================================
+/*!
+    Copy the positions, velocities and forces of \e m_awakeParticles
+    back into \e m_particles.
+
+    \fn     void cParticleSimulation::scatterAwake()
+*/
+//===========================================================================
+void cParticleSimulation::scatterAwake()
+{
+    unsigned int numAwake = (unsigned int)m_awakeIndex.size();
+    for (unsigned int k=0; k<numAwake; k++)
+    {
+        unsigned int i = m_awakeIndex[k];
+        m_particles.m_posX[i] = m_awakeParticles.m_posX[k];
+        m_particles.m_posY[i] = m_awakeParticles.m_posY[k];
+        m_particles.m_posZ[i] = m_awakeParticles.m_posZ[k];
+        m_particles.m_velX[i] = m_awakeParticles.m_velX[k];
+        m_particles.m_velY[i] = m_awakeParticles.m_velY[k];
+        m_particles.m_velZ[i] = m_awakeParticles.m_velZ[k];
+        m_particles.m_forceX[i] = m_awakeParticles.m_forceX[k];
+        m_particles.m_forceY[i] = m_awakeParticles.m_forceY[k];
+        m_particles.m_forceZ[i] = m_awakeParticles.m_forceZ[k];
+    }
+}
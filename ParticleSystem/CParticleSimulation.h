@@ -0,0 +1,339 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CParticleSimulationH
+#define CParticleSimulationH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+#include "CSpringTable.h"
+#include "CParticleIntegrators.h"
+#include "CParticleContacts.h"
+#include "CSpatialHash.h"
+#include "CTaskPool.h"
+#include "CTripleBuffer.h"
+#include "CLoopProfiler.h"
+#include "CParticleRandom.h"
+#include "CParticleIslands.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CParticleSimulation.h
+
+    \brief
+    <b> Particles </b> \n
+    Mass-spring particle system.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \struct     cParticleSnapshot
+    \ingroup    particles
+
+    \brief
+    Copy of the particle positions at the end of a step, handed from the
+    simulation thread to the graphics thread, together with everything
+    else needed to draw the frame. The spring endpoints are only copied
+    when \e m_topologyVersion differs from the one of the spring table.
+*/
+//===========================================================================
+struct cParticleSnapshot
+{
+    //! Positions of every particle.
+    std::vector<double> m_posX;
+    std::vector<double> m_posY;
+    std::vector<double> m_posZ;
+
+    //! Simulated time of the frame [s].
+    double m_time;
+
+    //! Number of steps taken before the frame.
+    unsigned int m_step;
+
+    //! Radius of the particles.
+    double m_particleRadius;
+
+    //! Endpoints of every spring.
+    std::vector<unsigned int> m_springA;
+    std::vector<unsigned int> m_springB;
+
+    //! Topology version of the spring table \e m_springA and \e m_springB were copied from.
+    unsigned int m_topologyVersion;
+
+    //! Constructor of cParticleSnapshot.
+    cParticleSnapshot() : m_time(0.0), m_step(0), m_particleRadius(0.0), m_topologyVersion(0) {}
+};
+
+
+//===========================================================================
+/*!
+    \class      cParticleSimulation
+    \ingroup    particles
+
+    \brief
+    cParticleSimulation owns the particles and springs of a scene and
+    advances them with a selectable integrator. The force model is the
+    sum of a constant external force, the springs and a linear drag
+    proportional to each particle's mass and velocity. After every step,
+    contacts with the static primitives of \e m_contacts are resolved,
+    and optionally contacts between particles, found through a spatial
+    hash rebuilt every step.
+
+    With a task pool, force accumulation, integration, contact response
+    and the broad phase run as chunked parallel loops. Chunks do not
+    depend on the number of threads, so any multithreaded run gives the
+    same results; a single-threaded run may differ in the last bits,
+    because chunk boundaries change which springs the SIMD kernels
+    evaluate in their scalar tail.
+
+    The class has no dependency on the scene graph or on OpenGL, so the
+    same physics runs in the interactive demo and in headless tools.
+
+    With sleeping enabled in \e m_islands, islands of particles that
+    have come to rest fall asleep. While some sleep, the awake particles
+    and their springs are gathered into compact arrays, rebuilt only when
+    islands fall asleep or wake up, and only those are integrated and
+    tested against the contact shapes; sleeping particles act as static
+    ones for particle-particle collisions. The step does no work at all
+    while every island sleeps. Contacts with awake particles, \ref wakeUp(),
+    \ref resetIntegrator() and any change of the external force, drag,
+    particle radius or particle restitution wake them again.
+    Threads that display the particles read them from \e m_snapshots,
+    filled by \ref publishSnapshot() on the simulation thread, rather
+    than from \e m_particles while it is being integrated.
+*/
+//===========================================================================
+class cParticleSimulation : public cParticleForceModel
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cParticleSimulation.
+    cParticleSimulation();
+
+    //! Destructor of cParticleSimulation.
+    virtual ~cParticleSimulation();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Select the integration scheme.
+    void setIntegrator(const cParticleIntegratorType a_type);
+
+    //! Run the simulation loops on \e a_pool (NULL: on the calling thread).
+    void setTaskPool(cTaskPool* a_pool);
+
+    //! Thread pool in use, or NULL.
+    inline cTaskPool* getTaskPool() const { return (m_pool); }
+
+    //! Charge the phases of every step to \e a_profiler (NULL: no profiling).
+    inline void setProfiler(cLoopProfiler* a_profiler) { m_profiler = a_profiler; }
+
+    //! Profiler in use, or NULL.
+    inline cLoopProfiler* getProfiler() const { return (m_profiler); }
+
+    //! Current integration scheme.
+    inline cParticleIntegratorType getIntegratorType() const { return (m_integrator->getType()); }
+
+    //! Advance the simulation by \e a_dt seconds.
+    void step(const double a_dt);
+
+    //! Copy the current positions into \e m_snapshots and publish them. Simulation thread only.
+    void publishSnapshot();
+
+    //! Publish positions interpolated from \e a_previous (\e a_alpha = 0) to the current ones (1).
+    void publishSnapshot(const cParticleSnapshot& a_previous, const double a_alpha);
+
+    //! Copy the current positions into \e a_frame, without publishing it.
+    void getSnapshot(cParticleSnapshot& a_frame) const;
+
+    //! Copy the particle radius and, if they changed, the spring endpoints into \e a_frame.
+    void fillSnapshotTopology(cParticleSnapshot& a_frame) const;
+
+    //! Simulated time since construction [s].
+    inline double getTime() const { return (m_time); }
+
+    //! Number of steps taken since construction.
+    inline unsigned int getNumSteps() const { return (m_numSteps); }
+
+    //! Set the simulated time and step count, e.g. when restoring a checkpoint.
+    inline void setClock(const double a_time, const unsigned int a_numSteps) { m_time = a_time; m_numSteps = a_numSteps; }
+
+    //! Number of particle-shape contacts resolved by the last step.
+    inline unsigned int getNumContacts() const { return (m_numContacts); }
+
+    //! Number of particle-particle contacts resolved by the last step.
+    inline unsigned int getNumParticleContacts() const { return (m_numParticleContacts); }
+
+    //! Notify the integrator that particles were moved from outside. Wakes every island.
+    void resetIntegrator();
+
+    //! Wake every island, e.g. after masses or springs were changed.
+    void wakeUp();
+
+    //! Overwrite the particle force accumulators with the total force.
+    virtual void computeForces(cParticleArrays& a_particles);
+
+    //! Overwrite the particle force accumulators with the external force and the drag.
+    virtual void computeExternalForces(cParticleArrays& a_particles);
+
+    //! Springs of the particles being integrated, for implicit integrators.
+    virtual const cSpringTable* getImplicitSprings() const { return (m_activeSprings); }
+
+    //! Drag rate, for implicit integrators.
+    virtual double getImplicitDrag() const { return (m_dragCoefficient); }
+
+    //! Contact shapes, for position based integrators.
+    virtual const cParticleContacts* getContactShapes() const { return (&m_contacts); }
+
+    //! Particle radius, for position based integrators.
+    virtual double getContactRadius() const { return (m_particleRadius); }
+
+    //! Current integrator, to query or tune scheme specific settings.
+    inline cParticleIntegrator* getIntegrator() { return (m_integrator); }
+    inline const cParticleIntegrator* getIntegrator() const { return (m_integrator); }
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Particle state.
+    cParticleArrays m_particles;
+
+    //! Springs between particles.
+    cSpringTable m_springs;
+
+    //! Constant force applied to every dynamic particle [N].
+    double m_externalForce[3];
+
+    //! Linear drag rate [1/s]; velocities decay as exp(-rate.t).
+    double m_dragCoefficient;
+
+    //! Static collision primitives.
+    cParticleContacts m_contacts;
+
+    //! Collision radius of every particle.
+    double m_particleRadius;
+
+    //! Resolve collisions between particles.
+    bool m_collideParticles;
+
+    //! Fraction of the normal velocity kept after a particle-particle impact.
+    double m_particleRestitution;
+
+    //! Broad phase for particle-particle collisions.
+    cSpatialHash m_hash;
+
+    //! Positions published for other threads, see \ref publishSnapshot().
+    cTripleBuffer<cParticleSnapshot> m_snapshots;
+
+    //! Random numbers of the scene (initial placement, perturbations), saved in checkpoints.
+    cParticleRandom m_random;
+
+    //! Islands of connected particles and their sleeping state.
+    cParticleIslands m_islands;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // TYPES:
+    //-----------------------------------------------------------------------
+
+    //! Overlapping pair found by the broad phase.
+    struct cParticlePair
+    {
+        unsigned int m_i, m_j;
+        double m_dx, m_dy, m_dz, m_d2;
+    };
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Separate overlapping particles and exchange their normal velocities.
+    unsigned int resolveParticleCollisions();
+
+    //! Return true if a parameter watched for waking islands changed since the last call.
+    bool haveSleepParametersChanged();
+
+    //! Gather the awake particles and their springs into \e m_awakeParticles and \e m_awakeSprings.
+    void buildAwakeSet();
+
+    //! Copy the state of the awake particles into \e m_awakeParticles.
+    void gatherAwake();
+
+    //! Copy the state of \e m_awakeParticles back into \e m_particles.
+    void scatterAwake();
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Current integrator.
+    cParticleIntegrator* m_integrator;
+
+    //! Thread pool, not owned.
+    cTaskPool* m_pool;
+
+    //! Profiler of the loop calling \ref step(), not owned.
+    cLoopProfiler* m_profiler;
+
+    //! Overlapping pairs found by each chunk of a parallel broad phase.
+    std::vector< std::vector<cParticlePair> > m_pairChunks;
+
+    //! Simulated time and step count.
+    double m_time;
+    unsigned int m_numSteps;
+
+    //! Contacts resolved by the last step.
+    unsigned int m_numContacts;
+    unsigned int m_numParticleContacts;
+
+    //! External force, drag, radius and restitution seen by the last step with sleeping.
+    double m_sleepParameters[6];
+
+    //! Springs used by \ref computeForces(): \e m_springs, or \e m_awakeSprings during a step over the awake particles.
+    const cSpringTable* m_activeSprings;
+
+    //! Awake particles, the static particles their springs hold, and those springs, renumbered.
+    cParticleArrays m_awakeParticles;
+    cSpringTable m_awakeSprings;
+
+    //! Index in \e m_particles of every particle of \e m_awakeParticles.
+    std::vector<unsigned int> m_awakeIndex;
+
+    //! Island version, spring topology and particle count \e m_awakeParticles was built for.
+    unsigned int m_awakeIslandVersion;
+    unsigned int m_awakeTopologyVersion;
+    unsigned int m_awakeNumParticles;
+    bool m_awakeValid;
+
+    //! The last step integrated \e m_awakeParticles rather than \e m_particles.
+    bool m_steppedAwake;
+
+    //! Not copyable.
+    cParticleSimulation(const cParticleSimulation&);
+    cParticleSimulation& operator=(const cParticleSimulation&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
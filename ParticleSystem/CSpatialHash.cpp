@@ -0,0 +1,194 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CSpatialHash.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// widest span of cells along one axis; outer cells are clamped beyond it
+static const int C_HASH_MAX_SPAN = (1 << 20) - 3;
+
+// bits sorted by each pass of the radix sort
+static const unsigned int C_HASH_RADIX_BITS = 11;
+
+// number of bits holding a padded coordinate of a span of a_span cells
+static unsigned int cCoordinateBits(const int a_span)
+{
+    // coordinates run from 1 to a_span, neighbors from 0 to a_span + 1
+    unsigned int bits = 1;
+    while ((1LL << bits) < (long long)a_span + 2) { bits++; }
+    return (bits);
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cSpatialHash.
+
+    \fn     cSpatialHash::cSpatialHash()
+*/
+//===========================================================================
+cSpatialHash::cSpatialHash()
+{
+    setCellSize(0.1);
+    m_strideX = 4;
+    m_strideY = 2;
+}
+
+
+//===========================================================================
+/*!
+    Rebuild the cells from the current particle positions: find the
+    bounding box of the particles, give every particle the key of its
+    padded cell, then sort the particles by key with a least significant
+    digit radix sort over the key bits in use. The sort is stable, so
+    particle indices stay in increasing order inside a cell.
+
+    \fn     void cSpatialHash::build(const cParticleArrays& a_particles)
+    \param  a_particles  Particles to insert.
+*/
+//===========================================================================
+void cSpatialHash::build(const cParticleArrays& a_particles)
+{
+    unsigned int numParticles = a_particles.getNumParticles();
+
+    m_sorted.resize(numParticles);
+    m_sortedX.resize(numParticles);
+    m_sortedY.resize(numParticles);
+    m_sortedZ.resize(numParticles);
+    m_sortedKey.resize(numParticles + 1);
+    m_scratchIndex.resize(numParticles);
+    m_scratchKey.resize(numParticles + 1);
+    m_sortedKey[numParticles] = m_scratchKey[numParticles] = ~0ULL;
+    if (numParticles == 0) { return; }
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+
+    // bounding box of the particles; NaN positions are left out
+    double low[3] = { HUGE_VAL, HUGE_VAL, HUGE_VAL };
+    double high[3] = { -HUGE_VAL, -HUGE_VAL, -HUGE_VAL };
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        if (px[i] < low[0]) { low[0] = px[i]; }
+        if (px[i] > high[0]) { high[0] = px[i]; }
+        if (py[i] < low[1]) { low[1] = py[i]; }
+        if (py[i] > high[1]) { high[1] = py[i]; }
+        if (pz[i] < low[2]) { low[2] = pz[i]; }
+        if (pz[i] > high[2]) { high[2] = pz[i]; }
+    }
+    for (int k=0; k<3; k++)
+    {
+        if (!(high[k] >= low[k])) { low[k] = high[k] = 0.0; }
+    }
+
+    // cells are counted from the corner of the box, so truncation is a
+    // floor; outer cells of a span wider than C_HASH_MAX_SPAN are clamped
+    double span[3];
+    unsigned int bits[3];
+    for (int k=0; k<3; k++)
+    {
+        double cells = floor((high[k] - low[k]) * m_invCellSize) + 1.0;
+        span[k] = (cells < C_HASH_MAX_SPAN) ? cells : (double)C_HASH_MAX_SPAN;
+        bits[k] = cCoordinateBits((int)span[k]);
+    }
+    m_strideY = 1ULL << bits[2];
+    m_strideX = 1ULL << (bits[1] + bits[2]);
+    unsigned int keyBits = bits[0] + bits[1] + bits[2];
+
+    // keys of the padded cells, in particle order; NaN goes to the last cell
+    double lastCell[3] = { span[0] - 1.0, span[1] - 1.0, span[2] - 1.0 };
+    for (unsigned int i=0; i<numParticles; i++)
+    {
+        double x = (px[i] - low[0]) * m_invCellSize;
+        double y = (py[i] - low[1]) * m_invCellSize;
+        double z = (pz[i] - low[2]) * m_invCellSize;
+        if (!(x < lastCell[0])) { x = lastCell[0]; }
+        if (!(y < lastCell[1])) { y = lastCell[1]; }
+        if (!(z < lastCell[2])) { z = lastCell[2]; }
+        m_sortedKey[i] = ((unsigned long long)x + 1) * m_strideX +
+                         ((unsigned long long)y + 1) * m_strideY +
+                         ((unsigned long long)z + 1);
+        m_sorted[i] = i;
+    }
+
+    // radix sort of (key, index), C_HASH_RADIX_BITS bits per pass
+    unsigned int numDigits = 1 << C_HASH_RADIX_BITS;
+    unsigned int digitMask = numDigits - 1;
+    m_digitCount.resize(numDigits + 1);
+    for (unsigned int shift=0; shift<keyBits; shift+=C_HASH_RADIX_BITS)
+    {
+        m_digitCount.assign(numDigits + 1, 0);
+        for (unsigned int i=0; i<numParticles; i++)
+        {
+            m_digitCount[((m_sortedKey[i] >> shift) & digitMask) + 1]++;
+        }
+        for (unsigned int d=0; d<numDigits; d++)
+        {
+            m_digitCount[d+1] += m_digitCount[d];
+        }
+        for (unsigned int i=0; i<numParticles; i++)
+        {
+            unsigned int slot = m_digitCount[(m_sortedKey[i] >> shift) & digitMask]++;
+            m_scratchKey[slot] = m_sortedKey[i];
+            m_scratchIndex[slot] = m_sorted[i];
+        }
+        m_sortedKey.swap(m_scratchKey);
+        m_sorted.swap(m_scratchIndex);
+    }
+
+    // positions in sorted order
+    for (unsigned int s=0; s<numParticles; s++)
+    {
+        unsigned int i = m_sorted[s];
+        m_sortedX[s] = px[i];
+        m_sortedY[s] = py[i];
+        m_sortedZ[s] = pz[i];
+    }
+}
+
+
+//===========================================================================
+/*!
+    Find the first entry of the sorted order whose key is not below
+    \e a_key.
+
+    \fn     unsigned int cSpatialHash::findKey(const unsigned long long a_key) const
+    \param  a_key  Cell key.
+    \return Return the index of the entry, or the number of entries if
+            every key is below \e a_key.
+*/
+//===========================================================================
+unsigned int cSpatialHash::findKey(const unsigned long long a_key) const
+{
+    unsigned int first = 0;
+    unsigned int count = getNumEntries();
+    while (count > 0)
+    {
+        unsigned int half = count / 2;
+        if (m_sortedKey[first + half] < a_key)
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return (first);
+}
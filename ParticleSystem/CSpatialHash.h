@@ -0,0 +1,261 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CSpatialHashH
+#define CSpatialHashH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CSpatialHash.h
+
+    \brief
+    <b> Particles </b> \n
+    Uniform grid spatial hash for particle neighbor queries.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cSpatialHash
+    \ingroup    particles
+
+    \brief
+    cSpatialHash buckets particles into the cells of a uniform grid laid
+    over their bounding box. Every cell gets an exact key, its x, y and z
+    coordinates packed from the most to the least significant bits, and
+    the particles are sorted by key with a radix sort over the bits in
+    use, so a rebuild is a few linear passes without allocation once the
+    buffers have grown. Positions and keys are copied in sorted order, so
+    a cell is a run of contiguous entries and rows of cells along z are
+    contiguous runs of runs.
+
+    With a cell size at least equal to the interaction distance, all the
+    neighbors of a particle lie in the 27 surrounding cells. Pairs are
+    enumerated with a half stencil: the particle's own cell and the 13
+    neighbors with a positive offset, which are the next cell along z
+    and three cells in each of four rows. The grid is padded by one cell
+    on every side, so each row is a range of keys at a fixed offset from
+    the particle's key; as keys only grow along the sorted order, each
+    row is found by a cursor that moves forward through the entries,
+    without any lookup. Neighbor probes thus read memory close to the
+    entries just read.
+
+    Grids wider than 2^20 cells along an axis clamp their outer cells.
+    Clamping keeps neighbors in the same or adjacent cells and pairs
+    are tested by distance, so it only costs time, never pairs.
+*/
+//===========================================================================
+class cSpatialHash
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cSpatialHash.
+    cSpatialHash();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Set the edge length of a grid cell.
+    inline void setCellSize(const double a_cellSize) { m_cellSize = a_cellSize; m_invCellSize = 1.0 / a_cellSize; }
+
+    //! Edge length of a grid cell.
+    inline double getCellSize() const { return (m_cellSize); }
+
+    //! Rebuild the cells from the current particle positions.
+    void build(const cParticleArrays& a_particles);
+
+    //! Call \e a_visitor once for every pair of particles closer than \e a_distance.
+    template <class T> void forEachPair(const cParticleArrays& a_particles,
+                                        const double a_distance, T& a_visitor) const
+    {
+        forEachPair(a_particles, a_distance, a_visitor, 0, getNumEntries());
+    }
+
+    //! Same, restricted to pairs found from entries [a_first, a_last) of \ref getSortedIndices().
+    template <class T> void forEachPair(const cParticleArrays& a_particles,
+                                        const double a_distance, T& a_visitor,
+                                        const unsigned int a_first,
+                                        const unsigned int a_last) const;
+
+    //! Number of particles in the hash.
+    inline unsigned int getNumEntries() const { return ((unsigned int)m_sorted.size()); }
+
+    //! Particle indices sorted by cell.
+    inline const unsigned int* getSortedIndices() const { return (&m_sorted[0]); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Index of the first entry at or after \e a_from whose key is not below \e a_key.
+    inline unsigned int seekKey(unsigned int a_from, const unsigned long long a_key) const
+    {
+        const unsigned long long* keys = &m_sortedKey[0];
+        while (keys[a_from] < a_key) { a_from++; }
+        return (a_from);
+    }
+
+    //! Index of the first entry whose key is not below \e a_key (binary search).
+    unsigned int findKey(const unsigned long long a_key) const;
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Cell size and its inverse.
+    double m_cellSize;
+    double m_invCellSize;
+
+    //! Key offsets of one cell along x and y (one along z).
+    unsigned long long m_strideX;
+    unsigned long long m_strideY;
+
+    //! Particle indices sorted by cell key.
+    std::vector<unsigned int> m_sorted;
+
+    //! Positions and cell keys in the order of \e m_sorted; one more key
+    //! above every cell ends the sorted keys.
+    std::vector<double> m_sortedX;
+    std::vector<double> m_sortedY;
+    std::vector<double> m_sortedZ;
+    std::vector<unsigned long long> m_sortedKey;
+
+    //! Radix sort buffers.
+    std::vector<unsigned int> m_scratchIndex;
+    std::vector<unsigned long long> m_scratchKey;
+    std::vector<unsigned int> m_digitCount;
+};
+
+
+//===========================================================================
+/*!
+    Visit every pair of particles whose centers are closer than
+    \e a_distance, which must not exceed the cell size. The visitor is
+    called as \e a_visitor(i, j, dx, dy, dz, distanceSquared) with
+    (dx, dy, dz) = position j - position i, using the positions at the
+    time of the last \ref build(). Each unordered pair is reported once.
+
+    Every pair is found from exactly one entry of the sorted order, and
+    only entries [a_first, a_last) are searched, so disjoint ranges can
+    be searched concurrently and their results concatenated in range
+    order to reproduce a full search.
+
+    \fn     template <class T> void cSpatialHash::forEachPair(
+            const cParticleArrays& a_particles, const double a_distance,
+            T& a_visitor, const unsigned int a_first,
+            const unsigned int a_last) const
+    \param  a_particles  Particles the hash was built from.
+    \param  a_distance  Interaction distance.
+    \param  a_visitor  Functor called for each close pair.
+    \param  a_first  First sorted entry to search from.
+    \param  a_last  One past the last sorted entry to search from.
+*/
+//===========================================================================
+template <class T> void cSpatialHash::forEachPair(const cParticleArrays& a_particles,
+                                                  const double a_distance,
+                                                  T& a_visitor,
+                                                  const unsigned int a_first,
+                                                  const unsigned int a_last) const
+{
+    (void)a_particles;
+    if (a_last <= a_first) { return; }
+
+    const double* sx = &m_sortedX[0];
+    const double* sy = &m_sortedY[0];
+    const double* sz = &m_sortedZ[0];
+    const unsigned long long* keys = &m_sortedKey[0];
+    const unsigned int* index = &m_sorted[0];
+    double distance2 = a_distance * a_distance;
+
+    // the four rows of three cells of the half stencil, as offsets of
+    // their first cell (z - 1); the next cell along z follows the own
+    // cell in the sorted order and is scanned with it
+    const unsigned long long row[4] =
+    {
+        m_strideY - 1,
+        m_strideX - m_strideY - 1,
+        m_strideX - 1,
+        m_strideX + m_strideY - 1
+    };
+
+    unsigned int cursor[4];
+    for (int r=0; r<4; r++)
+    {
+        cursor[r] = findKey(keys[a_first] + row[r]);
+    }
+
+    unsigned int s = a_first;
+    while (s < a_last)
+    {
+        // entries of the current cell, and the row ranges they share
+        unsigned long long key = keys[s];
+        unsigned int cellEnd = s + 1;
+        while (keys[cellEnd] == key) { cellEnd++; }
+        unsigned int nextEnd = cellEnd;
+        while (keys[nextEnd] == key + 1) { nextEnd++; }
+
+        unsigned int rowEnd[4];
+        for (int r=0; r<4; r++)
+        {
+            cursor[r] = seekKey(cursor[r], key + row[r]);
+            rowEnd[r] = seekKey(cursor[r], key + row[r] + 3);
+        }
+
+        unsigned int last = (cellEnd < a_last) ? cellEnd : a_last;
+        for (; s<last; s++)
+        {
+            double x = sx[s];
+            double y = sy[s];
+            double z = sz[s];
+
+            // later entries of the own cell, then the next cell along z
+            for (unsigned int k=s+1; k<nextEnd; k++)
+            {
+                double dx = sx[k] - x;
+                double dy = sy[k] - y;
+                double dz = sz[k] - z;
+                double d2 = dx*dx + dy*dy + dz*dz;
+                if (d2 < distance2) { a_visitor(index[s], index[k], dx, dy, dz, d2); }
+            }
+
+            // the four forward rows
+            for (int r=0; r<4; r++)
+            {
+                for (unsigned int k=cursor[r]; k<rowEnd[r]; k++)
+                {
+                    double dx = sx[k] - x;
+                    double dy = sy[k] - y;
+                    double dz = sz[k] - z;
+                    double d2 = dx*dx + dy*dy + dz*dz;
+                    if (d2 < distance2) { a_visitor(index[s], index[k], dx, dy, dz, d2); }
+                }
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
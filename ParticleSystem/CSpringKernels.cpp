@@ -0,0 +1,393 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CSpringKernels.h"
+#include "CSpringTable.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+#if defined(C_SPRING_KERNELS_X86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// DECLARED MACROS
+//---------------------------------------------------------------------------
+
+// allow AVX2/FMA intrinsics in a single function without compiling the
+// whole file for AVX2 (MSVC always allows them)
+#if defined(__GNUC__)
+#define C_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#else
+#define C_TARGET_AVX2
+#endif
+
+// springs shorter than this exert no force (direction is undefined)
+#define C_SPRING_MIN_LENGTH     1e-12
+
+
+//---------------------------------------------------------------------------
+// SCALAR KERNEL
+//---------------------------------------------------------------------------
+
+static void cSpringForcesScalar(const cSpringTable& a_springs,
+                                cParticleArrays& a_particles,
+                                const unsigned int a_first,
+                                const unsigned int a_last)
+{
+    const unsigned int* ia = a_springs.m_indexA;
+    const unsigned int* ib = a_springs.m_indexB;
+    const double* restLength = a_springs.m_restLength;
+    const double* stiffness = a_springs.m_stiffness;
+    const double* damping = a_springs.m_damping;
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+    const double* vx = a_particles.m_velX;
+    const double* vy = a_particles.m_velY;
+    const double* vz = a_particles.m_velZ;
+    double* fx = a_particles.m_forceX;
+    double* fy = a_particles.m_forceY;
+    double* fz = a_particles.m_forceZ;
+
+    for (unsigned int i=a_first; i<a_last; i++)
+    {
+        unsigned int a = ia[i];
+        unsigned int b = ib[i];
+
+        double dx = px[b] - px[a];
+        double dy = py[b] - py[a];
+        double dz = pz[b] - pz[a];
+
+        double length = sqrt(dx*dx + dy*dy + dz*dz);
+        if (length < C_SPRING_MIN_LENGTH) { continue; }
+        double invLength = 1.0 / length;
+
+        double stretchRate = ((vx[b] - vx[a])*dx +
+                              (vy[b] - vy[a])*dy +
+                              (vz[b] - vz[a])*dz) * invLength;
+
+        double f = (stiffness[i] * (length - restLength[i]) +
+                    damping[i] * stretchRate) * invLength;
+
+        fx[a] += f * dx;  fy[a] += f * dy;  fz[a] += f * dz;
+        fx[b] -= f * dx;  fy[b] -= f * dy;  fz[b] -= f * dz;
+    }
+}
+
+
+#if defined(C_SPRING_KERNELS_X86)
+
+//---------------------------------------------------------------------------
+// SSE2 KERNEL
+//---------------------------------------------------------------------------
+
+static void cSpringForcesSSE2(const cSpringTable& a_springs,
+                              cParticleArrays& a_particles,
+                              const unsigned int a_first,
+                              const unsigned int a_last)
+{
+    const unsigned int* ia = a_springs.m_indexA;
+    const unsigned int* ib = a_springs.m_indexB;
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+    const double* vx = a_particles.m_velX;
+    const double* vy = a_particles.m_velY;
+    const double* vz = a_particles.m_velZ;
+    double* fx = a_particles.m_forceX;
+    double* fy = a_particles.m_forceY;
+    double* fz = a_particles.m_forceZ;
+
+    const __m128d minLength = _mm_set1_pd(C_SPRING_MIN_LENGTH);
+    const __m128d one = _mm_set1_pd(1.0);
+
+    unsigned int i = a_first;
+    for (; i+2<=a_last; i+=2)
+    {
+        unsigned int a0 = ia[i], a1 = ia[i+1];
+        unsigned int b0 = ib[i], b1 = ib[i+1];
+
+        __m128d dx = _mm_sub_pd(_mm_set_pd(px[b1], px[b0]), _mm_set_pd(px[a1], px[a0]));
+        __m128d dy = _mm_sub_pd(_mm_set_pd(py[b1], py[b0]), _mm_set_pd(py[a1], py[a0]));
+        __m128d dz = _mm_sub_pd(_mm_set_pd(pz[b1], pz[b0]), _mm_set_pd(pz[a1], pz[a0]));
+        __m128d dvx = _mm_sub_pd(_mm_set_pd(vx[b1], vx[b0]), _mm_set_pd(vx[a1], vx[a0]));
+        __m128d dvy = _mm_sub_pd(_mm_set_pd(vy[b1], vy[b0]), _mm_set_pd(vy[a1], vy[a0]));
+        __m128d dvz = _mm_sub_pd(_mm_set_pd(vz[b1], vz[b0]), _mm_set_pd(vz[a1], vz[a0]));
+
+        __m128d length = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+                                                           _mm_mul_pd(dy, dy)),
+                                                _mm_mul_pd(dz, dz)));
+
+        // zero length springs get a zero inverse length, hence no force
+        __m128d valid = _mm_cmpge_pd(length, minLength);
+        __m128d invLength = _mm_and_pd(valid, _mm_div_pd(one, _mm_max_pd(length, minLength)));
+
+        __m128d stretchRate = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dvx, dx),
+                                                               _mm_mul_pd(dvy, dy)),
+                                                    _mm_mul_pd(dvz, dz)), invLength);
+
+        __m128d stretch = _mm_sub_pd(length, _mm_loadu_pd(a_springs.m_restLength + i));
+        __m128d f = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(a_springs.m_stiffness + i), stretch),
+                                          _mm_mul_pd(_mm_loadu_pd(a_springs.m_damping + i), stretchRate)),
+                               invLength);
+
+        double tx[2], ty[2], tz[2];
+        _mm_storeu_pd(tx, _mm_mul_pd(f, dx));
+        _mm_storeu_pd(ty, _mm_mul_pd(f, dy));
+        _mm_storeu_pd(tz, _mm_mul_pd(f, dz));
+
+        // scatter one lane at a time so that shared endpoints add up correctly
+        fx[a0] += tx[0];  fy[a0] += ty[0];  fz[a0] += tz[0];
+        fx[b0] -= tx[0];  fy[b0] -= ty[0];  fz[b0] -= tz[0];
+        fx[a1] += tx[1];  fy[a1] += ty[1];  fz[a1] += tz[1];
+        fx[b1] -= tx[1];  fy[b1] -= ty[1];  fz[b1] -= tz[1];
+    }
+
+    cSpringForcesScalar(a_springs, a_particles, i, a_last);
+}
+
+
+//---------------------------------------------------------------------------
+// AVX2 KERNEL
+//---------------------------------------------------------------------------
+
+// loads four doubles through an index vector (the masked form, from a
+// zero source, keeps GCC from warning about an undefined source)
+C_TARGET_AVX2
+static inline __m256d cGather4(const double* a_base, const __m128i a_index)
+{
+    return (_mm256_mask_i32gather_pd(_mm256_setzero_pd(), a_base, a_index,
+                                     _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8));
+}
+
+C_TARGET_AVX2
+static void cSpringForcesAVX2(const cSpringTable& a_springs,
+                              cParticleArrays& a_particles,
+                              const unsigned int a_first,
+                              const unsigned int a_last)
+{
+    const unsigned int* ia = a_springs.m_indexA;
+    const unsigned int* ib = a_springs.m_indexB;
+
+    const double* px = a_particles.m_posX;
+    const double* py = a_particles.m_posY;
+    const double* pz = a_particles.m_posZ;
+    const double* vx = a_particles.m_velX;
+    const double* vy = a_particles.m_velY;
+    const double* vz = a_particles.m_velZ;
+    double* fx = a_particles.m_forceX;
+    double* fy = a_particles.m_forceY;
+    double* fz = a_particles.m_forceZ;
+
+    const __m256d minLength = _mm256_set1_pd(C_SPRING_MIN_LENGTH);
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    unsigned int i = a_first;
+    for (; i+4<=a_last; i+=4)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(ia + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(ib + i));
+
+        __m256d dx = _mm256_sub_pd(cGather4(px, b), cGather4(px, a));
+        __m256d dy = _mm256_sub_pd(cGather4(py, b), cGather4(py, a));
+        __m256d dz = _mm256_sub_pd(cGather4(pz, b), cGather4(pz, a));
+        __m256d dvx = _mm256_sub_pd(cGather4(vx, b), cGather4(vx, a));
+        __m256d dvy = _mm256_sub_pd(cGather4(vy, b), cGather4(vy, a));
+        __m256d dvz = _mm256_sub_pd(cGather4(vz, b), cGather4(vz, a));
+
+        __m256d length = _mm256_sqrt_pd(_mm256_fmadd_pd(dz, dz,
+                                        _mm256_fmadd_pd(dy, dy,
+                                        _mm256_mul_pd(dx, dx))));
+
+        // zero length springs get a zero inverse length, hence no force
+        __m256d valid = _mm256_cmp_pd(length, minLength, _CMP_GE_OQ);
+        __m256d invLength = _mm256_and_pd(valid, _mm256_div_pd(one, _mm256_max_pd(length, minLength)));
+
+        __m256d stretchRate = _mm256_mul_pd(_mm256_fmadd_pd(dvz, dz,
+                                            _mm256_fmadd_pd(dvy, dy,
+                                            _mm256_mul_pd(dvx, dx))), invLength);
+
+        __m256d stretch = _mm256_sub_pd(length, _mm256_loadu_pd(a_springs.m_restLength + i));
+        __m256d f = _mm256_mul_pd(_mm256_fmadd_pd(_mm256_loadu_pd(a_springs.m_stiffness + i), stretch,
+                                  _mm256_mul_pd(_mm256_loadu_pd(a_springs.m_damping + i), stretchRate)),
+                                  invLength);
+
+        double tx[4], ty[4], tz[4];
+        _mm256_storeu_pd(tx, _mm256_mul_pd(f, dx));
+        _mm256_storeu_pd(ty, _mm256_mul_pd(f, dy));
+        _mm256_storeu_pd(tz, _mm256_mul_pd(f, dz));
+
+        // AVX2 has no scatter, and lanes may share endpoints anyway
+        for (unsigned int k=0; k<4; k++)
+        {
+            unsigned int ka = ia[i+k];
+            unsigned int kb = ib[i+k];
+            fx[ka] += tx[k];  fy[ka] += ty[k];  fz[ka] += tz[k];
+            fx[kb] -= tx[k];  fy[kb] -= ty[k];  fz[kb] -= tz[k];
+        }
+    }
+
+    cSpringForcesScalar(a_springs, a_particles, i, a_last);
+}
+
+#endif
+
+
+//===========================================================================
+/*!
+    Return true if \e a_kernel can run on this CPU. The result of the
+    CPU query is computed once.
+
+    \fn     bool cIsSpringKernelSupported(const cSpringKernelType a_kernel)
+    \param  a_kernel  Kernel to test.
+    \return Return \b true if the kernel is available.
+*/
+//===========================================================================
+bool cIsSpringKernelSupported(const cSpringKernelType a_kernel)
+{
+    switch (a_kernel)
+    {
+        case C_SPRING_KERNEL_AUTO:
+        case C_SPRING_KERNEL_SCALAR:
+            return (true);
+
+#if defined(C_SPRING_KERNELS_X86)
+        case C_SPRING_KERNEL_SSE2:
+            return (true);
+
+        case C_SPRING_KERNEL_AVX2:
+        {
+#if defined(_MSC_VER)
+            static int supported = -1;
+            if (supported < 0)
+            {
+                int info[4];
+                __cpuid(info, 1);
+                bool osxsave = (info[2] & (1 << 27)) != 0;
+                bool fma = (info[2] & (1 << 12)) != 0;
+                bool ymm = osxsave && ((_xgetbv(0) & 6) == 6);
+                __cpuidex(info, 7, 0);
+                bool avx2 = (info[1] & (1 << 5)) != 0;
+                supported = (ymm && fma && avx2) ? 1 : 0;
+            }
+            return (supported == 1);
+#else
+            static const bool supported = __builtin_cpu_supports("avx2") &&
+                                          __builtin_cpu_supports("fma");
+            return (supported);
+#endif
+        }
+#endif
+
+        default:
+            return (false);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Return the fastest kernel supported by the running CPU. Every kernel
+    is bound by the indexed loads of the endpoints and the read-modify-
+    write of their forces, which stay one lane at a time without a
+    scatter instruction, rather than by arithmetic. On the cloth of
+    benchSpringKernels the AVX2 gathers do not beat the SSE2 loads, so
+    SSE2 is preferred; AVX2 is only ahead on tables much larger than the
+    cache and remains available by name.
+
+    \fn     cSpringKernelType cGetBestSpringKernel()
+    \return Return the kernel type.
+*/
+//===========================================================================
+cSpringKernelType cGetBestSpringKernel()
+{
+    if (cIsSpringKernelSupported(C_SPRING_KERNEL_SSE2)) { return (C_SPRING_KERNEL_SSE2); }
+    return (C_SPRING_KERNEL_SCALAR);
+}
+
+
+//===========================================================================
+/*!
+    Return a printable name for \e a_kernel.
+
+    \fn     const char* cGetSpringKernelName(const cSpringKernelType a_kernel)
+    \param  a_kernel  Kernel type.
+    \return Return the name of the kernel.
+*/
+//===========================================================================
+const char* cGetSpringKernelName(const cSpringKernelType a_kernel)
+{
+    switch (a_kernel)
+    {
+        case C_SPRING_KERNEL_AUTO:   return ("auto");
+        case C_SPRING_KERNEL_SCALAR: return ("scalar");
+        case C_SPRING_KERNEL_SSE2:   return ("sse2");
+        case C_SPRING_KERNEL_AVX2:   return ("avx2");
+    }
+    return ("unknown");
+}
+
+
+//===========================================================================
+/*!
+    Accumulate the forces of springs [a_first, a_last) into the force
+    arrays of \e a_particles. \e C_SPRING_KERNEL_AUTO selects the best
+    kernel for this CPU; an unsupported kernel falls back to scalar code.
+
+    \fn     void cComputeSpringForces(const cSpringTable& a_springs,
+            cParticleArrays& a_particles, const unsigned int a_first,
+            const unsigned int a_last, cSpringKernelType a_kernel)
+    \param  a_springs  Spring table.
+    \param  a_particles  Particles the springs are attached to.
+    \param  a_first  First spring to evaluate.
+    \param  a_last  One past the last spring to evaluate.
+    \param  a_kernel  Kernel implementation to use.
+*/
+//===========================================================================
+void cComputeSpringForces(const cSpringTable& a_springs,
+                          cParticleArrays& a_particles,
+                          const unsigned int a_first,
+                          const unsigned int a_last,
+                          cSpringKernelType a_kernel)
+{
+    if (a_kernel == C_SPRING_KERNEL_AUTO)
+    {
+        static const cSpringKernelType best = cGetBestSpringKernel();
+        a_kernel = best;
+    }
+    else if (!cIsSpringKernelSupported(a_kernel))
+    {
+        a_kernel = C_SPRING_KERNEL_SCALAR;
+    }
+
+    switch (a_kernel)
+    {
+#if defined(C_SPRING_KERNELS_X86)
+        case C_SPRING_KERNEL_AVX2:
+            cSpringForcesAVX2(a_springs, a_particles, a_first, a_last);
+            break;
+
+        case C_SPRING_KERNEL_SSE2:
+            cSpringForcesSSE2(a_springs, a_particles, a_first, a_last);
+            break;
+#endif
+
+        default:
+            cSpringForcesScalar(a_springs, a_particles, a_first, a_last);
+            break;
+    }
+}
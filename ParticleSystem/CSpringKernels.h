@@ -0,0 +1,72 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CSpringKernelsH
+#define CSpringKernelsH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CSpringKernels.h
+
+    \brief
+    <b> Particles </b> \n
+    Scalar and SIMD spring force kernels with runtime dispatch.
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define C_SPRING_KERNELS_X86
+#endif
+//---------------------------------------------------------------------------
+
+class cSpringTable;
+
+//---------------------------------------------------------------------------
+// DECLARED TYPES
+//---------------------------------------------------------------------------
+
+//! Implementations of the spring force kernel.
+enum cSpringKernelType
+{
+    C_SPRING_KERNEL_AUTO,       //!< fastest kernel supported by the running CPU, see \ref cGetBestSpringKernel
+    C_SPRING_KERNEL_SCALAR,     //!< portable C++, one spring at a time
+    C_SPRING_KERNEL_SSE2,       //!< two springs per instruction
+    C_SPRING_KERNEL_AVX2        //!< four springs per instruction, hardware gathers, scalar force stores
+};
+
+
+//---------------------------------------------------------------------------
+// GLOBAL FUNCTIONS
+//---------------------------------------------------------------------------
+
+//! Return the fastest kernel supported by the running CPU.
+cSpringKernelType cGetBestSpringKernel();
+
+//! Return true if \e a_kernel can run on this CPU.
+bool cIsSpringKernelSupported(const cSpringKernelType a_kernel);
+
+//! Return a printable name for \e a_kernel.
+const char* cGetSpringKernelName(const cSpringKernelType a_kernel);
+
+//! Accumulate the forces of springs [a_first, a_last) into the particle force arrays.
+void cComputeSpringForces(const cSpringTable& a_springs,
+                          cParticleArrays& a_particles,
+                          const unsigned int a_first,
+                          const unsigned int a_last,
+                          cSpringKernelType a_kernel = C_SPRING_KERNEL_AUTO);
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -0,0 +1,456 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CSpringTable.h"
+//---------------------------------------------------------------------------
+#include <string.h>
+#include <algorithm>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// orders spring indices by (first endpoint, second endpoint)
+struct cSpringOrder
+{
+    const unsigned int* m_indexA;
+    const unsigned int* m_indexB;
+
+    bool operator()(const unsigned int a_left, const unsigned int a_right) const
+    {
+        if (m_indexA[a_left] != m_indexA[a_right])
+        {
+            return (m_indexA[a_left] < m_indexA[a_right]);
+        }
+        return (m_indexB[a_left] < m_indexB[a_right]);
+    }
+};
+
+// orders spring indices by (color, first endpoint, second endpoint)
+struct cSpringColorOrder
+{
+    const unsigned char* m_color;
+    cSpringOrder m_endpoints;
+
+    bool operator()(const unsigned int a_left, const unsigned int a_right) const
+    {
+        if (m_color[a_left] != m_color[a_right])
+        {
+            return (m_color[a_left] < m_color[a_right]);
+        }
+        return (m_endpoints(a_left, a_right));
+    }
+};
+
+// colors tracked per particle by colorSprings(); springs that find no free
+// color among the first C_SPRING_MAX_COLORS-1 go to a last, serial group
+static const unsigned int C_SPRING_MAX_COLORS = 64;
+
+// applies a permutation to one spring array in place, using a scratch buffer
+template <class T>
+static void cPermute(T* a_data, const std::vector<unsigned int>& a_order,
+                     std::vector<T>& a_scratch)
+{
+    unsigned int n = (unsigned int)a_order.size();
+    a_scratch.resize(n);
+    for (unsigned int i=0; i<n; i++) { a_scratch[i] = a_data[a_order[i]]; }
+    for (unsigned int i=0; i<n; i++) { a_data[i] = a_scratch[i]; }
+}
+
+
+//===========================================================================
+/*!
+    Constructor of cSpringTable.
+
+    \fn     cSpringTable::cSpringTable()
+*/
+//===========================================================================
+cSpringTable::cSpringTable()
+{
+    m_indexA = NULL;
+    m_indexB = NULL;
+    m_restLength = NULL;
+    m_stiffness = NULL;
+    m_damping = NULL;
+
+    m_numSprings = 0;
+    m_capacity = 0;
+    m_numIndependentColors = 0;
+    m_topologyVersion = 0;
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cSpringTable.
+
+    \fn     cSpringTable::~cSpringTable()
+*/
+//===========================================================================
+cSpringTable::~cSpringTable()
+{
+    cParticleAlignedFree(m_indexA);
+    cParticleAlignedFree(m_indexB);
+    cParticleAlignedFree(m_restLength);
+    cParticleAlignedFree(m_stiffness);
+    cParticleAlignedFree(m_damping);
+}
+
+
+//===========================================================================
+/*!
+    Make room for at least \e a_capacity springs.
+
+    \fn     void cSpringTable::reserve(const unsigned int a_capacity)
+    \param  a_capacity  Requested number of springs.
+*/
+//===========================================================================
+void cSpringTable::reserve(const unsigned int a_capacity)
+{
+    if (a_capacity > m_capacity)
+    {
+        reallocate(a_capacity);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Append a spring between two particles. The endpoints are stored in
+    increasing order.
+
+    \fn     unsigned int cSpringTable::addSpring(const unsigned int a_indexA,
+            const unsigned int a_indexB, const double a_restLength,
+            const double a_stiffness, const double a_damping)
+    \param  a_indexA  Index of the first particle.
+    \param  a_indexB  Index of the second particle.
+    \param  a_restLength  Rest length of the spring.
+    \param  a_stiffness  Stiffness of the spring.
+    \param  a_damping  Damping of the spring along its axis.
+    \return Return the index of the new spring.
+*/
+//===========================================================================
+unsigned int cSpringTable::addSpring(const unsigned int a_indexA,
+                                     const unsigned int a_indexB,
+                                     const double a_restLength,
+                                     const double a_stiffness,
+                                     const double a_damping)
+{
+    if (m_numSprings == m_capacity)
+    {
+        reallocate(2 * m_capacity + 1);
+    }
+
+    unsigned int index = m_numSprings++;
+    m_colorStart.clear();
+    m_topologyVersion++;
+
+    m_indexA[index] = std::min(a_indexA, a_indexB);
+    m_indexB[index] = std::max(a_indexA, a_indexB);
+    m_restLength[index] = a_restLength;
+    m_stiffness[index] = a_stiffness;
+    m_damping[index] = a_damping;
+
+    return (index);
+}
+
+
+//===========================================================================
+/*!
+    Remove all springs. Allocated memory is kept and cleared so that
+    padding elements describe inert springs.
+
+    \fn     void cSpringTable::clear()
+*/
+//===========================================================================
+void cSpringTable::clear()
+{
+    if (m_capacity > 0)
+    {
+        memset(m_indexA, 0, m_capacity * sizeof(unsigned int));
+        memset(m_indexB, 0, m_capacity * sizeof(unsigned int));
+        memset(m_restLength, 0, m_capacity * sizeof(double));
+        memset(m_stiffness, 0, m_capacity * sizeof(double));
+        memset(m_damping, 0, m_capacity * sizeof(double));
+    }
+
+    m_numSprings = 0;
+    m_colorStart.clear();
+    m_topologyVersion++;
+}
+
+
+//===========================================================================
+/*!
+    Sort springs by first, then second endpoint index. Consecutive
+    springs then touch nearby particles, which keeps the particle arrays
+    in cache during the force pass.
+
+    \fn     void cSpringTable::sortForLocality()
+*/
+//===========================================================================
+void cSpringTable::sortForLocality()
+{
+    std::vector<unsigned int> order(m_numSprings);
+    for (unsigned int i=0; i<m_numSprings; i++) { order[i] = i; }
+
+    cSpringOrder compare;
+    compare.m_indexA = m_indexA;
+    compare.m_indexB = m_indexB;
+    std::sort(order.begin(), order.end(), compare);
+
+    std::vector<unsigned int> scratchIndex;
+    std::vector<double> scratchValue;
+    cPermute(m_indexA, order, scratchIndex);
+    cPermute(m_indexB, order, scratchIndex);
+    cPermute(m_restLength, order, scratchValue);
+    cPermute(m_stiffness, order, scratchValue);
+    cPermute(m_damping, order, scratchValue);
+    m_topologyVersion++;
+    m_colorStart.clear();
+}
+
+
+//===========================================================================
+/*!
+    Assign each spring the lowest color not used yet by either of its
+    endpoints (greedy edge coloring), then reorder the table by color and,
+    inside a color, by endpoints. Typical meshes need about twice their
+    maximum particle degree in colors. A table already sorted by
+    endpoints, as \ref sortForLocality() leaves it, is reordered in linear
+    time. Adding, removing or sorting springs discards the coloring.
+
+    \fn     void cSpringTable::colorSprings()
+*/
+//===========================================================================
+void cSpringTable::colorSprings()
+{
+    unsigned int numParticles = 0;
+    for (unsigned int i=0; i<m_numSprings; i++)
+    {
+        numParticles = std::max(numParticles, m_indexB[i] + 1);
+    }
+
+    // bit c of used[p] is set once a spring of color c touches particle p
+    std::vector<unsigned long long> used(numParticles, 0);
+    std::vector<unsigned char> color(m_numSprings);
+    unsigned int overflow = C_SPRING_MAX_COLORS - 1;
+    unsigned int numColors = 0;
+    bool hasOverflow = false;
+
+    for (unsigned int i=0; i<m_numSprings; i++)
+    {
+        unsigned long long taken = used[m_indexA[i]] | used[m_indexB[i]];
+        unsigned int c = 0;
+        while ((c < overflow) && (taken & (1ULL << c))) { c++; }
+
+        color[i] = (unsigned char)c;
+        if (c < overflow)
+        {
+            used[m_indexA[i]] |= (1ULL << c);
+            used[m_indexB[i]] |= (1ULL << c);
+            numColors = std::max(numColors, c + 1);
+        }
+        else
+        {
+            hasOverflow = true;
+        }
+    }
+
+    std::vector<unsigned int> order(m_numSprings);
+    for (unsigned int i=0; i<m_numSprings; i++) { order[i] = i; }
+
+    cSpringColorOrder compare;
+    compare.m_color = color.empty() ? NULL : &color[0];
+    compare.m_endpoints.m_indexA = m_indexA;
+    compare.m_endpoints.m_indexB = m_indexB;
+
+    // a table already sorted by endpoints only needs a stable pass by color
+    bool sorted = true;
+    for (unsigned int i=1; (i<m_numSprings) && sorted; i++)
+    {
+        sorted = !compare.m_endpoints(i, i-1);
+    }
+
+    if (sorted)
+    {
+        std::vector<unsigned int> start(C_SPRING_MAX_COLORS + 1, 0);
+        for (unsigned int i=0; i<m_numSprings; i++) { start[color[i] + 1]++; }
+        for (unsigned int c=0; c<C_SPRING_MAX_COLORS; c++) { start[c+1] += start[c]; }
+        for (unsigned int i=0; i<m_numSprings; i++) { order[start[color[i]]++] = i; }
+    }
+    else
+    {
+        std::sort(order.begin(), order.end(), compare);
+    }
+
+    std::vector<unsigned int> scratchIndex;
+    std::vector<double> scratchValue;
+    cPermute(m_indexA, order, scratchIndex);
+    cPermute(m_indexB, order, scratchIndex);
+    cPermute(m_restLength, order, scratchValue);
+    cPermute(m_stiffness, order, scratchValue);
+    cPermute(m_damping, order, scratchValue);
+    m_topologyVersion++;
+
+    // group boundaries; the overflow group, if any, comes last
+    m_numIndependentColors = numColors;
+    m_colorStart.assign(1, 0);
+    unsigned int i = 0;
+    for (unsigned int c=0; c<numColors; c++)
+    {
+        while ((i < m_numSprings) && (color[order[i]] == c)) { i++; }
+        m_colorStart.push_back(i);
+    }
+    if (hasOverflow)
+    {
+        m_colorStart.push_back(m_numSprings);
+    }
+}
+
+
+//===========================================================================
+/*!
+    Set the same rest length on every spring.
+
+    \fn     void cSpringTable::setUniformRestLength(const double a_restLength)
+    \param  a_restLength  New rest length.
+*/
+//===========================================================================
+void cSpringTable::setUniformRestLength(const double a_restLength)
+{
+    for (unsigned int i=0; i<m_numSprings; i++) { m_restLength[i] = a_restLength; }
+}
+
+
+//===========================================================================
+/*!
+    Set the same stiffness on every spring.
+
+    \fn     void cSpringTable::setUniformStiffness(const double a_stiffness)
+    \param  a_stiffness  New stiffness.
+*/
+//===========================================================================
+void cSpringTable::setUniformStiffness(const double a_stiffness)
+{
+    for (unsigned int i=0; i<m_numSprings; i++) { m_stiffness[i] = a_stiffness; }
+}
+
+
+//===========================================================================
+/*!
+    Set the same damping on every spring.
+
+    \fn     void cSpringTable::setUniformDamping(const double a_damping)
+    \param  a_damping  New damping.
+*/
+//===========================================================================
+void cSpringTable::setUniformDamping(const double a_damping)
+{
+    for (unsigned int i=0; i<m_numSprings; i++) { m_damping[i] = a_damping; }
+}
+
+
+//===========================================================================
+/*!
+    Add the force of every spring to the force accumulators of its two
+    endpoints, in a single pass over the table. The spring force is
+    stiffness * (length - rest length) plus damping times the relative
+    velocity along the spring axis; it pulls the endpoints together when
+    the spring is stretched.
+
+    When a pool is given and the springs are colored, each color is
+    split into chunks processed concurrently, one color after the other.
+    Uncolored tables are processed on the calling thread.
+
+    \fn     void cSpringTable::accumulateForces(cParticleArrays& a_particles,
+            const cSpringKernelType a_kernel, cTaskPool* a_pool) const
+    \param  a_particles  Particles the springs are attached to.
+    \param  a_kernel  Kernel implementation, see \ref cComputeSpringForces.
+    \param  a_pool  Thread pool, or NULL.
+*/
+//===========================================================================
+void cSpringTable::accumulateForces(cParticleArrays& a_particles,
+                                    const cSpringKernelType a_kernel,
+                                    cTaskPool* a_pool) const
+{
+    if ((a_pool == NULL) || (a_pool->getNumThreads() <= 1) || m_colorStart.empty())
+    {
+        cComputeSpringForces(*this, a_particles, 0, m_numSprings, a_kernel);
+        return;
+    }
+
+    unsigned int numColors = getNumColors();
+    for (unsigned int c=0; c<numColors; c++)
+    {
+        unsigned int first = m_colorStart[c];
+        unsigned int last = m_colorStart[c+1];
+        if (!isColorIndependent(c))
+        {
+            cComputeSpringForces(*this, a_particles, first, last, a_kernel);
+            continue;
+        }
+
+        const cSpringTable& springs = *this;
+        a_pool->parallelFor(first, last, C_TASK_GRAIN,
+            [&](unsigned int a_begin, unsigned int a_end)
+            {
+                cComputeSpringForces(springs, a_particles, a_begin, a_end, a_kernel);
+            });
+    }
+}
+
+
+//===========================================================================
+/*!
+    Grow every array to \e a_capacity elements (rounded up to
+    \ref C_PARTICLE_PADDING), copying the springs in use and zeroing
+    the remainder.
+
+    \fn     void cSpringTable::reallocate(const unsigned int a_capacity)
+    \param  a_capacity  New minimum capacity.
+*/
+//===========================================================================
+void cSpringTable::reallocate(const unsigned int a_capacity)
+{
+    unsigned int capacity = (a_capacity + C_PARTICLE_PADDING - 1) /
+                            C_PARTICLE_PADDING * C_PARTICLE_PADDING;
+
+    unsigned int** indices[] = { &m_indexA, &m_indexB };
+    for (unsigned int k=0; k<2; k++)
+    {
+        unsigned int* data = (unsigned int*)cParticleAlignedMalloc(capacity * sizeof(unsigned int));
+        memset(data, 0, capacity * sizeof(unsigned int));
+        if (*indices[k] != NULL)
+        {
+            memcpy(data, *indices[k], m_numSprings * sizeof(unsigned int));
+            cParticleAlignedFree(*indices[k]);
+        }
+        *indices[k] = data;
+    }
+
+    double** values[] = { &m_restLength, &m_stiffness, &m_damping };
+    for (unsigned int k=0; k<3; k++)
+    {
+        double* data = (double*)cParticleAlignedMalloc(capacity * sizeof(double));
+        memset(data, 0, capacity * sizeof(double));
+        if (*values[k] != NULL)
+        {
+            memcpy(data, *values[k], m_numSprings * sizeof(double));
+            cParticleAlignedFree(*values[k]);
+        }
+        *values[k] = data;
+    }
+
+    m_capacity = capacity;
+}
@@ -0,0 +1,176 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CSpringTableH
+#define CSpringTableH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+#include "CSpringKernels.h"
+#include "CTaskPool.h"
+//---------------------------------------------------------------------------
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CSpringTable.h
+
+    \brief
+    <b> Particles </b> \n
+    Edge list of springs connecting particles.
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cSpringTable
+    \ingroup    particles
+
+    \brief
+    cSpringTable stores the topology and material of a spring network as
+    flat, aligned arrays: the two endpoint indices, the rest length, the
+    stiffness and the damping of each spring.
+
+    Springs are kept oriented so that \e m_indexA < \e m_indexB and can
+    be sorted by endpoint with \ref sortForLocality(), so that the force
+    pass reads the particle arrays in nearly sequential order.
+
+    For multithreaded force accumulation, \ref colorSprings() groups the
+    springs into colors in which no two springs share a particle; the
+    springs of one color can then scatter their forces concurrently
+    without atomics or per-thread buffers. The same colors let
+    \ref cXPBDIntegrator project its spring constraints in parallel,
+    color after color.
+*/
+//===========================================================================
+class cSpringTable
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cSpringTable.
+    cSpringTable();
+
+    //! Destructor of cSpringTable.
+    ~cSpringTable();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Make room for at least \e a_capacity springs.
+    void reserve(const unsigned int a_capacity);
+
+    //! Append a spring between two particles and return its index.
+    unsigned int addSpring(const unsigned int a_indexA, const unsigned int a_indexB,
+                           const double a_restLength, const double a_stiffness,
+                           const double a_damping = 0.0);
+
+    //! Remove all springs. Memory is kept for reuse.
+    void clear();
+
+    //! Sort springs by endpoint indices to improve memory locality.
+    void sortForLocality();
+
+    //! Reorder springs into groups that share no particle, for parallel scatter.
+    void colorSprings();
+
+    //! Number of color groups, or 0 if the springs are not colored.
+    inline unsigned int getNumColors() const { return (m_colorStart.empty() ? 0 : (unsigned int)m_colorStart.size() - 1); }
+
+    //! Index of the first spring of color \e a_color; color c ends where c+1 starts.
+    inline unsigned int getColorStart(const unsigned int a_color) const { return (m_colorStart[a_color]); }
+
+    //! True if the springs of color \e a_color may be processed concurrently.
+    inline bool isColorIndependent(const unsigned int a_color) const { return (a_color < m_numIndependentColors); }
+
+    //! Set the same rest length on every spring.
+    void setUniformRestLength(const double a_restLength);
+
+    //! Set the same stiffness on every spring.
+    void setUniformStiffness(const double a_stiffness);
+
+    //! Set the same damping on every spring.
+    void setUniformDamping(const double a_damping);
+
+    //! Add the force of every spring to the particle force accumulators.
+    void accumulateForces(cParticleArrays& a_particles,
+                          const cSpringKernelType a_kernel = C_SPRING_KERNEL_AUTO,
+                          cTaskPool* a_pool = NULL) const;
+
+    //! Number of springs currently stored.
+    inline unsigned int getNumSprings() const { return (m_numSprings); }
+
+    //! Counter incremented whenever springs are added, removed or reordered.
+    inline unsigned int getTopologyVersion() const { return (m_topologyVersion); }
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Index of the first endpoint of each spring.
+    unsigned int* m_indexA;
+
+    //! Index of the second endpoint of each spring.
+    unsigned int* m_indexB;
+
+    //! Rest length of each spring.
+    double* m_restLength;
+
+    //! Stiffness of each spring [N/m].
+    double* m_stiffness;
+
+    //! Damping of each spring along its axis [N.s/m].
+    double* m_damping;
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Grow every array to \e a_capacity elements, preserving contents.
+    void reallocate(const unsigned int a_capacity);
+
+    //! Not copyable.
+    cSpringTable(const cSpringTable&);
+    cSpringTable& operator=(const cSpringTable&);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Number of springs in use.
+    unsigned int m_numSprings;
+
+    //! Number of allocated elements per array.
+    unsigned int m_capacity;
+
+    //! Incremented on every change of the spring endpoints or order.
+    unsigned int m_topologyVersion;
+
+    //! First spring of each color, plus the end of the last color. Empty if not colored.
+    std::vector<unsigned int> m_colorStart;
+
+    //! Colors whose springs share no particle; a last overflow color, if any, does not qualify.
+    unsigned int m_numIndependentColors;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
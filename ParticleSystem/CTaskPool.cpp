@@ -0,0 +1,296 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CTaskPool.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// number of polls an idle worker makes before going to sleep
+static const int C_TASK_SPIN_COUNT = 2000;
+
+
+//===========================================================================
+/*!
+    Constructor of cTaskPool.
+
+    \fn     cTaskPool::cTaskPool(const unsigned int a_numThreads)
+    \param  a_numThreads  Number of threads, the caller included. Zero
+                          selects one thread per hardware core.
+*/
+//===========================================================================
+cTaskPool::cTaskPool(const unsigned int a_numThreads)
+{
+    m_numThreads = 1;
+    m_pending = 0;
+    m_generation = 0;
+    m_running = false;
+    m_numSteals = 0;
+
+    setNumThreads(a_numThreads);
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cTaskPool.
+
+    \fn     cTaskPool::~cTaskPool()
+*/
+//===========================================================================
+cTaskPool::~cTaskPool()
+{
+    stop();
+}
+
+
+//===========================================================================
+/*!
+    Stop the current workers and start a new set. Must not be called
+    while a loop is running.
+
+    \fn     void cTaskPool::setNumThreads(const unsigned int a_numThreads)
+    \param  a_numThreads  Number of threads, the caller included. Zero
+                          selects one thread per hardware core.
+*/
+//===========================================================================
+void cTaskPool::setNumThreads(const unsigned int a_numThreads)
+{
+    unsigned int numThreads = a_numThreads;
+    if (numThreads == 0)
+    {
+        numThreads = std::thread::hardware_concurrency();
+        if (numThreads == 0) { numThreads = 1; }
+    }
+
+    stop();
+    m_numThreads = numThreads;
+    start();
+}
+
+
+//===========================================================================
+/*!
+    Create one queue per thread and start the workers.
+
+    \fn     void cTaskPool::start()
+*/
+//===========================================================================
+void cTaskPool::start()
+{
+    for (unsigned int i=0; i<m_numThreads; i++)
+    {
+        m_queues.push_back(new cTaskQueue());
+    }
+
+    m_running = true;
+    for (unsigned int i=1; i<m_numThreads; i++)
+    {
+        m_workers.push_back(new std::thread(&cTaskPool::workerLoop, this, i));
+    }
+}
+
+
+//===========================================================================
+/*!
+    Wake every worker, wait for them to exit and release the queues.
+
+    \fn     void cTaskPool::stop()
+*/
+//===========================================================================
+void cTaskPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        m_running = false;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    for (unsigned int i=0; i<m_workers.size(); i++)
+    {
+        m_workers[i]->join();
+        delete m_workers[i];
+    }
+    m_workers.clear();
+
+    for (unsigned int i=0; i<m_queues.size(); i++)
+    {
+        delete m_queues[i];
+    }
+    m_queues.clear();
+}
+
+
+//===========================================================================
+/*!
+    Cut [a_first, a_last) into chunks, deal them round-robin to the
+    thread queues, wake the workers and work until every chunk is done.
+
+    \fn     void cTaskPool::run(void (*a_function)(const void*, unsigned int, unsigned int),
+            const void* a_body, const unsigned int a_first,
+            const unsigned int a_last, const unsigned int a_grain)
+    \param  a_function  Type-erased call of the loop body.
+    \param  a_body  Loop body.
+    \param  a_first  First element.
+    \param  a_last  One past the last element.
+    \param  a_grain  Elements per chunk.
+*/
+//===========================================================================
+void cTaskPool::run(void (*a_function)(const void*, unsigned int, unsigned int),
+                    const void* a_body, const unsigned int a_first,
+                    const unsigned int a_last, const unsigned int a_grain)
+{
+    unsigned int numChunks = getNumChunks(a_first, a_last, a_grain);
+    m_pending.store(numChunks);
+
+    for (unsigned int q=0; q<m_numThreads; q++)
+    {
+        std::lock_guard<std::mutex> lock(m_queues[q]->m_lock);
+        for (unsigned int k=q; k<numChunks; k+=m_numThreads)
+        {
+            cTask task;
+            task.m_function = a_function;
+            task.m_body = a_body;
+            task.m_begin = a_first + k * a_grain;
+            task.m_end = (a_last - task.m_begin > a_grain) ? (task.m_begin + a_grain) : a_last;
+            m_queues[q]->m_tasks.push_back(task);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    // help until the last chunk has finished, wherever it runs
+    while (m_pending.load() > 0)
+    {
+        cTask task;
+        if (popTask(0, task) || stealTask(0, task))
+        {
+            execute(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+//===========================================================================
+/*!
+    Take the most recently queued chunk of queue \e a_queue.
+
+    \fn     bool cTaskPool::popTask(const unsigned int a_queue, cTask& a_task)
+    \param  a_queue  Queue index.
+    \param  a_task  Receives the chunk.
+    \return Return __true__ if a chunk was taken.
+*/
+//===========================================================================
+bool cTaskPool::popTask(const unsigned int a_queue, cTask& a_task)
+{
+    cTaskQueue* queue = m_queues[a_queue];
+    std::lock_guard<std::mutex> lock(queue->m_lock);
+    if (queue->m_tasks.empty()) { return (false); }
+
+    a_task = queue->m_tasks.back();
+    queue->m_tasks.pop_back();
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Take the oldest chunk of another thread's queue, visiting the queues
+    in order starting after the thief.
+
+    \fn     bool cTaskPool::stealTask(const unsigned int a_thief, cTask& a_task)
+    \param  a_thief  Queue index of the calling thread.
+    \param  a_task  Receives the chunk.
+    \return Return __true__ if a chunk was taken.
+*/
+//===========================================================================
+bool cTaskPool::stealTask(const unsigned int a_thief, cTask& a_task)
+{
+    for (unsigned int k=1; k<m_numThreads; k++)
+    {
+        cTaskQueue* queue = m_queues[(a_thief + k) % m_numThreads];
+        std::lock_guard<std::mutex> lock(queue->m_lock);
+        if (queue->m_tasks.empty()) { continue; }
+
+        a_task = queue->m_tasks.front();
+        queue->m_tasks.pop_front();
+        m_numSteals++;
+        return (true);
+    }
+    return (false);
+}
+
+
+//===========================================================================
+/*!
+    Run one chunk and count it as done.
+
+    \fn     void cTaskPool::execute(const cTask& a_task)
+    \param  a_task  Chunk to run.
+*/
+//===========================================================================
+void cTaskPool::execute(const cTask& a_task)
+{
+    a_task.m_function(a_task.m_body, a_task.m_begin, a_task.m_end);
+    m_pending.fetch_sub(1);
+}
+
+
+//===========================================================================
+/*!
+    Main loop of a worker: run chunks from its own queue, then steal,
+    then spin for a while and finally sleep until a new loop arrives.
+
+    \fn     void cTaskPool::workerLoop(const unsigned int a_index)
+    \param  a_index  Queue index of the worker.
+*/
+//===========================================================================
+void cTaskPool::workerLoop(const unsigned int a_index)
+{
+    while (true)
+    {
+        // remember the generation before looking for work, so that a
+        // loop submitted after the search is never missed
+        unsigned int seen = m_generation.load();
+
+        cTask task;
+        if (popTask(a_index, task) || stealTask(a_index, task))
+        {
+            execute(task);
+            continue;
+        }
+
+        int spin = 0;
+        while ((spin < C_TASK_SPIN_COUNT) && (m_generation.load() == seen))
+        {
+            std::this_thread::yield();
+            spin++;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeLock);
+        while (m_running && (m_generation.load() == seen))
+        {
+            m_wake.wait(lock);
+        }
+        if (!m_running) { return; }
+    }
+}
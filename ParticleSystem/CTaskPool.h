@@ -0,0 +1,261 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CTaskPoolH
+#define CTaskPoolH
+//---------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CTaskPool.h
+
+    \brief
+    <b> Particles </b> \n
+    Persistent work-stealing thread pool.
+*/
+//===========================================================================
+
+//! Default number of elements per parallel-for chunk.
+const unsigned int C_TASK_GRAIN = 2048;
+
+//===========================================================================
+/*!
+    \class      cTaskPool
+    \ingroup    particles
+
+    \brief
+    cTaskPool keeps a fixed set of worker threads alive for the lifetime
+    of the simulation and runs chunked parallel-for loops on them.
+
+    Every thread, including the caller of \ref parallelFor(), owns a
+    queue of chunks. A thread takes work from the back of its own queue
+    and, once it is empty, steals from the front of the other queues,
+    so uneven chunks are rebalanced without a central scheduler. The
+    caller takes part in the work and returns when every chunk is done.
+
+    Idle workers spin briefly, then sleep until the next loop is
+    submitted. Loops may be submitted from one thread at a time and must
+    not be nested. A pool of one thread runs every loop inline.
+*/
+//===========================================================================
+class cTaskPool
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cTaskPool. Zero threads selects one per hardware core.
+    cTaskPool(const unsigned int a_numThreads = 0);
+
+    //! Destructor of cTaskPool.
+    ~cTaskPool();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Stop the workers and restart with \e a_numThreads threads (zero: one per core).
+    void setNumThreads(const unsigned int a_numThreads);
+
+    //! Number of threads running loops, the calling thread included.
+    inline unsigned int getNumThreads() const { return (m_numThreads); }
+
+    //! Run \e a_body(begin, end) over [a_first, a_last) in chunks of \e a_grain elements.
+    template <class T> void parallelFor(const unsigned int a_first,
+                                        const unsigned int a_last,
+                                        const unsigned int a_grain,
+                                        const T& a_body);
+
+    //! Number of chunks \ref parallelFor() creates for a range.
+    static inline unsigned int getNumChunks(const unsigned int a_first,
+                                            const unsigned int a_last,
+                                            const unsigned int a_grain)
+    {
+        if (a_last <= a_first) { return (1); }
+        return ((a_last - a_first + a_grain - 1) / a_grain);
+    }
+
+    //! Number of chunks taken from another thread's queue since construction.
+    inline unsigned int getNumSteals() const { return (m_numSteals.load()); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // TYPES:
+    //-----------------------------------------------------------------------
+
+    //! One chunk of a parallel loop.
+    struct cTask
+    {
+        void (*m_function)(const void*, unsigned int, unsigned int);
+        const void* m_body;
+        unsigned int m_begin;
+        unsigned int m_end;
+    };
+
+    //! Work queue owned by one thread.
+    struct cTaskQueue
+    {
+        std::mutex m_lock;
+        std::deque<cTask> m_tasks;
+    };
+
+    //! Calls the body of a loop on one chunk.
+    template <class T> static void invoke(const void* a_body,
+                                          unsigned int a_begin,
+                                          unsigned int a_end)
+    {
+        (*(const T*)a_body)(a_begin, a_end);
+    }
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Split a loop into chunks, queue them and help until all are done.
+    void run(void (*a_function)(const void*, unsigned int, unsigned int),
+             const void* a_body, const unsigned int a_first,
+             const unsigned int a_last, const unsigned int a_grain);
+
+    //! Take a chunk from the back of queue \e a_queue.
+    bool popTask(const unsigned int a_queue, cTask& a_task);
+
+    //! Take a chunk from the front of any queue but \e a_thief.
+    bool stealTask(const unsigned int a_thief, cTask& a_task);
+
+    //! Run a chunk and mark it done.
+    void execute(const cTask& a_task);
+
+    //! Main loop of worker \e a_index.
+    void workerLoop(const unsigned int a_index);
+
+    //! Start \e m_numThreads - 1 workers.
+    void start();
+
+    //! Stop and join all workers.
+    void stop();
+
+    //! Not copyable.
+    cTaskPool(const cTaskPool&);
+    cTaskPool& operator=(const cTaskPool&);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Threads running loops, the caller included.
+    unsigned int m_numThreads;
+
+    //! Worker threads (index 0 is the caller and has no thread).
+    std::vector<std::thread*> m_workers;
+
+    //! One queue per thread.
+    std::vector<cTaskQueue*> m_queues;
+
+    //! Chunks queued or running for the current loop.
+    std::atomic<unsigned int> m_pending;
+
+    //! Incremented every time a loop is submitted; wakes sleeping workers.
+    std::atomic<unsigned int> m_generation;
+
+    //! False when the workers must exit.
+    bool m_running;
+
+    //! Lock and condition on which idle workers sleep.
+    std::mutex m_wakeLock;
+    std::condition_variable m_wake;
+
+    //! Statistics.
+    std::atomic<unsigned int> m_numSteals;
+};
+
+
+//===========================================================================
+/*!
+    Run \e a_body(begin, end) over the range [a_first, a_last). The range
+    is cut into chunks of \e a_grain elements; chunk k starts at
+    a_first + k * a_grain, so bodies that keep per-chunk results can
+    recover their slot from \e begin. Ranges that fit in a single chunk,
+    and pools of one thread, call \e a_body once on the whole range.
+
+    \fn     template <class T> void cTaskPool::parallelFor(
+            const unsigned int a_first, const unsigned int a_last,
+            const unsigned int a_grain, const T& a_body)
+    \param  a_first  First element.
+    \param  a_last  One past the last element.
+    \param  a_grain  Elements per chunk.
+    \param  a_body  Functor called on each chunk.
+*/
+//===========================================================================
+template <class T> void cTaskPool::parallelFor(const unsigned int a_first,
+                                               const unsigned int a_last,
+                                               const unsigned int a_grain,
+                                               const T& a_body)
+{
+    if (a_last <= a_first) { return; }
+
+    unsigned int grain = (a_grain > 0) ? a_grain : 1;
+    if ((m_numThreads <= 1) || (a_last - a_first <= grain))
+    {
+        a_body(a_first, a_last);
+        return;
+    }
+
+    run(&invoke<T>, &a_body, a_first, a_last, grain);
+}
+
+
+//===========================================================================
+/*!
+    Run a parallel loop on \e a_pool, or inline if \e a_pool is NULL.
+
+    \fn     template <class T> void cParallelFor(cTaskPool* a_pool,
+            const unsigned int a_first, const unsigned int a_last,
+            const unsigned int a_grain, const T& a_body)
+    \param  a_pool  Pool to run on, or NULL.
+    \param  a_first  First element.
+    \param  a_last  One past the last element.
+    \param  a_grain  Elements per chunk.
+    \param  a_body  Functor called on each chunk.
+*/
+//===========================================================================
+template <class T> inline void cParallelFor(cTaskPool* a_pool,
+                                            const unsigned int a_first,
+                                            const unsigned int a_last,
+                                            const unsigned int a_grain,
+                                            const T& a_body)
+{
+    if (a_pool != NULL)
+    {
+        a_pool->parallelFor(a_first, a_last, a_grain, a_body);
+    }
+    else if (a_last > a_first)
+    {
+        a_body(a_first, a_last);
+    }
+}
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
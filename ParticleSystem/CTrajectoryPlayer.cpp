@@ -0,0 +1,448 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CTrajectoryPlayer.h"
+//---------------------------------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cTrajectoryPlayer.
+
+    \fn     cTrajectoryPlayer::cTrajectoryPlayer()
+*/
+//===========================================================================
+cTrajectoryPlayer::cTrajectoryPlayer()
+{
+    memset(&m_header, 0, sizeof(m_header));
+    m_data = NULL;
+    m_mappedSize = 0;
+    m_numFrames = 0;
+    m_firstSlot = 0;
+    m_lastFrame = 0;
+    m_prefetchedEnd = 0;
+#if defined(_WIN32)
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = NULL;
+#else
+    m_file = -1;
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cTrajectoryPlayer.
+
+    \fn     cTrajectoryPlayer::~cTrajectoryPlayer()
+*/
+//===========================================================================
+cTrajectoryPlayer::~cTrajectoryPlayer()
+{
+    close();
+}
+
+
+//===========================================================================
+/*!
+    Map \e a_filename read-only, check its header and build the time
+    index. Files left behind by a crash are accepted: only the frames
+    counted in the header and present in the file are played.
+
+    \fn     bool cTrajectoryPlayer::open(const std::string& a_filename)
+    \param  a_filename  Trajectory file.
+    \return Return true if the file holds at least one frame.
+*/
+//===========================================================================
+bool cTrajectoryPlayer::open(const std::string& a_filename)
+{
+    close();
+
+    const void* view = NULL;
+    unsigned long long size = 0;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(a_filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) { return (false); }
+
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart >= (LONGLONG)sizeof(cTrajectoryHeader)) &&
+        ((unsigned long long)fileSize.QuadPart <= (SIZE_T)-1))
+    {
+        size = (unsigned long long)fileSize.QuadPart;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    if (mapping != NULL)
+    {
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (view == NULL)
+    {
+        if (mapping != NULL) { CloseHandle(mapping); }
+        CloseHandle(file);
+        return (false);
+    }
+    m_file = file;
+    m_mapping = mapping;
+#else
+    int file = ::open(a_filename.c_str(), O_RDONLY);
+    if (file < 0) { return (false); }
+
+    struct stat status;
+    if ((fstat(file, &status) == 0) && (status.st_size >= (off_t)sizeof(cTrajectoryHeader)) &&
+        ((unsigned long long)status.st_size <= (size_t)-1))
+    {
+        size = (unsigned long long)status.st_size;
+        view = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, file, 0);
+        if (view == MAP_FAILED) { view = NULL; }
+    }
+    if (view == NULL)
+    {
+        ::close(file);
+        return (false);
+    }
+    m_file = file;
+#endif
+
+    m_data = (const char*)view;
+    m_mappedSize = size;
+    memcpy(&m_header, m_data, sizeof(m_header));
+
+    // reject files of another format or layout
+    bool valid = (memcmp(m_header.m_magic, C_TRAJECTORY_MAGIC, sizeof(C_TRAJECTORY_MAGIC)) == 0) &&
+                 (m_header.m_version == C_TRAJECTORY_VERSION) &&
+                 (m_header.m_headerSize >= sizeof(cTrajectoryHeader)) &&
+                 (m_header.m_headerSize <= size) &&
+                 (m_header.m_capacity > 0) &&
+                 (m_header.m_frameSize == cTrajectoryRecorder::getFrameSize(m_header.m_numParticles,
+                                                                             m_header.m_numParameters));
+    if (!valid)
+    {
+        close();
+        return (false);
+    }
+
+    // frames present: counted by the recorder, within the capacity and within the file
+    unsigned long long kept = (m_header.m_firstFrame < m_header.m_numFrames) ?
+                              (m_header.m_numFrames - m_header.m_firstFrame) : 0;
+    unsigned long long stored = (kept < m_header.m_capacity) ? kept : m_header.m_capacity;
+    unsigned long long inFile = (size - m_header.m_headerSize) / m_header.m_frameSize;
+    m_numFrames = (stored < inFile) ? stored : inFile;
+    m_firstSlot = (m_header.m_numFrames - stored) % m_header.m_capacity;
+    if (m_numFrames == 0)
+    {
+        close();
+        return (false);
+    }
+
+    m_index.clear();
+    m_index.reserve((size_t)(m_numFrames / C_TRAJECTORY_INDEX_STRIDE + 1));
+    for (unsigned long long k=0; k<m_numFrames; k+=C_TRAJECTORY_INDEX_STRIDE)
+    {
+        m_index.push_back(getFrameTime(k));
+    }
+
+    m_lastFrame = 0;
+    m_prefetchedEnd = 0;
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Unmap and close the file.
+
+    \fn     void cTrajectoryPlayer::close()
+*/
+//===========================================================================
+void cTrajectoryPlayer::close()
+{
+    if (m_data == NULL) { return; }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle((HANDLE)m_mapping);
+    CloseHandle((HANDLE)m_file);
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = NULL;
+#else
+    munmap((void*)m_data, (size_t)m_mappedSize);
+    ::close(m_file);
+    m_file = -1;
+#endif
+
+    m_data = NULL;
+    m_mappedSize = 0;
+    m_numFrames = 0;
+    m_index.clear();
+}
+
+
+//===========================================================================
+/*!
+    Start of a frame in the mapping.
+
+    \fn     const char* cTrajectoryPlayer::getFrame(const unsigned long long a_frame) const
+    \param  a_frame  Frame, in [0, getNumFrames()).
+    \return Return a pointer to the frame record.
+*/
+//===========================================================================
+const char* cTrajectoryPlayer::getFrame(const unsigned long long a_frame) const
+{
+    unsigned long long slot = (m_firstSlot + a_frame) % m_header.m_capacity;
+    return (m_data + m_header.m_headerSize + slot * m_header.m_frameSize);
+}
+
+
+//===========================================================================
+/*!
+    Simulated time of a frame.
+
+    \fn     double cTrajectoryPlayer::getFrameTime(const unsigned long long a_frame) const
+    \param  a_frame  Frame, in [0, getNumFrames()).
+    \return Return the time in seconds, or zero if the frame does not exist.
+*/
+//===========================================================================
+double cTrajectoryPlayer::getFrameTime(const unsigned long long a_frame) const
+{
+    if (a_frame >= m_numFrames) { return (0.0); }
+
+    double time;
+    memcpy(&time, getFrame(a_frame) + sizeof(uint64_t), sizeof(time));
+    return (time);
+}
+
+
+//===========================================================================
+/*!
+    Simulation step of a frame.
+
+    \fn     unsigned long long cTrajectoryPlayer::getFrameStep(const unsigned long long a_frame) const
+    \param  a_frame  Frame, in [0, getNumFrames()).
+    \return Return the step, or zero if the frame does not exist.
+*/
+//===========================================================================
+unsigned long long cTrajectoryPlayer::getFrameStep(const unsigned long long a_frame) const
+{
+    if (a_frame >= m_numFrames) { return (0); }
+
+    uint64_t step;
+    memcpy(&step, getFrame(a_frame), sizeof(step));
+    return (step);
+}
+
+
+//===========================================================================
+/*!
+    Find the frame on screen at time \e a_time: a binary search of the
+    sparse index gives the stride holding the time, and a binary search
+    of the frame times inside that stride gives the frame.
+
+    \fn     unsigned long long cTrajectoryPlayer::findFrame(const double a_time) const
+    \param  a_time  Simulated time [s].
+    \return Return the last frame whose time is not after \e a_time, or
+            frame 0 if \e a_time is before the recording.
+*/
+//===========================================================================
+unsigned long long cTrajectoryPlayer::findFrame(const double a_time) const
+{
+    if (m_index.empty() || (a_time <= m_index[0])) { return (0); }
+
+    // last index entry not after a_time
+    size_t lo = 0;
+    size_t hi = m_index.size();
+    while (hi - lo > 1)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (m_index[mid] <= a_time) { lo = mid; } else { hi = mid; }
+    }
+
+    // last frame not after a_time within that stride
+    unsigned long long first = (unsigned long long)lo * C_TRAJECTORY_INDEX_STRIDE;
+    unsigned long long last = first + C_TRAJECTORY_INDEX_STRIDE;
+    if (last > m_numFrames) { last = m_numFrames; }
+    while (last - first > 1)
+    {
+        unsigned long long mid = (first + last) / 2;
+        if (getFrameTime(mid) <= a_time) { first = mid; } else { last = mid; }
+    }
+    return (first);
+}
+
+
+//===========================================================================
+/*!
+    Copy the positions of a frame into a snapshot, as the simulation
+    would publish it, and prefetch the following frames.
+
+    \fn     bool cTrajectoryPlayer::readFrame(const unsigned long long a_frame,
+            cParticleSnapshot& a_snapshot)
+    \param  a_frame  Frame, in [0, getNumFrames()).
+    \param  a_snapshot  Snapshot to fill.
+    \return Return false if the frame does not exist.
+*/
+//===========================================================================
+bool cTrajectoryPlayer::readFrame(const unsigned long long a_frame, cParticleSnapshot& a_snapshot)
+{
+    if (a_frame >= m_numFrames) { return (false); }
+
+    unsigned int n = m_header.m_numParticles;
+    const char* p = getFrame(a_frame) + sizeof(uint64_t) + sizeof(double) +
+                    m_header.m_numParameters * sizeof(double);
+    const double* posX = (const double*)p;
+
+    a_snapshot.m_posX.assign(posX, posX + n);
+    a_snapshot.m_posY.assign(posX + n, posX + 2 * n);
+    a_snapshot.m_posZ.assign(posX + 2 * n, posX + 3 * n);
+    a_snapshot.m_time = getFrameTime(a_frame);
+    a_snapshot.m_step = (unsigned int)getFrameStep(a_frame);
+
+    readAhead(a_frame);
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Copy the parameters of a frame.
+
+    \fn     bool cTrajectoryPlayer::readParameters(const unsigned long long a_frame,
+            double* a_parameters) const
+    \param  a_frame  Frame, in [0, getNumFrames()).
+    \param  a_parameters  Array of \ref getNumParameters() values to fill.
+    \return Return false if the frame does not exist.
+*/
+//===========================================================================
+bool cTrajectoryPlayer::readParameters(const unsigned long long a_frame, double* a_parameters) const
+{
+    if (a_frame >= m_numFrames) { return (false); }
+
+    const char* p = getFrame(a_frame) + sizeof(uint64_t) + sizeof(double);
+    memcpy(a_parameters, p, m_header.m_numParameters * sizeof(double));
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Copy the positions and velocities of a frame into particle arrays
+    holding the same number of particles, e.g. to resume the simulation
+    from a recorded state.
+
+    \fn     bool cTrajectoryPlayer::readState(const unsigned long long a_frame,
+            cParticleArrays& a_particles)
+    \param  a_frame  Frame, in [0, getNumFrames()).
+    \param  a_particles  Particles to overwrite.
+    \return Return false if the frame does not exist or the particle count differs.
+*/
+//===========================================================================
+bool cTrajectoryPlayer::readState(const unsigned long long a_frame, cParticleArrays& a_particles)
+{
+    unsigned int n = m_header.m_numParticles;
+    if ((a_frame >= m_numFrames) || (a_particles.getNumParticles() != n)) { return (false); }
+
+    const char* p = getFrame(a_frame) + sizeof(uint64_t) + sizeof(double) +
+                    m_header.m_numParameters * sizeof(double);
+    size_t bytes = n * sizeof(double);
+    memcpy(a_particles.m_posX, p, bytes);   p += bytes;
+    memcpy(a_particles.m_posY, p, bytes);   p += bytes;
+    memcpy(a_particles.m_posZ, p, bytes);   p += bytes;
+    memcpy(a_particles.m_velX, p, bytes);   p += bytes;
+    memcpy(a_particles.m_velY, p, bytes);   p += bytes;
+    memcpy(a_particles.m_velZ, p, bytes);
+
+    readAhead(a_frame);
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Prefetch the frames after \e a_frame when playing forward, or before
+    it when playing backward. Forward hints are issued for
+    \ref C_TRAJECTORY_READ_AHEAD frames at a time, once half of the
+    previous batch has been consumed.
+
+    \fn     void cTrajectoryPlayer::readAhead(const unsigned long long a_frame)
+    \param  a_frame  Frame just read.
+*/
+//===========================================================================
+void cTrajectoryPlayer::readAhead(const unsigned long long a_frame)
+{
+    if (a_frame >= m_lastFrame)
+    {
+        if (a_frame + C_TRAJECTORY_READ_AHEAD / 2 >= m_prefetchedEnd)
+        {
+            unsigned long long end = a_frame + 1 + C_TRAJECTORY_READ_AHEAD;
+            if (end > m_numFrames) { end = m_numFrames; }
+            prefetch(a_frame + 1, end);
+            m_prefetchedEnd = end;
+        }
+    }
+    else
+    {
+        unsigned long long first = (a_frame > C_TRAJECTORY_READ_AHEAD) ? a_frame - C_TRAJECTORY_READ_AHEAD : 0;
+        prefetch(first, a_frame);
+        m_prefetchedEnd = a_frame + 1;
+    }
+    m_lastFrame = a_frame;
+}
+
+
+//===========================================================================
+/*!
+    Tell the system that the frames [a_first, a_last) will be needed
+    soon. The range is split where the ring wraps around.
+
+    \fn     void cTrajectoryPlayer::prefetch(const unsigned long long a_first,
+            const unsigned long long a_last) const
+    \param  a_first  First frame.
+    \param  a_last  Frame after the last one.
+*/
+//===========================================================================
+void cTrajectoryPlayer::prefetch(const unsigned long long a_first, const unsigned long long a_last) const
+{
+#if !defined(_WIN32)
+    static const uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+
+    unsigned long long frame = a_first;
+    while (frame < a_last)
+    {
+        // contiguous slots up to the end of the range or of the ring
+        unsigned long long slot = (m_firstSlot + frame) % m_header.m_capacity;
+        unsigned long long count = a_last - frame;
+        if (slot + count > m_header.m_capacity) { count = m_header.m_capacity - slot; }
+
+        uintptr_t begin = (uintptr_t)getFrame(frame);
+        uintptr_t end = begin + (uintptr_t)(count * m_header.m_frameSize);
+        begin -= begin % pageSize;
+        posix_madvise((void*)begin, (size_t)(end - begin), POSIX_MADV_WILLNEED);
+
+        frame += count;
+    }
+#else
+    (void)a_first;
+    (void)a_last;
+#endif
+}
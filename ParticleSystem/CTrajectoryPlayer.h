@@ -0,0 +1,178 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CTrajectoryPlayerH
+#define CTrajectoryPlayerH
+//---------------------------------------------------------------------------
+#include "CTrajectoryRecorder.h"
+#include "CParticleSimulation.h"
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CTrajectoryPlayer.h
+
+    \brief
+    <b> Particles </b> \n
+    Random-access playback of trajectory files.
+*/
+//===========================================================================
+
+//! Frames between two entries of the time index of \ref cTrajectoryPlayer.
+const unsigned int C_TRAJECTORY_INDEX_STRIDE = 256;
+
+//! Frames hinted to the operating system ahead of the playback position.
+const unsigned int C_TRAJECTORY_READ_AHEAD = 64;
+
+//===========================================================================
+/*!
+    \class      cTrajectoryPlayer
+    \ingroup    particles
+
+    \brief
+    cTrajectoryPlayer reads back the files written by
+    \ref cTrajectoryRecorder. Frames are numbered from 0, the oldest
+    frame still in the file (for a ring that wrapped, the frame written
+    right after the newest one), to \ref getNumFrames() - 1.
+
+    The file is mapped read-only and never loaded as a whole: the
+    operating system pages frames in on demand and drops them under
+    memory pressure, so files larger than RAM play back on a 64-bit
+    system. After each read the player asks the system to prefetch the
+    next frames in the direction of playback (posix_madvise; on Windows
+    the memory manager's own read-ahead of mapped files is relied on).
+
+    Because frames have a fixed size, frame \e k is found with one
+    multiplication. Finding the frame at a given time uses a sparse
+    index of the time of every \ref C_TRAJECTORY_INDEX_STRIDE th frame,
+    built at \ref open() with one small read per entry, followed by a
+    binary search of at most eight frame times inside one stride, so
+    seeking costs the same anywhere in the file whether the recording
+    used a fixed timestep or not.
+
+    A player must be used from one thread.
+*/
+//===========================================================================
+class cTrajectoryPlayer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cTrajectoryPlayer.
+    cTrajectoryPlayer();
+
+    //! Destructor of cTrajectoryPlayer. Closes the file.
+    ~cTrajectoryPlayer();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Map a trajectory file and build its time index.
+    bool open(const std::string& a_filename);
+
+    //! Unmap and close the file.
+    void close();
+
+    //! True while a file is open.
+    inline bool isOpen() const { return (m_data != NULL); }
+
+    //! Number of frames that can be played.
+    inline unsigned long long getNumFrames() const { return (m_numFrames); }
+
+    //! Particles per frame.
+    inline unsigned int getNumParticles() const { return (m_header.m_numParticles); }
+
+    //! Parameters per frame.
+    inline unsigned int getNumParameters() const { return (m_header.m_numParameters); }
+
+    //! Simulated time of frame \e a_frame [s].
+    double getFrameTime(const unsigned long long a_frame) const;
+
+    //! Simulation step of frame \e a_frame.
+    unsigned long long getFrameStep(const unsigned long long a_frame) const;
+
+    //! Last frame recorded at or before \e a_time (the first frame if earlier).
+    unsigned long long findFrame(const double a_time) const;
+
+    //! Copy the positions, time and step of frame \e a_frame into \e a_snapshot.
+    bool readFrame(const unsigned long long a_frame, cParticleSnapshot& a_snapshot);
+
+    //! Copy the parameters of frame \e a_frame into \e a_parameters.
+    bool readParameters(const unsigned long long a_frame, double* a_parameters) const;
+
+    //! Copy the positions and velocities of frame \e a_frame into \e a_particles.
+    bool readState(const unsigned long long a_frame, cParticleArrays& a_particles);
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Start of frame \e a_frame in the mapping.
+    const char* getFrame(const unsigned long long a_frame) const;
+
+    //! Ask the system to load the frames following \e a_frame in the playback direction.
+    void readAhead(const unsigned long long a_frame);
+
+    //! Hint the frames [a_first, a_last) to the system.
+    void prefetch(const unsigned long long a_first, const unsigned long long a_last) const;
+
+    //! Not copyable.
+    cTrajectoryPlayer(const cTrajectoryPlayer&);
+    cTrajectoryPlayer& operator=(const cTrajectoryPlayer&);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Copy of the file header.
+    cTrajectoryHeader m_header;
+
+    //! Start of the mapping, NULL when closed.
+    const char* m_data;
+
+    //! Size of the mapping in bytes.
+    unsigned long long m_mappedSize;
+
+    //! Number of playable frames, and slot of frame 0.
+    unsigned long long m_numFrames;
+    unsigned long long m_firstSlot;
+
+    //! Time of every \ref C_TRAJECTORY_INDEX_STRIDE th frame.
+    std::vector<double> m_index;
+
+    //! Last frame read, and the end of the range already prefetched.
+    unsigned long long m_lastFrame;
+    unsigned long long m_prefetchedEnd;
+
+#if defined(_WIN32)
+    //! File and mapping handles.
+    void* m_file;
+    void* m_mapping;
+#else
+    //! File descriptor.
+    int m_file;
+#endif
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
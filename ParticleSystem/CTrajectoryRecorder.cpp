@@ -0,0 +1,332 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CTrajectoryRecorder.h"
+//---------------------------------------------------------------------------
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Constructor of cTrajectoryRecorder.
+
+    \fn     cTrajectoryRecorder::cTrajectoryRecorder()
+*/
+//===========================================================================
+cTrajectoryRecorder::cTrajectoryRecorder()
+{
+    m_header = NULL;
+    m_mappedSize = 0;
+#if defined(_WIN32)
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = NULL;
+#else
+    m_file = -1;
+#endif
+}
+
+
+//===========================================================================
+/*!
+    Destructor of cTrajectoryRecorder.
+
+    \fn     cTrajectoryRecorder::~cTrajectoryRecorder()
+*/
+//===========================================================================
+cTrajectoryRecorder::~cTrajectoryRecorder()
+{
+    close();
+}
+
+
+//===========================================================================
+/*!
+    Size of one frame slot.
+
+    \fn     unsigned long long cTrajectoryRecorder::getFrameSize(const unsigned int a_numParticles,
+            const unsigned int a_numParameters)
+    \param  a_numParticles  Particles per frame.
+    \param  a_numParameters  Parameters per frame.
+    \return Return the size in bytes.
+*/
+//===========================================================================
+unsigned long long cTrajectoryRecorder::getFrameSize(const unsigned int a_numParticles,
+                                                     const unsigned int a_numParameters)
+{
+    return (sizeof(uint64_t) + sizeof(double) +
+            (unsigned long long)a_numParameters * sizeof(double) +
+            6ULL * a_numParticles * sizeof(double));
+}
+
+
+//===========================================================================
+/*!
+    Create (or overwrite) \e a_filename with room for \e a_capacity
+    frames, reserve the disk space and map the whole file into memory.
+    This is the only slow call of the recorder; open the file before the
+    time-critical part of a run.
+
+    \fn     bool cTrajectoryRecorder::open(const std::string& a_filename,
+            const unsigned int a_numParticles, const unsigned int a_numParameters,
+            const unsigned long long a_capacity, const bool a_ring)
+    \param  a_filename  File to create.
+    \param  a_numParticles  Particles per frame.
+    \param  a_numParameters  Parameters per frame.
+    \param  a_capacity  Number of frame slots.
+    \param  a_ring  Overwrite the oldest frames when full instead of stopping.
+    \return Return true if the file is ready for recording.
+*/
+//===========================================================================
+bool cTrajectoryRecorder::open(const std::string& a_filename, const unsigned int a_numParticles,
+                               const unsigned int a_numParameters,
+                               const unsigned long long a_capacity, const bool a_ring)
+{
+    close();
+    if (a_capacity == 0) { return (false); }
+
+    unsigned long long frameSize = getFrameSize(a_numParticles, a_numParameters);
+    unsigned long long size = sizeof(cTrajectoryHeader) + a_capacity * frameSize;
+    void* view = NULL;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(a_filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                              NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) { return (false); }
+
+    // the mapping extends the file to its full size
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                        (DWORD)(size >> 32), (DWORD)(size & 0xffffffffULL), NULL);
+    if (mapping != NULL)
+    {
+        view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)size);
+    }
+    if (view == NULL)
+    {
+        if (mapping != NULL) { CloseHandle(mapping); }
+        CloseHandle(file);
+        DeleteFileA(a_filename.c_str());
+        return (false);
+    }
+    m_file = file;
+    m_mapping = mapping;
+#else
+    int file = ::open(a_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) { return (false); }
+
+    bool ok = (ftruncate(file, (off_t)size) == 0);
+#if defined(__linux__)
+    // allocate the blocks now: writing a page of a sparse file on a full disk raises SIGBUS
+    ok = ok && (posix_fallocate(file, 0, (off_t)size) == 0);
+#endif
+    if (ok)
+    {
+        int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+        // fault every page in now rather than on the first write of each frame
+        flags |= MAP_POPULATE;
+#endif
+        view = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, flags, file, 0);
+        if (view == MAP_FAILED) { view = NULL; }
+    }
+    if (view == NULL)
+    {
+        ::close(file);
+        unlink(a_filename.c_str());
+        return (false);
+    }
+    m_file = file;
+#endif
+
+    m_filename = a_filename;
+    m_mappedSize = size;
+    m_header = (cTrajectoryHeader*)view;
+
+    memset(m_header, 0, sizeof(cTrajectoryHeader));
+    memcpy(m_header->m_magic, C_TRAJECTORY_MAGIC, sizeof(C_TRAJECTORY_MAGIC));
+    m_header->m_version = C_TRAJECTORY_VERSION;
+    m_header->m_headerSize = sizeof(cTrajectoryHeader);
+    m_header->m_numParticles = a_numParticles;
+    m_header->m_numParameters = a_numParameters;
+    m_header->m_frameSize = frameSize;
+    m_header->m_capacity = a_capacity;
+    m_header->m_numFrames = 0;
+    m_header->m_firstFrame = 0;
+    m_header->m_flags = a_ring ? C_TRAJECTORY_RING : 0;
+
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Unmap and close the file. In append mode the unused slots at the end
+    of the file are cut off.
+
+    \fn     void cTrajectoryRecorder::close()
+*/
+//===========================================================================
+void cTrajectoryRecorder::close()
+{
+    if (m_header == NULL) { return; }
+
+    unsigned long long size = m_mappedSize;
+    if ((m_header->m_flags & C_TRAJECTORY_RING) == 0)
+    {
+        size = m_header->m_headerSize + m_header->m_numFrames * m_header->m_frameSize;
+    }
+    else if ((m_header->m_numFrames < m_header->m_capacity) && (m_header->m_firstFrame == 0))
+    {
+        // a ring that never wrapped holds exactly the frames written
+        m_header->m_capacity = (m_header->m_numFrames > 0) ? m_header->m_numFrames : 1;
+        size = m_header->m_headerSize + m_header->m_capacity * m_header->m_frameSize;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_header);
+    CloseHandle((HANDLE)m_mapping);
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG)size;
+    if (SetFilePointerEx((HANDLE)m_file, end, NULL, FILE_BEGIN))
+    {
+        SetEndOfFile((HANDLE)m_file);
+    }
+    CloseHandle((HANDLE)m_file);
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = NULL;
+#else
+    munmap(m_header, (size_t)m_mappedSize);
+    if (ftruncate(m_file, (off_t)size) != 0) { /* the file keeps its unused slots */ }
+    ::close(m_file);
+    m_file = -1;
+#endif
+
+    m_header = NULL;
+    m_mappedSize = 0;
+}
+
+
+//===========================================================================
+/*!
+    Copy the current state into the next frame slot. The frame counter
+    of the header is advanced last, so a reader of a file left behind by
+    a crash only sees complete frames.
+
+    \fn     bool cTrajectoryRecorder::record(const cParticleArrays& a_particles,
+            const double a_time, const unsigned long long a_step,
+            const double* a_parameters)
+    \param  a_particles  Particles to record.
+    \param  a_time  Simulated time [s].
+    \param  a_step  Simulation step.
+    \param  a_parameters  Parameters of the frame (as many as given to \ref open()).
+    \return Return true if the frame was recorded.
+*/
+//===========================================================================
+bool cTrajectoryRecorder::record(const cParticleArrays& a_particles, const double a_time,
+                                 const unsigned long long a_step, const double* a_parameters)
+{
+    if (m_header == NULL) { return (false); }
+
+    unsigned int n = m_header->m_numParticles;
+    if (a_particles.getNumParticles() != n) { return (false); }
+
+    unsigned long long frame = m_header->m_numFrames;
+    bool ring = ((m_header->m_flags & C_TRAJECTORY_RING) != 0);
+    if (!ring && (frame >= m_header->m_capacity)) { return (false); }
+
+    unsigned long long slot = frame % m_header->m_capacity;
+    char* p = (char*)m_header + m_header->m_headerSize + slot * m_header->m_frameSize;
+
+    uint64_t step = a_step;
+    memcpy(p, &step, sizeof(step));                     p += sizeof(step);
+    memcpy(p, &a_time, sizeof(a_time));                 p += sizeof(a_time);
+
+    size_t parameterBytes = m_header->m_numParameters * sizeof(double);
+    if (parameterBytes > 0)
+    {
+        memcpy(p, a_parameters, parameterBytes);        p += parameterBytes;
+    }
+
+    size_t bytes = n * sizeof(double);
+    memcpy(p, a_particles.m_posX, bytes);               p += bytes;
+    memcpy(p, a_particles.m_posY, bytes);               p += bytes;
+    memcpy(p, a_particles.m_posZ, bytes);               p += bytes;
+    memcpy(p, a_particles.m_velX, bytes);               p += bytes;
+    memcpy(p, a_particles.m_velY, bytes);               p += bytes;
+    memcpy(p, a_particles.m_velZ, bytes);
+
+    m_header->m_numFrames = frame + 1;
+    return (true);
+}
+
+
+//===========================================================================
+/*!
+    Simulated time of a frame still held in its slot.
+
+    \fn     double cTrajectoryRecorder::getFrameTime(const unsigned long long a_frame) const
+    \param  a_frame  Frame, counting from zero since \ref open().
+    \return Return the time in seconds.
+*/
+//===========================================================================
+double cTrajectoryRecorder::getFrameTime(const unsigned long long a_frame) const
+{
+    unsigned long long slot = a_frame % m_header->m_capacity;
+    const char* p = (const char*)m_header + m_header->m_headerSize + slot * m_header->m_frameSize;
+    double time;
+    memcpy(&time, p + sizeof(uint64_t), sizeof(time));
+    return (time);
+}
+
+
+//===========================================================================
+/*!
+    Drop the frames recorded after \e a_time. After a restart, a restore
+    or a rewind, this removes the frames of the abandoned future so that
+    the file stays in time order and the next frame continues from the
+    restored state. In ring mode the slots of the dropped frames are
+    reused; frames already overwritten by the dropped ones are lost too.
+
+    \fn     void cTrajectoryRecorder::truncate(const double a_time)
+    \param  a_time  Simulated time of the restored state [s].
+*/
+//===========================================================================
+void cTrajectoryRecorder::truncate(const double a_time)
+{
+    if (m_header == NULL) { return; }
+
+    // frames still in their slot, in time order
+    unsigned long long end = m_header->m_numFrames;
+    unsigned long long begin = m_header->m_firstFrame;
+    if (end - begin > m_header->m_capacity) { begin = end - m_header->m_capacity; }
+
+    // keep the frames up to a_time
+    unsigned long long lo = begin;
+    unsigned long long hi = end;
+    while (lo < hi)
+    {
+        unsigned long long mid = lo + (hi - lo) / 2;
+        if (getFrameTime(mid) <= a_time) { lo = mid + 1; }
+        else { hi = mid; }
+    }
+    if (lo == end) { return; }
+
+    // the start moves first, so a reader never takes a dropped slot for a valid frame
+    m_header->m_firstFrame = begin;
+    m_header->m_numFrames = lo;
+}
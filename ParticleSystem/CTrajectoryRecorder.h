@@ -0,0 +1,218 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CTrajectoryRecorderH
+#define CTrajectoryRecorderH
+//---------------------------------------------------------------------------
+#include "CParticleArrays.h"
+#include <stdint.h>
+#include <string>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CTrajectoryRecorder.h
+
+    \brief
+    <b> Particles </b> \n
+    Memory-mapped binary recording of particle trajectories.
+*/
+//===========================================================================
+
+//! Magic number at the start of every trajectory file.
+const char C_TRAJECTORY_MAGIC[8] = { 'P', 'T', 'R', 'A', 'J', 'E', 'C', 'T' };
+
+//! Version of the trajectory file layout.
+const uint32_t C_TRAJECTORY_VERSION = 2;
+
+//! Flag of \ref cTrajectoryHeader: frames wrap around and overwrite the oldest.
+const uint32_t C_TRAJECTORY_RING = 1;
+
+//===========================================================================
+/*!
+    \struct     cTrajectoryHeader
+    \ingroup    particles
+
+    \brief
+    First 64 bytes of a trajectory file, in the byte order of the
+    machine that wrote it. The header is followed by \e m_capacity
+    frame slots of \e m_frameSize bytes each. A frame holds, in order:
+
+    \code
+    uint64_t step;                      // simulation step
+    double   time;                      // simulated time [s]
+    double   parameters[numParameters];
+    double   posX[numParticles], posY[numParticles], posZ[numParticles];
+    double   velX[numParticles], velY[numParticles], velZ[numParticles];
+    \endcode
+
+    Frame \e k (counting from zero since the recording started) is
+    stored in slot \e k modulo \e m_capacity. Without the ring flag at
+    most \e m_capacity frames are written; with it, the file holds the
+    last \e m_capacity frames. Frames before \e m_firstFrame were
+    discarded by \ref cTrajectoryRecorder::truncate() and are never
+    played, even where their slot was not overwritten yet.
+*/
+//===========================================================================
+struct cTrajectoryHeader
+{
+    //! \ref C_TRAJECTORY_MAGIC.
+    char m_magic[8];
+
+    //! \ref C_TRAJECTORY_VERSION.
+    uint32_t m_version;
+
+    //! Size of this header in bytes (offset of the first slot).
+    uint32_t m_headerSize;
+
+    //! Particles and parameters per frame.
+    uint32_t m_numParticles;
+    uint32_t m_numParameters;
+
+    //! Size of one frame slot in bytes.
+    uint64_t m_frameSize;
+
+    //! Number of frame slots in the file.
+    uint64_t m_capacity;
+
+    //! Number of frames recorded, including those overwritten in ring mode.
+    uint64_t m_numFrames;
+
+    //! First frame still valid after a \ref cTrajectoryRecorder::truncate(), zero otherwise.
+    uint64_t m_firstFrame;
+
+    //! \ref C_TRAJECTORY_RING or zero.
+    uint32_t m_flags;
+
+    //! Reserved, zero.
+    uint32_t m_reserved;
+};
+
+//===========================================================================
+/*!
+    \class      cTrajectoryRecorder
+    \ingroup    particles
+
+    \brief
+    cTrajectoryRecorder writes the positions and velocities of every
+    particle, with a few scalar parameters, into a file of fixed size
+    that is created and mapped into memory by \ref open(). Recording a
+    frame is then a handful of memcpy calls into the mapping: no system
+    call, no allocation and no formatting happens on the simulation
+    thread, and the operating system writes the pages back in the
+    background. The disk space is reserved at \ref open() so that a full
+    disk cannot fault a later write.
+
+    In append mode the recording stops when the file is full and
+    \ref close() trims the file to the frames written. In ring mode the
+    file keeps the most recent frames, like a flight recorder, which is
+    the mode to use for long interactive sessions.
+
+    The frames of a file are in time order, which the player relies on
+    to seek. When the simulation clock jumps back (restart, restore or
+    rewind), call \ref truncate() with the new time before recording
+    the next frame.
+
+    A recorder must be opened, fed and closed from one thread, normally
+    the thread that steps the simulation.
+*/
+//===========================================================================
+class cTrajectoryRecorder
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cTrajectoryRecorder.
+    cTrajectoryRecorder();
+
+    //! Destructor of cTrajectoryRecorder. Closes the file.
+    ~cTrajectoryRecorder();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Create and map a file of \e a_capacity frames.
+    bool open(const std::string& a_filename, const unsigned int a_numParticles,
+              const unsigned int a_numParameters, const unsigned long long a_capacity,
+              const bool a_ring);
+
+    //! Unmap and close the file.
+    void close();
+
+    //! Append one frame. Returns false if closed, full or the particle count differs.
+    bool record(const cParticleArrays& a_particles, const double a_time,
+                const unsigned long long a_step, const double* a_parameters);
+
+    //! Drop the frames recorded after \e a_time, so that the recording follows a rewind.
+    void truncate(const double a_time);
+
+    //! True while a file is open.
+    inline bool isOpen() const { return (m_header != NULL); }
+
+    //! Name of the open file.
+    inline const std::string& getFilename() const { return (m_filename); }
+
+    //! Number of frames recorded since \ref open().
+    inline unsigned long long getNumFrames() const { return ((m_header != NULL) ? m_header->m_numFrames : 0); }
+
+    //! Number of frame slots in the file.
+    inline unsigned long long getCapacity() const { return ((m_header != NULL) ? m_header->m_capacity : 0); }
+
+    //! Size of one frame in bytes for \e a_numParticles and \e a_numParameters.
+    static unsigned long long getFrameSize(const unsigned int a_numParticles,
+                                           const unsigned int a_numParameters);
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Not copyable.
+    cTrajectoryRecorder(const cTrajectoryRecorder&);
+    cTrajectoryRecorder& operator=(const cTrajectoryRecorder&);
+
+    //! Simulated time of a frame still held in its slot.
+    double getFrameTime(const unsigned long long a_frame) const;
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Name of the open file.
+    std::string m_filename;
+
+    //! Start of the mapping (the header), NULL when closed.
+    cTrajectoryHeader* m_header;
+
+    //! Size of the mapping in bytes.
+    unsigned long long m_mappedSize;
+
+#if defined(_WIN32)
+    //! File and mapping handles.
+    void* m_file;
+    void* m_mapping;
+#else
+    //! File descriptor.
+    int m_file;
+#endif
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
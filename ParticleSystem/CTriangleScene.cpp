@@ -0,0 +1,102 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CTriangleScene.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    Fill an empty simulation with the scene of the interactive demo:
+    three particles connected pairwise by springs, falling under gravity
+    onto a 2 x 2 square at z = -0.5, and colliding with each other. The
+    particles are created at their fixed start positions.
+
+    \fn     void cBuildTriangleScene(cParticleSimulation& a_simulation,
+            const cTriangleSceneParameters& a_parameters)
+    \param  a_simulation  Simulation to fill.
+    \param  a_parameters  Physical parameters.
+*/
+//===========================================================================
+void cBuildTriangleScene(cParticleSimulation& a_simulation,
+                         const cTriangleSceneParameters& a_parameters)
+{
+    // the particles collide with a square of half size 1
+    double planePoint[3] = { 0, 0, -0.5 };
+    double planeNormal[3] = { 0, 0, 1 };
+    double planeTangent[3] = { 1, 0, 0 };
+    a_simulation.m_contacts.addBoundedPlane(planePoint, planeNormal, planeTangent,
+                                            1.0, 1.0, 0.05, a_parameters.m_restitution);
+    a_simulation.m_particleRadius = 0.05;
+
+    // the particles also bounce off each other
+    a_simulation.m_collideParticles = true;
+    a_simulation.m_particleRestitution = a_parameters.m_restitution;
+
+    cParticleArrays& particles = a_simulation.m_particles;
+    particles.reserve(C_TRIANGLE_SCENE_PARTICLES);
+    for (unsigned int k=0; k<C_TRIANGLE_SCENE_PARTICLES; k++)
+    {
+        particles.addParticle(0, 0, 0, a_parameters.m_mass);
+    }
+
+    // connect every pair of particles with a spring
+    cSpringTable& springs = a_simulation.m_springs;
+    springs.reserve(C_TRIANGLE_SCENE_SPRINGS);
+    springs.addSpring(0, 1, a_parameters.m_restLength, a_parameters.m_stiffness);
+    springs.addSpring(0, 2, a_parameters.m_restLength, a_parameters.m_stiffness);
+    springs.addSpring(1, 2, a_parameters.m_restLength, a_parameters.m_stiffness);
+    springs.sortForLocality();
+    springs.colorSprings();
+
+    // gravity is applied as a constant force, as in the original demo
+    a_simulation.m_externalForce[0] = 0.0;
+    a_simulation.m_externalForce[1] = 0.0;
+    a_simulation.m_externalForce[2] = -9.8;
+    a_simulation.m_dragCoefficient = a_parameters.m_drag;
+
+    cPlaceTriangleScene(a_simulation, false);
+}
+
+
+//===========================================================================
+/*!
+    Stop every particle and move it to its start position: a fixed
+    triangle at z = 0.5, or random positions over the square at the same
+    height, drawn from the simulation's own generator.
+
+    \fn     void cPlaceTriangleScene(cParticleSimulation& a_simulation,
+            const bool a_random)
+    \param  a_simulation  Simulation built by \ref cBuildTriangleScene().
+    \param  a_random  Use random horizontal positions.
+*/
+//===========================================================================
+void cPlaceTriangleScene(cParticleSimulation& a_simulation, const bool a_random)
+{
+    cParticleArrays& particles = a_simulation.m_particles;
+    particles.clearVelocities();
+    a_simulation.resetIntegrator();
+
+    if (a_random)
+    {
+        for (unsigned int k=0; k<C_TRIANGLE_SCENE_PARTICLES; k++)
+        {
+            particles.m_posX[k] = a_simulation.m_random.nextDouble(-0.7, 0.7);
+            particles.m_posY[k] = a_simulation.m_random.nextDouble(-0.7, 0.7);
+            particles.m_posZ[k] = 0.5;
+        }
+    }
+    else
+    {
+        particles.m_posX[0] = -0.5; particles.m_posY[0] = 0.0;  particles.m_posZ[0] = 0.5;
+        particles.m_posX[1] = 0.0;  particles.m_posY[1] = 0.4;  particles.m_posZ[1] = 0.5;
+        particles.m_posX[2] = 0.0;  particles.m_posY[2] = -0.3; particles.m_posZ[2] = 0.5;
+    }
+}
@@ -0,0 +1,78 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CTriangleSceneH
+#define CTriangleSceneH
+//---------------------------------------------------------------------------
+#include "CParticleSimulation.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CTriangleScene.h
+
+    \brief
+    <b> Particles </b> \n
+    The three particle scene of the interactive demo, shared with the
+    headless tools.
+*/
+//===========================================================================
+
+//! Number of particles and springs of the triangle scene.
+const unsigned int C_TRIANGLE_SCENE_PARTICLES = 3;
+const unsigned int C_TRIANGLE_SCENE_SPRINGS = 3;
+
+//===========================================================================
+/*!
+    \struct     cTriangleSceneParameters
+    \ingroup    particles
+
+    \brief
+    Physical parameters of the triangle scene. The defaults are those of
+    the interactive demo.
+*/
+//===========================================================================
+struct cTriangleSceneParameters
+{
+    //! Mass of each particle [kg].
+    double m_mass;
+
+    //! Rest length of each spring [m].
+    double m_restLength;
+
+    //! Stiffness of each spring [N/m].
+    double m_stiffness;
+
+    //! Restitution of the ground and of particle-particle impacts.
+    double m_restitution;
+
+    //! Linear drag rate [1/s].
+    double m_drag;
+
+    //! Constructor of cTriangleSceneParameters.
+    cTriangleSceneParameters() : m_mass(10.0), m_restLength(0.5), m_stiffness(100.0),
+                                 m_restitution(0.9), m_drag(0.6) {}
+};
+
+//---------------------------------------------------------------------------
+// GLOBAL FUNCTIONS
+//---------------------------------------------------------------------------
+
+//! Fill an empty simulation with three particles joined by springs above a square.
+void cBuildTriangleScene(cParticleSimulation& a_simulation,
+                         const cTriangleSceneParameters& a_parameters);
+
+//! Put the particles of the triangle scene back at rest at their start positions.
+void cPlaceTriangleScene(cParticleSimulation& a_simulation, const bool a_random);
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
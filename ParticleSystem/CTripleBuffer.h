@@ -0,0 +1,119 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CTripleBufferH
+#define CTripleBufferH
+//---------------------------------------------------------------------------
+#include <atomic>
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CTripleBuffer.h
+
+    \brief
+    <b> Particles </b> \n
+    Lock-free single producer, single consumer triple buffer.
+*/
+//===========================================================================
+
+//! Flag set in the shared slot when it holds a frame the reader has not taken.
+const unsigned int C_TRIPLE_BUFFER_NEW = 4;
+
+//! Mask extracting the buffer index from the shared slot.
+const unsigned int C_TRIPLE_BUFFER_INDEX = 3;
+
+//===========================================================================
+/*!
+    \class      cTripleBuffer
+    \ingroup    particles
+
+    \brief
+    cTripleBuffer hands complete frames from one writer thread to one
+    reader thread without locks. Of the three buffers, one belongs to
+    the writer, one to the reader, and one is shared. Publishing swaps
+    the writer's buffer with the shared one; the reader swaps its buffer
+    with the shared one only when a new frame was published since it
+    last looked. Each swap is a single atomic exchange, so neither side
+    ever waits, and the reader always sees the newest complete frame:
+    a frame is never visible while it is being written.
+
+    Frames published faster than they are read are skipped. The writer
+    and reader indices are padded onto separate cache lines so that the two
+    threads do not share lines outside of the exchanges.
+*/
+//===========================================================================
+template <class T> class cTripleBuffer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cTripleBuffer.
+    cTripleBuffer() : m_writeIndex(0), m_shared(1), m_readIndex(2) {}
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Buffer the writer fills. Writer thread only.
+    inline T& getWriteBuffer() { return (m_buffers[m_writeIndex]); }
+
+    //! Make the write buffer the newest frame and take a free buffer to write next. Writer thread only.
+    inline void publish()
+    {
+        m_writeIndex = m_shared.exchange(m_writeIndex | C_TRIPLE_BUFFER_NEW,
+                                         std::memory_order_acq_rel) & C_TRIPLE_BUFFER_INDEX;
+    }
+
+    //! Take the newest frame if one was published; returns __true__ if the read buffer changed. Reader thread only.
+    inline bool update()
+    {
+        if ((m_shared.load(std::memory_order_acquire) & C_TRIPLE_BUFFER_NEW) == 0) { return (false); }
+        m_readIndex = m_shared.exchange(m_readIndex, std::memory_order_acq_rel) & C_TRIPLE_BUFFER_INDEX;
+        return (true);
+    }
+
+    //! Frame the reader currently holds. Reader thread only.
+    inline const T& getReadBuffer() const { return (m_buffers[m_readIndex]); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! The three frames.
+    T m_buffers[3];
+
+    //! Buffer owned by the writer.
+    unsigned int m_writeIndex;
+    char m_padWrite[64];
+
+    //! Buffer owned by neither side, plus the \ref C_TRIPLE_BUFFER_NEW flag.
+    std::atomic<unsigned int> m_shared;
+    char m_padShared[64];
+
+    //! Buffer owned by the reader.
+    unsigned int m_readIndex;
+
+    //! Not copyable.
+    cTripleBuffer(const cTripleBuffer&);
+    cTripleBuffer& operator=(const cTripleBuffer&);
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
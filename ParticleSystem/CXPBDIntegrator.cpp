@@ -0,0 +1,371 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include "CXPBDIntegrator.h"
+//---------------------------------------------------------------------------
+#include <math.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// LOCAL HELPERS
+//---------------------------------------------------------------------------
+
+// springs per chunk of a parallel color; a projection costs about as much
+// as a spring force, so chunks are as large as those of the force pass
+static const unsigned int C_XPBD_GRAIN = C_TASK_GRAIN;
+
+//===========================================================================
+/*!
+    Constructor of cXPBDIntegrator. Steps take four iterations and the
+    compliance of each spring is the inverse of its stiffness.
+
+    \fn     cXPBDIntegrator::cXPBDIntegrator()
+*/
+//===========================================================================
+cXPBDIntegrator::cXPBDIntegrator()
+{
+    m_numIterations = 4;
+    m_compliance = -1.0;
+    m_lastError = 0.0;
+    m_numContacts = 0;
+}
+
+
+//===========================================================================
+/*!
+    XPBD step: predict, project the constraints, update the velocities.
+    Without springs or planes in the force model, the step reduces to
+    symplectic Euler.
+
+    \fn     void cXPBDIntegrator::integrate(cParticleForceModel& a_model,
+            cParticleArrays& a_particles, const double a_dt)
+    \param  a_model  Force model.
+    \param  a_particles  Particles to advance.
+    \param  a_dt  Timestep in seconds.
+*/
+//===========================================================================
+void cXPBDIntegrator::integrate(cParticleForceModel& a_model,
+                                cParticleArrays& a_particles,
+                                const double a_dt)
+{
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    double* vx = a_particles.m_velX;
+    double* vy = a_particles.m_velY;
+    double* vz = a_particles.m_velZ;
+    const double* fx = a_particles.m_forceX;
+    const double* fy = a_particles.m_forceY;
+    const double* fz = a_particles.m_forceZ;
+    const double* w = a_particles.m_invMass;
+    unsigned int n = a_particles.getNumParticles();
+    if ((n == 0) || (a_dt <= 0.0)) { return; }
+
+    const cSpringTable* springs = a_model.getImplicitSprings();
+    const cParticleContacts* contacts = a_model.getContactShapes();
+    double radius = a_model.getContactRadius();
+
+    m_posX.resize(n);
+    m_posY.resize(n);
+    m_posZ.resize(n);
+    m_contactShape.assign(n, 0);
+    double* px0 = &m_posX[0];
+    double* py0 = &m_posY[0];
+    double* pz0 = &m_posZ[0];
+
+    // forces other than the springs, then the predicted positions
+    a_model.computeExternalForces(a_particles);
+
+    cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int i=a_begin; i<a_end; i++)
+        {
+            px0[i] = px[i];
+            py0[i] = py[i];
+            pz0[i] = pz[i];
+            vx[i] += a_dt * w[i] * fx[i];
+            vy[i] += a_dt * w[i] * fy[i];
+            vz[i] += a_dt * w[i] * fz[i];
+            px[i] += a_dt * vx[i];
+            py[i] += a_dt * vy[i];
+            pz[i] += a_dt * vz[i];
+        }
+    });
+
+    // constraint projection, multipliers start from zero every step
+    unsigned int numSprings = (springs != NULL) ? springs->getNumSprings() : 0;
+    m_lambda.assign(numSprings, 0.0);
+    m_lastError = 0.0;
+
+    for (unsigned int k=0; k<m_numIterations; k++)
+    {
+        if (numSprings > 0)
+        {
+            m_lastError = projectSprings(*springs, a_particles, a_dt);
+        }
+        if (contacts != NULL)
+        {
+            projectPlanes(*contacts, radius, a_particles);
+        }
+    }
+
+    // velocities from the displacement; planes reflect and rub the particles they hold
+    cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+    {
+        for (unsigned int i=a_begin; i<a_end; i++)
+        {
+            if (w[i] <= 0.0) { continue; }
+
+            double ux = (px[i] - px0[i]) / a_dt;
+            double uy = (py[i] - py0[i]) / a_dt;
+            double uz = (pz[i] - pz0[i]) / a_dt;
+
+            if (m_contactShape[i] > 0)
+            {
+                const cContactShape& shape = contacts->getShape(m_contactShape[i] - 1);
+                const double* normal = shape.m_normal;
+
+                // normal velocity before the projection, and after it; impacts
+                // slower than what the forces add in two steps are resting
+                // contacts, which must not bounce
+                double vn0 = vx[i]*normal[0] + vy[i]*normal[1] + vz[i]*normal[2];
+                double vn = ux*normal[0] + uy*normal[1] + uz*normal[2];
+                double an = w[i] * (fx[i]*normal[0] + fy[i]*normal[1] + fz[i]*normal[2]);
+                bool impact = (vn0 < -2.0 * a_dt * fabs(an));
+                double tn = impact ? (-shape.m_restitution * vn0) : vn;
+                double slip = 1.0 - shape.m_friction;
+
+                ux = (ux - vn*normal[0]) * slip + tn * normal[0];
+                uy = (uy - vn*normal[1]) * slip + tn * normal[1];
+                uz = (uz - vn*normal[2]) * slip + tn * normal[2];
+            }
+
+            vx[i] = ux;
+            vy[i] = uy;
+            vz[i] = uz;
+        }
+    });
+
+    m_numContacts = 0;
+    for (unsigned int i=0; i<n; i++)
+    {
+        m_numContacts += (m_contactShape[i] > 0) ? 1 : 0;
+    }
+}
+
+
+//===========================================================================
+/*!
+    Project every spring constraint once. On a table colored by
+    \ref cSpringTable::colorSprings(), the colors are projected one after
+    the other and the springs of an independent color, which share no
+    particle, are split into chunks projected concurrently on the task
+    pool: no two threads write the same particle, so no atomics are
+    needed, and each spring still sees the corrections of the colors
+    before it, as in a serial Gauss-Seidel sweep. Colored tables are
+    stored by color, so a serial sweep visits the springs in the same
+    order and gives the same result for any number of threads.
+
+    \fn     double cXPBDIntegrator::projectSprings(const cSpringTable& a_springs,
+            cParticleArrays& a_particles, const double a_dt)
+    \param  a_springs  Springs projected as distance constraints.
+    \param  a_particles  Particles to correct.
+    \param  a_dt  Timestep in seconds.
+    \return Return the largest |C| met, before its correction [m].
+*/
+//===========================================================================
+double cXPBDIntegrator::projectSprings(const cSpringTable& a_springs,
+                                       cParticleArrays& a_particles,
+                                       const double a_dt)
+{
+    unsigned int numColors = a_springs.getNumColors();
+    if ((m_pool == NULL) || (m_pool->getNumThreads() <= 1) || (numColors == 0))
+    {
+        return (projectSpringRange(a_springs, a_particles, a_dt, 0, a_springs.getNumSprings()));
+    }
+
+    double maxError = 0.0;
+    for (unsigned int c=0; c<numColors; c++)
+    {
+        unsigned int first = a_springs.getColorStart(c);
+        unsigned int last = a_springs.getColorStart(c+1);
+        if (!a_springs.isColorIndependent(c))
+        {
+            maxError = fmax(maxError, projectSpringRange(a_springs, a_particles, a_dt, first, last));
+            continue;
+        }
+
+        // largest error of each chunk, reduced after the color
+        unsigned int numChunks = cTaskPool::getNumChunks(first, last, C_XPBD_GRAIN);
+        m_chunkError.assign(numChunks, 0.0);
+        m_pool->parallelFor(first, last, C_XPBD_GRAIN,
+            [&](unsigned int a_begin, unsigned int a_end)
+            {
+                m_chunkError[(a_begin - first) / C_XPBD_GRAIN] =
+                    projectSpringRange(a_springs, a_particles, a_dt, a_begin, a_end);
+            });
+        for (unsigned int k=0; k<numChunks; k++)
+        {
+            maxError = fmax(maxError, m_chunkError[k]);
+        }
+    }
+
+    return (maxError);
+}
+
+
+//===========================================================================
+/*!
+    Project the spring constraints [a_first, a_last) once, in table
+    order. The correction of a spring is shared by its endpoints in
+    proportion to their inverse masses; springs between static particles
+    are skipped, and so are springs without stiffness when the
+    compliance is derived from it.
+
+    \fn     double cXPBDIntegrator::projectSpringRange(const cSpringTable& a_springs,
+            cParticleArrays& a_particles, const double a_dt,
+            const unsigned int a_first, const unsigned int a_last)
+    \param  a_springs  Springs projected as distance constraints.
+    \param  a_particles  Particles to correct.
+    \param  a_dt  Timestep in seconds.
+    \param  a_first  First spring.
+    \param  a_last  One past the last spring.
+    \return Return the largest |C| met, before its correction [m].
+*/
+//===========================================================================
+double cXPBDIntegrator::projectSpringRange(const cSpringTable& a_springs,
+                                           cParticleArrays& a_particles,
+                                           const double a_dt,
+                                           const unsigned int a_first,
+                                           const unsigned int a_last)
+{
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    const double* px0 = &m_posX[0];
+    const double* py0 = &m_posY[0];
+    const double* pz0 = &m_posZ[0];
+    const double* w = a_particles.m_invMass;
+    double* lambda = &m_lambda[0];
+
+    double h2 = a_dt * a_dt;
+    double maxError = 0.0;
+
+    for (unsigned int s=a_first; s<a_last; s++)
+    {
+        unsigned int a = a_springs.m_indexA[s];
+        unsigned int b = a_springs.m_indexB[s];
+        double wsum = w[a] + w[b];
+        if (wsum <= 0.0) { continue; }
+
+        double stiffness = a_springs.m_stiffness[s];
+        double alpha = m_compliance;
+        if (alpha < 0.0)
+        {
+            if (stiffness <= 0.0) { continue; }
+            alpha = 1.0 / stiffness;
+        }
+
+        double dx = px[b] - px[a];
+        double dy = py[b] - py[a];
+        double dz = pz[b] - pz[a];
+        double length = sqrt(dx*dx + dy*dy + dz*dz);
+        if (length < 1e-12) { continue; }
+        dx /= length;  dy /= length;  dz /= length;
+
+        double c = length - a_springs.m_restLength[s];
+        maxError = fmax(maxError, fabs(c));
+
+        // relative displacement along the spring, for the damping term
+        double motion = dx * ((px[b] - px0[b]) - (px[a] - px0[a])) +
+                        dy * ((py[b] - py0[b]) - (py[a] - py0[a])) +
+                        dz * ((pz[b] - pz0[b]) - (pz[a] - pz0[a]));
+
+        double alphaTilde = alpha / h2;
+        double gamma = alpha * a_springs.m_damping[s] / a_dt;
+        double dl = (-c - alphaTilde * lambda[s] - gamma * motion) /
+                    ((1.0 + gamma) * wsum + alphaTilde);
+        lambda[s] += dl;
+
+        px[a] -= w[a] * dl * dx;  py[a] -= w[a] * dl * dy;  pz[a] -= w[a] * dl * dz;
+        px[b] += w[b] * dl * dx;  py[b] += w[b] * dl * dy;  pz[b] += w[b] * dl * dz;
+    }
+
+    return (maxError);
+}
+
+
+//===========================================================================
+/*!
+    Push every dynamic particle that penetrates a plane shape back to its
+    surface (a contact constraint of zero compliance), and remember the
+    plane for the velocity update. Extent and thickness of bounded planes
+    are tested as in \ref cParticleContacts::resolve().
+
+    \fn     void cXPBDIntegrator::projectPlanes(const cParticleContacts& a_contacts,
+            const double a_radius, cParticleArrays& a_particles)
+    \param  a_contacts  Contact shapes; only planes are projected.
+    \param  a_radius  Collision radius of the particles.
+    \param  a_particles  Particles to correct.
+*/
+//===========================================================================
+void cXPBDIntegrator::projectPlanes(const cParticleContacts& a_contacts,
+                                   const double a_radius,
+                                   cParticleArrays& a_particles)
+{
+    double* px = a_particles.m_posX;
+    double* py = a_particles.m_posY;
+    double* pz = a_particles.m_posZ;
+    const double* w = a_particles.m_invMass;
+    unsigned int* holder = &m_contactShape[0];
+    unsigned int n = a_particles.getNumParticles();
+
+    for (unsigned int k=0; k<a_contacts.getNumShapes(); k++)
+    {
+        const cContactShape& shape = a_contacts.getShape(k);
+        if (shape.m_type != C_CONTACT_PLANE) { continue; }
+
+        const double* nrm = shape.m_normal;
+        const double* t = shape.m_tangent;
+        const double* c = shape.m_center;
+        double b[3] = { nrm[1]*t[2] - nrm[2]*t[1],
+                        nrm[2]*t[0] - nrm[0]*t[2],
+                        nrm[0]*t[1] - nrm[1]*t[0] };
+
+        // zero sizes mean unbounded
+        double halfU = (shape.m_halfSize[0] > 0.0) ? shape.m_halfSize[0] : HUGE_VAL;
+        double halfV = (shape.m_halfSize[1] > 0.0) ? shape.m_halfSize[1] : HUGE_VAL;
+        double maxDepth = (shape.m_halfSize[2] > 0.0) ? (a_radius + shape.m_halfSize[2]) : HUGE_VAL;
+
+        cParallelFor(m_pool, 0, n, C_TASK_GRAIN, [&](unsigned int a_begin, unsigned int a_end)
+        {
+            for (unsigned int i=a_begin; i<a_end; i++)
+            {
+                double qx = px[i] - c[0];
+                double qy = py[i] - c[1];
+                double qz = pz[i] - c[2];
+
+                double depth = a_radius - (qx*nrm[0] + qy*nrm[1] + qz*nrm[2]);
+                double u = fabs(qx*t[0] + qy*t[1] + qz*t[2]);
+                double v = fabs(qx*b[0] + qy*b[1] + qz*b[2]);
+
+                if ((depth > 0.0) && (depth < maxDepth) && (u <= halfU) && (v <= halfV) &&
+                    (w[i] > 0.0))
+                {
+                    px[i] += nrm[0] * depth;
+                    py[i] += nrm[1] * depth;
+                    pz[i] += nrm[2] * depth;
+                    holder[i] = k + 1;
+                }
+            }
+        });
+    }
+}
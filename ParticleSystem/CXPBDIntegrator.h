@@ -0,0 +1,166 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#ifndef CXPBDIntegratorH
+#define CXPBDIntegratorH
+//---------------------------------------------------------------------------
+#include "CParticleIntegrators.h"
+#include "CSpringTable.h"
+#include "CParticleContacts.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*!
+    \file       CXPBDIntegrator.h
+
+    \brief
+    <b> Particles </b> \n
+    Extended position based dynamics (XPBD).
+*/
+//===========================================================================
+
+//===========================================================================
+/*!
+    \class      cXPBDIntegrator
+    \ingroup    particles
+
+    \brief
+    Extended position based dynamics (Macklin, Mueller and Chentanez).
+    Springs are not applied as forces but as distance constraints
+    C = |xb - xa| - L with a compliance (inverse stiffness) alpha, so a
+    step stays stable at any timestep and spring stiffness. Each step:
+
+    - advances velocities with the forces other than the springs
+      (external force, drag) and predicts positions x* = x + h.v,
+    - projects every spring constraint \e m_numIterations times, Gauss-
+      Seidel fashion, with the Lagrange multiplier update
+
+        dl = (-C - a.l - g.grad(C).(x - x0)) / ((1 + g).(wa + wb) + a)
+
+      where a = alpha/h^2 and g = alpha.beta/h, beta being the damping
+      of the spring; the plane shapes of the force model are projected
+      in the same iterations as contact constraints,
+    - and derives velocities from the displacement, (x - x0)/h. Particles
+      in contact with a plane then get the restitution and friction of
+      the plane applied to their velocity.
+
+    Compliance is the inverse of the stiffness of each spring unless a
+    uniform compliance is set with \ref setCompliance(); zero compliance
+    gives inextensible springs. A few iterations are enough for stiff
+    cloth and ropes at haptic rates; fewer iterations make the material
+    softer, never unstable.
+
+    With a task pool and a spring table colored once at build time by
+    \ref cSpringTable::colorSprings(), the Gauss-Seidel sweep runs color
+    by color, the springs of a color in parallel: they share no particle,
+    so threads never write the same particle. Colored tables are stored
+    by color, so the serial sweep takes the same order and the result
+    does not depend on the number of threads.
+
+    Forces other than the springs come from
+    \ref cParticleForceModel::computeExternalForces(), springs from
+    \ref cParticleForceModel::getImplicitSprings() and planes from
+    \ref cParticleForceModel::getContactShapes(). Bounded planes are
+    projected within their extent and thickness, as the contact pass of
+    \ref cParticleContacts does; boxes and spheres are left to that pass.
+*/
+//===========================================================================
+class cXPBDIntegrator : public cParticleIntegrator
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cXPBDIntegrator.
+    cXPBDIntegrator();
+
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Advance \e a_particles by \e a_dt seconds.
+    virtual void integrate(cParticleForceModel& a_model,
+                           cParticleArrays& a_particles,
+                           const double a_dt);
+
+    //! Type of the scheme.
+    virtual cParticleIntegratorType getType() const { return (C_INTEGRATOR_XPBD); }
+
+    //! Set the number of constraint iterations per step (at least 1).
+    inline void setNumIterations(const unsigned int a_numIterations) { m_numIterations = (a_numIterations > 0) ? a_numIterations : 1; }
+
+    //! Number of constraint iterations per step.
+    inline unsigned int getNumIterations() const { return (m_numIterations); }
+
+    //! Set a compliance [m/N] shared by every spring; negative: the inverse of each stiffness.
+    inline void setCompliance(const double a_compliance) { m_compliance = a_compliance; }
+
+    //! Compliance shared by every spring, or a negative value if derived from the stiffness.
+    inline double getCompliance() const { return (m_compliance); }
+
+    //! Largest spring constraint error |C| before the last iteration of the last step [m].
+    inline double getLastError() const { return (m_lastError); }
+
+    //! Number of particles held by a plane constraint in the last step.
+    inline unsigned int getNumContacts() const { return (m_numContacts); }
+
+
+  private:
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    //! Project every spring constraint once, color by color. Returns the largest |C| met.
+    double projectSprings(const cSpringTable& a_springs, cParticleArrays& a_particles,
+                          const double a_dt);
+
+    //! Project the spring constraints [a_first, a_last) once. Returns the largest |C| met.
+    double projectSpringRange(const cSpringTable& a_springs, cParticleArrays& a_particles,
+                              const double a_dt, const unsigned int a_first,
+                              const unsigned int a_last);
+
+    //! Project the plane constraints of \e a_contacts on particles of radius \e a_radius.
+    void projectPlanes(const cParticleContacts& a_contacts, const double a_radius,
+                       cParticleArrays& a_particles);
+
+
+    //-----------------------------------------------------------------------
+    // MEMBERS:
+    //-----------------------------------------------------------------------
+
+    //! Solver settings.
+    unsigned int m_numIterations;
+    double m_compliance;
+
+    //! Statistics of the last step.
+    double m_lastError;
+    unsigned int m_numContacts;
+
+    //! Positions at the start of the step.
+    std::vector<double> m_posX, m_posY, m_posZ;
+
+    //! Lagrange multiplier of each spring, cleared every step.
+    std::vector<double> m_lambda;
+
+    //! Per particle: index of the plane shape holding it plus one, 0 if none.
+    std::vector<unsigned int> m_contactShape;
+
+    //! Largest constraint error of each chunk of a parallel color.
+    std::vector<double> m_chunkError;
+};
+
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
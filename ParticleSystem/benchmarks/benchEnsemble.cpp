@@ -0,0 +1,169 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+//---------------------------------------------------------------------------
+#include "../CParticleEnsemble.h"
+#include "../CTriangleScene.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*
+    BENCHMARK:    benchEnsemble.cpp
+
+    Measures the throughput (scenario steps per second) of the triangle
+    scene of the demo, run one scenario at a time with cParticleSimulation
+    and side by side in the lanes of a cParticleEnsemble with every
+    kernel. Scenarios differ by their mass, stiffness, restitution, drag
+    and start positions, and fall onto the square so that contacts and
+    bounces are part of the measurement. The final positions of every
+    kernel are compared against the one-by-one runs.
+
+    Build (no CHAI 3D needed):
+        g++ -O2 -std=c++11 -pthread benchEnsemble.cpp ../CParticleArrays.cpp
+            ../CSpringTable.cpp ../CSpringKernels.cpp ../CParticleIntegrators.cpp
+            ../CImplicitEulerIntegrator.cpp ../CParticleContacts.cpp
+            ../CSpatialHash.cpp ../CTaskPool.cpp ../CParticleSimulation.cpp
+            ../CParticleIslands.cpp ../CTriangleScene.cpp ../CLoopProfiler.cpp ../CLatencyHistogram.cpp
+            ../CParticleEnsemble.cpp ../CXPBDIntegrator.cpp -o benchEnsemble
+
+    Usage:
+        benchEnsemble [scenarios] [steps] [integrator]
+*/
+//===========================================================================
+
+// fills an empty simulation with scenario a_index of the benchmark
+static void buildScenario(cParticleSimulation& a_simulation, const unsigned int a_index,
+                          const cParticleIntegratorType a_integrator)
+{
+    cTriangleSceneParameters parameters;
+    parameters.m_mass = 1.0 + 0.3 * (a_index % 37);
+    parameters.m_stiffness = 50.0 + 7.0 * (a_index % 53);
+    parameters.m_restitution = 0.2 + 0.01 * (a_index % 71);
+    parameters.m_drag = 0.1 * (a_index % 7);
+
+    cBuildTriangleScene(a_simulation, parameters);
+    a_simulation.m_random.setSeed(a_index + 1);
+    cPlaceTriangleScene(a_simulation, (a_index % 3) != 0);
+    a_simulation.setIntegrator(a_integrator);
+}
+
+int main(int argc, char* argv[])
+{
+    int numScenarios = (argc > 1) ? atoi(argv[1]) : 256;
+    int numSteps = (argc > 2) ? atoi(argv[2]) : 2000;
+    int integrator = (argc > 3) ? atoi(argv[3]) : C_DEFAULT_PARTICLE_INTEGRATOR;
+    if (numScenarios < 1) { numScenarios = 1; }
+    if (numSteps < 1) { numSteps = 1; }
+    if (!cIsEnsembleIntegrator((cParticleIntegratorType)integrator))
+    {
+        printf("integrator %d is not supported by cParticleEnsemble\n", integrator);
+        return (1);
+    }
+
+    const double timeStep = 0.001;
+
+    printf("scenarios: %d  steps: %d  integrator: %s\n", numScenarios, numSteps,
+           cGetParticleIntegratorName((cParticleIntegratorType)integrator));
+    printf("best kernel on this CPU: %s\n\n", cGetEnsembleKernelName(cGetBestEnsembleKernel()));
+
+    //-----------------------------------------------------------------------
+    // ONE BY ONE
+    //-----------------------------------------------------------------------
+
+    std::vector< std::unique_ptr<cParticleSimulation> > scenarios(numScenarios);
+    for (int k = 0; k < numScenarios; k++)
+    {
+        scenarios[k].reset(new cParticleSimulation());
+        buildScenario(*scenarios[k], k, (cParticleIntegratorType)integrator);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int k = 0; k < numScenarios; k++)
+    {
+        for (int s = 0; s < numSteps; s++)
+        {
+            scenarios[k]->step(timeStep);
+        }
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    double singleRate = (double)numScenarios * numSteps / seconds;
+    printf("%-8s %10.2f Msteps/s\n", "single", singleRate * 1e-6);
+
+    //-----------------------------------------------------------------------
+    // ENSEMBLE
+    //-----------------------------------------------------------------------
+
+    cEnsembleKernelType kernels[] = { C_ENSEMBLE_KERNEL_SCALAR,
+                                      C_ENSEMBLE_KERNEL_SSE2,
+                                      C_ENSEMBLE_KERNEL_AVX2,
+                                      C_ENSEMBLE_KERNEL_AVX512 };
+
+    for (unsigned int k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        if (!cIsEnsembleKernelSupported(kernels[k]))
+        {
+            printf("%-8s not supported\n", cGetEnsembleKernelName(kernels[k]));
+            continue;
+        }
+
+        cParticleEnsemble ensemble;
+        for (int lane = 0; lane < numScenarios; lane++)
+        {
+            cParticleSimulation scenario;
+            buildScenario(scenario, lane, (cParticleIntegratorType)integrator);
+            if (lane == 0) { ensemble.create(scenario, numScenarios); }
+            ensemble.setLane(lane, scenario);
+        }
+        ensemble.setKernel(kernels[k]);
+
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < numSteps; s++)
+        {
+            ensemble.step(timeStep);
+        }
+        stop = std::chrono::steady_clock::now();
+
+        // compare against the one-by-one runs
+        double maxError = 0.0;
+        int numExact = 0;
+        for (int lane = 0; lane < numScenarios; lane++)
+        {
+            const cParticleArrays& particles = scenarios[lane]->m_particles;
+            double laneError = 0.0;
+            for (unsigned int i = 0; i < particles.getNumParticles(); i++)
+            {
+                double pos[3];
+                ensemble.getPosition(lane, i, pos);
+                laneError = fmax(laneError, fabs(pos[0] - particles.m_posX[i]));
+                laneError = fmax(laneError, fabs(pos[1] - particles.m_posY[i]));
+                laneError = fmax(laneError, fabs(pos[2] - particles.m_posZ[i]));
+            }
+            if (laneError == 0.0) { numExact++; }
+            maxError = fmax(maxError, laneError);
+        }
+
+        seconds = std::chrono::duration<double>(stop - start).count();
+        double rate = (double)numScenarios * numSteps / seconds;
+        printf("%-8s %10.2f Msteps/s  %6.2fx single  exact %d/%d  max |error| %.3g\n",
+               cGetEnsembleKernelName(kernels[k]), rate * 1e-6, rate / singleRate,
+               numExact, numScenarios, maxError);
+    }
+
+    return (0);
+}
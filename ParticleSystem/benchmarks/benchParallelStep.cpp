@@ -0,0 +1,132 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+//---------------------------------------------------------------------------
+#include "../CParticleSimulation.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*
+    BENCHMARK:    benchParallelStep.cpp
+
+    Measures the time of a full simulation step (forces, integration,
+    contacts and particle-particle collisions) on a square cloth falling
+    onto a sphere, with 1, 2, 4, 8, 16 and 32 threads, and reports the
+    speedup over one thread. The springs are colored once so that their
+    forces are scattered in parallel without conflicts.
+
+    Thread counts above the number of hardware cores are still run, but
+    only show the cost of oversubscription.
+
+    Build (no CHAI 3D needed):
+        g++ -O2 -std=c++11 -pthread benchParallelStep.cpp ../CParticleArrays.cpp
+            ../CSpringTable.cpp ../CSpringKernels.cpp ../CParticleIntegrators.cpp
+            ../CImplicitEulerIntegrator.cpp ../CParticleContacts.cpp
+            ../CSpatialHash.cpp ../CTaskPool.cpp ../CParticleSimulation.cpp
+            ../CParticleIslands.cpp ../CLoopProfiler.cpp ../CLatencyHistogram.cpp
+            ../CXPBDIntegrator.cpp -o benchParallelStep
+
+    Usage:
+        benchParallelStep [grid side] [steps]
+*/
+//===========================================================================
+
+// builds a cloth of side x side particles above a sphere
+static void buildCloth(cParticleSimulation& a_sim, const int a_side)
+{
+    const double spacing = 0.02;
+
+    a_sim.m_particles.reserve(a_side * a_side);
+    srand(1);
+    for (int y = 0; y < a_side; y++)
+    {
+        for (int x = 0; x < a_side; x++)
+        {
+            double jitter = 0.001 * rand() / RAND_MAX;
+            a_sim.m_particles.addParticle(x * spacing + jitter, y * spacing, 0.3 + jitter, 0.01);
+        }
+    }
+
+    a_sim.m_springs.reserve(4 * a_side * a_side);
+    for (int y = 0; y < a_side; y++)
+    {
+        for (int x = 0; x < a_side; x++)
+        {
+            unsigned int i = y * a_side + x;
+            if (x + 1 < a_side) { a_sim.m_springs.addSpring(i, i + 1, spacing, 50.0, 0.01); }
+            if (y + 1 < a_side) { a_sim.m_springs.addSpring(i, i + a_side, spacing, 50.0, 0.01); }
+            if ((x + 1 < a_side) && (y + 1 < a_side))
+            {
+                a_sim.m_springs.addSpring(i, i + a_side + 1, spacing * sqrt(2.0), 25.0, 0.01);
+                a_sim.m_springs.addSpring(i + 1, i + a_side, spacing * sqrt(2.0), 25.0, 0.01);
+            }
+        }
+    }
+    a_sim.m_springs.sortForLocality();
+    a_sim.m_springs.colorSprings();
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    double center[3] = { 0.5 * a_side * spacing, 0.5 * a_side * spacing, 0.1 };
+    a_sim.m_contacts.addPlane(point, normal, 0.3);
+    a_sim.m_contacts.addSphere(center, 0.1, 0.3);
+
+    a_sim.m_externalForce[2] = -9.8 * 0.01;
+    a_sim.m_dragCoefficient = 0.1;
+    a_sim.m_particleRadius = 0.008;
+    a_sim.m_collideParticles = true;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int side = (argc > 1) ? atoi(argv[1]) : 256;
+    int steps = (argc > 2) ? atoi(argv[2]) : 100;
+    if (side < 2) { side = 2; }
+    if (steps < 1) { steps = 1; }
+
+    const unsigned int threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+
+    printf("particles: %d  steps: %d  hardware threads: %u\n\n",
+           side * side, steps, std::thread::hardware_concurrency());
+
+    double baseTime = 0.0;
+    for (unsigned int k = 0; k < sizeof(threadCounts) / sizeof(threadCounts[0]); k++)
+    {
+        cTaskPool pool(threadCounts[k]);
+        cParticleSimulation sim;
+        buildCloth(sim, side);
+        sim.setTaskPool(&pool);
+
+        // warm up caches and scratch buffers once
+        sim.step(0.001);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++)
+        {
+            sim.step(0.001);
+        }
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count() / steps;
+        if (k == 0) { baseTime = ms; }
+
+        printf("threads %2u  %8.3f ms/step  %5.2fx  steals %u\n",
+               threadCounts[k], ms, baseTime / ms, pool.getNumSteals());
+    }
+
+    return (0);
+}
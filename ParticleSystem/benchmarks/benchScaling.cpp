@@ -0,0 +1,422 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+//---------------------------------------------------------------------------
+#include "../CParticleSimulation.h"
+#include "../CParticleGenerators.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*
+    BENCHMARK:    benchScaling.cpp
+
+    Measures full simulation steps on synthetic scenes and writes one
+    JSON document with a record per (scene, particle count, thread count):
+
+        chain   hanging chain pinned at one end, one spring per particle
+        grid    cubic lattice falling on a plane, three springs per particle
+        cloth   square cloth falling on a sphere, four springs per particle,
+                with particle-particle collisions
+        jelly   braced cube falling on a plane, structural, shear and bend
+                springs, about 16 springs per particle
+        cloud   random cloud falling into an open box, no springs, with
+                particle-particle collisions
+
+    The spring count is therefore swept through the scenes (0 to about 16
+    springs per particle) while the particle count and the thread count
+    are swept by the options below. Every record holds the steps per
+    second, the time per particle per step and an estimated memory
+    bandwidth. The bandwidth is a model, not a hardware counter: every
+    particle array is counted as read once and positions, velocities and
+    forces as written once per step, and every spring as reading its own
+    data plus the positions and velocities of both endpoints and writing
+    their forces. Contact and collision traffic is not counted, so the
+    figure is a lower bound of the real traffic.
+
+    Progress goes to stderr and the JSON to stdout (or the -o file), so
+    results of two builds can be compared with any JSON tool.
+
+    Build (no CHAI 3D needed):
+        g++ -O2 -std=c++11 -pthread benchScaling.cpp ../CParticleArrays.cpp
+            ../CSpringTable.cpp ../CSpringKernels.cpp ../CParticleIntegrators.cpp
+            ../CImplicitEulerIntegrator.cpp ../CParticleContacts.cpp
+            ../CSpatialHash.cpp ../CTaskPool.cpp ../CParticleSimulation.cpp
+            ../CParticleIslands.cpp ../CLoopProfiler.cpp ../CLatencyHistogram.cpp
+            ../CXPBDIntegrator.cpp ../CParticleGenerators.cpp -o benchScaling
+
+    Usage:
+        benchScaling [options]
+            -scenes LIST    comma separated scenes (default chain,grid,cloth,jelly,cloud)
+            -sizes LIST     comma separated particle counts (default 1000,10000,100000)
+            -threads LIST   comma separated thread counts (default 1, 2, 4...
+                            up to the number of hardware threads)
+            -time T         minimum measured time per record [s] (default 0.25)
+            -integrator I   integrator index (default velocity Verlet)
+            -o FILE         write the JSON to FILE instead of stdout
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+// SCENES
+//---------------------------------------------------------------------------
+
+// time step of every scene
+static const double C_BENCH_TIMESTEP = 0.001;
+
+// hanging chain of n particles, pinned at its first particle
+static void buildChain(cParticleSimulation& a_sim, const unsigned int a_count)
+{
+    const double spacing = 0.01;
+    unsigned int count = (a_count < 2) ? 2 : a_count;
+
+    cGeneratorMaterial material;
+    material.m_stiffness = 200.0;
+    material.m_shearStiffness = 0.0;
+    material.m_bendStiffness = 0.0;
+
+    double start[3] = { 0.0, 0.0, 1.0 };
+    double end[3] = { (count - 1) * spacing, 0.0, 1.0 };
+    cParticleBlock block;
+    cGenerateRope(a_sim, start, end, count, material, &block);
+    a_sim.m_particles.setMass(block.getIndex(0), 0.0);
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    a_sim.m_contacts.addPlane(point, normal, 0.3);
+
+    a_sim.m_externalForce[2] = -9.8 * 0.01;
+    a_sim.m_dragCoefficient = 0.1;
+    a_sim.m_particleRadius = 0.004;
+}
+
+// cubic lattice of about n particles with springs along the three axes
+static void buildGrid(cParticleSimulation& a_sim, const unsigned int a_count)
+{
+    const double spacing = 0.02;
+    int side = (int)floor(cbrt((double)a_count) + 0.5);
+    if (side < 2) { side = 2; }
+
+    cGeneratorMaterial material;
+    material.m_shearStiffness = 0.0;
+    material.m_bendStiffness = 0.0;
+
+    double origin[3] = { 0.0, 0.0, 0.1 };
+    double size[3] = { (side - 1) * spacing, (side - 1) * spacing, (side - 1) * spacing };
+    unsigned int count[3] = { (unsigned int)side, (unsigned int)side, (unsigned int)side };
+    cGenerateLattice(a_sim, origin, size, count, material);
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    a_sim.m_contacts.addPlane(point, normal, 0.3);
+
+    a_sim.m_externalForce[2] = -9.8 * 0.01;
+    a_sim.m_dragCoefficient = 0.1;
+    a_sim.m_particleRadius = 0.008;
+}
+
+// square cloth of about n particles above a sphere
+static void buildCloth(cParticleSimulation& a_sim, const unsigned int a_count)
+{
+    const double spacing = 0.02;
+    int side = (int)floor(sqrt((double)a_count) + 0.5);
+    if (side < 2) { side = 2; }
+
+    cGeneratorMaterial material;
+    material.m_stiffness = 50.0;
+    material.m_shearStiffness = 25.0;
+    material.m_bendStiffness = 0.0;
+
+    double origin[3] = { 0.0, 0.0, 0.3 };
+    double edgeU[3] = { (side - 1) * spacing, 0.0, 0.0 };
+    double edgeV[3] = { 0.0, (side - 1) * spacing, 0.0 };
+    cParticleBlock block;
+    cGenerateCloth(a_sim, origin, edgeU, edgeV, side, side, material, &block);
+
+    // a small jitter, so the cloth does not land flat on the sphere
+    srand(1);
+    for (int y = 0; y < side; y++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            unsigned int i = block.getIndex(x, y);
+            double jitter = 0.001 * rand() / RAND_MAX;
+            a_sim.m_particles.m_posX[i] += jitter;
+            a_sim.m_particles.m_posZ[i] += jitter;
+        }
+    }
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    double center[3] = { 0.5 * side * spacing, 0.5 * side * spacing, 0.1 };
+    a_sim.m_contacts.addPlane(point, normal, 0.3);
+    a_sim.m_contacts.addSphere(center, 0.1, 0.3);
+
+    a_sim.m_externalForce[2] = -9.8 * 0.01;
+    a_sim.m_dragCoefficient = 0.1;
+    a_sim.m_particleRadius = 0.008;
+    a_sim.m_collideParticles = true;
+}
+
+// fully braced jelly cube of about n particles dropped on a plane
+static void buildJelly(cParticleSimulation& a_sim, const unsigned int a_count)
+{
+    const double spacing = 0.02;
+    int side = (int)floor(cbrt((double)a_count) + 0.5);
+    if (side < 2) { side = 2; }
+
+    cGeneratorMaterial material;
+
+    double edge = (side - 1) * spacing;
+    double center[3] = { 0.5 * edge, 0.5 * edge, 0.1 + 0.5 * edge };
+    cGenerateJellyCube(a_sim, center, edge, side, material);
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    a_sim.m_contacts.addPlane(point, normal, 0.3);
+
+    a_sim.m_externalForce[2] = -9.8 * 0.01;
+    a_sim.m_dragCoefficient = 0.1;
+    a_sim.m_particleRadius = 0.008;
+}
+
+// random cloud of n particles falling into a box
+static void buildCloud(cParticleSimulation& a_sim, const unsigned int a_count)
+{
+    const double radius = 0.005;
+
+    // about one particle per (4 r)^3, in a cube resting on the floor
+    double size = 4.0 * radius * cbrt((double)a_count);
+
+    a_sim.m_particles.reserve(a_count);
+    srand(1);
+    for (unsigned int i = 0; i < a_count; i++)
+    {
+        a_sim.m_particles.addParticle(size * rand() / RAND_MAX,
+                                      size * rand() / RAND_MAX,
+                                      radius + size * rand() / RAND_MAX, 0.001);
+    }
+
+    // floor and four walls, all facing inwards
+    double low[3] = { 0.0, 0.0, 0.0 };
+    double high[3] = { size, size, 0.0 };
+    double up[3] = { 0.0, 0.0, 1.0 };
+    double east[3] = { 1.0, 0.0, 0.0 };
+    double west[3] = { -1.0, 0.0, 0.0 };
+    double north[3] = { 0.0, 1.0, 0.0 };
+    double south[3] = { 0.0, -1.0, 0.0 };
+    a_sim.m_contacts.addPlane(low, up, 0.2);
+    a_sim.m_contacts.addPlane(low, east, 0.2);
+    a_sim.m_contacts.addPlane(high, west, 0.2);
+    a_sim.m_contacts.addPlane(low, north, 0.2);
+    a_sim.m_contacts.addPlane(high, south, 0.2);
+
+    a_sim.m_externalForce[2] = -9.8 * 0.001;
+    a_sim.m_dragCoefficient = 0.1;
+    a_sim.m_particleRadius = radius;
+    a_sim.m_collideParticles = true;
+    a_sim.m_particleRestitution = 0.2;
+}
+
+// builds the scene called a_name; returns false for an unknown name
+static bool buildScene(cParticleSimulation& a_sim, const std::string& a_name,
+                       const unsigned int a_count)
+{
+    if (a_name == "chain")      { buildChain(a_sim, a_count); }
+    else if (a_name == "grid")  { buildGrid(a_sim, a_count); }
+    else if (a_name == "cloth") { buildCloth(a_sim, a_count); }
+    else if (a_name == "jelly") { buildJelly(a_sim, a_count); }
+    else if (a_name == "cloud") { buildCloud(a_sim, a_count); }
+    else                        { return (false); }
+    return (true);
+}
+
+
+//---------------------------------------------------------------------------
+// OPTIONS
+//---------------------------------------------------------------------------
+
+// splits a comma separated list
+static std::vector<std::string> splitList(const char* a_list)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* c = a_list; ; c++)
+    {
+        if ((*c == ',') || (*c == 0))
+        {
+            if (!item.empty()) { items.push_back(item); }
+            item.clear();
+            if (*c == 0) { break; }
+        }
+        else
+        {
+            item += *c;
+        }
+    }
+    return (items);
+}
+
+// splits a comma separated list of positive integers
+static std::vector<unsigned int> splitCounts(const char* a_list)
+{
+    std::vector<std::string> items = splitList(a_list);
+    std::vector<unsigned int> counts;
+    for (unsigned int k = 0; k < items.size(); k++)
+    {
+        int value = atoi(items[k].c_str());
+        if (value > 0) { counts.push_back((unsigned int)value); }
+    }
+    return (counts);
+}
+
+
+//---------------------------------------------------------------------------
+// MAIN
+//---------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> scenes = splitList("chain,grid,cloth,jelly,cloud");
+    std::vector<unsigned int> sizes = splitCounts("1000,10000,100000");
+    std::vector<unsigned int> threadCounts;
+    double minTime = 0.25;
+    int integrator = C_DEFAULT_PARTICLE_INTEGRATOR;
+    const char* outputName = NULL;
+
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads == 0) { hardwareThreads = 1; }
+    for (unsigned int t = 1; t <= hardwareThreads; t *= 2)
+    {
+        threadCounts.push_back(t);
+    }
+
+    for (int k = 1; k < argc; k++)
+    {
+        bool hasValue = (k + 1 < argc);
+        if ((strcmp(argv[k], "-scenes") == 0) && hasValue)          { scenes = splitList(argv[++k]); }
+        else if ((strcmp(argv[k], "-sizes") == 0) && hasValue)      { sizes = splitCounts(argv[++k]); }
+        else if ((strcmp(argv[k], "-threads") == 0) && hasValue)    { threadCounts = splitCounts(argv[++k]); }
+        else if ((strcmp(argv[k], "-time") == 0) && hasValue)       { minTime = atof(argv[++k]); }
+        else if ((strcmp(argv[k], "-integrator") == 0) && hasValue) { integrator = atoi(argv[++k]); }
+        else if ((strcmp(argv[k], "-o") == 0) && hasValue)          { outputName = argv[++k]; }
+        else
+        {
+            fprintf(stderr, "usage: %s [-scenes LIST] [-sizes LIST] [-threads LIST]\n"
+                            "          [-time T] [-integrator I] [-o FILE]\n", argv[0]);
+            return (1);
+        }
+    }
+    if ((integrator < 0) || (integrator >= C_NUM_INTEGRATORS))
+    {
+        fprintf(stderr, "unknown integrator %d\n", integrator);
+        return (1);
+    }
+
+    FILE* out = stdout;
+    if (outputName != NULL)
+    {
+        out = fopen(outputName, "w");
+        if (out == NULL)
+        {
+            fprintf(stderr, "cannot open %s\n", outputName);
+            return (1);
+        }
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"hardware_threads\": %u,\n", hardwareThreads);
+    fprintf(out, "  \"integrator\": \"%s\",\n",
+            cGetParticleIntegratorName((cParticleIntegratorType)integrator));
+    fprintf(out, "  \"timestep\": %g,\n", C_BENCH_TIMESTEP);
+    fprintf(out, "  \"results\": [");
+
+    bool first = true;
+    for (unsigned int s = 0; s < scenes.size(); s++)
+    {
+        for (unsigned int n = 0; n < sizes.size(); n++)
+        {
+            for (unsigned int t = 0; t < threadCounts.size(); t++)
+            {
+                cTaskPool pool(threadCounts[t]);
+                cParticleSimulation sim;
+                if (!buildScene(sim, scenes[s], sizes[n]))
+                {
+                    fprintf(stderr, "unknown scene %s\n", scenes[s].c_str());
+                    return (1);
+                }
+                sim.setIntegrator((cParticleIntegratorType)integrator);
+                sim.setTaskPool(&pool);
+
+                // warm up caches and scratch buffers once
+                sim.step(C_BENCH_TIMESTEP);
+
+                // run whole batches until the minimum time is reached
+                long steps = 0;
+                long batch = 1;
+                double seconds = 0.0;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                while ((seconds < minTime) || (steps < 3))
+                {
+                    for (long k = 0; k < batch; k++)
+                    {
+                        sim.step(C_BENCH_TIMESTEP);
+                    }
+                    steps += batch;
+                    if (batch < 64) { batch *= 2; }
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    seconds = std::chrono::duration<double>(now - start).count();
+                }
+
+                double numParticles = sim.m_particles.getNumParticles();
+                double numSprings = sim.m_springs.getNumSprings();
+
+                // traffic model, see the header of this file
+                double particleBytes = numParticles * (10 + 9) * sizeof(double);
+                double springBytes = numSprings * (2 * sizeof(unsigned int) + 3 * sizeof(double) +
+                                                   2 * 9 * sizeof(double));
+                double bytesPerStep = particleBytes + springBytes;
+
+                double stepsPerSecond = steps / seconds;
+                double nsPerParticle = 1e9 * seconds / (steps * numParticles);
+                double bandwidth = bytesPerStep * stepsPerSecond / 1e9;
+
+                fprintf(stderr, "%-6s particles %8.0f  springs %8.0f  threads %2u  "
+                                "%10.1f steps/s  %8.2f ns/particle  %6.2f GB/s\n",
+                        scenes[s].c_str(), numParticles, numSprings, pool.getNumThreads(),
+                        stepsPerSecond, nsPerParticle, bandwidth);
+
+                fprintf(out, "%s\n    {\"scene\": \"%s\", \"particles\": %.0f, \"springs\": %.0f, "
+                             "\"threads\": %u, \"steps\": %ld, \"seconds\": %.6f, "
+                             "\"steps_per_second\": %.3f, \"ns_per_particle_step\": %.3f, "
+                             "\"bytes_per_step\": %.0f, \"bandwidth_gb_per_second\": %.3f, "
+                             "\"contacts\": %u, \"particle_contacts\": %u}",
+                        first ? "" : ",", scenes[s].c_str(), numParticles, numSprings,
+                        pool.getNumThreads(), steps, seconds, stepsPerSecond, nsPerParticle,
+                        bytesPerStep, bandwidth, sim.getNumContacts(),
+                        sim.getNumParticleContacts());
+                first = false;
+            }
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) { fclose(out); }
+
+    return (0);
+}
@@ -0,0 +1,154 @@
+//===========================================================================
+/*
+    This file is part of the Dynamic Simulation with Particles project,
+    built on top of the CHAI 3D visualization and haptics libraries.
+
+    \author    <http://www.chai3d.org>
+    \version   2.0.0
+*/
+//===========================================================================
+
+//---------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+//---------------------------------------------------------------------------
+#include "../CSpringTable.h"
+//---------------------------------------------------------------------------
+
+//===========================================================================
+/*
+    BENCHMARK:    benchSpringKernels.cpp
+
+    Measures the throughput of the spring force kernels (springs per
+    second) on a square cloth of structural and shear springs whose
+    particles are slightly jittered so that every spring is stretched.
+    The forces produced by each SIMD kernel are compared against the
+    scalar kernel.
+
+    Build (no CHAI 3D needed):
+        g++ -O2 -std=c++11 -pthread benchSpringKernels.cpp ../CParticleArrays.cpp
+            ../CSpringTable.cpp ../CSpringKernels.cpp ../CTaskPool.cpp
+            -o benchSpringKernels
+
+    Usage:
+        benchSpringKernels [grid side] [repetitions]
+*/
+//===========================================================================
+
+int main(int argc, char* argv[])
+{
+    int side = (argc > 1) ? atoi(argv[1]) : 256;
+    int repetitions = (argc > 2) ? atoi(argv[2]) : 50;
+    if (side < 2) { side = 2; }
+    if (repetitions < 1) { repetitions = 1; }
+
+    //-----------------------------------------------------------------------
+    // BUILD CLOTH
+    //-----------------------------------------------------------------------
+
+    const double spacing = 0.01;
+
+    cParticleArrays particles;
+    particles.reserve(side * side);
+    srand(1);
+    for (int y = 0; y < side; y++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            double jitter = 0.002 * rand() / RAND_MAX;
+            unsigned int index = particles.addParticle(x * spacing + jitter,
+                                                       y * spacing - jitter,
+                                                       jitter, 0.01);
+            particles.m_velZ[index] = 0.1 * rand() / RAND_MAX;
+        }
+    }
+
+    cSpringTable springs;
+    springs.reserve(4 * side * side);
+    for (int y = 0; y < side; y++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            unsigned int i = y * side + x;
+            if (x + 1 < side) { springs.addSpring(i, i + 1, spacing, 100.0, 0.1); }
+            if (y + 1 < side) { springs.addSpring(i, i + side, spacing, 100.0, 0.1); }
+            if ((x + 1 < side) && (y + 1 < side))
+            {
+                springs.addSpring(i, i + side + 1, spacing * sqrt(2.0), 50.0, 0.1);
+                springs.addSpring(i + 1, i + side, spacing * sqrt(2.0), 50.0, 0.1);
+            }
+        }
+    }
+    springs.sortForLocality();
+
+    unsigned int numParticles = particles.getNumParticles();
+    unsigned int numSprings = springs.getNumSprings();
+
+    printf("particles: %u  springs: %u  repetitions: %d\n", numParticles, numSprings, repetitions);
+    printf("best kernel on this CPU: %s\n\n", cGetSpringKernelName(cGetBestSpringKernel()));
+
+    //-----------------------------------------------------------------------
+    // REFERENCE FORCES
+    //-----------------------------------------------------------------------
+
+    particles.clearForces();
+    springs.accumulateForces(particles, C_SPRING_KERNEL_SCALAR);
+    std::vector<double> reference(3 * numParticles);
+    for (unsigned int i = 0; i < numParticles; i++)
+    {
+        reference[3*i+0] = particles.m_forceX[i];
+        reference[3*i+1] = particles.m_forceY[i];
+        reference[3*i+2] = particles.m_forceZ[i];
+    }
+
+    //-----------------------------------------------------------------------
+    // RUN KERNELS
+    //-----------------------------------------------------------------------
+
+    cSpringKernelType kernels[] = { C_SPRING_KERNEL_SCALAR,
+                                    C_SPRING_KERNEL_SSE2,
+                                    C_SPRING_KERNEL_AVX2 };
+
+    double scalarRate = 0.0;
+    for (unsigned int k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        if (!cIsSpringKernelSupported(kernels[k]))
+        {
+            printf("%-8s not supported\n", cGetSpringKernelName(kernels[k]));
+            continue;
+        }
+
+        // warm up caches once
+        particles.clearForces();
+        springs.accumulateForces(particles, kernels[k]);
+
+        double maxError = 0.0;
+        for (unsigned int i = 0; i < numParticles; i++)
+        {
+            maxError = fmax(maxError, fabs(particles.m_forceX[i] - reference[3*i+0]));
+            maxError = fmax(maxError, fabs(particles.m_forceY[i] - reference[3*i+1]));
+            maxError = fmax(maxError, fabs(particles.m_forceZ[i] - reference[3*i+2]));
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; r++)
+        {
+            particles.clearForces();
+            springs.accumulateForces(particles, kernels[k]);
+        }
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(stop - start).count();
+        double rate = (double)numSprings * repetitions / seconds;
+        if (kernels[k] == C_SPRING_KERNEL_SCALAR) { scalarRate = rate; }
+
+        printf("%-8s %10.2f Msprings/s  %6.2fx scalar  max |error| %.3g\n",
+               cGetSpringKernelName(kernels[k]), rate * 1e-6,
+               (scalarRate > 0.0) ? rate / scalarRate : 0.0, maxError);
+    }
+
+    return (0);
+}